@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "util/util_converter.h"
+
+/**
+ * The benchmark suite name
+ */
+static char bench_suite[BENCH_NAME_LENGTH] = "";
+
+/**
+ * Result files prefix, NULL if results are only printed
+ */
+static const char *bench_output = NULL;
+
+/**
+ * Result files
+ */
+static FILE *bench_csv = NULL;
+static FILE *bench_json = NULL;
+
+/**
+ * Flag if a JSON result has already been written
+ */
+static bool bench_json_first = true;
+
+/**
+ * Allocations done so far
+ */
+static unsigned long bench_allocations_counter = 0;
+
+/**
+ * The real allocators, the calls of the benchmarked code are redirected to the __wrap_ ones by the linker
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    bench_allocations_counter++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    bench_allocations_counter++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    bench_allocations_counter++;
+    return __real_realloc(ptr, size);
+}
+
+unsigned long bench_allocations(void) {
+    return bench_allocations_counter;
+}
+
+/**
+ * Compare two durations for qsort
+ * @param a First duration
+ * @param b Second duration
+ * @return Comparison result
+ */
+static int bench_compare(const void *a, const void *b);
+
+/**
+ * Return a percentile from sorted samples using the nearest rank
+ * @param samples The sorted samples
+ * @param percentile The percentile in [0, 1]
+ * @return The percentile value
+ */
+static double bench_percentile(const BenchSamples *samples, double percentile);
+
+bool bench_arguments(int argc, char **args, size_t *iterations) {
+    ConverterResult result;
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(args[i], BENCH_ARG_OUTPUT) == 0 && i + 1 < argc) {
+            bench_output = args[++i];
+        } else if (strcmp(args[i], BENCH_ARG_ITERATIONS) == 0 && i + 1 < argc &&
+                   !(result = converter_string_to_long(args[++i])).error && result.data.Long > 0) {
+            *iterations = (size_t) result.data.Long;
+        } else {
+            fprintf(stderr, "Usage: %s [%s <prefix>] [%s <iterations>]\n", args[0], BENCH_ARG_OUTPUT,
+                    BENCH_ARG_ITERATIONS);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void bench_begin(const char *suite) {
+    char file_name[BUFSIZ];
+
+    strncpy(bench_suite, suite, BENCH_NAME_LENGTH - 1);
+    bench_suite[BENCH_NAME_LENGTH - 1] = '\0';
+
+    if (bench_output != NULL) {
+        snprintf(file_name, sizeof(file_name), "%s.csv", bench_output);
+        if ((bench_csv = fopen(file_name, "w")) == NULL) perror("Bench CSV");
+        snprintf(file_name, sizeof(file_name), "%s.json", bench_output);
+        if ((bench_json = fopen(file_name, "w")) == NULL) perror("Bench JSON");
+    }
+    if (bench_csv != NULL)
+        fprintf(bench_csv, "suite,name,params,samples,ops,p50_ns,p99_ns,mean_ns,max_ns,throughput,allocations\n");
+    if (bench_json != NULL) fprintf(bench_json, "[\n");
+    bench_json_first = true;
+
+    printf("\t%-*s %-*s %8s %12s %12s %12s %12s %14s %8s\n", BENCH_NAME_WIDTH, "NAME", BENCH_PARAMS_LENGTH / 2,
+           "PARAMS", "SAMPLES", "P50(ns)", "P99(ns)", "MEAN(ns)", "MAX(ns)", "OPS/s", "ALLOC/op");
+    /* Benchmarks fork, nothing must be left in a buffer a child could flush again */
+    fflush(NULL);
+}
+
+void bench_end(void) {
+    if (bench_csv != NULL) {
+        fclose(bench_csv);
+        bench_csv = NULL;
+    }
+    if (bench_json != NULL) {
+        fprintf(bench_json, "\n]\n");
+        fclose(bench_json);
+        bench_json = NULL;
+    }
+    if (bench_output != NULL) printf("Results written to %s.csv and %s.json\n", bench_output, bench_output);
+}
+
+BenchSamples *new_bench_samples(size_t capacity) {
+    BenchSamples *samples = (BenchSamples *) malloc(sizeof(BenchSamples));
+    if (samples == NULL) {
+        perror("Bench Samples Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    samples->capacity = (capacity == 0) ? 1 : capacity;
+    samples->size = 0;
+    samples->values = (double *) malloc(sizeof(double) * samples->capacity);
+    if (samples->values == NULL) {
+        perror("Bench Samples Values Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    return samples;
+}
+
+void free_bench_samples(BenchSamples *samples) {
+    if (samples == NULL) return;
+
+    free(samples->values);
+    free(samples);
+}
+
+void bench_samples_add(BenchSamples *samples, double ns) {
+    if (samples == NULL) return;
+
+    if (samples->size == samples->capacity) {
+        samples->capacity *= 2;
+        samples->values = (double *) realloc(samples->values, sizeof(double) * samples->capacity);
+        if (samples->values == NULL) {
+            perror("Bench Samples Values Memory Reallocation");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    samples->values[samples->size++] = ns;
+}
+
+static int bench_compare(const void *a, const void *b) {
+    double value_a = *(const double *) a;
+    double value_b = *(const double *) b;
+
+    return (value_a > value_b) - (value_a < value_b);
+}
+
+static double bench_percentile(const BenchSamples *samples, double percentile) {
+    size_t rank;
+    if (samples->size == 0) return 0;
+
+    rank = (size_t) (percentile * samples->size + 0.999999);
+    if (rank == 0) rank = 1;
+    if (rank > samples->size) rank = samples->size;
+
+    return samples->values[rank - 1];
+}
+
+void bench_report(const char *name, const char *params, BenchSamples *samples, size_t ops_per_sample,
+                  double allocations_per_op) {
+    double total = 0;
+    double p50;
+    double p99;
+    double mean;
+    double max;
+    double throughput;
+    size_t i;
+    if (samples == NULL || samples->size == 0 || ops_per_sample == 0) return;
+
+    qsort(samples->values, samples->size, sizeof(double), bench_compare);
+    for (i = 0; i < samples->size; ++i) total += samples->values[i];
+
+    p50 = bench_percentile(samples, 0.50) / ops_per_sample;
+    p99 = bench_percentile(samples, 0.99) / ops_per_sample;
+    max = samples->values[samples->size - 1] / ops_per_sample;
+    mean = total / samples->size / ops_per_sample;
+    throughput = (total > 0) ? (double) samples->size * ops_per_sample / (total / 1000000000.0) : 0;
+
+    printf("\t%-*s %-*s %8ld %12.1f %12.1f %12.1f %12.1f %14.1f ", BENCH_NAME_WIDTH, name,
+           BENCH_PARAMS_LENGTH / 2, params, samples->size, p50, p99, mean, max, throughput);
+    (allocations_per_op < 0) ? printf("%8s\n", "-") : printf("%8.2f\n", allocations_per_op);
+
+    if (bench_csv != NULL) {
+        fprintf(bench_csv, "%s,%s,%s,%ld,%ld,%.1f,%.1f,%.1f,%.1f,%.1f,", bench_suite, name, params, samples->size,
+                ops_per_sample, p50, p99, mean, max, throughput);
+        (allocations_per_op < 0) ? fprintf(bench_csv, "\n") : fprintf(bench_csv, "%.2f\n", allocations_per_op);
+    }
+    if (bench_json != NULL) {
+        fprintf(bench_json, "%s{\"suite\":\"%s\",\"name\":\"%s\",\"params\":\"%s\",\"samples\":%ld,\"ops\":%ld,",
+                (bench_json_first) ? "" : ",\n", bench_suite, name, params, samples->size, ops_per_sample);
+        fprintf(bench_json, "\"p50_ns\":%.1f,\"p99_ns\":%.1f,\"mean_ns\":%.1f,\"max_ns\":%.1f,\"throughput\":%.1f,",
+                p50, p99, mean, max, throughput);
+        (allocations_per_op < 0) ? fprintf(bench_json, "\"allocations\":null}")
+                                 : fprintf(bench_json, "\"allocations\":%.2f}", allocations_per_op);
+        bench_json_first = false;
+    }
+
+    fflush(NULL);
+}
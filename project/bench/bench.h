@@ -0,0 +1,84 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "util/util_stopwatch.h"
+
+#define BENCH_NAME_LENGTH 32
+#define BENCH_NAME_WIDTH 42
+#define BENCH_PARAMS_LENGTH 64
+#define BENCH_ARG_OUTPUT "-o"
+#define BENCH_ARG_ITERATIONS "-n"
+#define BENCH_NO_ALLOCATIONS -1.0
+
+/**
+ * Struct Bench Samples, the measured durations of a benchmark
+ */
+typedef struct BenchSamples {
+    double *values;
+    size_t size;
+    size_t capacity;
+} BenchSamples;
+
+/**
+ * Parse the common benchmark arguments
+ *  -o <prefix> Write results to <prefix>.csv & <prefix>.json
+ *  -n <iterations> Number of iterations
+ * @param argc Number of arguments
+ * @param args Arguments
+ * @param iterations The iterations, untouched if not passed
+ * @return true if valid, false otherwise
+ */
+bool bench_arguments(int argc, char **args, size_t *iterations);
+
+/**
+ * Print the results header and open the result files, if any
+ * @param suite The benchmark suite name
+ */
+void bench_begin(const char *suite);
+
+/**
+ * Close the result files
+ */
+void bench_end(void);
+
+/**
+ * Create and return a Bench Samples
+ * @param capacity The initial capacity
+ * @return The new Bench Samples
+ */
+BenchSamples *new_bench_samples(size_t capacity);
+
+/**
+ * Free a Bench Samples
+ * @param samples The Bench Samples
+ */
+void free_bench_samples(BenchSamples *samples);
+
+/**
+ * Add a measured duration
+ * @param samples The Bench Samples
+ * @param ns The duration in nanoseconds
+ */
+void bench_samples_add(BenchSamples *samples, double ns);
+
+/**
+ * Number of malloc, calloc and realloc calls done so far
+ *  Calls are counted through the linker --wrap option, see the bench rule of the Makefile
+ * @return The number of allocations
+ */
+unsigned long bench_allocations(void);
+
+/**
+ * Report a benchmark, samples are sorted in place
+ * @param name The benchmark name
+ * @param params The benchmark parameters
+ * @param samples The measured durations
+ * @param ops_per_sample Operations done in every sample, durations are reported per operation
+ * @param allocations_per_op Allocations per operation, BENCH_NO_ALLOCATIONS if not measured
+ */
+void bench_report(const char *name, const char *params, BenchSamples *samples, size_t ops_per_sample,
+                  double allocations_per_op);
+
+#endif
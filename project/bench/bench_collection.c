@@ -0,0 +1,401 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "collection/collection_list.h"
+#include "collection/collection_trie.h"
+#include "device/device_communication.h"
+#include "util/util_converter.h"
+
+#define BENCH_COLLECTION_SAMPLES 20
+#define BENCH_COLLECTION_BATCH 1000
+#define BENCH_COLLECTION_LOOKUPS 100
+#define BENCH_COLLECTION_SEED 42
+#define BENCH_COLLECTION_WORD_LENGTH 16
+#define BENCH_COLLECTION_WORD_LENGTH_MIN 4
+#define BENCH_COLLECTION_WORD_LENGTH_MAX 12
+#define BENCH_COLLECTION_PREFIX_LENGTH 3
+#define BENCH_COLLECTION_TRIE_RESULT_LENGTH 100
+
+/**
+ * A word of the Trie benchmarks
+ */
+typedef char BenchCollectionWord[BENCH_COLLECTION_WORD_LENGTH];
+
+/**
+ * Elements in the collections
+ */
+static const size_t bench_collection_sizes[] = {10, 100, 1000, 10000, 100000};
+
+/**
+ * Measurement in progress, allocations are counted only while the Stopwatch runs
+ */
+static Stopwatch bench_collection_start;
+static unsigned long bench_collection_start_allocations;
+static unsigned long bench_collection_allocations;
+
+/**
+ * Start measuring a sample
+ */
+static void bench_collection_sample_begin(void);
+
+/**
+ * Stop measuring a sample and add it
+ * @param samples The Bench Samples
+ */
+static void bench_collection_sample_end(BenchSamples *samples);
+
+/**
+ * Report the samples and reset them for the next benchmark
+ * @param name The benchmark name
+ * @param params The benchmark parameters
+ * @param samples The Bench Samples
+ * @param ops_per_sample Operations done in every sample
+ */
+static void bench_collection_report(const char *name, const char *params, BenchSamples *samples,
+                                    size_t ops_per_sample);
+
+/**
+ * Compare two int values, the equals of the benchmarked Lists
+ * @param data_1 First value
+ * @param data_2 Second value
+ * @return true if equals, false otherwise
+ */
+static bool bench_collection_equals(const void *data_1, const void *data_2);
+
+/**
+ * Allocate an int value
+ * @param value The value
+ * @return The allocated value
+ */
+static int *bench_collection_int(int value);
+
+/**
+ * Create a List with the values [0, size)
+ * @param size The size of the List
+ * @return The List
+ */
+static List *bench_collection_list(size_t size);
+
+/**
+ * Return a random value in [0, bound)
+ * @param bound The bound
+ * @return The random value
+ */
+static size_t bench_collection_random(size_t bound);
+
+/**
+ * Benchmark List operations on a List of size elements
+ * @param size The List size
+ * @param samples The Bench Samples
+ */
+static void bench_collection_list_all(size_t size, BenchSamples *samples);
+
+/**
+ * Benchmark Trie operations on a Trie of size words
+ * @param size The Trie size
+ * @param samples The Bench Samples
+ */
+static void bench_collection_trie_all(size_t size, BenchSamples *samples);
+
+/**
+ * Benchmark the converters
+ * @param samples The Bench Samples
+ */
+static void bench_collection_converter_all(BenchSamples *samples);
+
+/**
+ * Benchmark the split of messages with different number of fields
+ * @param samples The Bench Samples
+ */
+static void bench_collection_split_all(BenchSamples *samples);
+
+/**
+ * Number of samples of every benchmark
+ */
+static size_t bench_collection_samples = BENCH_COLLECTION_SAMPLES;
+
+int main(int argc, char **args) {
+    BenchSamples *samples;
+    size_t i;
+
+    if (!bench_arguments(argc, args, &bench_collection_samples)) return EXIT_FAILURE;
+
+    srand(BENCH_COLLECTION_SEED);
+    samples = new_bench_samples(bench_collection_samples);
+
+    bench_begin("collection");
+    for (i = 0; i < sizeof(bench_collection_sizes) / sizeof(size_t); ++i) {
+        bench_collection_list_all(bench_collection_sizes[i], samples);
+    }
+    for (i = 0; i < sizeof(bench_collection_sizes) / sizeof(size_t); ++i) {
+        bench_collection_trie_all(bench_collection_sizes[i], samples);
+    }
+    bench_collection_converter_all(samples);
+    bench_collection_split_all(samples);
+    bench_end();
+
+    free_bench_samples(samples);
+
+    return EXIT_SUCCESS;
+}
+
+static void bench_collection_sample_begin(void) {
+    bench_collection_start_allocations = bench_allocations();
+    bench_collection_start = stopwatch_now();
+}
+
+static void bench_collection_sample_end(BenchSamples *samples) {
+    Stopwatch elapsed = stopwatch_elapsed(bench_collection_start);
+
+    bench_collection_allocations += bench_allocations() - bench_collection_start_allocations;
+    bench_samples_add(samples, (double) elapsed);
+}
+
+static void bench_collection_report(const char *name, const char *params, BenchSamples *samples,
+                                    size_t ops_per_sample) {
+    bench_report(name, params, samples, ops_per_sample,
+                 (double) bench_collection_allocations / ((double) ops_per_sample * samples->size));
+    samples->size = 0;
+    bench_collection_allocations = 0;
+}
+
+static bool bench_collection_equals(const void *data_1, const void *data_2) {
+    return *(const int *) data_1 == *(const int *) data_2;
+}
+
+static int *bench_collection_int(int value) {
+    int *data = (int *) malloc(sizeof(int));
+    if (data == NULL) {
+        perror("Bench Collection Int Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    *data = value;
+    return data;
+}
+
+static List *bench_collection_list(size_t size) {
+    List *list = new_list(NULL, bench_collection_equals);
+    size_t i;
+
+    for (i = 0; i < size; ++i) list_add_last(list, bench_collection_int((int) i));
+
+    return list;
+}
+
+static size_t bench_collection_random(size_t bound) {
+    return (size_t) (((unsigned long) rand() * ((unsigned long) RAND_MAX + 1) + (unsigned long) rand()) % bound);
+}
+
+static void bench_collection_list_all(size_t size, BenchSamples *samples) {
+    List *list;
+    int **values;
+    int keys[BENCH_COLLECTION_LOOKUPS];
+    size_t batch = (size < BENCH_COLLECTION_LOOKUPS) ? size : BENCH_COLLECTION_LOOKUPS;
+    char params[BENCH_PARAMS_LENGTH];
+    size_t sample;
+    size_t i;
+
+    snprintf(params, BENCH_PARAMS_LENGTH, "size=%ld", size);
+
+    /* list_add_last: build the whole List, elements are allocated before */
+    values = (int **) malloc(sizeof(int *) * size);
+    if (values == NULL) {
+        perror("Bench Collection Values Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        for (i = 0; i < size; ++i) values[i] = bench_collection_int((int) i);
+        list = new_list(NULL, bench_collection_equals);
+
+        bench_collection_sample_begin();
+        for (i = 0; i < size; ++i) list_add_last(list, values[i]);
+        bench_collection_sample_end(samples);
+
+        free_list(list);
+    }
+    bench_collection_report("list_add_last", params, samples, size);
+    free(values);
+
+    list = bench_collection_list(size);
+
+    /* list_get: random indexes */
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        for (i = 0; i < batch; ++i) keys[i] = (int) bench_collection_random(size);
+
+        bench_collection_sample_begin();
+        for (i = 0; i < batch; ++i) list_get(list, (size_t) keys[i]);
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("list_get", params, samples, batch);
+
+    /* list_get_index: random values */
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        for (i = 0; i < batch; ++i) keys[i] = (int) bench_collection_random(size);
+
+        bench_collection_sample_begin();
+        for (i = 0; i < batch; ++i) list_get_index(list, &keys[i]);
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("list_get_index", params, samples, batch);
+
+    /* list_contains: random values */
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        for (i = 0; i < batch; ++i) keys[i] = (int) bench_collection_random(size);
+
+        bench_collection_sample_begin();
+        for (i = 0; i < batch; ++i) list_contains(list, &keys[i]);
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("list_contains", params, samples, batch);
+
+    /* list_remove: distinct random values, put back after every sample */
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        for (i = 0; i < batch; ++i) {
+            size_t j;
+
+            do {
+                keys[i] = (int) bench_collection_random(size);
+                for (j = 0; j < i && keys[j] != keys[i]; ++j);
+            } while (j < i);
+        }
+
+        bench_collection_sample_begin();
+        for (i = 0; i < batch; ++i) list_remove(list, &keys[i]);
+        bench_collection_sample_end(samples);
+
+        for (i = 0; i < batch; ++i) list_add_last(list, bench_collection_int(keys[i]));
+    }
+    bench_collection_report("list_remove", params, samples, batch);
+
+    free_list(list);
+}
+
+static void bench_collection_trie_all(size_t size, BenchSamples *samples) {
+    Trie *trie;
+    BenchCollectionWord *words;
+    BenchCollectionWord prefixes[BENCH_COLLECTION_BATCH];
+    char result[BENCH_COLLECTION_TRIE_RESULT_LENGTH];
+    size_t batch = (size < BENCH_COLLECTION_BATCH) ? size : BENCH_COLLECTION_BATCH;
+    char params[BENCH_PARAMS_LENGTH];
+    size_t sample;
+    size_t length;
+    size_t i;
+    size_t j;
+
+    snprintf(params, BENCH_PARAMS_LENGTH, "size=%ld", size);
+
+    words = (BenchCollectionWord *) malloc(sizeof(BenchCollectionWord) * size);
+    if (words == NULL) {
+        perror("Bench Collection Words Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < size; ++i) {
+        length = BENCH_COLLECTION_WORD_LENGTH_MIN +
+                 bench_collection_random(BENCH_COLLECTION_WORD_LENGTH_MAX - BENCH_COLLECTION_WORD_LENGTH_MIN + 1);
+        for (j = 0; j < length; ++j) words[i][j] = (char) (TRIE_ALPHABET_FIRST + bench_collection_random(TRIE_ALPHABET));
+        words[i][length] = '\0';
+    }
+
+    /* trie_insert: build the whole Trie */
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        trie = new_trie(NULL, NULL);
+
+        bench_collection_sample_begin();
+        for (i = 0; i < size; ++i) trie_insert(trie, words[i], 1);
+        bench_collection_sample_end(samples);
+
+        free_trie(trie);
+    }
+    bench_collection_report("trie_insert", params, samples, size);
+
+    trie = new_trie(NULL, NULL);
+    for (i = 0; i < size; ++i) trie_insert(trie, words[i], 1);
+
+    /* trie_search: complete the prefix of random words, like autocomplete */
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        for (i = 0; i < batch; ++i) {
+            strncpy(prefixes[i], words[bench_collection_random(size)], BENCH_COLLECTION_PREFIX_LENGTH);
+            prefixes[i][BENCH_COLLECTION_PREFIX_LENGTH] = '\0';
+        }
+
+        bench_collection_sample_begin();
+        for (i = 0; i < batch; ++i) {
+            result[0] = '\0';
+            trie_search(trie->root, prefixes[i], result);
+        }
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("trie_search", params, samples, batch);
+
+    free_trie(trie);
+    free(words);
+}
+
+static void bench_collection_converter_all(BenchSamples *samples) {
+    char longs[BENCH_COLLECTION_BATCH][BENCH_COLLECTION_WORD_LENGTH];
+    char doubles[BENCH_COLLECTION_BATCH][BENCH_COLLECTION_WORD_LENGTH];
+    char dates[BENCH_COLLECTION_BATCH][CONVERTER_DATA_STRING_LENGTH];
+    size_t sample;
+    size_t i;
+
+    for (i = 0; i < BENCH_COLLECTION_BATCH; ++i) {
+        snprintf(longs[i], BENCH_COLLECTION_WORD_LENGTH, "%ld", (long) bench_collection_random(1000000));
+        snprintf(doubles[i], BENCH_COLLECTION_WORD_LENGTH, "%.3f", bench_collection_random(1000000) / 1000.0);
+        snprintf(dates[i], CONVERTER_DATA_STRING_LENGTH, "2099-%02ld-%02ld_%02ld:%02ld:%02ld",
+                 1 + bench_collection_random(12), 1 + bench_collection_random(28), bench_collection_random(24),
+                 bench_collection_random(60), bench_collection_random(60));
+    }
+
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        bench_collection_sample_begin();
+        for (i = 0; i < BENCH_COLLECTION_BATCH; ++i) converter_string_to_long(longs[i]);
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("converter_string_to_long", "-", samples, BENCH_COLLECTION_BATCH);
+
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        bench_collection_sample_begin();
+        for (i = 0; i < BENCH_COLLECTION_BATCH; ++i) converter_string_to_double(doubles[i]);
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("converter_string_to_double", "-", samples, BENCH_COLLECTION_BATCH);
+
+    for (sample = 0; sample < bench_collection_samples; ++sample) {
+        bench_collection_sample_begin();
+        for (i = 0; i < BENCH_COLLECTION_BATCH; ++i) converter_string_to_date(dates[i]);
+        bench_collection_sample_end(samples);
+    }
+    bench_collection_report("converter_string_to_date", "-", samples, BENCH_COLLECTION_BATCH);
+}
+
+static void bench_collection_split_all(BenchSamples *samples) {
+    const size_t fields[] = {1, 4, DEVICE_COMMUNICATION_MESSAGE_FIELDS_MAX};
+    char message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    char params[BENCH_PARAMS_LENGTH];
+    size_t used;
+    size_t sample;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < sizeof(fields) / sizeof(size_t); ++i) {
+        /* Fields like the ones of an info record */
+        for (j = 0, used = 0; j < fields[i]; ++j) {
+            used += snprintf(message + used, DEVICE_COMMUNICATION_MESSAGE_LENGTH - used, "%ld.%03ld%s",
+                             (long) bench_collection_random(1000), (long) bench_collection_random(1000),
+                             DEVICE_COMMUNICATION_MESSAGE_FIELDS_DELIMITER);
+        }
+
+        for (sample = 0; sample < bench_collection_samples; ++sample) {
+            bench_collection_sample_begin();
+            for (j = 0; j < BENCH_COLLECTION_BATCH; ++j) {
+                device_communication_free_message_fields(device_communication_split_message_fields(message));
+            }
+            bench_collection_sample_end(samples);
+        }
+
+        snprintf(params, BENCH_PARAMS_LENGTH, "fields=%ld", fields[i]);
+        bench_collection_report("device_communication_split_message_fields", params, samples,
+                                BENCH_COLLECTION_BATCH);
+    }
+}
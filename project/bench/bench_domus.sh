@@ -0,0 +1,174 @@
+#!/bin/sh
+# -------------------------
+# DOMUS END-TO-END BENCHMARK
+# -------------------------
+# Build parameterized topologies, run them through Domus in batch mode and
+# report the latency of every command as CSV & JSON.
+#
+# Usage: bench_domus.sh <bin_dir> <out_dir> [name]
+#
+# Environment:
+#   BENCH_TOPOLOGIES  Topologies to run           (default: "flat hub chain")
+#   BENCH_SIZES       Number of devices per run    (default: "10 100 1000")
+#   BENCH_FANOUT      Bulbs per hub in hub         (default: 10)
+#   BENCH_SAMPLES     Repetitions of read commands (default: 10)
+
+set -e
+
+BIN_DIR=${1:?"bin directory required"}
+OUT_DIR=${2:?"output directory required"}
+NAME=${3:-domus}
+
+TOPOLOGIES=${BENCH_TOPOLOGIES:-"flat hub chain"}
+SIZES=${BENCH_SIZES:-"10 100 1000"}
+FANOUT=${BENCH_FANOUT:-10}
+SAMPLES=${BENCH_SAMPLES:-10}
+
+# Ids are assigned in order starting from 2, 1 is the Controller
+CONTROLLER_ID=1
+FIRST_ID=2
+
+mkdir -p "$OUT_DIR"
+OUT_DIR=$(cd "$OUT_DIR" && pwd)
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+CSV="$OUT_DIR/$NAME.csv"
+JSON="$OUT_DIR/$NAME.json"
+
+# -------------------------
+# TOPOLOGIES
+# -------------------------
+
+# flat: <n> bulbs connected to the Controller
+topology_flat() {
+    n=$1
+    i=0
+    while [ $i -lt "$n" ]; do echo "add bulb"; i=$((i + 1)); done
+    i=0
+    while [ $i -lt "$n" ]; do echo "link $((FIRST_ID + i)) to $CONTROLLER_ID"; i=$((i + 1)); done
+    BULBS=$(seq $FIRST_ID $((FIRST_ID + n - 1)))
+}
+
+# hub: <n> devices, hubs connected to the Controller each with <fanout> bulbs
+topology_hub() {
+    n=$1
+    hubs=$(( (n + FANOUT) / (FANOUT + 1) ))
+    bulbs=$((n - hubs))
+    i=0
+    while [ $i -lt "$hubs" ]; do echo "add hub"; i=$((i + 1)); done
+    i=0
+    while [ $i -lt "$bulbs" ]; do echo "add bulb"; i=$((i + 1)); done
+    i=0
+    while [ $i -lt "$hubs" ]; do echo "link $((FIRST_ID + i)) to $CONTROLLER_ID"; i=$((i + 1)); done
+    i=0
+    while [ $i -lt "$bulbs" ]; do
+        echo "link $((FIRST_ID + hubs + i)) to $((FIRST_ID + i % hubs))"
+        i=$((i + 1))
+    done
+    BULBS=$(seq $((FIRST_ID + hubs)) $((FIRST_ID + n - 1)))
+}
+
+# chain: <n> - 1 timers each connected to the previous one, a bulb at the bottom
+topology_chain() {
+    n=$1
+    i=0
+    while [ $i -lt $((n - 1)) ]; do echo "add timer"; i=$((i + 1)); done
+    echo "add bulb"
+    echo "link $FIRST_ID to $CONTROLLER_ID"
+    i=1
+    while [ $i -lt "$n" ]; do echo "link $((FIRST_ID + i)) to $((FIRST_ID + i - 1))"; i=$((i + 1)); done
+    BULBS=$((FIRST_ID + n - 1))
+}
+
+# -------------------------
+# SCRIPT
+# -------------------------
+
+# Build the whole script of a run: topology, reads, switches and deletion
+bench_script() {
+    topology=$1
+    n=$2
+
+    "topology_$topology" "$n"
+
+    i=0
+    while [ $i -lt "$SAMPLES" ]; do
+        echo "list"
+        echo "hierarchy"
+        echo "info $((FIRST_ID + (i * n / SAMPLES) % n))"
+        i=$((i + 1))
+    done
+    for id in $BULBS; do echo "switch $id turn off"; done
+    for id in $BULBS; do echo "switch $id turn on"; done
+    i=0
+    while [ $i -lt "$SAMPLES" ] && [ $i -lt "$n" ]; do
+        echo "del $((FIRST_ID + n - 1 - i))"
+        i=$((i + 1))
+    done
+    echo "del --all"
+    echo "exit"
+}
+
+# -------------------------
+# REPORT
+# -------------------------
+
+# Append the statistics of a timing file to the CSV & JSON results
+# p50/p99 use the nearest rank, throughput is commands per second
+bench_report() {
+    topology=$1
+    n=$2
+    timing=$3
+
+    for command in $(cut -d, -f1 "$timing" | grep -v "^exit$" | sort -u); do
+        grep "^$command," "$timing" | cut -d, -f2 | sort -g | awk \
+            -v topology="$topology" -v devices="$n" -v command="$command" \
+            -v csv="$CSV" -v json="$JSON" '
+            { value[NR] = $1; total += $1 }
+            END {
+                p50 = value[int(NR * 0.50 + 0.999999)]
+                p99 = value[int(NR * 0.99 + 0.999999)]
+                throughput = (total > 0) ? NR / (total / 1000) : 0
+                printf "%s,%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%.1f\n", topology, devices, command, NR, total,
+                       p50, p99, value[NR], throughput >> csv
+                printf "{\"topology\":\"%s\",\"devices\":%d,\"command\":\"%s\",\"count\":%d,\"total_ms\":%.3f,", \
+                       topology, devices, command, NR, total >> json
+                printf "\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,\"throughput\":%.1f}\n", \
+                       p50, p99, value[NR], throughput >> json
+                printf "\t%-8s %6d  %-10s %6d  %10.3f  %10.3f  %10.3f  %10.1f\n", topology, devices, command, NR,
+                       p50, p99, value[NR], throughput
+            }'
+    done
+}
+
+# -------------------------
+# RUN
+# -------------------------
+
+echo "topology,devices,command,count,total_ms,p50_ms,p99_ms,max_ms,throughput" > "$CSV"
+: > "$JSON.tmp"
+JSON_FINAL=$JSON
+JSON="$JSON.tmp"
+
+printf "\t%-8s %6s  %-10s %6s  %10s  %10s  %10s  %10s\n" "TOPOLOGY" "N" "COMMAND" "COUNT" "P50(ms)" "P99(ms)" \
+       "MAX(ms)" "OPS/s"
+
+cd "$BIN_DIR"
+for topology in $TOPOLOGIES; do
+    for n in $SIZES; do
+        bench_script "$topology" "$n" > "$WORK_DIR/script"
+        ./domus --script "$WORK_DIR/script" --timing "$WORK_DIR/timing" < /dev/null > /dev/null 2>&1
+        bench_report "$topology" "$n" "$WORK_DIR/timing"
+    done
+done
+
+# One JSON array of result objects
+{
+    echo "["
+    sed '$!s/$/,/' "$JSON"
+    echo "]"
+} > "$JSON_FINAL"
+rm -f "$JSON"
+
+echo "Results written to $CSV and $JSON_FINAL"
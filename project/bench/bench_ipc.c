@@ -0,0 +1,348 @@
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "bench.h"
+#include "device/device_communication.h"
+
+#define BENCH_IPC_ITERATIONS 10000
+#define BENCH_IPC_WARMUP 100
+/* A Queue number different from Domus, a running Domus is not disturbed */
+#define BENCH_IPC_QUEUE_NUMBER 42
+#define BENCH_IPC_QUEUE_TYPE_REQUEST 1
+#define BENCH_IPC_QUEUE_TYPE_REPLY 2
+
+/**
+ * The volatile variable for knowing if the node process must continue or die
+ */
+static volatile sig_atomic_t bench_ipc_run = true;
+
+/**
+ * Node only: the Device Communication with the parent
+ */
+static DeviceCommunication *bench_ipc_parent = NULL;
+
+/**
+ * Node only: the Device Communication with the next node of the chain, NULL if last
+ */
+static DeviceCommunication *bench_ipc_next = NULL;
+
+/**
+ * Node only: records sent for every info request, like a Control Device answering for its children
+ */
+static size_t bench_ipc_records = 1;
+
+/**
+ * Spawn a chain of echo nodes, like a chain of Control Devices
+ * @param depth The number of nodes in the chain
+ * @param records The records sent back by the last node for every info request
+ * @return The Device Communication with the first node
+ */
+static DeviceCommunication *bench_ipc_spawn(size_t depth, size_t records);
+
+/**
+ * Node loop, wait for messages until a terminate message is received
+ */
+static void bench_ipc_node_run(void);
+
+/**
+ * Node handler for DEVICE_COMMUNICATION_READ_PIPE
+ *  Forward the message to the next node, if any, otherwise echo it
+ * @param signal_number The signal number
+ */
+static void bench_ipc_node_read_pipe(int signal_number);
+
+/**
+ * Terminate a chain of nodes
+ * @param device_communication The Device Communication with the first node
+ */
+static void bench_ipc_terminate(DeviceCommunication *device_communication);
+
+/**
+ * Initialize a message with a payload
+ * @param message The message
+ * @param payload The payload length
+ */
+static void bench_ipc_message(DeviceCommunicationMessage *message, size_t payload);
+
+/**
+ * Measure pipe + signal round trips from a root to <fanout> chains of <depth> nodes
+ * @param iterations The iterations
+ * @param payload The payload length
+ * @param fanout The number of chains
+ * @param depth The number of nodes in every chain
+ */
+static void bench_ipc_pipe(size_t iterations, size_t payload, size_t fanout, size_t depth);
+
+/**
+ * Measure multi-record replies, every record is acknowledged by the reader
+ * @param iterations The iterations
+ * @param records The records of every reply
+ */
+static void bench_ipc_pipe_stream(size_t iterations, size_t records);
+
+/**
+ * Measure SysV Queue Message round trips, the transport of Domus Manual
+ * @param iterations The iterations
+ * @param payload The payload length
+ */
+static void bench_ipc_queue(size_t iterations, size_t payload);
+
+int main(int argc, char **args) {
+    size_t iterations = BENCH_IPC_ITERATIONS;
+    const size_t payloads[] = {0, 64, DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1};
+    const size_t fanouts[] = {1, 4, 16};
+    const size_t depths[] = {1, 2, 4, 8};
+    const size_t records[] = {1, 16, 64};
+    const size_t queue_payloads[] = {0, 64, QUEUE_MESSAGE_MESSAGE_LENGTH - 1};
+    size_t i;
+
+    if (!bench_arguments(argc, args, &iterations)) return EXIT_FAILURE;
+
+    bench_begin("ipc");
+    for (i = 0; i < sizeof(payloads) / sizeof(size_t); ++i) bench_ipc_pipe(iterations, payloads[i], 1, 1);
+    for (i = 1; i < sizeof(fanouts) / sizeof(size_t); ++i) bench_ipc_pipe(iterations, 64, fanouts[i], 1);
+    for (i = 1; i < sizeof(depths) / sizeof(size_t); ++i) bench_ipc_pipe(iterations, 64, 1, depths[i]);
+    for (i = 0; i < sizeof(records) / sizeof(size_t); ++i) bench_ipc_pipe_stream(iterations, records[i]);
+    for (i = 0; i < sizeof(queue_payloads) / sizeof(size_t); ++i) bench_ipc_queue(iterations, queue_payloads[i]);
+    bench_end();
+
+    return EXIT_SUCCESS;
+}
+
+static DeviceCommunication *bench_ipc_spawn(size_t depth, size_t records) {
+    DeviceCommunication *device_communication;
+    pid_t pid;
+    int write_parent_read_child[2];
+    int write_child_read_parent[2];
+
+    if (pipe(write_parent_read_child) == -1 || pipe(write_child_read_parent) == -1) {
+        perror("Bench IPC Pipe");
+        exit(EXIT_FAILURE);
+    }
+
+    switch (pid = fork()) {
+        case -1: {
+            perror("Bench IPC Fork");
+            exit(EXIT_FAILURE);
+        }
+        case 0: {
+            close(write_parent_read_child[1]);
+            close(write_child_read_parent[0]);
+
+            bench_ipc_parent = new_device_communication(getppid(), write_parent_read_child[0],
+                                                        write_child_read_parent[1]);
+            bench_ipc_next = (depth > 1) ? bench_ipc_spawn(depth - 1, records) : NULL;
+            bench_ipc_records = records;
+            bench_ipc_node_run();
+            exit(EXIT_SUCCESS);
+        }
+        default: {
+            close(write_parent_read_child[0]);
+            close(write_child_read_parent[1]);
+            break;
+        }
+    }
+
+    device_communication = new_device_communication(pid, write_child_read_parent[0], write_parent_read_child[1]);
+    if (device_communication_read_message(device_communication).type != MESSAGE_TYPE_I_AM_ALIVE) {
+        fprintf(stderr, "Bench IPC: node %d is not alive\n", pid);
+        exit(EXIT_FAILURE);
+    }
+
+    return device_communication;
+}
+
+static void bench_ipc_node_run(void) {
+    DeviceCommunicationMessage out_message;
+    sigset_t read_pipe_mask;
+    sigset_t wait_mask;
+
+    /* Same wait as device_child_run: messages are handled only while waiting */
+    sigemptyset(&read_pipe_mask);
+    sigaddset(&read_pipe_mask, DEVICE_COMMUNICATION_READ_PIPE);
+    sigprocmask(SIG_BLOCK, &read_pipe_mask, &wait_mask);
+    sigdelset(&wait_mask, DEVICE_COMMUNICATION_READ_PIPE);
+    signal(DEVICE_COMMUNICATION_READ_PIPE, bench_ipc_node_read_pipe);
+
+    bench_ipc_message(&out_message, 0);
+    out_message.type = MESSAGE_TYPE_I_AM_ALIVE;
+    device_communication_write_message(bench_ipc_parent, &out_message);
+
+    while (bench_ipc_run) {
+        sigsuspend(&wait_mask);
+    }
+
+    if (bench_ipc_next != NULL) device_communication_close_communication(bench_ipc_next);
+}
+
+static void bench_ipc_node_read_pipe(int signal_number) {
+    DeviceCommunicationMessage in_message;
+    DeviceCommunicationMessage out_message;
+    size_t i;
+    if (signal_number != DEVICE_COMMUNICATION_READ_PIPE) return;
+
+    in_message = device_communication_read_message(bench_ipc_parent);
+    out_message = (bench_ipc_next != NULL) ? device_communication_write_message_with_ack(bench_ipc_next, &in_message)
+                                           : in_message;
+
+    if (in_message.type == MESSAGE_TYPE_TERMINATE) {
+        bench_ipc_run = false;
+    } else if (in_message.type == MESSAGE_TYPE_INFO) {
+        /* All records but the last wait for the reader to ask the next one */
+        out_message.flag_continue = true;
+        for (i = 1; i < bench_ipc_records; ++i) {
+            device_communication_write_message_with_ack_silent(bench_ipc_parent, &out_message);
+        }
+        out_message.flag_continue = false;
+    }
+
+    device_communication_write_message(bench_ipc_parent, &out_message);
+}
+
+static void bench_ipc_terminate(DeviceCommunication *device_communication) {
+    DeviceCommunicationMessage out_message;
+
+    bench_ipc_message(&out_message, 0);
+    out_message.type = MESSAGE_TYPE_TERMINATE;
+    device_communication_write_message_with_ack(device_communication, &out_message);
+    device_communication_close_communication(device_communication);
+    free(device_communication);
+}
+
+static void bench_ipc_message(DeviceCommunicationMessage *message, size_t payload) {
+    memset(message, 0, sizeof(DeviceCommunicationMessage));
+
+    message->type = MESSAGE_TYPE_SWITCH;
+    if (payload >= DEVICE_COMMUNICATION_MESSAGE_LENGTH) payload = DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1;
+    memset(message->message, 'x', payload);
+    message->message[payload] = '\0';
+}
+
+static void bench_ipc_pipe(size_t iterations, size_t payload, size_t fanout, size_t depth) {
+    DeviceCommunication **nodes;
+    DeviceCommunicationMessage out_message;
+    BenchSamples *samples;
+    Stopwatch start;
+    char params[BENCH_PARAMS_LENGTH];
+    size_t i;
+    size_t j;
+
+    nodes = (DeviceCommunication **) malloc(sizeof(DeviceCommunication *) * fanout);
+    if (nodes == NULL) {
+        perror("Bench IPC Nodes Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+    for (j = 0; j < fanout; ++j) nodes[j] = bench_ipc_spawn(depth, 1);
+
+    bench_ipc_message(&out_message, payload);
+    samples = new_bench_samples(iterations);
+
+    for (i = 0; i < BENCH_IPC_WARMUP + iterations; ++i) {
+        start = stopwatch_now();
+        for (j = 0; j < fanout; ++j) device_communication_write_message_with_ack(nodes[j], &out_message);
+        if (i >= BENCH_IPC_WARMUP) bench_samples_add(samples, (double) stopwatch_elapsed(start));
+    }
+
+    snprintf(params, BENCH_PARAMS_LENGTH, "payload=%ld fanout=%ld depth=%ld", payload, fanout, depth);
+    bench_report("pipe_round_trip", params, samples, fanout, BENCH_NO_ALLOCATIONS);
+
+    for (j = 0; j < fanout; ++j) bench_ipc_terminate(nodes[j]);
+    free(nodes);
+    free_bench_samples(samples);
+}
+
+static void bench_ipc_pipe_stream(size_t iterations, size_t records) {
+    DeviceCommunication *node;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationMessage in_message;
+    BenchSamples *samples;
+    Stopwatch start;
+    char params[BENCH_PARAMS_LENGTH];
+    size_t i;
+
+    node = bench_ipc_spawn(1, records);
+    bench_ipc_message(&out_message, 0);
+    out_message.type = MESSAGE_TYPE_INFO;
+    samples = new_bench_samples(iterations);
+
+    for (i = 0; i < BENCH_IPC_WARMUP + iterations; ++i) {
+        start = stopwatch_now();
+        in_message = device_communication_write_message_with_ack(node, &out_message);
+        while (in_message.flag_continue) {
+            in_message = device_communication_write_message_with_ack_silent(node, &out_message);
+        }
+        if (i >= BENCH_IPC_WARMUP) bench_samples_add(samples, (double) stopwatch_elapsed(start));
+    }
+
+    snprintf(params, BENCH_PARAMS_LENGTH, "records=%ld", records);
+    bench_report("pipe_stream", params, samples, records, BENCH_NO_ALLOCATIONS);
+
+    bench_ipc_terminate(node);
+    free_bench_samples(samples);
+}
+
+static void bench_ipc_queue(size_t iterations, size_t payload) {
+    Queue_message *request;
+    Queue_message *reply;
+    Message *in_message;
+    BenchSamples *samples;
+    Stopwatch start;
+    char text[QUEUE_MESSAGE_MESSAGE_LENGTH];
+    char params[BENCH_PARAMS_LENGTH];
+    pid_t pid;
+    size_t i;
+
+    if (payload >= QUEUE_MESSAGE_MESSAGE_LENGTH) payload = QUEUE_MESSAGE_MESSAGE_LENGTH - 1;
+    memset(text, 'x', payload);
+    text[payload] = '\0';
+
+    queue_message_create_queue();
+    request = new_queue_message(QUEUE_MESSAGE_QUEUE_NAME, BENCH_IPC_QUEUE_NUMBER, BENCH_IPC_QUEUE_TYPE_REQUEST, text,
+                                true);
+
+    switch (pid = fork()) {
+        case -1: {
+            perror("Bench IPC Fork");
+            exit(EXIT_FAILURE);
+        }
+        case 0: {
+            /* Echo every request, allocating like a Device does */
+            while (true) {
+                in_message = queue_message_receive_message(request->message_id, BENCH_IPC_QUEUE_TYPE_REQUEST, false);
+                reply = new_queue_message(QUEUE_MESSAGE_QUEUE_NAME, BENCH_IPC_QUEUE_NUMBER,
+                                          BENCH_IPC_QUEUE_TYPE_REPLY, in_message->mesg_text, false);
+                queue_message_send_message(reply);
+                free(reply);
+                free(in_message);
+            }
+        }
+        default: {
+            break;
+        }
+    }
+
+    samples = new_bench_samples(iterations);
+
+    /*
+     * queue_message_send_message_with_ack waits the reply with pause(), a notification arriving before it
+     * would hang the benchmark, the reply is awaited with a blocking receive instead
+     */
+    for (i = 0; i < BENCH_IPC_WARMUP + iterations; ++i) {
+        start = stopwatch_now();
+        queue_message_send_message(request);
+        queue_message_notify(pid);
+        in_message = queue_message_receive_message(request->message_id, BENCH_IPC_QUEUE_TYPE_REPLY, false);
+        if (i >= BENCH_IPC_WARMUP) bench_samples_add(samples, (double) stopwatch_elapsed(start));
+        free(in_message);
+    }
+
+    snprintf(params, BENCH_PARAMS_LENGTH, "payload=%ld", payload);
+    bench_report("queue_round_trip", params, samples, 1, BENCH_NO_ALLOCATIONS);
+
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    queue_message_remove_message_queue(request->message_id);
+    free(request);
+    free_bench_samples(samples);
+}
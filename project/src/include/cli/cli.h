@@ -1,6 +1,8 @@
 #ifndef _CLI_H
 #define _CLI_H
 
+#include <stdbool.h>
+
 #define CLI_POINTER ">"
 #define CLI_CONTINUE 1
 #define CLI_TERMINATE 0
@@ -12,8 +14,12 @@
 #define CLI_CHARACTER_EXIT 3
 #define CLI_CHARACTER_TAB 9
 #define CLI_CHARACTER_MINUS 45
+#define CLI_CHARACTER_DOT 46
+#define CLI_CHARACTER_SLASH 47
 #define CLI_CHARACTER_CARRIAGE_RETURN 13
 #define CLI_CHARACTER_SPACE 32
+#define CLI_CHARACTER_AMPERSAND 38
+#define CLI_CHARACTER_COMMENT 35
 #define CLI_CHARACTER_COLON 58
 #define CLI_CHARACTER_QUESTION_MARK 63
 #define CLI_CHARACTER_UP_ARROW 65
@@ -27,4 +33,40 @@
  */
 void cli_start(void);
 
+/**
+ * Check if the CLI reads commands from a terminal using the line editor
+ * @return true if interactive, false if in batch mode
+ */
+bool cli_is_interactive(void);
+
+/**
+ * Read commands from a script file in batch mode instead of stdin
+ * @param file_name The script file name
+ * @return true if the script has been opened, false otherwise
+ */
+bool cli_set_script(const char *file_name);
+
+/**
+ * Record the latency of every command executed in batch mode into a file
+ *  One line per command: <command>,<milliseconds>
+ * @param file_name The timing file name
+ * @return true if the file has been opened, false otherwise
+ */
+bool cli_set_timing(const char *file_name);
+
+/**
+ * Choose how the terminal in raw mode delivers Ctrl + C, nothing is done if it is not in raw mode
+ *  Commands run with signals, so Ctrl + C stops them like in cooked mode
+ * @param enabled true to send SIGINT, false to read it as a character
+ */
+void cli_terminal_signals(bool enabled);
+
+/**
+ * Split the line in tokens and return an array of strings
+ *  The tokens point inside line, which is modified
+ * @param line Buffer current line
+ * @return Array of strings terminating with NULL
+ */
+char **cli_split_line(char *line);
+
 #endif
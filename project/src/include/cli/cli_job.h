@@ -0,0 +1,85 @@
+#ifndef _CLI_JOB_H
+#define _CLI_JOB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <poll.h>
+#include "domus.h"
+#include "util/util_stopwatch.h"
+
+#define CLI_JOB_MAX 8
+#define CLI_JOB_LINE_LENGTH 64
+/* Wait for every job */
+#define CLI_JOB_ALL 0
+
+/**
+ * Struct Cli Job, a command running in the background
+ *  Its records are printed while the prompt keeps reading commands
+ */
+typedef struct CliJob {
+    size_t id;
+    char line[CLI_JOB_LINE_LENGTH];
+    DomusWalk *walk;
+    Stopwatch start;
+} CliJob;
+
+/**
+ * Start a job reading the records of an info walk
+ * @param args The command arguments, the job is shown with them
+ * @param walk The walk, ended here if the job cannot start
+ * @return true if started, false if there are no Devices or too many jobs
+ */
+bool cli_job_start(char **args, DomusWalk *walk);
+
+/**
+ * Return the number of jobs running
+ * @return The number of jobs
+ */
+size_t cli_job_count(void);
+
+/**
+ * Fill the descriptors the next records of the jobs arrive on
+ * @param descriptors The descriptors to fill, events are set to POLLIN
+ * @param length The number of descriptors that can be filled
+ * @return The number of descriptors filled
+ */
+size_t cli_job_descriptors(struct pollfd *descriptors, size_t length);
+
+/**
+ * Print the records of every job that have already arrived, a finished job is reported and removed
+ * @return true if a job has read a record or finished, false otherwise
+ */
+bool cli_job_run(void);
+
+/**
+ * Read every Device a job is reading to the end, so a command can talk to the Devices
+ *  The job continues with the next Device when it runs again
+ */
+void cli_job_quiesce(void);
+
+/**
+ * Wait until a job finishes, printing its records
+ *  In interactive mode Ctrl + C stops waiting, the job keeps running
+ * @param id The job id or CLI_JOB_ALL
+ * @return true if the job finished, false if it does not exist or waiting was interrupted
+ */
+bool cli_job_wait(size_t id);
+
+/**
+ * Cancel a job, the records not read yet are dropped
+ * @param id The job id
+ * @return true if cancelled, false if it does not exist
+ */
+bool cli_job_cancel(size_t id);
+
+/**
+ * Print every job running
+ */
+void cli_job_print(void);
+
+/**
+ * Cancel every job still running
+ */
+void cli_job_tini(void);
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef _COMMAND_H
 #define _COMMAND_H
 
+#include <stdbool.h>
+
 #define COMMAND_NAME_LENGTH 25
 #define COMMAND_DESCRIPTION_LENGTH 250
 #define COMMAND_SYNTAX_LENGTH 35
+/* Trailing argument running a Command in the background */
+#define COMMAND_BACKGROUND "&"
 
 /**
  * Command Struct
@@ -12,6 +16,8 @@ typedef struct Command {
     char name[COMMAND_NAME_LENGTH];
     char description[COMMAND_DESCRIPTION_LENGTH];
     char syntax[COMMAND_SYNTAX_LENGTH];
+    /* Flag if the Command can run in the background */
+    bool background;
 
     int (*execute)(char **);
 } Command;
@@ -34,6 +40,7 @@ void command_tini(void);
 
 /**
  * Create a new Command
+ *  A field longer than its Command limit is cut and reported on stderr
  * @param name Command name, command identifier
  * @param description Command description, help purpose
  * @param syntax Command syntax, help purpose
@@ -42,6 +49,13 @@ void command_tini(void);
  */
 Command *new_command(char name[], char description[], char syntax[], int (*execute)(char **));
 
+/**
+ * Find a supported Command given its name
+ * @param name The Command name
+ * @return The Command, NULL if not supported
+ */
+const Command *command_find(const char *name);
+
 /**
  * Execute the command passed in args[0]
  * @param args Command & parameter/s
@@ -49,6 +63,12 @@ Command *new_command(char name[], char description[], char syntax[], int (*execu
  */
 int command_execute(char **args);
 
+/**
+ * Check if the Command being executed has been asked to run in the background
+ * @return true if in the background, false otherwise
+ */
+bool command_is_background(void);
+
 /**
  * Print all commands using command_print function
  */
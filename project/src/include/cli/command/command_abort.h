@@ -0,0 +1,12 @@
+#ifndef _COMMAND_ABORT_H
+#define _COMMAND_ABORT_H
+
+#include "command.h"
+
+/**
+ * Definition of abort Command
+ * @return The abort Command
+ */
+Command *command_abort(void);
+
+#endif
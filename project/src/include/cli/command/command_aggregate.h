@@ -0,0 +1,12 @@
+#ifndef _COMMAND_AGGREGATE_H
+#define _COMMAND_AGGREGATE_H
+
+#include "command.h"
+
+/**
+ * Definition of aggregate Command
+ * @return The aggregate Command
+ */
+Command *command_aggregate(void);
+
+#endif
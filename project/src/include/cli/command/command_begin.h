@@ -0,0 +1,12 @@
+#ifndef _COMMAND_BEGIN_H
+#define _COMMAND_BEGIN_H
+
+#include "command.h"
+
+/**
+ * Definition of begin Command
+ * @return The begin Command
+ */
+Command *command_begin(void);
+
+#endif
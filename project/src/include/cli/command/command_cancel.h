@@ -0,0 +1,12 @@
+#ifndef _COMMAND_CANCEL_H
+#define _COMMAND_CANCEL_H
+
+#include "command.h"
+
+/**
+ * Definition of cancel Command
+ * @return The cancel Command
+ */
+Command *command_cancel(void);
+
+#endif
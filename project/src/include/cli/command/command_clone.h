@@ -0,0 +1,12 @@
+#ifndef _COMMAND_CLONE_H
+#define _COMMAND_CLONE_H
+
+#include "command.h"
+
+/**
+ * Definition of clone Command
+ * @return The clone Command
+ */
+Command *command_clone(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _COMMAND_COMMIT_H
+#define _COMMAND_COMMIT_H
+
+#include "command.h"
+
+/**
+ * Definition of commit Command
+ * @return The commit Command
+ */
+Command *command_commit(void);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _COMMAND_GROUP_H
+#define _COMMAND_GROUP_H
+
+#include "command.h"
+
+#define COMMAND_GROUP_CREATE "create"
+#define COMMAND_GROUP_DEL "del"
+#define COMMAND_GROUP_SWITCH "switch"
+
+/**
+ * Definition of group Command
+ * @return The group Command
+ */
+Command *command_group(void);
+
+#endif
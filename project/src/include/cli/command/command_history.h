@@ -0,0 +1,17 @@
+#ifndef _COMMAND_HISTORY_H
+#define _COMMAND_HISTORY_H
+
+#include "command.h"
+
+#define COMMAND_HISTORY_START "start"
+#define COMMAND_HISTORY_STOP "stop"
+#define COMMAND_HISTORY_NOW "now"
+#define COMMAND_HISTORY_DATE_LENGTH 20
+
+/**
+ * Definition of history Command
+ * @return The history Command
+ */
+Command *command_history(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _COMMAND_JOBS_H
+#define _COMMAND_JOBS_H
+
+#include "command.h"
+
+/**
+ * Definition of jobs Command
+ * @return The jobs Command
+ */
+Command *command_jobs(void);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _COMMAND_JOURNAL_H
+#define _COMMAND_JOURNAL_H
+
+#include "command.h"
+
+#define COMMAND_JOURNAL_OFF "off"
+
+/**
+ * Definition of journal Command
+ * @return The journal Command
+ */
+Command *command_journal(void);
+
+#endif
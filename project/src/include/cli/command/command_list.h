@@ -3,6 +3,9 @@
 
 #include "command.h"
 
+#define COMMAND_LIST_PREDICATES "type=<device>[,<device>] state=<on|off> under=<id> name=<name> name~<glob>"
+#define COMMAND_LIST_RESOURCES "--resources"
+
 /**
  * Definition of list Command
  * @return The list Command
@@ -0,0 +1,12 @@
+#ifndef _COMMAND_LOAD_H
+#define _COMMAND_LOAD_H
+
+#include "command.h"
+
+/**
+ * Definition of load Command
+ * @return The load Command
+ */
+Command *command_load(void);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _COMMAND_METRICS_H
+#define _COMMAND_METRICS_H
+
+#include "command.h"
+
+#define COMMAND_METRICS_OFF "off"
+
+/**
+ * Definition of metrics Command
+ * @return The metrics Command
+ */
+Command *command_metrics(void);
+
+#endif
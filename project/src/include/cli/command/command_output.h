@@ -0,0 +1,12 @@
+#ifndef _COMMAND_OUTPUT_H
+#define _COMMAND_OUTPUT_H
+
+#include "command.h"
+
+/**
+ * Definition of output Command
+ * @return The output Command
+ */
+Command *command_output(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _COMMAND_SAVE_H
+#define _COMMAND_SAVE_H
+
+#include "command.h"
+
+/**
+ * Definition of save Command
+ * @return The save Command
+ */
+Command *command_save(void);
+
+#endif
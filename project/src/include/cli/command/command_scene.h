@@ -0,0 +1,16 @@
+#ifndef _COMMAND_SCENE_H
+#define _COMMAND_SCENE_H
+
+#include "command.h"
+
+#define COMMAND_SCENE_CREATE "create"
+#define COMMAND_SCENE_DEL "del"
+#define COMMAND_SCENE_APPLY "apply"
+
+/**
+ * Definition of scene Command
+ * @return The scene Command
+ */
+Command *command_scene(void);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _COMMAND_SOURCE_H
+#define _COMMAND_SOURCE_H
+
+#include "command.h"
+
+#define COMMAND_SOURCE_NAME "source"
+
+/**
+ * Definition of source Command
+ * @return The source Command
+ */
+Command *command_source(void);
+
+#endif
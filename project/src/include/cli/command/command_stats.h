@@ -0,0 +1,12 @@
+#ifndef _COMMAND_STATS_H
+#define _COMMAND_STATS_H
+
+#include "command.h"
+
+/**
+ * Definition of stats Command
+ * @return The stats Command
+ */
+Command *command_stats(void);
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "command.h"
 
+#define COMMAND_SWITCH_CONDITIONS "state=<on|off> version=<version>"
+
 /**
  * Definition of switch Command
  * @return The switch Command
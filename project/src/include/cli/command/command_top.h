@@ -0,0 +1,15 @@
+#ifndef _COMMAND_TOP_H
+#define _COMMAND_TOP_H
+
+#include "command.h"
+
+#define COMMAND_TOP_INTERVAL 1
+#define COMMAND_TOP_ITERATIONS 5
+
+/**
+ * Definition of top Command
+ * @return The top Command
+ */
+Command *command_top(void);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _COMMAND_TRACE_H
+#define _COMMAND_TRACE_H
+
+#include "command.h"
+
+#define COMMAND_TRACE_EXPORT "--export"
+#define COMMAND_TRACE_NAME_LENGTH 128
+
+/**
+ * Definition of trace Command
+ * @return The trace Command
+ */
+Command *command_trace(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _COMMAND_WAIT_H
+#define _COMMAND_WAIT_H
+
+#include "command.h"
+
+/**
+ * Definition of wait Command
+ * @return The wait Command
+ */
+Command *command_wait(void);
+
+#endif
@@ -39,7 +39,14 @@ typedef struct Trie {
 Trie *new_trie(void (*destroy)(void *), bool(*equals)(const void *, const void *));
 
 /**
- * Create new trie_node
+ * Free a Trie and all its nodes
+ * @param trie The Trie to free
+ * @return true if the Trie has been freed, false otherwise
+ */
+bool free_trie(Trie *trie);
+
+/**
+ * Create new trie_node with no children
  * @return
  */
 Trie_node *new_trie_node(void);
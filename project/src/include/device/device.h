@@ -73,6 +73,8 @@ typedef struct Device {
     bool state;
     void *registry;
     bool override;
+    /* Incremented by every switch that changes the Device, a conditional switch can expect it */
+    size_t version;
     List *switches;
 } Device;
 
@@ -85,6 +87,18 @@ typedef struct ControlDevice {
     List *devices;
 } ControlDevice;
 
+/**
+ * Struct Device Fork,
+ *  a child to fork together with others
+ */
+typedef struct DeviceFork {
+    size_t id;
+    const DeviceDescriptor *device_descriptor;
+    char name[DEVICE_NAME_LENGTH];
+    /* Set by the fork, true if the child is alive */
+    bool forked;
+} DeviceFork;
+
 /**
  * Initialize the List of supported Devices
  */
@@ -245,6 +259,17 @@ bool device_check_control_device(const ControlDevice *control_device);
 bool control_device_fork(const ControlDevice *control_device, size_t id, const DeviceDescriptor *device_descriptor,
                          const char *custom_name);
 
+/**
+ * Fork many children at once and save them to the controller devices list
+ *  Every child is forked before waiting for the first 'I_AM_ALIVE', so they start in parallel
+ *  The children alive are added at the end of the list in the same order of forks
+ * @param control_device The control device
+ * @param forks The children to fork, a child with a NULL Device Descriptor is skipped
+ * @param count The number of children
+ * @return The number of children alive
+ */
+size_t control_device_fork_all(const ControlDevice *control_device, DeviceFork *forks, size_t count);
+
 /**
  * Check if the Control Device has Devices
  * @param control_device The control device to check
@@ -7,6 +7,8 @@
 #include "device/device_communication.h"
 
 #define DEVICE_CHILD_ARGS_LENGTH 2
+/* A switch position of a Device Descriptor with one of these characters is a placeholder for any value */
+#define DEVICE_CHILD_TRANSACTION_PLACEHOLDERS "<[?"
 
 /**
  * An endless loop with pause for low LEVEL CPU LOAD
@@ -22,6 +24,12 @@ void device_child_run(void (*do_on_wake_up)(void));
  */
 bool device_child_set_device_to_spawn(DeviceCommunicationMessage message);
 
+/**
+ * Check if a prepared transaction holds this Device, every other switch is refused meanwhile
+ * @return true if held, false otherwise
+ */
+bool device_child_transaction_is_held(void);
+
 /**
  * Create and return a Device like but with arguments parameters.
  *  Only for child process!
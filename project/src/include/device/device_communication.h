@@ -11,9 +11,15 @@
 #define DEVICE_COMMUNICATION_READ_PIPE SIGUSR1
 #define DEVICE_COMMUNICATION_TIMER SIGUSR2
 #define DEVICE_COMMUNICATION_READ_QUEUE SIGCONT
+/* Sent to the parent when a Device or its subtree changed, ignored by default so Domus needs no handler */
+#define DEVICE_COMMUNICATION_CHANGED SIGURG
 #define DEVICE_COMMUNICATION_MESSAGE_LENGTH 256
 #define DEVICE_COMMUNICATION_MESSAGE_FIELDS_MAX 16
 #define DEVICE_COMMUNICATION_MESSAGE_FIELDS_DELIMITER "\n"
+/* Milliseconds a Device has to terminate with its whole subtree before it is killed */
+#define DEVICE_COMMUNICATION_TERMINATE_TIMEOUT 5000
+/* Milliseconds a Control Device keeps to kill its own stragglers before its parent kills it */
+#define DEVICE_COMMUNICATION_TERMINATE_MARGIN 250
 
 /* Message types */
 #define MESSAGE_TYPE_NO_MESSAGE 0
@@ -27,6 +33,15 @@
 #define MESSAGE_TYPE_LOCK 8
 #define MESSAGE_TYPE_UNLOCK 9
 #define MESSAGE_TYPE_UNLOCK_AND_TERMINATE 10
+#define MESSAGE_TYPE_AGGREGATE 11
+#define MESSAGE_TYPE_STATS 12
+#define MESSAGE_TYPE_TRACE 13
+#define MESSAGE_TYPE_SWITCH_MULTI 14
+#define MESSAGE_TYPE_SWITCH_SELECT 15
+#define MESSAGE_TYPE_PREPARE 16
+#define MESSAGE_TYPE_COMMIT 17
+#define MESSAGE_TYPE_ABORT 18
+#define MESSAGE_TYPE_SPAWN_SUBTREE 19
 #define MESSAGE_TYPE_SYSTEM_STATUS 124
 #define MESSAGE_TYPE_UNKNOWN 125
 #define MESSAGE_TYPE_GET_PID 126
@@ -47,6 +62,9 @@
 #define MESSAGE_RETURN_VALUE_EMPTY_FRIDGE_ERROR "ERROR\nEMPTYFRIDGE"
 #define MESSAGE_RETURN_VALUE_MINTHERMO_FRIDGE_ERROR "ERROR\nMINTHERMOFRIDGE"
 #define MESSAGE_RETURN_VALUE_MAXTHERMO_FRIDGE_ERROR "ERROR\nMAXTHERMOFRIDGE"
+#define MESSAGE_RETURN_LOCKED_ERROR "ERROR\nLOCKED"
+#define MESSAGE_RETURN_TRANSACTION_ERROR "ERROR\nTRANSACTION"
+#define MESSAGE_RETURN_CONDITION_ERROR "ERROR\nCONDITION"
 
 /* END Message Status */
 
@@ -68,6 +86,14 @@ typedef struct DeviceCommunication {
     pid_t pid;
     int com_read;
     int com_write;
+    /* Device types that can be found through this communication, see device_communication_filter */
+    unsigned int types;
+    /* Last delta info walk answered in full through this communication, 0 if none */
+    size_t info_epoch;
+    /* A record of that walk changes with time, the subtree is always asked */
+    bool info_live;
+    /* Override of the first record of that walk, a Control Device folds it into its own record */
+    bool info_override;
 } DeviceCommunication;
 
 /**
@@ -77,13 +103,23 @@ typedef struct DeviceCommunicationMessage {
     size_t type;
 
     size_t ctr_hop;
+    /* Trace the message hop by hop if not DEVICE_COMMUNICATION_TRACE_NONE, see device_communication_trace */
+    size_t trace_id;
 
     size_t id_sender;
     size_t id_recipient;
     size_t id_device_descriptor;
+    /* Process of the sender, relayed records keep the pid of the Device that created them */
+    pid_t pid_sender;
 
     bool flag_force;
     bool flag_continue;
+    /* The message carries no record, it only closes a multi-record stream */
+    bool flag_skip;
+    /* Delta info record: the subtree of the sender is the same as in the walk since, its records are not sent */
+    bool flag_unchanged;
+    /* Info record with a value changing with time, it is never answered as unchanged */
+    bool flag_live;
     bool override;
     char message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
     char device_name[DEVICE_NAME_LENGTH];
@@ -106,6 +142,34 @@ new_device_communication(pid_t pid, int com_read, int com_write);
  */
 bool device_communication_close_communication(DeviceCommunication *device_communication);
 
+/**
+ * Kill a Device that did not terminate, then close the communication with it
+ * @param device_communication The Device Communication
+ * @return true if killed, false otherwise
+ */
+bool device_communication_kill(DeviceCommunication *device_communication);
+
+/**
+ * Terminate all the Devices of a list together
+ *  TERMINATE is sent to every Device at once, so they all tear their subtrees down at the same time, then their
+ *  records are collected one Device after the other. The terminated Devices are reaped together and removed from
+ *  the list, the ones not done within the timeout are killed. A Device answering with another type stays
+ * @param devices The Device Communications of the Devices
+ * @param out_message The TERMINATE message
+ * @param timeout The milliseconds the Devices have, their children get DEVICE_COMMUNICATION_TERMINATE_MARGIN less
+ * @param records The list a copy of every TERMINATE record is added to, NULL to discard them
+ * @return The number of Devices that answered TERMINATE
+ */
+size_t device_communication_terminate_all(List *devices, const DeviceCommunicationMessage *out_message,
+                                          unsigned long timeout, List *records);
+
+/**
+ * Return the timeout carried by a TERMINATE message
+ * @param message The message
+ * @return The milliseconds, DEVICE_COMMUNICATION_TERMINATE_TIMEOUT if not set
+ */
+unsigned long device_communication_terminate_timeout(const DeviceCommunicationMessage *message);
+
 /**
  * Check if a Device from A message is directly connected
  * @param message The message to check from
@@ -138,6 +202,16 @@ DeviceCommunicationMessage device_communication_write_message_with_ack(DeviceCom
 DeviceCommunicationMessage device_communication_write_message_with_ack_silent(DeviceCommunication *device_communication,
                                                                               const DeviceCommunicationMessage *out_message);
 
+/**
+ * Write a message and notify the recipient without waiting for a response
+ *  The response must be read later with device_communication_read_message,
+ *  messages to different recipients can be in flight together but only one for every recipient
+ * @param device_communication The Device Communication structure
+ * @param out_message The message to send
+ */
+void device_communication_write_message_notify(const DeviceCommunication *device_communication,
+                                               const DeviceCommunicationMessage *out_message);
+
 /**
  * Write a message
  * @param device_communication The Device Communication structure
@@ -0,0 +1,78 @@
+#ifndef _DEVICE_COMMUNICATION_AGGREGATE_H
+#define _DEVICE_COMMUNICATION_AGGREGATE_H
+
+#include <stdbool.h>
+#include "collection/collection_list.h"
+#include "device/device_communication.h"
+#include "device/device_communication_filter.h"
+
+#define DEVICE_COMMUNICATION_AGGREGATE_METRICS_MAX 4
+#define DEVICE_COMMUNICATION_AGGREGATE_METRIC_NAME_LENGTH 16
+
+/**
+ * Struct Device Communication Aggregate Metric, a numeric info field folded over a group of Devices
+ */
+typedef struct DeviceCommunicationAggregateMetric {
+    double sum;
+    double min;
+    double max;
+} DeviceCommunicationAggregateMetric;
+
+/**
+ * Struct Device Communication Aggregate, the partial aggregate of all Devices with the same type and state
+ *  Control Devices fold the records of their children and send one aggregate per group to their parent
+ */
+typedef struct DeviceCommunicationAggregate {
+    size_t id_device_descriptor;
+    bool state;
+    size_t count;
+    size_t metrics;
+    DeviceCommunicationAggregateMetric metric[DEVICE_COMMUNICATION_AGGREGATE_METRICS_MAX];
+} DeviceCommunicationAggregate;
+
+/**
+ * Return the number of numeric metrics of a Device type
+ * @param id_device_descriptor The Device Descriptor id
+ * @return The number of metrics
+ */
+size_t device_communication_aggregate_metrics(size_t id_device_descriptor);
+
+/**
+ * Return the name of a numeric metric of a Device type
+ * @param id_device_descriptor The Device Descriptor id
+ * @param index The metric index
+ * @return The metric name, NULL if not exists
+ */
+const char *device_communication_aggregate_metric_name(size_t id_device_descriptor, size_t index);
+
+/**
+ * Fold a message into a List of aggregates
+ *  An info record is added if it matches the filter, an aggregate record is merged, others are ignored
+ * @param aggregates The List of aggregates
+ * @param filter The filter for info records
+ * @param message The message
+ * @return true if something has been folded, false otherwise
+ */
+bool device_communication_aggregate_add_message(List *aggregates, const DeviceCommunicationFilter *filter,
+                                                const DeviceCommunicationMessage *message);
+
+/**
+ * Add a Device to a List of aggregates
+ * @param aggregates The List of aggregates
+ * @param id_device_descriptor The Device Descriptor id
+ * @param state The Device state
+ * @param values The metric values of the Device, NULL if it has none
+ */
+void device_communication_aggregate_add(List *aggregates, size_t id_device_descriptor, bool state,
+                                        const double *values);
+
+/**
+ * Encode an aggregate as a message
+ * @param aggregate The aggregate
+ * @param message The message buffer
+ * @param length The message buffer length
+ */
+void device_communication_aggregate_to_message(const DeviceCommunicationAggregate *aggregate, char *message,
+                                               size_t length);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _DEVICE_COMMUNICATION_CONDITION_H
+#define _DEVICE_COMMUNICATION_CONDITION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "device/device.h"
+
+#define DEVICE_COMMUNICATION_CONDITION_ANY -1
+
+#define DEVICE_COMMUNICATION_CONDITION_KEYWORD "if"
+#define DEVICE_COMMUNICATION_CONDITION_KEY_STATE "state="
+#define DEVICE_COMMUNICATION_CONDITION_KEY_VERSION "version="
+
+/**
+ * Struct Device Communication Condition, what a Device must be for a conditional switch to be applied
+ *  It travels after the label and the position of a SWITCH message, the target evaluates it before switching
+ */
+typedef struct DeviceCommunicationCondition {
+    int state;
+    long version;
+} DeviceCommunicationCondition;
+
+/**
+ * Initialize an empty condition, it always holds
+ * @param condition The condition to initialize
+ */
+void device_communication_condition_init(DeviceCommunicationCondition *condition);
+
+/**
+ * Check if a condition has no predicates
+ * @param condition The condition
+ * @return true if empty, false otherwise
+ */
+bool device_communication_condition_is_empty(const DeviceCommunicationCondition *condition);
+
+/**
+ * Add a predicate to the condition
+ *  state=<on|off> | version=<version>
+ * @param condition The condition
+ * @param predicate The predicate
+ * @return true if added, false if not valid
+ */
+bool device_communication_condition_add_predicate(DeviceCommunicationCondition *condition, const char *predicate);
+
+/**
+ * Encode a conditional switch as a message: label, position and then one predicate per line
+ * @param condition The condition
+ * @param switch_label The Device Switch Label
+ * @param switch_pos The Device Switch Position
+ * @param message The message buffer
+ * @param length The message buffer length
+ * @return true if it fits, false otherwise
+ */
+bool device_communication_condition_to_message(const DeviceCommunicationCondition *condition,
+                                               const char *switch_label, const char *switch_pos, char *message,
+                                               size_t length);
+
+/**
+ * Decode a conditional switch, the message is left with the plain switch
+ * @param condition The condition, empty if the message has no predicates
+ * @param message The SWITCH message
+ * @return true if the message has a condition, false otherwise
+ */
+bool device_communication_condition_from_message(DeviceCommunicationCondition *condition, char *message);
+
+/**
+ * Check if a Device satisfies the condition
+ * @param condition The condition
+ * @param state The Device state
+ * @param version The Device version
+ * @return true if it holds, false otherwise
+ */
+bool device_communication_condition_holds(const DeviceCommunicationCondition *condition, bool state,
+                                          size_t version);
+
+#endif
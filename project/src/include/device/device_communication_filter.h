@@ -0,0 +1,160 @@
+#ifndef _DEVICE_COMMUNICATION_FILTER_H
+#define _DEVICE_COMMUNICATION_FILTER_H
+
+#include <stdbool.h>
+#include "device/device.h"
+#include "device/device_communication.h"
+
+#define DEVICE_COMMUNICATION_FILTER_TYPE(id) (1U << (id))
+#define DEVICE_COMMUNICATION_FILTER_ANY -1
+#define DEVICE_COMMUNICATION_FILTER_UNDER_ANY ((size_t) -1)
+
+#define DEVICE_COMMUNICATION_FILTER_KEY_TYPE "type"
+#define DEVICE_COMMUNICATION_FILTER_KEY_TYPES "types"
+#define DEVICE_COMMUNICATION_FILTER_KEY_STATE "state"
+#define DEVICE_COMMUNICATION_FILTER_KEY_UNDER "under"
+#define DEVICE_COMMUNICATION_FILTER_KEY_NAME "name"
+#define DEVICE_COMMUNICATION_FILTER_KEY_SINCE "since"
+#define DEVICE_COMMUNICATION_FILTER_KEY_EPOCH "epoch"
+#define DEVICE_COMMUNICATION_FILTER_EQUALS '='
+#define DEVICE_COMMUNICATION_FILTER_GLOB '~'
+#define DEVICE_COMMUNICATION_FILTER_TYPE_DELIMITER ","
+#define DEVICE_COMMUNICATION_FILTER_WILDCARDS "*?["
+
+/**
+ * Struct Device Communication Filter, a predicate on info records
+ *  It travels inside the INFO message so every Control Device can evaluate it on its children
+ */
+typedef struct DeviceCommunicationFilter {
+    unsigned int types;
+    int state;
+    size_t under;
+    bool name_glob;
+    char name[DEVICE_NAME_LENGTH];
+    /* Delta info walk: the walk whose records the asker still holds, 0 if none, and the number of this walk */
+    size_t since;
+    size_t epoch;
+} DeviceCommunicationFilter;
+
+/**
+ * Initialize an empty filter, it matches everything
+ * @param filter The filter to initialize
+ */
+void device_communication_filter_init(DeviceCommunicationFilter *filter);
+
+/**
+ * Check if a filter has no predicates
+ * @param filter The filter
+ * @return true if empty, false otherwise
+ */
+bool device_communication_filter_is_empty(const DeviceCommunicationFilter *filter);
+
+/**
+ * Check if a filter asks for a delta info walk
+ *  A Device that did not change since the walk since answers with a single unchanged record
+ * @param filter The filter
+ * @return true if delta, false otherwise
+ */
+bool device_communication_filter_is_delta(const DeviceCommunicationFilter *filter);
+
+/**
+ * Add a predicate to the filter
+ *  type=<device>[,<device>] | state=<on|off> | under=<id> | name=<name> | name~<glob>
+ *  A name with a wildcard is a glob even after =
+ * @param filter The filter
+ * @param predicate The predicate
+ * @return true if added, false if not valid
+ */
+bool device_communication_filter_add_predicate(DeviceCommunicationFilter *filter, const char *predicate);
+
+/**
+ * Encode the filter as a message, one predicate per line
+ * @param filter The filter
+ * @param message The message buffer
+ * @param length The message buffer length
+ */
+void device_communication_filter_to_message(const DeviceCommunicationFilter *filter, char *message, size_t length);
+
+/**
+ * Decode a filter from a message, an empty message is an empty filter
+ *  The since and epoch of a delta info walk are only accepted here, they are not predicates
+ * @param filter The filter
+ * @param message The message
+ */
+void device_communication_filter_from_message(DeviceCommunicationFilter *filter, const char *message);
+
+/**
+ * Check if a Device matches the filter
+ * @param filter The filter, NULL matches everything
+ * @param id The Device id
+ * @param id_device_descriptor The Device Descriptor id
+ * @param device_name The Device name
+ * @param state The Device state
+ * @return true if it matches, false otherwise
+ */
+bool device_communication_filter_match(const DeviceCommunicationFilter *filter, size_t id,
+                                       size_t id_device_descriptor, const char *device_name, bool state);
+
+/**
+ * Check if an info record matches the filter
+ * @param filter The filter, NULL matches everything
+ * @param message The info record
+ * @return true if it matches, false otherwise
+ */
+bool device_communication_filter_match_message(const DeviceCommunicationFilter *filter,
+                                               const DeviceCommunicationMessage *message);
+
+/**
+ * Check if a subtree can contain a Device matching the filter
+ * @param filter The filter, NULL matches everything
+ * @param types The Device types that can be found in the subtree
+ * @return true if the subtree must be visited, false if it can be pruned
+ */
+bool device_communication_filter_may_match(const DeviceCommunicationFilter *filter, unsigned int types);
+
+/**
+ * Check if a Device is selected by a switch selector
+ *  A Device is selected only below the Control Device with the under id, which clears it for its children
+ *  The Controller is selected only by its type
+ * @param filter The selector
+ * @param id The Device id
+ * @param id_device_descriptor The Device Descriptor id
+ * @param device_name The Device name
+ * @param state The Device state
+ * @return true if selected, false otherwise
+ */
+bool device_communication_filter_select(const DeviceCommunicationFilter *filter, size_t id,
+                                        size_t id_device_descriptor, const char *device_name, bool state);
+
+/**
+ * Encode a switch of the Devices selected by the filter as a message, label and position first
+ * @param filter The selector
+ * @param switch_label The label to switch
+ * @param switch_pos The position to switch the label into
+ * @param message The message buffer
+ * @param length The message buffer length
+ * @return true if encoded, false if it does not fit
+ */
+bool device_communication_filter_to_selector(const DeviceCommunicationFilter *filter, const char *switch_label,
+                                             const char *switch_pos, char *message, size_t length);
+
+/**
+ * Decode a switch selector message
+ * @param filter The selector
+ * @param message The message
+ * @param switch_message The buffer for the switch message of the selected Devices
+ * @param length The switch message buffer length
+ * @return true if decoded, false otherwise
+ */
+bool device_communication_filter_from_selector(DeviceCommunicationFilter *filter, const char *message,
+                                               char *switch_message, size_t length);
+
+/**
+ * Record the type of the Devices spawned through a Device Communication
+ * @param device_communication The Device Communication the spawn went through
+ * @param spawn_message The SPAWN_DEVICE or SPAWN_SUBTREE message
+ */
+void device_communication_filter_track_spawn(DeviceCommunication *device_communication,
+                                             const DeviceCommunicationMessage *spawn_message);
+
+#endif
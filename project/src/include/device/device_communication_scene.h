@@ -0,0 +1,112 @@
+#ifndef _DEVICE_COMMUNICATION_SCENE_H
+#define _DEVICE_COMMUNICATION_SCENE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "device/device_communication.h"
+
+/* A target id takes at least two characters of a message */
+#define DEVICE_COMMUNICATION_SCENE_TARGETS (DEVICE_COMMUNICATION_MESSAGE_LENGTH / 2)
+/* Every action takes at least four characters of a message */
+#define DEVICE_COMMUNICATION_SCENE_ACTIONS (DEVICE_COMMUNICATION_MESSAGE_LENGTH / 4)
+#define DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH 64
+#define DEVICE_COMMUNICATION_SCENE_ID_DELIMITER ","
+
+/**
+ * Struct Device Communication Scene Action, a switch label and the position to move it to
+ */
+typedef struct DeviceCommunicationSceneAction {
+    char label[DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH];
+    char pos[DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH];
+} DeviceCommunicationSceneAction;
+
+/**
+ * Struct Device Communication Scene Target, a Device and the action to execute on it
+ */
+typedef struct DeviceCommunicationSceneTarget {
+    size_t id;
+    size_t action;
+} DeviceCommunicationSceneTarget;
+
+/**
+ * Struct Device Communication Scene, the targets of a multi target switch
+ *  It travels inside the SWITCH_MULTI message, every Control Device removes the targets found under a child
+ *  before asking the next one
+ */
+typedef struct DeviceCommunicationScene {
+    size_t targets_count;
+    size_t actions_count;
+    DeviceCommunicationSceneTarget targets[DEVICE_COMMUNICATION_SCENE_TARGETS];
+    DeviceCommunicationSceneAction actions[DEVICE_COMMUNICATION_SCENE_ACTIONS];
+} DeviceCommunicationScene;
+
+/**
+ * Initialize an empty scene
+ * @param scene The scene to initialize
+ */
+void device_communication_scene_init(DeviceCommunicationScene *scene);
+
+/**
+ * Check if a scene has no targets
+ * @param scene The scene
+ * @return true if empty, false otherwise
+ */
+bool device_communication_scene_is_empty(const DeviceCommunicationScene *scene);
+
+/**
+ * Add a target to the scene, targets with the same action share it
+ * @param scene The scene
+ * @param id The Device id
+ * @param label The switch label
+ * @param pos The switch position
+ * @return true if added, false if the scene is full or the label or position is too long
+ */
+bool device_communication_scene_add(DeviceCommunicationScene *scene, size_t id, const char *label, const char *pos);
+
+/**
+ * Return the target of a Device
+ * @param scene The scene
+ * @param id The Device id
+ * @return The target, NULL if the Device is not a target
+ */
+const DeviceCommunicationSceneTarget *device_communication_scene_find(const DeviceCommunicationScene *scene, size_t id);
+
+/**
+ * Remove the target of a Device
+ * @param scene The scene
+ * @param id The Device id
+ * @return true if removed, false if the Device is not a target
+ */
+bool device_communication_scene_remove(DeviceCommunicationScene *scene, size_t id);
+
+/**
+ * Encode the targets of a scene as a message, targets are grouped by action
+ *  label, position and then the comma separated ids, one per line
+ * @param scene The scene
+ * @param from The index of the first target to encode
+ * @param message The message buffer
+ * @param length The message buffer length
+ * @return The index of the first target not encoded, the next message starts from it
+ */
+size_t device_communication_scene_to_message(const DeviceCommunicationScene *scene, size_t from, char *message,
+                                             size_t length);
+
+/**
+ * Decode a scene from a message
+ * @param scene The scene
+ * @param message The message
+ * @return true if decoded, false if the message is not valid
+ */
+bool device_communication_scene_from_message(DeviceCommunicationScene *scene, const char *message);
+
+/**
+ * Encode the action of a target as a SWITCH message
+ * @param scene The scene
+ * @param target The target
+ * @param message The message buffer
+ * @param length The message buffer length
+ */
+void device_communication_scene_to_switch(const DeviceCommunicationScene *scene,
+                                          const DeviceCommunicationSceneTarget *target, char *message, size_t length);
+
+#endif
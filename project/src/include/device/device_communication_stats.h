@@ -0,0 +1,148 @@
+#ifndef _DEVICE_COMMUNICATION_STATS_H
+#define _DEVICE_COMMUNICATION_STATS_H
+
+#include <stdbool.h>
+#include "device/device_communication.h"
+#include "device/device_communication_filter.h"
+#include "util/util_stopwatch.h"
+
+/* Log-linear buckets: every power of two is split in 2^SUB_BUCKET_BITS linear buckets, relative error 1/8 */
+#define DEVICE_COMMUNICATION_STATS_SUB_BUCKET_BITS 3
+#define DEVICE_COMMUNICATION_STATS_SUB_BUCKETS (1 << DEVICE_COMMUNICATION_STATS_SUB_BUCKET_BITS)
+#define DEVICE_COMMUNICATION_STATS_MAGNITUDES 40
+#define DEVICE_COMMUNICATION_STATS_BUCKETS (DEVICE_COMMUNICATION_STATS_MAGNITUDES * DEVICE_COMMUNICATION_STATS_SUB_BUCKETS)
+/* Message types 0-23 and 124-131 have a histogram */
+#define DEVICE_COMMUNICATION_STATS_TYPES 32
+#define DEVICE_COMMUNICATION_STATS_TYPE_NAME_LENGTH 24
+/* Only Control Devices wait for acks, only subtrees containing them have statistics */
+#define DEVICE_COMMUNICATION_STATS_DEVICE_TYPES (DEVICE_COMMUNICATION_FILTER_TYPE(DEVICE_TYPE_CONTROLLER) \
+                                                | DEVICE_COMMUNICATION_FILTER_TYPE(DEVICE_TYPE_HUB) \
+                                                | DEVICE_COMMUNICATION_FILTER_TYPE(DEVICE_TYPE_TIMER))
+
+/**
+ * Struct Device Communication Stats Histogram, send to ack latencies of a message type
+ */
+typedef struct DeviceCommunicationStatsHistogram {
+    unsigned long count;
+    unsigned long errors;
+    Stopwatch max;
+    Stopwatch sum;
+    unsigned int bucket[DEVICE_COMMUNICATION_STATS_BUCKETS];
+} DeviceCommunicationStatsHistogram;
+
+/**
+ * Struct Device Communication Stats, one histogram per message type
+ */
+typedef struct DeviceCommunicationStats {
+    DeviceCommunicationStatsHistogram histogram[DEVICE_COMMUNICATION_STATS_TYPES];
+} DeviceCommunicationStats;
+
+/**
+ * Struct Device Communication Stats Counters, messages written and read by a process for every message type
+ */
+typedef struct DeviceCommunicationStatsCounters {
+    unsigned long written[DEVICE_COMMUNICATION_STATS_TYPES];
+    unsigned long read[DEVICE_COMMUNICATION_STATS_TYPES];
+} DeviceCommunicationStatsCounters;
+
+/**
+ * Create and return an empty Device Communication Stats
+ *  Remember to free!
+ * @return The new Device Communication Stats
+ */
+DeviceCommunicationStats *new_device_communication_stats(void);
+
+/**
+ * Return the Device Communication Stats of this process
+ * @return The Device Communication Stats of this process
+ */
+const DeviceCommunicationStats *device_communication_stats(void);
+
+/**
+ * Record the send to ack latency of a message in the statistics of this process
+ *  An ack is an error if its type is error or its message starts with an error status
+ * @param type The type of the sent message
+ * @param elapsed Nanoseconds from send to ack
+ * @param ack The ack received
+ */
+void device_communication_stats_record(size_t type, Stopwatch elapsed, const DeviceCommunicationMessage *ack);
+
+/**
+ * Count a message written or read by this process
+ * @param type The message type
+ * @param written true if written, false if read
+ */
+void device_communication_stats_count(size_t type, bool written);
+
+/**
+ * Return the message counters of this process
+ * @return The message counters of this process
+ */
+const DeviceCommunicationStatsCounters *device_communication_stats_counters(void);
+
+/**
+ * Merge statistics into others
+ * @param stats The statistics to merge into
+ * @param other The statistics to merge
+ */
+void device_communication_stats_merge(DeviceCommunicationStats *stats, const DeviceCommunicationStats *other);
+
+/**
+ * Merge a stats record into statistics, other messages are ignored
+ * @param stats The statistics
+ * @param message The stats record
+ * @return true if merged, false otherwise
+ */
+bool device_communication_stats_add_message(DeviceCommunicationStats *stats, const DeviceCommunicationMessage *message);
+
+/**
+ * Encode the next part of the statistics as a stats record
+ *  Every record carries the non empty buckets of a message type, start with cursor 0 and call until false
+ * @param stats The statistics
+ * @param cursor The position to continue from, updated
+ * @param message The message buffer
+ * @param length The message buffer length
+ * @return true if a record has been encoded, false if there is nothing left
+ */
+bool device_communication_stats_to_message(const DeviceCommunicationStats *stats, size_t *cursor, char *message,
+                                           size_t length);
+
+/**
+ * Return the histogram index of a message type
+ * @param type The message type
+ * @return The histogram index, DEVICE_COMMUNICATION_STATS_TYPES if the type has no histogram
+ */
+size_t device_communication_stats_index(size_t type);
+
+/**
+ * Return the message type of a histogram
+ * @param index The histogram index
+ * @return The message type
+ */
+size_t device_communication_stats_type(size_t index);
+
+/**
+ * Return the name of a message type
+ * @param type The message type
+ * @return The name, NULL if unknown
+ */
+const char *device_communication_stats_type_name(size_t type);
+
+/**
+ * Return the latency under which a percentage of the samples falls
+ *  The value is the upper bound of the bucket, never greater than the maximum
+ * @param histogram The histogram
+ * @param percentile The percentile in (0, 100]
+ * @return The latency in nanoseconds, 0 if the histogram is empty
+ */
+Stopwatch device_communication_stats_percentile(const DeviceCommunicationStatsHistogram *histogram, double percentile);
+
+/**
+ * Return how many samples are surely not greater than a latency, those whose bucket ends within it
+ * @param histogram The histogram
+ * @param bound The latency in nanoseconds
+ * @return The number of samples
+ */
+unsigned long device_communication_stats_cumulative(const DeviceCommunicationStatsHistogram *histogram, Stopwatch bound);
+
+#endif
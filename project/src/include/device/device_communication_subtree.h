@@ -0,0 +1,109 @@
+#ifndef _DEVICE_COMMUNICATION_SUBTREE_H
+#define _DEVICE_COMMUNICATION_SUBTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "device/device_communication.h"
+
+/* A node takes at least ten characters of a message */
+#define DEVICE_COMMUNICATION_SUBTREE_NODES (DEVICE_COMMUNICATION_MESSAGE_LENGTH / 10)
+/* Parent of the nodes spawned directly under the recipient */
+#define DEVICE_COMMUNICATION_SUBTREE_ROOT -1
+#define DEVICE_COMMUNICATION_SUBTREE_FIELD_DELIMITER '\t'
+
+/**
+ * Struct Device Communication Subtree Node, a Device to spawn with its init values
+ */
+typedef struct DeviceCommunicationSubtreeNode {
+    size_t id;
+    size_t id_device_descriptor;
+    /* Index of the parent node, DEVICE_COMMUNICATION_SUBTREE_ROOT if spawned by the recipient */
+    long parent;
+    char name[DEVICE_NAME_LENGTH];
+    /* The fields of the INFO message of the Device, one per line */
+    char values[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+} DeviceCommunicationSubtreeNode;
+
+/**
+ * Struct Device Communication Subtree, the Devices spawned by a single SPAWN_SUBTREE message
+ *  Parents always come before their children, every Control Device spawns its roots together and
+ *  sends each of them the part of the subtree below it
+ */
+typedef struct DeviceCommunicationSubtree {
+    size_t count;
+    DeviceCommunicationSubtreeNode nodes[DEVICE_COMMUNICATION_SUBTREE_NODES];
+} DeviceCommunicationSubtree;
+
+/**
+ * Initialize an empty subtree
+ * @param subtree The subtree to initialize
+ */
+void device_communication_subtree_init(DeviceCommunicationSubtree *subtree);
+
+/**
+ * Add a node to the subtree
+ * @param subtree The subtree
+ * @param id The Device id
+ * @param id_device_descriptor The Device Descriptor id
+ * @param parent The index of the parent node, DEVICE_COMMUNICATION_SUBTREE_ROOT if spawned by the recipient
+ * @param name The Device name
+ * @param values The init values, the fields of the INFO message of the Device
+ * @return true if added, false if the subtree is full, the parent is not in it or a field is not valid
+ */
+bool device_communication_subtree_add(DeviceCommunicationSubtree *subtree, size_t id, size_t id_device_descriptor,
+                                      long parent, const char *name, const char *values);
+
+/**
+ * Return the index of the node of a Device
+ * @param subtree The subtree
+ * @param id The Device id
+ * @return The index, DEVICE_COMMUNICATION_SUBTREE_ROOT if the Device is not in the subtree
+ */
+long device_communication_subtree_find(const DeviceCommunicationSubtree *subtree, size_t id);
+
+/**
+ * Count the roots of the subtree
+ * @param subtree The subtree
+ * @param id_device_descriptor Set to the Device Descriptor id of the roots if they all share it, 0 otherwise
+ * @return The number of roots
+ */
+size_t device_communication_subtree_roots(const DeviceCommunicationSubtree *subtree, size_t *id_device_descriptor);
+
+/**
+ * Copy the descendants of a node as a new subtree, the children of the node become its roots
+ * @param subtree The subtree
+ * @param index The index of the node
+ * @param descendants The subtree to fill
+ */
+void device_communication_subtree_descendants(const DeviceCommunicationSubtree *subtree, size_t index,
+                                              DeviceCommunicationSubtree *descendants);
+
+/**
+ * Encode a subtree as a message, one node per line with its fields separated by tabs
+ *  parent, id, Device Descriptor id, name and then the init values
+ * @param subtree The subtree
+ * @param message The message buffer
+ * @param length The message buffer length
+ * @return true if encoded, false if it does not fit
+ */
+bool device_communication_subtree_to_message(const DeviceCommunicationSubtree *subtree, char *message, size_t length);
+
+/**
+ * Decode a subtree from a message
+ * @param subtree The subtree
+ * @param message The message
+ * @return true if decoded, false if the message is not valid
+ */
+bool device_communication_subtree_from_message(DeviceCommunicationSubtree *subtree, const char *message);
+
+/**
+ * Encode the init values of a node as a SET_INIT_VALUES message
+ * @param subtree The subtree
+ * @param index The index of the node
+ * @param message The message buffer
+ * @param length The message buffer length
+ */
+void device_communication_subtree_to_init_values(const DeviceCommunicationSubtree *subtree, size_t index,
+                                                 char *message, size_t length);
+
+#endif
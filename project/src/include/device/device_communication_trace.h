@@ -0,0 +1,95 @@
+#ifndef _DEVICE_COMMUNICATION_TRACE_H
+#define _DEVICE_COMMUNICATION_TRACE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "device/device_communication.h"
+#include "util/util_stopwatch.h"
+
+#define DEVICE_COMMUNICATION_TRACE_SPANS 256
+#define DEVICE_COMMUNICATION_TRACE_NONE 0
+
+/**
+ * Struct Device Communication Trace Span, the time a traced message spent in a process
+ *  Time points come from a monotonic clock shared by all processes
+ */
+typedef struct DeviceCommunicationTraceSpan {
+    size_t trace_id;
+    size_t id_device;
+    size_t id_device_descriptor;
+    pid_t pid;
+    size_t type;
+    Stopwatch arrival;
+    /* First message sent to a child, 0 if never forwarded */
+    Stopwatch forward;
+    /* Last message sent to the parent */
+    Stopwatch reply;
+    /* Nesting in the trace, computed when the spans are assembled */
+    size_t depth;
+} DeviceCommunicationTraceSpan;
+
+/**
+ * Generate a trace id unique among all processes
+ * @return The trace id
+ */
+size_t device_communication_trace_new_id(void);
+
+/**
+ * Return the trace id of the span in progress, new messages carry it
+ * @return The trace id, DEVICE_COMMUNICATION_TRACE_NONE if not tracing
+ */
+size_t device_communication_trace_current(void);
+
+/**
+ * Begin the span of a message, nothing happens if the message is not traced
+ * @param trace_id The trace id of the message
+ * @param id_device The id of this Device
+ * @param id_device_descriptor The Device Descriptor id of this Device
+ * @param type The message type
+ */
+void device_communication_trace_begin(size_t trace_id, size_t id_device, size_t id_device_descriptor, size_t type);
+
+/**
+ * Mark the span in progress as forwarded, only the first call counts
+ */
+void device_communication_trace_forward(void);
+
+/**
+ * Mark the span in progress as replied if the message is written to the parent process
+ * @param pid The pid of the process the message is written to
+ */
+void device_communication_trace_reply(pid_t pid);
+
+/**
+ * End the span in progress and store it in the ring buffer of this process
+ *  The oldest span is overwritten when the ring buffer is full
+ */
+void device_communication_trace_end(void);
+
+/**
+ * Iterate the stored spans of a trace
+ * @param trace_id The trace id
+ * @param cursor The position to continue from, start with 0, updated
+ * @return The next span, NULL if there are no more
+ */
+const DeviceCommunicationTraceSpan *device_communication_trace_next(size_t trace_id, size_t *cursor);
+
+/**
+ * Encode a span as a trace record
+ * @param span The span
+ * @param message The message buffer
+ * @param length The message buffer length
+ */
+void device_communication_trace_span_to_message(const DeviceCommunicationTraceSpan *span, char *message,
+                                                size_t length);
+
+/**
+ * Decode a trace record
+ * @param span The span to fill
+ * @param message The trace record
+ * @return true if decoded, false if the message is not a valid trace record
+ */
+bool device_communication_trace_span_from_message(DeviceCommunicationTraceSpan *span,
+                                                  const DeviceCommunicationMessage *message);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _DEVICE_COMMUNICATION_TRANSACTION_H
+#define _DEVICE_COMMUNICATION_TRANSACTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "device/device_communication_scene.h"
+
+/* Milliseconds a prepared Device waits for the commit before releasing itself */
+#define DEVICE_COMMUNICATION_TRANSACTION_TIMEOUT 5000
+#define DEVICE_COMMUNICATION_TRANSACTION_NONE 0
+
+/**
+ * Encode a transaction message, the transaction id and timeout followed by the targets of the scene from index from
+ * @param id The transaction id
+ * @param timeout The timeout in milliseconds
+ * @param scene The scene
+ * @param from The index of the first target to encode
+ * @param message The message buffer
+ * @param length The message buffer length
+ * @return The index of the first target not encoded, from if none fits
+ */
+size_t device_communication_transaction_to_message(size_t id, unsigned long timeout,
+                                                   const DeviceCommunicationScene *scene, size_t from,
+                                                   char *message, size_t length);
+
+/**
+ * Decode a transaction message
+ * @param message The message
+ * @param id The transaction id
+ * @param timeout The timeout in milliseconds
+ * @param scene The scene to fill with the targets
+ * @return true if decoded, false if not valid
+ */
+bool device_communication_transaction_from_message(const char *message, size_t *id, unsigned long *timeout,
+                                                   DeviceCommunicationScene *scene);
+
+#endif
@@ -5,10 +5,22 @@
 #include <unistd.h>
 #include <stdbool.h>
 #include "device/device.h"
+#include "device/device_communication_filter.h"
+#include "device/device_communication_condition.h"
+#include "device/device_communication_scene.h"
+#include "util/util_process.h"
+#include "domus_journal.h"
 
 #define DOMUS_ID 0
 #define CONTROLLER_ID 1
-#define DEVICE_MESSAGE_TO_ALL_DEVICES -1
+#define DEVICE_MESSAGE_TO_ALL_DEVICES ((size_t) -1)
+#define DOMUS_TRACE_TIMELINE_LENGTH 32
+#define DOMUS_TRACE_DEVICE_LENGTH 32
+#define DOMUS_TRACE_DEPTH_MAX 64
+#define DOMUS_RESOURCES_COLUMN_LENGTH 10
+#define DOMUS_WALK_DONE 0
+#define DOMUS_WALK_PENDING 1
+#define DOMUS_WALK_RECORD 2
 
 /**
  * Struct Domus Registry
@@ -17,6 +29,48 @@ typedef struct DomusRegistry {
     size_t next_id;
 } DomusRegistry;
 
+/**
+ * Handler of info records, called once per record as soon as it arrives
+ *  The record is released when the handler returns, copy it to keep it
+ */
+typedef void (*DomusRecordHandler)(const DeviceCommunicationMessage *message, void *context);
+
+/**
+ * Struct Domus Resources Row, the info message of a Device and what its process costs
+ */
+typedef struct DomusResourcesRow {
+    const DeviceCommunicationMessage *message;
+    ProcessResources resources;
+} DomusResourcesRow;
+
+/**
+ * Struct Domus Walk, an info walk reading one record at a time
+ *  The Devices directly connected to Domus are asked one after the other and a record is read only
+ *  once it has arrived, so the walk can advance between the keys typed at the prompt
+ */
+typedef struct DomusWalk {
+    size_t id;
+    DeviceCommunicationFilter filter;
+    DeviceCommunicationMessage out_message;
+    /* Pids of the Devices directly connected to Domus when the walk started */
+    pid_t *pids;
+    size_t count;
+    size_t next;
+    /* The Device answering, NULL between two Devices */
+    DeviceCommunication *current;
+    /* The Device answering has not sent its first record yet */
+    bool first;
+    Stopwatch sent;
+    bool done;
+    /* Records are read and dropped */
+    bool cancelled;
+    /* Output format of the command that started the walk */
+    int format;
+    size_t records;
+    /* Records of the other output formats, rendered when the walk ends */
+    List *collected;
+} DomusWalk;
+
 /**
  * Start Domus System
  */
@@ -44,6 +98,18 @@ size_t domus_fork_device(const DeviceDescriptor *device_descriptor, const char *
  */
 bool domus_system_is_active(void);
 
+/**
+ * Begin a batch of independent commands
+ *  Inside a batch the System status is asked only once and the info of all Devices
+ *  is collected at most once, until a command changes the hierarchy or a state
+ */
+void domus_batch_begin(void);
+
+/**
+ * End the current batch and release the cached values
+ */
+void domus_batch_end(void);
+
 /**
  * Check if the Domus has devices
  * @return true if has devices, false otherwise
@@ -69,6 +135,26 @@ bool domus_del_by_id(size_t id);
  */
 bool domus_del_all(void);
 
+/**
+ * Return the info messages of a Device and its subtree
+ *  Remember to free!
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @return The List of info messages, empty if there are none
+ */
+List *domus_info_list(size_t id);
+
+/**
+ * Hand the info messages of a Device and its subtree matching the filter one at a time
+ *  Records are handed in arrival order, a Control Device comes after its subtree
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The info filter, can be NULL
+ * @param handler The record handler
+ * @param context The context of the handler
+ * @return The number of records handed
+ */
+size_t domus_info_each(size_t id, const DeviceCommunicationFilter *filter, DomusRecordHandler handler,
+                       void *context);
+
 /**
  * Given an id, returns info of the device
  *  If it's a Control Device show info about all connected devices
@@ -77,19 +163,179 @@ bool domus_del_all(void);
  */
 bool domus_info_by_id(size_t id);
 
+/**
+ * Given an id, returns info of the device and its subtree matching the filter
+ *  The filter is evaluated by the Control Devices, only matching records are collected
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The info filter
+ * @return true if at least one Device matches, false otherwise
+ */
+bool domus_info_filter(size_t id, const DeviceCommunicationFilter *filter);
+
 /**
  * Show info about all devices
  * @return true if found, false otherwise
  */
 bool domus_info_all(void);
 
+/**
+ * Start an info walk of a Device and its subtree, see domus_walk_step
+ *  Remember to end it!
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The info filter, NULL for none
+ * @return The walk, NULL if there are no Devices
+ */
+DomusWalk *domus_walk_start(size_t id, const DeviceCommunicationFilter *filter);
+
+/**
+ * Advance a walk by at most one record, a matching record is printed in the output format of the walk
+ *  In the table format as soon as it is read, in the others when the walk ends
+ * @param walk The walk
+ * @param wait true to wait for the record, false to return if it has not arrived yet
+ * @return DOMUS_WALK_RECORD if a record was read, DOMUS_WALK_PENDING if it has not arrived yet
+ *  or another walk is reading the next Device, DOMUS_WALK_DONE if the walk is over
+ */
+int domus_walk_step(DomusWalk *walk, bool wait);
+
+/**
+ * Return the descriptor the next record of a walk arrives on
+ * @param walk The walk
+ * @return The descriptor, -1 if no Device is answering
+ */
+int domus_walk_descriptor(const DomusWalk *walk);
+
+/**
+ * Stop a walk, the Device answering is still read to the end but its records are dropped
+ * @param walk The walk
+ */
+void domus_walk_cancel(DomusWalk *walk);
+
+/**
+ * Render the records collected by a walk and free it
+ *  The Device answering must be read to the end first, see domus_walk_descriptor
+ * @param walk The walk
+ * @return The number of matching records read
+ */
+size_t domus_walk_end(DomusWalk *walk);
+
+/**
+ * Show COUNT, SUM, MIN, MAX and AVG of the Devices matching the filter, grouped by type and state
+ *  Every Control Device folds its children into one partial aggregate per group
+ * @param id The Device id whose subtree is aggregated or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The info filter
+ * @return true if at least one Device matches, false otherwise
+ */
+bool domus_aggregate(size_t id, const DeviceCommunicationFilter *filter);
+
+/**
+ * Show COUNT, ERRORS, P50, P90, P99 and MAX send to ack latency of every message type
+ *  Every Control Device merges the statistics of its subtree
+ * @param id The Control Device id whose subtree statistics are shown or DEVICE_MESSAGE_TO_ALL_DEVICES to add Domus
+ * @return true if something has been recorded, false otherwise
+ */
+bool domus_stats(size_t id);
+
+/**
+ * Show RSS, CPU time, CPU usage, context switches and open file descriptors of every Device process
+ *  The pids come with the info records of a single walk, /proc is sampled once for all of them
+ * @param id The Device id whose subtree is shown or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The predicates the Devices must match, can be NULL
+ * @param sort_by_cpu true to show the busiest processes first, false to keep the hierarchy order
+ * @return true if at least one Device has been shown, false otherwise
+ */
+bool domus_resources(size_t id, const DeviceCommunicationFilter *filter, bool sort_by_cpu);
+
+/**
+ * Begin tracing, every message sent until domus_trace_end carries the trace id
+ * @return The trace id
+ */
+size_t domus_trace_begin(void);
+
+/**
+ * End tracing, collect the spans recorded by every Device and show them as a timeline
+ * @param trace_id The trace id
+ * @param name The traced command
+ * @param export_file_name The file to export the spans to as Chrome trace JSON, NULL otherwise
+ * @return true if exported or not requested, false if the file cannot be written
+ */
+bool domus_trace_end(size_t trace_id, const char *name, const char *export_file_name);
+
 /**
  * Given an ID, set the switch label to switch_pos
+ *  With a condition the Device checks it and switches in the same step, otherwise it answers with its state and version
  * @param id The Device id
  * @param switch_label The Device Switch Label
  * @param switch_pos switch pos The Device Switch Position
+ * @param condition The condition the Device must satisfy, NULL to always switch
+ */
+void domus_switch(size_t id, const char *switch_label, const char *switch_pos,
+                  const DeviceCommunicationCondition *condition);
+
+/**
+ * Switch every target of a scene, each with its own label and position
+ *  The targets travel in a single SWITCH_MULTI message through the tree, a few if they do not fit in one
+ * @param scene The scene
+ * @return The number of switched targets, -1 if there are no Devices
+ */
+long domus_switch_multi(const DeviceCommunicationScene *scene);
+
+/**
+ * Switch the label of every Device matching a selector to switch_pos
+ *  Every Device decides if it is selected while the SWITCH_SELECT message walks the tree once
+ * @param filter The selector
+ * @param switch_label The Device Switch Label
+ * @param switch_pos The Device Switch Position
+ * @return The number of switched Devices, -1 if there are no Devices or the selector does not fit in a message
+ */
+long domus_switch_select(const DeviceCommunicationFilter *filter, const char *switch_label, const char *switch_pos);
+
+/**
+ * Open a transaction, the switches staged until the commit are applied to all their Devices or to none
+ * @param timeout The milliseconds a prepared Device waits for the commit before releasing itself
+ * @return true if opened, false if a transaction is already open
+ */
+bool domus_transaction_begin(unsigned long timeout);
+
+/**
+ * Check if a transaction is open
+ * @return true if open, false otherwise
+ */
+bool domus_transaction_is_open(void);
+
+/**
+ * Return the number of switches staged by the open transaction
+ * @return The number of staged switches, 0 if no transaction is open
+ */
+size_t domus_transaction_staged(void);
+
+/**
+ * Stage a switch in the open transaction, replacing the one staged for the same Device
+ * @param id The Device id
+ * @param switch_label The Device Switch Label
+ * @param switch_pos The Device Switch Position
+ * @return true if staged, false if no transaction is open or it is full
+ */
+bool domus_transaction_stage(size_t id, const char *switch_label, const char *switch_pos);
+
+/**
+ * Stage every target of a scene in the open transaction
+ * @param scene The scene
+ * @return The number of staged targets, -1 if no transaction is open
  */
-void domus_switch(size_t id, const char *switch_label, const char *switch_pos);
+long domus_transaction_stage_scene(const DeviceCommunicationScene *scene);
+
+/**
+ * Close the open transaction dropping its staged switches, no Device has been asked anything yet
+ */
+void domus_transaction_abort(void);
+
+/**
+ * Close the open transaction applying its staged switches in two walks of the tree
+ *  The PREPARE walk checks every switch and holds its Device until the deadline,
+ *  then a COMMIT walk switches them all or, if one target failed or is missing, an ABORT walk releases them all
+ * @return The number of switched Devices, -1 if aborted or no transaction is open
+ */
+long domus_transaction_commit(void);
 
 /**
  * Link a Device with a Control Device
@@ -102,6 +348,51 @@ void domus_switch(size_t id, const char *switch_label, const char *switch_pos);
  */
 int domus_link(size_t device_id, size_t control_device_id);
 
+/**
+ * Clone a Device and its subtree under the same parent, with new ids
+ *  The copies directly connected to Domus are forked together, the others are spawned with SPAWN_SUBTREE messages
+ * @param id The Device id
+ * @param count The number of copies
+ * @return The number of Devices spawned, -1 if the Device is not found or cannot be cloned
+ */
+long domus_clone(size_t id, size_t count);
+
+/**
+ * Save the topology and the registry values of every Device to a snapshot file
+ *  The Controller is saved too but, like in domus_load, it is not counted
+ * @param file_name The snapshot file
+ * @return The number of Devices saved, -1 if the file cannot be written
+ */
+long domus_save(const char *file_name);
+
+/**
+ * Replace every Device with the ones of a snapshot file
+ *  The Devices directly connected to Domus are forked together and their init values are sent in bulk,
+ *  the subtree below each of them is sent to it with SPAWN_SUBTREE messages
+ * @param file_name The snapshot file
+ * @return The number of Devices restored, -1 if the file is not a valid snapshot
+ */
+long domus_load(const char *file_name);
+
+/**
+ * Apply a journal entry again, without printing and without journaling it
+ * @param entry The journal entry
+ * @return true if at least one Device has been changed, false otherwise
+ */
+bool domus_replay(const DomusJournalEntry *entry);
+
+/**
+ * Return the id the next Device will get
+ * @return The next id
+ */
+size_t domus_next_id(void);
+
+/**
+ * Set the journal to recover when Domus starts and to keep writing afterwards
+ * @param file_name The journal file
+ */
+void domus_set_journal(const char *file_name);
+
 /**
  * Return the pid of the given Device ID
  * @param device_id The Device ID to get pid from
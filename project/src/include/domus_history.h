@@ -0,0 +1,120 @@
+#ifndef _DOMUS_HISTORY_H
+#define _DOMUS_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "util/util_series.h"
+
+#define DOMUS_HISTORY_DIRECTORY_LENGTH 200
+#define DOMUS_HISTORY_PATH_LENGTH 256
+/* Seconds between two samples of every Device */
+#define DOMUS_HISTORY_INTERVAL 60
+/* Days a point is kept for */
+#define DOMUS_HISTORY_RETENTION 7
+#define DOMUS_HISTORY_METRIC_LENGTH 16
+/* A query answers with at most this many aggregates */
+#define DOMUS_HISTORY_BUCKETS 20
+#define DOMUS_HISTORY_BLOCK_MAGIC "DMHB"
+
+/**
+ * Struct Domus History Block, the header of every block appended to a series file
+ *  The timestamps column and then the values column follow, the block is valid only if its CRC-32 matches
+ */
+typedef struct DomusHistoryBlock {
+    char magic[4];
+    uint32_t count;
+    int64_t first;
+    int64_t last;
+    uint32_t timestamps_length;
+    uint32_t values_length;
+    /* CRC-32 of the two columns */
+    uint32_t crc;
+    uint32_t reserved;
+} DomusHistoryBlock;
+
+/**
+ * Struct Domus History Series, the points of a metric of a Device not appended to its file yet
+ */
+typedef struct DomusHistorySeries {
+    size_t id;
+    size_t metric;
+    /* Flag if the Device answered the last sample */
+    bool seen;
+    SeriesEncoder encoder;
+} DomusHistorySeries;
+
+/**
+ * Struct Domus History Bucket, the aggregate of the points of a time range
+ */
+typedef struct DomusHistoryBucket {
+    time_t from;
+    time_t to;
+    size_t count;
+    double min;
+    double max;
+    double sum;
+    double last;
+} DomusHistoryBucket;
+
+/**
+ * Sample every Device every interval, sampling once right away
+ *  The history of a metric of a Device is kept in <directory>/<id>.<metric>
+ * @param directory The directory of the series files, created if missing
+ * @param interval The interval in seconds
+ * @param retention The retention in days
+ * @return true if enabled, false otherwise
+ */
+bool domus_history_enable(const char *directory, unsigned long interval, unsigned long retention);
+
+/**
+ * Stop sampling, the points not appended yet are appended to their files
+ * @return true if it was enabled, false otherwise
+ */
+bool domus_history_disable(void);
+
+/**
+ * Return the directory of the series files
+ * @return The directory, NULL if disabled
+ */
+const char *domus_history_directory(void);
+
+/**
+ * Return the interval of the samples
+ * @return The interval in seconds, 0 if disabled
+ */
+unsigned long domus_history_interval(void);
+
+/**
+ * Return the retention of the points
+ * @return The retention in days, 0 if disabled
+ */
+unsigned long domus_history_retention(void);
+
+/**
+ * Return the number of series being sampled
+ * @return The number of series
+ */
+size_t domus_history_series(void);
+
+/**
+ * Check if a metric is recorded for some Device type
+ * @param metric The name of the metric
+ * @return true if recorded, false otherwise
+ */
+bool domus_history_is_metric(const char *metric);
+
+/**
+ * Aggregate the points of a metric of a Device in at most DOMUS_HISTORY_BUCKETS buckets of the same width
+ *  Buckets without points are not returned, points older than the retention are ignored
+ * @param id The Device id
+ * @param metric The name of the metric
+ * @param from The first second of the range
+ * @param to The last second of the range
+ * @param buckets The buckets to fill, at least DOMUS_HISTORY_BUCKETS
+ * @return The number of buckets filled, -1 if history is disabled or the metric is unknown
+ */
+long domus_history_query(size_t id, const char *metric, time_t from, time_t to, DomusHistoryBucket *buckets);
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _DOMUS_JOURNAL_H
+#define _DOMUS_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DOMUS_JOURNAL_FILE_NAME_LENGTH 256
+/* Milliseconds between two syncs of the journal to disk */
+#define DOMUS_JOURNAL_WINDOW 50
+/* Size in bytes of the journal that starts a compaction */
+#define DOMUS_JOURNAL_COMPACT_SIZE (64 * 1024)
+#define DOMUS_JOURNAL_TEXT_LENGTH 64
+/* Entries of the same window are written together from a buffer of this size */
+#define DOMUS_JOURNAL_BUFFER_LENGTH 4096
+/* Suffix of the snapshot the journal is replayed on */
+#define DOMUS_JOURNAL_SNAPSHOT_SUFFIX ".snap"
+/* Suffix of the journal being compacted */
+#define DOMUS_JOURNAL_OLD_SUFFIX ".old"
+/* Id of an entry about all Devices */
+#define DOMUS_JOURNAL_ALL UINT32_MAX
+
+#define DOMUS_JOURNAL_ENTRY_ADD 1
+#define DOMUS_JOURNAL_ENTRY_DEL 2
+#define DOMUS_JOURNAL_ENTRY_LINK 3
+#define DOMUS_JOURNAL_ENTRY_SWITCH 4
+#define DOMUS_JOURNAL_ENTRY_CLONE 5
+
+/**
+ * Struct Domus Journal Frame, the beginning of every entry in the journal file
+ *  The entry is valid only if its CRC-32 matches, a torn write at the end is discarded
+ */
+typedef struct DomusJournalFrame {
+    /* Length of the entry that follows */
+    uint32_t length;
+    uint32_t crc;
+} DomusJournalFrame;
+
+/**
+ * Struct Domus Journal Entry, a mutation of the topology or of a state
+ *  Only the text up to its terminator is written
+ */
+typedef struct DomusJournalEntry {
+    uint64_t sequence;
+    uint16_t type;
+    /* Length of the text including the terminator */
+    uint16_t text_length;
+    uint32_t id;
+    /* Device Descriptor of an add, Control Device of a link, copies of a clone */
+    uint32_t argument;
+    /* Name of an add, switch message of a switch */
+    char text[DOMUS_JOURNAL_TEXT_LENGTH];
+} DomusJournalEntry;
+
+/**
+ * Start journaling to a file, the snapshot it is based on is written next to it
+ * @param file_name The journal file
+ * @param window The milliseconds between two syncs of the journal
+ * @param recover true to restore the snapshot and replay the journal first,
+ *  false to replace them with the current Devices
+ * @return The number of entries replayed, -1 if the journal cannot be written
+ */
+long domus_journal_enable(const char *file_name, unsigned long window, bool recover);
+
+/**
+ * Sync and stop journaling, waiting for a compaction in progress
+ * @return true if it was enabled, false otherwise
+ */
+bool domus_journal_disable(void);
+
+/**
+ * Return the journal file being written
+ * @return The journal file, NULL if disabled
+ */
+const char *domus_journal_file_name(void);
+
+/**
+ * Return the milliseconds between two syncs of the journal
+ * @return The window, 0 if disabled
+ */
+unsigned long domus_journal_window(void);
+
+/**
+ * Return the sequence of the last entry appended
+ * @return The sequence, 0 if there are none
+ */
+uint64_t domus_journal_sequence(void);
+
+/**
+ * Return the size of the journal since the last compaction
+ * @return The size in bytes
+ */
+size_t domus_journal_size(void);
+
+/**
+ * Append a mutation to the journal, nothing if disabled or replaying
+ *  The entry is buffered, written and synced together with the others of the same window
+ * @param type The entry type, one of DOMUS_JOURNAL_ENTRY_*
+ * @param id The Device id, DOMUS_JOURNAL_ALL for all Devices
+ * @param argument The Device Descriptor of an add or the Control Device of a link, 0 otherwise
+ * @param text The name of an add or the switch message of a switch, can be NULL
+ */
+void domus_journal_append(uint16_t type, size_t id, size_t argument, const char *text);
+
+/**
+ * Replace the snapshot with the current Devices and empty the journal
+ *  Used when the Devices change without entries, like after a load
+ * @return true if written, false otherwise
+ */
+bool domus_journal_checkpoint(void);
+
+#endif
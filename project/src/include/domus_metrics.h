@@ -0,0 +1,80 @@
+#ifndef _DOMUS_METRICS_H
+#define _DOMUS_METRICS_H
+
+#include <stdbool.h>
+#include "util/util_stopwatch.h"
+
+#define DOMUS_METRICS_FILE_NAME_LENGTH 256
+#define DOMUS_METRICS_INTERVAL 15
+/* Upper bounds in seconds of the exported latency histogram buckets */
+#define DOMUS_METRICS_LATENCY_BOUNDS {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25}
+
+#define DOMUS_METRICS_OPERATION_SPAWN 0
+#define DOMUS_METRICS_OPERATION_LINK 1
+#define DOMUS_METRICS_OPERATION_DEL 2
+#define DOMUS_METRICS_OPERATION_SAVE 3
+#define DOMUS_METRICS_OPERATION_LOAD 4
+#define DOMUS_METRICS_OPERATION_CLONE 5
+#define DOMUS_METRICS_OPERATIONS 6
+
+#define DOMUS_METRICS_REQUEST_DOMUS_PID 0
+#define DOMUS_METRICS_REQUEST_DEVICE_PID 1
+#define DOMUS_METRICS_REQUESTS 2
+
+/**
+ * Struct Domus Metrics Operation, how many times an operation has been executed and how long it took
+ */
+typedef struct DomusMetricsOperation {
+    unsigned long count;
+    unsigned long errors;
+    Stopwatch duration;
+} DomusMetricsOperation;
+
+/**
+ * Count an operation executed by Domus
+ * @param operation The operation, one of DOMUS_METRICS_OPERATION_*
+ * @param start When the operation started
+ * @param success true if the operation succeeded, false otherwise
+ */
+void domus_metrics_operation(size_t operation, Stopwatch start, bool success);
+
+/**
+ * Count a request received from Domus Manual
+ * @param request The request, one of DOMUS_METRICS_REQUEST_*
+ */
+void domus_metrics_request(size_t request);
+
+/**
+ * Write the metrics file every interval, writing it once right away
+ * @param file_name The metrics file, should end with .prom to be picked by the node_exporter textfile collector
+ * @param interval The interval in seconds
+ * @return true if the first write succeeded, false otherwise and nothing is scheduled
+ */
+bool domus_metrics_enable(const char *file_name, unsigned long interval);
+
+/**
+ * Stop writing the metrics file, the last one written is kept
+ * @return true if it was enabled, false otherwise
+ */
+bool domus_metrics_disable(void);
+
+/**
+ * Return the metrics file being written
+ * @return The metrics file, NULL if disabled
+ */
+const char *domus_metrics_file_name(void);
+
+/**
+ * Return the interval of the metrics file
+ * @return The interval in seconds, 0 if disabled
+ */
+unsigned long domus_metrics_interval(void);
+
+/**
+ * Write the metrics file in the Prometheus text format
+ *  The file is written next to the destination and renamed over it, scrapers never see a partial file
+ * @return true if written, false otherwise
+ */
+bool domus_metrics_write(void);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef _DOMUS_SCENE_H
+#define _DOMUS_SCENE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "collection/collection_list.h"
+#include "device/device_communication_scene.h"
+
+#define DOMUS_SCENE_NAME_LENGTH 32
+
+/**
+ * Struct Domus Group, Devices switched together
+ */
+typedef struct DomusGroup {
+    char name[DOMUS_SCENE_NAME_LENGTH];
+    size_t count;
+    size_t ids[DEVICE_COMMUNICATION_SCENE_TARGETS];
+} DomusGroup;
+
+/**
+ * Struct Domus Scene, Devices each with its own switch label and position
+ */
+typedef struct DomusScene {
+    char name[DOMUS_SCENE_NAME_LENGTH];
+    DeviceCommunicationScene scene;
+} DomusScene;
+
+/**
+ * Create a group, replacing the one with the same name
+ * @param name The name of the group
+ * @param ids The ids of the Devices
+ * @param count The number of ids, at most DEVICE_COMMUNICATION_SCENE_TARGETS
+ * @return true if created, false otherwise
+ */
+bool domus_group_create(const char *name, const size_t *ids, size_t count);
+
+/**
+ * Delete a group
+ * @param name The name of the group
+ * @return true if deleted, false if not found
+ */
+bool domus_group_delete(const char *name);
+
+/**
+ * Return a group
+ * @param name The name of the group
+ * @return The group, NULL if not found
+ */
+const DomusGroup *domus_group_get(const char *name);
+
+/**
+ * Return all groups
+ * @return The List of groups, can be empty
+ */
+const List *domus_groups(void);
+
+/**
+ * Switch every Device of a group with a single multi target switch, only staged if a transaction is open
+ * @param name The name of the group
+ * @param switch_label The Device Switch Label
+ * @param switch_pos The Device Switch Position
+ * @return The number of switched or staged Devices, -1 if the group is not found or there are no Devices
+ */
+long domus_group_switch(const char *name, const char *switch_label, const char *switch_pos);
+
+/**
+ * Create a scene, replacing the one with the same name
+ * @param name The name of the scene
+ * @param scene The targets of the scene
+ * @return true if created, false otherwise
+ */
+bool domus_scene_create(const char *name, const DeviceCommunicationScene *scene);
+
+/**
+ * Delete a scene
+ * @param name The name of the scene
+ * @return true if deleted, false if not found
+ */
+bool domus_scene_delete(const char *name);
+
+/**
+ * Return a scene
+ * @param name The name of the scene
+ * @return The scene, NULL if not found
+ */
+const DomusScene *domus_scene_get(const char *name);
+
+/**
+ * Return all scenes
+ * @return The List of scenes, can be empty
+ */
+const List *domus_scenes(void);
+
+/**
+ * Apply a scene with a single multi target switch, only staged if a transaction is open
+ * @param name The name of the scene
+ * @return The number of switched or staged Devices, -1 if the scene is not found or there are no Devices
+ */
+long domus_scene_apply(const char *name);
+
+/**
+ * Release all groups and scenes
+ */
+void domus_scene_tini(void);
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef _DOMUS_SNAPSHOT_H
+#define _DOMUS_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "collection/collection_list.h"
+#include "device/device.h"
+
+#define DOMUS_SNAPSHOT_MAGIC "DMSS"
+#define DOMUS_SNAPSHOT_MAGIC_LENGTH 4
+#define DOMUS_SNAPSHOT_VERSION 2
+#define DOMUS_SNAPSHOT_FILE_NAME_LENGTH 256
+/* Records and their values start at a multiple of it */
+#define DOMUS_SNAPSHOT_ALIGNMENT 4
+
+/**
+ * Struct Domus Snapshot Header, the beginning of a snapshot file
+ *  Integers are in the byte order of the machine that saved it
+ */
+typedef struct DomusSnapshotHeader {
+    char magic[DOMUS_SNAPSHOT_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t count;
+    /* The next id of the Domus Registry when saved */
+    uint32_t next_id;
+    /* The last journal entry included, see domus_journal */
+    uint64_t sequence;
+} DomusSnapshotHeader;
+
+/**
+ * Struct Domus Snapshot Record, a Device in the snapshot followed by its values
+ *  Records are in hierarchy order, a parent always comes before its children
+ */
+typedef struct DomusSnapshotRecord {
+    uint32_t id;
+    /* DOMUS_ID if directly connected to Domus */
+    uint32_t parent;
+    uint16_t device_descriptor;
+    /* Length of the values including the terminator */
+    uint16_t values_length;
+    char name[DEVICE_NAME_LENGTH];
+} DomusSnapshotRecord;
+
+/**
+ * Struct Domus Snapshot, a snapshot file mapped in memory
+ */
+typedef struct DomusSnapshot {
+    void *data;
+    size_t size;
+    const DomusSnapshotHeader *header;
+} DomusSnapshot;
+
+/**
+ * Write a snapshot file
+ *  The file is written next to the destination and renamed over it, a failed save never corrupts the old one
+ * @param file_name The snapshot file
+ * @param message_list The info messages of every Device in hierarchy order, the registry values are saved as is
+ * @param next_id The next id of the Domus Registry
+ * @param sequence The last journal entry included
+ * @return true if written, false otherwise
+ */
+bool domus_snapshot_write(const char *file_name, const List *message_list, size_t next_id, uint64_t sequence);
+
+/**
+ * Map a snapshot file in memory and validate it
+ *  Every record is checked once, iterating it afterwards needs no more checks
+ * @param file_name The snapshot file
+ * @return The Domus Snapshot, NULL if it cannot be read or it is not a valid snapshot
+ */
+DomusSnapshot *domus_snapshot_open(const char *file_name);
+
+/**
+ * Free a Domus Snapshot, unmapping the file
+ * @param snapshot The Domus Snapshot to free
+ * @return true if freed, false otherwise
+ */
+bool free_domus_snapshot(DomusSnapshot *snapshot);
+
+/**
+ * Return the record at the offset and move the offset to the next one
+ * @param snapshot The Domus Snapshot
+ * @param offset The offset of the record, 0 for the first one
+ * @return The record, NULL when there are no more records
+ */
+const DomusSnapshotRecord *domus_snapshot_next(const DomusSnapshot *snapshot, size_t *offset);
+
+/**
+ * Return the values of a record, the registry fields as sent in the info message
+ * @param record The record
+ * @return The values
+ */
+const char *domus_snapshot_values(const DomusSnapshotRecord *record);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _UTIL_CRC_H
+#define _UTIL_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Initial value of a CRC-32 computed in pieces */
+#define CRC32_INIT 0
+
+/**
+ * Continue a CRC-32 (IEEE 802.3, the one of zlib and gzip) over more data
+ * @param crc The CRC-32 of the previous data, CRC32_INIT for the first piece
+ * @param data The data
+ * @param length The length of the data
+ * @return The CRC-32 of the previous data followed by this data
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t length);
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef _UTIL_OUTPUT_H
+#define _UTIL_OUTPUT_H
+
+#include <stdbool.h>
+
+#define OUTPUT_FORMAT_TABLE 0
+#define OUTPUT_FORMAT_JSON 1
+#define OUTPUT_FORMAT_CSV 2
+
+#define OUTPUT_FORMAT_NAME_TABLE "table"
+#define OUTPUT_FORMAT_NAME_JSON "json"
+#define OUTPUT_FORMAT_NAME_CSV "csv"
+
+#define OUTPUT_FLAG_PREFIX "--"
+
+#define OUTPUT_KEY_LENGTH 32
+#define OUTPUT_VALUE_LENGTH 64
+
+#define OUTPUT_FIELD_TYPE_NULL 0
+#define OUTPUT_FIELD_TYPE_BOOL 1
+#define OUTPUT_FIELD_TYPE_LONG 2
+#define OUTPUT_FIELD_TYPE_DOUBLE 3
+#define OUTPUT_FIELD_TYPE_STRING 4
+
+/**
+ * Output Field Struct, a typed key value pair of a record
+ */
+typedef struct OutputField {
+    char key[OUTPUT_KEY_LENGTH];
+    int type;
+    union value {
+        bool Bool;
+        long Long;
+        double Double;
+        char String[OUTPUT_VALUE_LENGTH];
+    } value;
+} OutputField;
+
+/**
+ * Return the current output format
+ *  The per-command format, if any, wins over the session one
+ * @return The output format
+ */
+int output_format(void);
+
+/**
+ * Return the output format given its name
+ * @param name The format name: table | json | csv
+ * @return The output format, -1 if unknown
+ */
+int output_format_by_name(const char *name);
+
+/**
+ * Return the output format given a command flag
+ * @param flag The flag: --table | --json | --csv
+ * @return The output format, -1 if not an output flag
+ */
+int output_format_by_flag(const char *flag);
+
+/**
+ * Return the name of an output format
+ * @param format The output format
+ * @return The format name
+ */
+const char *output_format_name(int format);
+
+/**
+ * Set the output format for the whole session
+ * @param format The output format
+ * @return true if set, false if unknown
+ */
+bool output_set_format(int format);
+
+/**
+ * Set the output format for the current command only
+ * @param format The output format, -1 to return to the session format
+ * @return The previous command output format
+ */
+int output_set_command_format(int format);
+
+/**
+ * Start collecting records
+ */
+void output_begin(void);
+
+/**
+ * Start a new record, next fields are added to it
+ */
+void output_record(void);
+
+/**
+ * Add a null field to the current record
+ * @param key The field key
+ */
+void output_null(const char *key);
+
+/**
+ * Add a bool field to the current record
+ * @param key The field key
+ * @param value The field value
+ */
+void output_bool(const char *key, bool value);
+
+/**
+ * Add a long field to the current record
+ * @param key The field key
+ * @param value The field value
+ */
+void output_long(const char *key, long value);
+
+/**
+ * Add a double field to the current record
+ * @param key The field key
+ * @param value The field value
+ */
+void output_double(const char *key, double value);
+
+/**
+ * Add a string field to the current record
+ * @param key The field key
+ * @param value The field value
+ */
+void output_string(const char *key, const char *value);
+
+/**
+ * Render all collected records in the current format and release them
+ *  JSON is an array of objects, CSV has a header with the union of all keys
+ */
+void output_end(void);
+
+/**
+ * Release all collected records without rendering them
+ */
+void output_discard(void);
+
+#endif
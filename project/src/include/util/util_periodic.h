@@ -0,0 +1,40 @@
+#ifndef _UTIL_PERIODIC_H
+#define _UTIL_PERIODIC_H
+
+#include <stdbool.h>
+
+#define PERIODIC_TASKS_MAX 8
+
+/**
+ * Periodic task function
+ */
+typedef void (*PeriodicTask)(void);
+
+/**
+ * Run a task every interval, the first run is one interval from now
+ *  Registering a task again only changes its interval
+ * @param task The task
+ * @param interval_ms The interval in milliseconds, greater than 0
+ * @return true if registered, false if there is no room for another task
+ */
+bool periodic_register(PeriodicTask task, unsigned long interval_ms);
+
+/**
+ * Stop running a task
+ * @param task The task
+ * @return true if it was registered, false otherwise
+ */
+bool periodic_unregister(PeriodicTask task);
+
+/**
+ * Return the milliseconds until the next task is due
+ * @return The milliseconds, 0 if a task is already due, -1 if there are no tasks
+ */
+long periodic_timeout(void);
+
+/**
+ * Run every task that is due, a task never runs inside another one
+ */
+void periodic_run(void);
+
+#endif
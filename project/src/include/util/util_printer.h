@@ -19,6 +19,8 @@
 #define BACKGROUND_COLOR_YELLOW "\x1b[43m"
 #define BACKGROUND_COLOR_WHITE "\x1b[37m"
 
+#define PRINTER_BUFFER_SIZE 4096
+
 /**
  * Print the string to stdout
  * @param format The String
@@ -49,4 +51,23 @@ void println(const char *format, ...);
  */
 void println_color(const char *color, const char *format, ...);
 
+/**
+ * Print the string to stdout without any color code
+ * @param format The String
+ * @param ... Format tags
+ */
+void print_plain(const char *format, ...);
+
+/**
+ * Start buffering stdout, everything printed is collected in a single growing buffer
+ *  Calls can be nested, the buffer is written on every printer_buffer_end
+ */
+void printer_buffer_begin(void);
+
+/**
+ * Write the buffered output with a single write
+ *  Buffering stops when the outermost printer_buffer_begin is closed
+ */
+void printer_buffer_end(void);
+
 #endif
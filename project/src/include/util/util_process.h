@@ -0,0 +1,56 @@
+#ifndef _UTIL_PROCESS_H
+#define _UTIL_PROCESS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "util/util_stopwatch.h"
+
+/* Samples younger than this are served from the cache */
+#define PROCESS_RESOURCES_CACHE_TTL_MS 500
+#define PROCESS_RESOURCES_PATH_LENGTH 64
+#define PROCESS_RESOURCES_LINE_LENGTH 512
+
+/**
+ * Struct Process Resources, what a process costs as reported by /proc
+ */
+typedef struct ProcessResources {
+    pid_t pid;
+    /* Resident set size in KiB */
+    unsigned long rss;
+    /* User plus system CPU time in nanoseconds */
+    unsigned long long cpu_time;
+    /* CPU usage since the previous sample, since the process start for the first one */
+    double cpu_percent;
+    unsigned long voluntary_context_switches;
+    unsigned long involuntary_context_switches;
+    /* Open file descriptors, -1 if not readable */
+    long fds;
+    Stopwatch sampled;
+} ProcessResources;
+
+/**
+ * Read the resources of a process from /proc, cpu_percent is the average since the process start
+ * @param pid The pid of the process
+ * @param resources The resources to fill
+ * @return true if read, false if the process does not exist or /proc is not available
+ */
+bool process_resources_read(pid_t pid, ProcessResources *resources);
+
+/**
+ * Return the resources of a process, read again only if the cached sample is older than the ttl
+ *  A process that cannot be read is dropped from the cache
+ * @param pid The pid of the process
+ * @return The cached resources, NULL if the process cannot be read
+ */
+const ProcessResources *process_resources_sample(pid_t pid);
+
+/**
+ * Sample the resources of many processes in one pass through the cache
+ * @param pids The pids of the processes
+ * @param count The number of pids
+ * @param resources The resources to fill, one for every pid, pid is 0 if the process cannot be read
+ * @return The number of processes read
+ */
+size_t process_resources_sample_all(const pid_t *pids, size_t count, ProcessResources *resources);
+
+#endif
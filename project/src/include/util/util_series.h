@@ -0,0 +1,108 @@
+#ifndef _UTIL_SERIES_H
+#define _UTIL_SERIES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Points of a block, an encoder is full when it reaches it */
+#define SERIES_BLOCK_POINTS 120
+/* Worst case of a timestamp is 4 + 32 bits, the first one is 64 bits */
+#define SERIES_TIMESTAMPS_LENGTH (8 + SERIES_BLOCK_POINTS * 5)
+/* Worst case of a value is 2 + 5 + 6 + 64 bits */
+#define SERIES_VALUES_LENGTH (8 + SERIES_BLOCK_POINTS * 10)
+
+/**
+ * Struct Series Bits, a bit stream written most significant bit first
+ */
+typedef struct SeriesBits {
+    unsigned char *data;
+    size_t capacity;
+    /* Bits written or read */
+    size_t bits;
+} SeriesBits;
+
+/**
+ * Struct Series Encoder, a block of points compressed in two columns
+ *  Timestamps are stored as delta of delta, values as XOR with the previous one
+ */
+typedef struct SeriesEncoder {
+    unsigned char timestamps_data[SERIES_TIMESTAMPS_LENGTH];
+    unsigned char values_data[SERIES_VALUES_LENGTH];
+    SeriesBits timestamps;
+    SeriesBits values;
+    size_t count;
+    int64_t first;
+    int64_t last;
+    int64_t delta;
+    uint64_t value;
+    unsigned int leading;
+    unsigned int trailing;
+} SeriesEncoder;
+
+/**
+ * Struct Series Decoder, reads back the points of a block
+ */
+typedef struct SeriesDecoder {
+    SeriesBits timestamps;
+    SeriesBits values;
+    size_t count;
+    size_t index;
+    int64_t last;
+    int64_t delta;
+    uint64_t value;
+    unsigned int leading;
+    unsigned int trailing;
+} SeriesDecoder;
+
+/**
+ * Empty an encoder
+ * @param encoder The Series Encoder
+ */
+void series_encoder_reset(SeriesEncoder *encoder);
+
+/**
+ * Append a point, timestamps must not go backwards
+ * @param encoder The Series Encoder
+ * @param timestamp The timestamp in seconds
+ * @param value The value
+ * @return true if appended, false if the block is full or the timestamp goes backwards
+ */
+bool series_encoder_append(SeriesEncoder *encoder, int64_t timestamp, double value);
+
+/**
+ * Return the bytes used by the timestamps column
+ * @param encoder The Series Encoder
+ * @return The length in bytes
+ */
+size_t series_encoder_timestamps_length(const SeriesEncoder *encoder);
+
+/**
+ * Return the bytes used by the values column
+ * @param encoder The Series Encoder
+ * @return The length in bytes
+ */
+size_t series_encoder_values_length(const SeriesEncoder *encoder);
+
+/**
+ * Start reading a block
+ * @param decoder The Series Decoder
+ * @param timestamps The timestamps column
+ * @param timestamps_length The length in bytes of the timestamps column
+ * @param values The values column
+ * @param values_length The length in bytes of the values column
+ * @param count The number of points
+ */
+void series_decoder_init(SeriesDecoder *decoder, const unsigned char *timestamps, size_t timestamps_length,
+                         const unsigned char *values, size_t values_length, size_t count);
+
+/**
+ * Read the next point
+ * @param decoder The Series Decoder
+ * @param timestamp The timestamp read
+ * @param value The value read
+ * @return true if read, false if there are no more points or the block is truncated
+ */
+bool series_decoder_next(SeriesDecoder *decoder, int64_t *timestamp, double *value);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _UTIL_STOPWATCH_H
+#define _UTIL_STOPWATCH_H
+
+#define STOPWATCH_NS_PER_MS 1000000.0
+
+/**
+ * Stopwatch time point in nanoseconds
+ */
+typedef unsigned long long Stopwatch;
+
+/**
+ * Read the current time from a monotonic clock
+ *  The value is meaningful only when compared to another time point
+ * @return The current time point in nanoseconds
+ */
+Stopwatch stopwatch_now(void);
+
+/**
+ * Nanoseconds elapsed since a time point
+ * @param start The start time point
+ * @return Elapsed nanoseconds
+ */
+Stopwatch stopwatch_elapsed(Stopwatch start);
+
+/**
+ * Milliseconds elapsed since a time point
+ * @param start The start time point
+ * @return Elapsed milliseconds
+ */
+double stopwatch_elapsed_ms(Stopwatch start);
+
+#endif
@@ -1,8 +1,16 @@
 
+#include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
 #include "cli/cli.h"
+#include "cli/cli_job.h"
 #include "cli/command/command.h"
 #include "util/util_printer.h"
+#include "util/util_stopwatch.h"
+#include "util/util_periodic.h"
 #include "collection/collection_list.h"
 #include "collection/collection_trie.h"
 
@@ -10,8 +18,84 @@
 static List *cli_list = NULL;
 static Node *cli_node = NULL;
 
+/**
+ * Script stream for batch mode, NULL if commands are read from stdin
+ */
+static FILE *cli_script = NULL;
+
+/**
+ * Timing stream for batch mode, NULL if latencies are not recorded
+ */
+static FILE *cli_timing = NULL;
+
+/**
+ * Terminal attributes before entering raw mode, restored at exit
+ */
+static struct termios cli_termios_cooked;
+
+/**
+ * Flag if the terminal is currently in raw mode
+ */
+static bool cli_termios_raw = false;
+
+/**
+ * Switch the terminal in raw mode, only once per session
+ *  Special characters are delivered as they are typed, output processing is kept
+ */
+static void cli_terminal_raw(void);
+
+/**
+ * Restore the terminal attributes saved by cli_terminal_raw
+ */
+static void cli_terminal_restore(void);
+
+/**
+ * Interactive loop, read lines using the raw mode line editor
+ */
+static void cli_start_interactive(void);
+
+/**
+ * Batch loop, read and execute lines from stream until EOF or exit
+ * @param stream The input stream
+ */
+static void cli_start_batch(FILE *stream);
+
+/**
+ * Read the next line from a stream without any line editing
+ *  A line longer than the buffer is skipped with an error
+ * @param stream The input stream
+ * @return Buffer or NULL if EOF
+ */
+static char *cli_read_script_line(FILE *stream);
+
+/**
+ * Wait until a script stream has input, running the periodic tasks that become due meanwhile
+ *  The records of the background jobs are printed as they arrive
+ *  The stream must be unbuffered, otherwise buffered input is not seen
+ * @param stream The input stream
+ */
+static void cli_wait_script(FILE *stream);
+
+/**
+ * Wait until stdin has input, running the periodic tasks that become due meanwhile
+ *  The records of the background jobs are printed as they arrive
+ *  stdin must be unbuffered, otherwise buffered input is not seen
+ * @param buffer The line being typed
+ * @param position The length of the line being typed
+ */
+static void cli_wait_input(const char *buffer, int position);
+
+/**
+ * Print the records of the background jobs that have arrived in place of the line being typed,
+ * then show the prompt and the line again
+ * @param buffer The line being typed
+ * @param position The length of the line being typed
+ */
+static void cli_print_jobs(const char *buffer, int position);
+
 /**
  * Execute the command passed in args[0] or CONTINUE if no command found or args[0] == NULL
+ *  Periodic tasks that became due during the command run after it
  * @param args Argument command + params
  * @return CLI status code: 'CONTINUE' | 'TERMINATE'
  */
@@ -25,29 +109,236 @@ static int cli_execute(char **args);
  */
 static char *cli_read_line(void);
 
-/**
- * Split the line in tokens and return an array of strings
- * @param line Buffer current line
- * @return Array of strings terminating with NULL
- */
-static char **cli_split_line(char *line);
-
 void cli_start(void) {
+    cli_list = new_list(NULL, NULL);
+
+    if (cli_is_interactive()) {
+        cli_start_interactive();
+    } else {
+        cli_start_batch((cli_script != NULL) ? cli_script : stdin);
+    }
+
+    cli_job_tini();
+}
+
+bool cli_is_interactive(void) {
+    return cli_script == NULL && isatty(STDIN_FILENO);
+}
+
+bool cli_set_script(const char *file_name) {
+    FILE *script;
+    if (file_name == NULL) return false;
+
+    if ((script = fopen(file_name, "r")) == NULL) return false;
+    if (cli_script != NULL) fclose(cli_script);
+    cli_script = script;
+
+    return true;
+}
+
+bool cli_set_timing(const char *file_name) {
+    FILE *timing;
+    if (file_name == NULL) return false;
+
+    if ((timing = fopen(file_name, "w")) == NULL) return false;
+    if (cli_timing != NULL) fclose(cli_timing);
+    cli_timing = timing;
+
+    return true;
+}
+
+static void cli_start_interactive(void) {
     char *line;
     char **args;
     int status;
 
-    cli_list = new_list(NULL, NULL);
+    cli_terminal_raw();
+    /* Every key is read on its own, so waiting on the descriptor never misses typed input */
+    setvbuf(stdin, NULL, _IONBF, 0);
 
     do {
         print("%s ", CLI_POINTER);
         line = cli_read_line();
         args = cli_split_line(line);
+        /* A hung Command can be stopped with Ctrl + C, the line editor reads it as a character */
+        cli_terminal_signals(true);
         status = cli_execute(args);
+        cli_terminal_signals(false);
 
         free(line);
         free(args);
     } while (status);
+
+    cli_terminal_restore();
+}
+
+static void cli_start_batch(FILE *stream) {
+    char *line;
+    char **args;
+    int status = CLI_CONTINUE;
+    Stopwatch start;
+
+    /* Every line is read on its own, so waiting on the descriptor never misses buffered input */
+    setvbuf(stream, NULL, _IONBF, 0);
+
+    while (status) {
+        cli_wait_script(stream);
+        if ((line = cli_read_script_line(stream)) == NULL) break;
+
+        args = cli_split_line(line);
+        /* Skip comments */
+        if (args[0] == NULL || args[0][0] != CLI_CHARACTER_COMMENT) {
+            start = stopwatch_now();
+            status = cli_execute(args);
+            if (cli_timing != NULL && args[0] != NULL) {
+                fprintf(cli_timing, "%s,%.6lf\n", args[0], stopwatch_elapsed_ms(start));
+            }
+        }
+        fflush(stdout);
+
+        free(line);
+        free(args);
+    }
+
+    /* A script ends once its jobs have printed every record */
+    cli_job_wait(CLI_JOB_ALL);
+
+    if (stream != stdin) {
+        fclose(stream);
+        cli_script = NULL;
+    }
+    if (cli_timing != NULL) {
+        fclose(cli_timing);
+        cli_timing = NULL;
+    }
+}
+
+static char *cli_read_script_line(FILE *stream) {
+    size_t length;
+    int c;
+    char *buffer = (char *) malloc(sizeof(char) * CLI_READ_LINE_BUFFER_SIZE);
+    if (buffer == NULL) {
+        perror("Read Script Line Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    if (fgets(buffer, CLI_READ_LINE_BUFFER_SIZE, stream) == NULL) {
+        free(buffer);
+        return NULL;
+    }
+
+    /* The rest of a line too long is dropped, it must not run as another command */
+    length = strlen(buffer);
+    if (length > 0 && buffer[length - 1] != '\n' && (c = getc(stream)) != EOF && c != '\n') {
+        while ((c = getc(stream)) != EOF && c != '\n');
+        println_color(COLOR_RED, "\tLine longer than %d characters skipped", CLI_READ_LINE_BUFFER_SIZE - 1);
+        buffer[0] = CLI_STRING_TERMINATOR;
+    }
+
+    return buffer;
+}
+
+static void cli_terminal_raw(void) {
+    struct termios raw;
+    if (cli_termios_raw || tcgetattr(STDIN_FILENO, &cli_termios_cooked) == -1) return;
+
+    raw = cli_termios_cooked;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    /* Typed characters are echoed by the terminal, the line editor relies on it */
+    raw.c_lflag &= ~(ICANON | IEXTEN | ISIG);
+    raw.c_cflag |= CS8;
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) {
+        perror("Terminal Raw Mode");
+        return;
+    }
+
+    cli_termios_raw = true;
+    atexit(cli_terminal_restore);
+}
+
+void cli_terminal_signals(bool enabled) {
+    struct termios attributes;
+    if (!cli_termios_raw || tcgetattr(STDIN_FILENO, &attributes) == -1) return;
+
+    if (enabled) attributes.c_lflag |= ISIG;
+    else attributes.c_lflag &= ~ISIG;
+    tcsetattr(STDIN_FILENO, TCSANOW, &attributes);
+}
+
+static void cli_terminal_restore(void) {
+    if (!cli_termios_raw) return;
+
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &cli_termios_cooked);
+    cli_termios_raw = false;
+}
+
+static void cli_wait_script(FILE *stream) {
+    struct pollfd descriptors[CLI_JOB_MAX + 1];
+    size_t length;
+    long timeout;
+    int ready;
+
+    while (true) {
+        descriptors[0].fd = fileno(stream);
+        descriptors[0].events = POLLIN;
+        descriptors[0].revents = 0;
+        length = 1 + cli_job_descriptors(descriptors + 1, CLI_JOB_MAX);
+
+        if ((timeout = periodic_timeout()) != 0) {
+            ready = poll(descriptors, length, (int) timeout);
+            /* Devices and Domus Manual interrupt with signals */
+            if (ready == -1 && errno == EINTR) continue;
+            if (ready == -1 || descriptors[0].revents != 0) return;
+            if (ready > 0) {
+                cli_job_run();
+                continue;
+            }
+        }
+
+        cli_job_quiesce();
+        periodic_run();
+        cli_job_run();
+    }
+}
+
+static void cli_wait_input(const char *buffer, int position) {
+    struct pollfd descriptors[CLI_JOB_MAX + 1];
+    size_t length;
+    long timeout;
+    int ready;
+
+    while (true) {
+        descriptors[0].fd = STDIN_FILENO;
+        descriptors[0].events = POLLIN;
+        descriptors[0].revents = 0;
+        length = 1 + cli_job_descriptors(descriptors + 1, CLI_JOB_MAX);
+
+        if ((timeout = periodic_timeout()) != 0) {
+            ready = poll(descriptors, length, (int) timeout);
+            /* Devices and Domus Manual interrupt with signals */
+            if (ready == -1 && errno == EINTR) continue;
+            if (ready == -1 || descriptors[0].revents != 0) return;
+            if (ready > 0) {
+                cli_print_jobs(buffer, position);
+                continue;
+            }
+        }
+
+        cli_job_quiesce();
+        periodic_run();
+        if (cli_job_count() > 0) cli_print_jobs(buffer, position);
+    }
+}
+
+static void cli_print_jobs(const char *buffer, int position) {
+    printf("\r\033[K");
+    fflush(stdout);
+    cli_job_run();
+    print("%s %.*s", CLI_POINTER, position, buffer);
+    fflush(stdout);
 }
 
 static int cli_execute(char **args) {
@@ -57,6 +348,12 @@ static int cli_execute(char **args) {
         println_color(COLOR_RED, "\tCommand '%s' not found", args[0]);
         status = CLI_CONTINUE;
     }
+    if (status && periodic_timeout() == 0) {
+        cli_job_quiesce();
+        periodic_run();
+    }
+    /* Jobs stopped by the Command go on with the next Device */
+    if (status) cli_job_run();
     return status;
 }
 
@@ -158,20 +455,21 @@ static char *cli_read_line(void) {
         exit(EXIT_FAILURE);
     }
 
-    /*
-     * switch to raw terminal mode in order
-     * to catch special characters
-     */
-    system("stty raw");
-
     while (true) {
 
+        cli_wait_input(buffer, position);
         c = getchar();
 
+        if (c == EOF) {
+            strcpy(buffer, "exit");
+            return buffer;
+        }
+
         if (isCapital(c) || isLower(c) || isNumber(c) || c == CLI_CHARACTER_DELETE ||
             c == CLI_CHARACTER_CARRIAGE_RETURN || c == CLI_CHARACTER_TAB || c == CLI_CHARACTER_ARROW ||
             c == CLI_CHARACTER_EXIT || c == CLI_CHARACTER_SPACE || c == CLI_CHARACTER_MINUS ||
-            c == CLI_CHARACTER_QUESTION_MARK || c == CLI_CHARACTER_UNDERSCORE || c == CLI_CHARACTER_COLON) {
+            c == CLI_CHARACTER_QUESTION_MARK || c == CLI_CHARACTER_UNDERSCORE || c == CLI_CHARACTER_COLON ||
+            c == CLI_CHARACTER_DOT || c == CLI_CHARACTER_SLASH || c == CLI_CHARACTER_AMPERSAND) {
             switch (c) {
                 /*
                  * If Ctrl + C is typed
@@ -182,10 +480,6 @@ static char *cli_read_line(void) {
                      */
                     clear_from_char(position);
                     printf("\n");
-                    /*
-                    * switch back to normal terminal
-                    */
-                    system("stty cooked");
                     strcpy(buffer, "exit");
                     return (buffer);
                 }
@@ -228,7 +522,6 @@ static char *cli_read_line(void) {
                     white_space(3);
                     cursor_left(0);
                     printf("\n");
-                    system("stty cooked");
 
                     /*
                      * Do not add empty buffer to list
@@ -344,13 +637,8 @@ static char *cli_read_line(void) {
                 }
 
                 default: {
-                    if (c == EOF) {
-                        exit(EXIT_SUCCESS);
-                    } else {
-
-                        buffer[position] = c;
-                        position++;
-                    }
+                    buffer[position] = c;
+                    position++;
                 }
             }
         } else {
@@ -360,7 +648,7 @@ static char *cli_read_line(void) {
 }
 
 
-static char **cli_split_line(char *line) {
+char **cli_split_line(char *line) {
     int position = 0;
     int buffer_size = CLI_SPLIT_LINE_BUFFER_SIZE;
     char *token;
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "cli/cli.h"
+#include "cli/cli_job.h"
+#include "collection/collection_list.h"
+#include "util/util_periodic.h"
+#include "util/util_printer.h"
+
+/**
+ * Jobs running, in start order
+ */
+static List *cli_jobs = NULL;
+
+/**
+ * The id of the next job
+ */
+static size_t cli_job_next_id = 1;
+
+/**
+ * Find a job given its id
+ * @param id The job id
+ * @return The job, NULL if not found
+ */
+static CliJob *cli_job_find(size_t id);
+
+/**
+ * Report a job, end its walk and remove it
+ * @param job The job
+ */
+static void cli_job_finish(CliJob *job);
+
+/**
+ * Wait until a job finishes, reading Ctrl + C as a character
+ * @param id The job id or CLI_JOB_ALL
+ * @return true if the job finished, false if waiting was interrupted
+ */
+static bool cli_job_wait_logic(size_t id);
+
+bool cli_job_start(char **args, DomusWalk *walk) {
+    CliJob *job;
+    size_t length = 0;
+    size_t i;
+    if (args == NULL || walk == NULL) {
+        println("\tNo Devices");
+        return false;
+    }
+    if (cli_jobs == NULL) cli_jobs = new_list(NULL, NULL);
+    if (cli_jobs->size >= CLI_JOB_MAX) {
+        domus_walk_cancel(walk);
+        domus_walk_end(walk);
+        println_color(COLOR_RED, "\tToo many jobs, wait for one of them to finish");
+        return false;
+    }
+
+    job = (CliJob *) malloc(sizeof(CliJob));
+    if (job == NULL) {
+        perror("Cli Job Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    job->id = cli_job_next_id++;
+    job->line[0] = '\0';
+    for (i = 0; args[i] != NULL && length < CLI_JOB_LINE_LENGTH - 1; ++i) {
+        length += snprintf(job->line + length, CLI_JOB_LINE_LENGTH - length, (i == 0) ? "%s" : " %s", args[i]);
+    }
+    job->walk = walk;
+    job->start = stopwatch_now();
+    list_add_last(cli_jobs, job);
+
+    println("\t[%lu] %s", job->id, job->line);
+    /* Ask the first Device right away */
+    domus_walk_step(walk, false);
+
+    return true;
+}
+
+size_t cli_job_count(void) {
+    return (cli_jobs == NULL) ? 0 : cli_jobs->size;
+}
+
+size_t cli_job_descriptors(struct pollfd *descriptors, size_t length) {
+    CliJob *data;
+    size_t count = 0;
+    int descriptor;
+    if (cli_jobs == NULL || descriptors == NULL) return 0;
+
+    list_for_each(data, cli_jobs) {
+        if (count >= length) break;
+        if ((descriptor = domus_walk_descriptor(data->walk)) == -1) continue;
+
+        descriptors[count].fd = descriptor;
+        descriptors[count].events = POLLIN;
+        descriptors[count].revents = 0;
+        count++;
+    }
+
+    return count;
+}
+
+bool cli_job_run(void) {
+    CliJob *job;
+    Node *node;
+    Node *next;
+    int status;
+    bool progress = true;
+    bool ran = false;
+    if (cli_jobs == NULL) return false;
+
+    printer_buffer_begin();
+    /* A job waiting for a Device read by another job goes on once that job moves to the next Device */
+    while (progress) {
+        progress = false;
+        for (node = cli_jobs->head; node != NULL; node = next) {
+            next = node->next;
+            job = (CliJob *) node->data;
+
+            while ((status = domus_walk_step(job->walk, false)) == DOMUS_WALK_RECORD) progress = true;
+            if (status == DOMUS_WALK_DONE) {
+                cli_job_finish(job);
+                progress = true;
+            }
+        }
+        ran |= progress;
+    }
+    printer_buffer_end();
+
+    return ran;
+}
+
+void cli_job_quiesce(void) {
+    CliJob *data;
+    if (cli_jobs == NULL) return;
+
+    printer_buffer_begin();
+    list_for_each(data, cli_jobs) {
+        while (domus_walk_descriptor(data->walk) != -1) domus_walk_step(data->walk, true);
+    }
+    printer_buffer_end();
+}
+
+bool cli_job_wait(size_t id) {
+    bool toRtn;
+    if (id != CLI_JOB_ALL && cli_job_find(id) == NULL) return false;
+
+    /* Ctrl + C stops waiting instead of stopping Domus */
+    cli_terminal_signals(false);
+    toRtn = cli_job_wait_logic(id);
+    cli_terminal_signals(true);
+
+    return toRtn;
+}
+
+static bool cli_job_wait_logic(size_t id) {
+    struct pollfd descriptors[CLI_JOB_MAX + 1];
+    size_t length;
+    long timeout;
+    int c;
+
+    while (true) {
+        cli_job_run();
+        if ((id == CLI_JOB_ALL) ? cli_job_count() == 0 : cli_job_find(id) == NULL) return true;
+
+        length = cli_job_descriptors(descriptors, CLI_JOB_MAX);
+        if (cli_is_interactive()) {
+            descriptors[length].fd = STDIN_FILENO;
+            descriptors[length].events = POLLIN;
+            descriptors[length].revents = 0;
+            length++;
+        }
+
+        timeout = periodic_timeout();
+        /* Devices and Domus Manual interrupt with signals */
+        if (poll(descriptors, length, (int) timeout) == -1 && errno != EINTR) return false;
+
+        if (periodic_timeout() == 0) {
+            cli_job_quiesce();
+            periodic_run();
+        }
+        if (cli_is_interactive() && (descriptors[length - 1].revents & POLLIN)) {
+            /* Other keys are dropped, the prompt is not shown while waiting */
+            if ((c = getchar()) == CLI_CHARACTER_EXIT || c == EOF) {
+                println("");
+                return false;
+            }
+        }
+    }
+}
+
+bool cli_job_cancel(size_t id) {
+    CliJob *job;
+    if ((job = cli_job_find(id)) == NULL) return false;
+
+    domus_walk_cancel(job->walk);
+    cli_job_finish(job);
+
+    return true;
+}
+
+void cli_job_print(void) {
+    CliJob *data;
+    if (cli_job_count() == 0) {
+        println("\tNo jobs");
+        return;
+    }
+
+    list_for_each(data, cli_jobs) {
+        println("\t[%lu] Running %-*s %lu records in %.3lf ms", data->id, CLI_JOB_LINE_LENGTH / 2, data->line,
+                data->walk->records, stopwatch_elapsed_ms(data->start));
+    }
+}
+
+void cli_job_tini(void) {
+    CliJob *job;
+    if (cli_jobs == NULL) return;
+
+    while ((job = (CliJob *) list_get_first(cli_jobs)) != NULL) {
+        domus_walk_cancel(job->walk);
+        cli_job_finish(job);
+    }
+
+    free_list(cli_jobs);
+    cli_jobs = NULL;
+}
+
+static CliJob *cli_job_find(size_t id) {
+    CliJob *data;
+    if (cli_jobs == NULL) return NULL;
+
+    list_for_each(data, cli_jobs) {
+        if (id == CLI_JOB_ALL || data->id == id) return data;
+    }
+
+    return NULL;
+}
+
+static void cli_job_finish(CliJob *job) {
+    Node *node;
+    size_t index = 0;
+    size_t records;
+    bool cancelled = job->walk->cancelled;
+
+    records = domus_walk_end(job->walk);
+    if (cancelled) {
+        println_color(COLOR_YELLOW, "\t[%lu] Cancelled %s", job->id, job->line);
+    } else {
+        println_color(COLOR_GREEN, "\t[%lu] Done %s: %lu records in %.3lf ms", job->id, job->line, records,
+                      stopwatch_elapsed_ms(job->start));
+    }
+
+    for (node = cli_jobs->head; node != NULL && node->data != job; node = node->next) index++;
+    if (node != NULL) list_remove_index(cli_jobs, index);
+    free(job);
+}
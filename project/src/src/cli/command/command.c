@@ -6,20 +6,42 @@
 #include "collection/collection_trie.h"
 #include "cli/command/command.h"
 #include "cli/cli.h"
+#include "cli/cli_job.h"
 #include "util/util_printer.h"
+#include "util/util_output.h"
 
 /* Supported Commands */
+#include "cli/command/command_abort.h"
 #include "cli/command/command_add.h"
+#include "cli/command/command_aggregate.h"
+#include "cli/command/command_begin.h"
+#include "cli/command/command_cancel.h"
 #include "cli/command/command_clear.h"
+#include "cli/command/command_clone.h"
+#include "cli/command/command_commit.h"
 #include "cli/command/command_del.h"
 #include "cli/command/command_device.h"
 #include "cli/command/command_exit.h"
+#include "cli/command/command_group.h"
 #include "cli/command/command_help.h"
 #include "cli/command/command_hierarchy.h"
+#include "cli/command/command_history.h"
 #include "cli/command/command_info.h"
+#include "cli/command/command_jobs.h"
+#include "cli/command/command_journal.h"
 #include "cli/command/command_link.h"
 #include "cli/command/command_list.h"
+#include "cli/command/command_load.h"
+#include "cli/command/command_metrics.h"
+#include "cli/command/command_output.h"
+#include "cli/command/command_save.h"
+#include "cli/command/command_scene.h"
+#include "cli/command/command_source.h"
+#include "cli/command/command_stats.h"
 #include "cli/command/command_switch.h"
+#include "cli/command/command_top.h"
+#include "cli/command/command_trace.h"
+#include "cli/command/command_wait.h"
 #include "cli/command/command_connect.h"
 #include "cli/command/command_connect_manual.h"
 #include "cli/command/command_switch_manual.h"
@@ -33,34 +55,78 @@ static List *commands = NULL;
  * Trie of Supported Commands
  */
 static Trie *autocomplete = NULL;
+/**
+ * Flag if the Command being executed runs in the background
+ */
+static bool command_background = false;
 
 void command_init(void) {
     if (commands != NULL || autocomplete != NULL) return;
     commands = new_list(NULL, NULL);
     autocomplete = new_trie(NULL, NULL);
 
+    list_add_last(commands, command_abort());
+    autocomplete = trie_insert(autocomplete, command_abort()->name, 1);
     list_add_last(commands, command_add());
     autocomplete = trie_insert(autocomplete, command_add()->name, 1);
+    list_add_last(commands, command_aggregate());
+    autocomplete = trie_insert(autocomplete, command_aggregate()->name, 1);
+    list_add_last(commands, command_begin());
+    autocomplete = trie_insert(autocomplete, command_begin()->name, 1);
+    list_add_last(commands, command_cancel());
+    autocomplete = trie_insert(autocomplete, command_cancel()->name, 1);
     list_add_last(commands, command_clear());
     autocomplete = trie_insert(autocomplete, command_clear()->name, 1);
+    list_add_last(commands, command_clone());
+    autocomplete = trie_insert(autocomplete, command_clone()->name, 1);
+    list_add_last(commands, command_commit());
+    autocomplete = trie_insert(autocomplete, command_commit()->name, 1);
     list_add_last(commands, command_del());
     autocomplete = trie_insert(autocomplete, command_del()->name, 1);
     list_add_last(commands, command_device());
     autocomplete = trie_insert(autocomplete, command_device()->name, 1);
     list_add_last(commands, command_exit());
     autocomplete = trie_insert(autocomplete, command_exit()->name, 1);
+    list_add_last(commands, command_group());
+    autocomplete = trie_insert(autocomplete, command_group()->name, 1);
     list_add_last(commands, command_help());
     autocomplete = trie_insert(autocomplete, command_help()->name, 1);
     list_add_last(commands, command_hierarchy());
     autocomplete = trie_insert(autocomplete, command_hierarchy()->name, 1);
+    list_add_last(commands, command_history());
+    autocomplete = trie_insert(autocomplete, command_history()->name, 1);
     list_add_last(commands, command_info());
     autocomplete = trie_insert(autocomplete, command_info()->name, 1);
+    list_add_last(commands, command_jobs());
+    autocomplete = trie_insert(autocomplete, command_jobs()->name, 1);
+    list_add_last(commands, command_journal());
+    autocomplete = trie_insert(autocomplete, command_journal()->name, 1);
     list_add_last(commands, command_link());
     autocomplete = trie_insert(autocomplete, command_link()->name, 1);
     list_add_last(commands, command_list());
     autocomplete = trie_insert(autocomplete, command_list()->name, 1);
+    list_add_last(commands, command_load());
+    autocomplete = trie_insert(autocomplete, command_load()->name, 1);
+    list_add_last(commands, command_metrics());
+    autocomplete = trie_insert(autocomplete, command_metrics()->name, 1);
+    list_add_last(commands, command_output());
+    autocomplete = trie_insert(autocomplete, command_output()->name, 1);
+    list_add_last(commands, command_save());
+    autocomplete = trie_insert(autocomplete, command_save()->name, 1);
+    list_add_last(commands, command_scene());
+    autocomplete = trie_insert(autocomplete, command_scene()->name, 1);
+    list_add_last(commands, command_source());
+    autocomplete = trie_insert(autocomplete, command_source()->name, 1);
+    list_add_last(commands, command_stats());
+    autocomplete = trie_insert(autocomplete, command_stats()->name, 1);
     list_add_last(commands, command_switch());
     autocomplete = trie_insert(autocomplete, command_switch()->name, 1);
+    list_add_last(commands, command_top());
+    autocomplete = trie_insert(autocomplete, command_top()->name, 1);
+    list_add_last(commands, command_trace());
+    autocomplete = trie_insert(autocomplete, command_trace()->name, 1);
+    list_add_last(commands, command_wait());
+    autocomplete = trie_insert(autocomplete, command_wait()->name, 1);
     list_add_last(commands, command_connect());
     autocomplete = trie_insert(autocomplete, command_connect()->name, 1);
 }
@@ -98,31 +164,85 @@ Command *new_command(char name[], char description[], char syntax[], int (*execu
     strncpy(command->name, name, COMMAND_NAME_LENGTH);
     strncpy(command->description, description, COMMAND_DESCRIPTION_LENGTH);
     strncpy(command->syntax, syntax, COMMAND_SYNTAX_LENGTH);
+    /* strncpy does not terminate a string as long as the field */
+    command->name[COMMAND_NAME_LENGTH - 1] = '\0';
+    command->description[COMMAND_DESCRIPTION_LENGTH - 1] = '\0';
+    command->syntax[COMMAND_SYNTAX_LENGTH - 1] = '\0';
+    if (strlen(name) >= COMMAND_NAME_LENGTH || strlen(description) >= COMMAND_DESCRIPTION_LENGTH ||
+        strlen(syntax) >= COMMAND_SYNTAX_LENGTH)
+        fprintf(stderr, "Command %s: name, description or syntax too long, the help is cut\n", command->name);
+    command->background = false;
     command->execute = execute;
     return command;
 }
 
+const Command *command_find(const char *name) {
+    Command *data;
+    if (commands == NULL || name == NULL) return NULL;
+
+    list_for_each(data, commands) {
+        if (strcmp(name, data->name) == 0) return data;
+    }
+
+    return NULL;
+}
+
 int command_execute(char **args) {
     Command *data;
+    int status = -1;
+    int format = -1;
+    int flag_format;
+    int previous_format = -1;
+    bool background;
+    size_t i;
+    size_t j;
     if (args[0] == NULL) {
         /* No Command passed, CONTINUE */
         return CLI_CONTINUE;
     }
 
+    /* Output format flags are valid for every Command */
+    for (i = 1, j = 1; args[i] != NULL; ++i) {
+        if ((flag_format = output_format_by_flag(args[i])) != -1) format = flag_format;
+        else args[j++] = args[i];
+    }
+    args[j] = NULL;
+    background = j > 1 && strcmp(args[j - 1], COMMAND_BACKGROUND) == 0;
+    if (background) args[j - 1] = NULL;
+    if (format != -1) previous_format = output_set_command_format(format);
+
+    /* Background jobs cannot be reading a Device while the Command talks to it */
+    cli_job_quiesce();
+
+    /* Command output is flushed once */
+    printer_buffer_begin();
     list_for_each(data, commands) {
         if (strcmp(args[0], data->name) == 0) {
             /* Command Found */
             if (args[1] != NULL && strcmp(args[1], CLI_QUESTION) == 0) {
                 /* Command Question */
                 command_print(data);
-                return CLI_CONTINUE;
+                status = CLI_CONTINUE;
+            } else if (background && !data->background) {
+                println_color(COLOR_RED, "\tCommand '%s' cannot run in the background", data->name);
+                status = CLI_CONTINUE;
+            } else {
+                /* Execute Command */
+                command_background = background;
+                status = data->execute(args);
+                command_background = false;
             }
-            /* Execute Command */
-            return data->execute(args);
+            break;
         }
     }
+    printer_buffer_end();
+    if (format != -1) output_set_command_format(previous_format);
+
+    return status;
+}
 
-    return -1;
+bool command_is_background(void) {
+    return command_background;
 }
 
 void command_print_all(void) {
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_abort.h"
+#include "util/util_printer.h"
+
+/**
+ * Close the open transaction dropping its staged switches
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _abort(char **args) {
+    size_t staged = domus_transaction_staged();
+
+    if (!domus_transaction_is_open()) {
+        println("\tNo transaction is open");
+    } else {
+        domus_transaction_abort();
+        println("\tTransaction aborted, %lu staged switches dropped", staged);
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_abort(void) {
+    return new_command(
+            "abort",
+            "Close the transaction opened by begin dropping its staged switches",
+            "abort",
+            _abort);
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_aggregate.h"
+#include "cli/command/command_list.h"
+#include "util/util_printer.h"
+
+/**
+ * Show COUNT, SUM, MIN, MAX and AVG of the devices grouped by type and state
+ *  Aggregates are computed inside the Devices tree
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _aggregate(char **args) {
+    DeviceCommunicationFilter filter;
+    size_t i;
+
+    if (domus_system_is_active()) {
+        device_communication_filter_init(&filter);
+        for (i = 1; args[i] != NULL; ++i) {
+            if (!device_communication_filter_add_predicate(&filter, args[i])) {
+                println("\tPredicate %s is not valid", args[i]);
+                println_color(COLOR_YELLOW, "\t\t%s", COMMAND_LIST_PREDICATES);
+                return CLI_CONTINUE;
+            }
+        }
+
+        if (!domus_has_devices()) {
+            println("\tNo Devices");
+        } else if (!domus_aggregate((filter.under == DEVICE_COMMUNICATION_FILTER_UNDER_ANY)
+                                    ? DEVICE_MESSAGE_TO_ALL_DEVICES : filter.under, &filter)) {
+            println("\tNo Devices match");
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_aggregate(void) {
+    return new_command(
+            "aggregate",
+            "Show COUNT, SUM, MIN, MAX and AVG of the devices grouped by type and state. Filter with [predicates]: "
+            COMMAND_LIST_PREDICATES,
+            "aggregate [predicates]",
+            _aggregate);
+}
@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_begin.h"
+#include "device/device_communication_transaction.h"
+#include "util/util_converter.h"
+#include "util/util_printer.h"
+
+/**
+ * Open a transaction, the next switches are staged until commit
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _begin(char **args) {
+    ConverterResult timeout;
+
+    if (domus_transaction_is_open()) {
+        println("\tA transaction is already open with %lu staged switches", domus_transaction_staged());
+        println_color(COLOR_YELLOW, "\t\tcommit | abort");
+    } else if (args[1] != NULL && ((timeout = converter_string_to_long(args[1])).error || timeout.data.Long <= 0)) {
+        println("\tTimeout %s is not valid", args[1]);
+    } else {
+        domus_transaction_begin((args[1] == NULL) ? DEVICE_COMMUNICATION_TRANSACTION_TIMEOUT
+                                                  : (unsigned long) timeout.data.Long);
+        println("\tTransaction open, switches are staged until commit");
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_begin(void) {
+    return new_command(
+            "begin",
+            "Open a transaction: the next switches, group switches and scenes are staged and applied by commit "
+            "to all their devices or to none. A prepared device waits [timeout] milliseconds for the commit",
+            "begin [timeout]",
+            _begin);
+}
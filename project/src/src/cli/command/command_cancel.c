@@ -0,0 +1,36 @@
+#include <stdbool.h>
+#include "cli/cli.h"
+#include "cli/cli_job.h"
+#include "cli/command/command_cancel.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Cancel a command running in the background
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _cancel(char **args) {
+    ConverterResult result;
+
+    if (args[1] == NULL) {
+        println("\tPlease add a job id");
+    } else if (args[2] != NULL) {
+        println("\tToo many arguments");
+    } else {
+        result = converter_string_to_long(args[1]);
+
+        if (result.error || result.data.Long <= 0) println("\tPlease add a valid job id");
+        else if (!cli_job_cancel(result.data.Long)) println("\tCannot find a job with id %ld", result.data.Long);
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_cancel(void) {
+    return new_command(
+            "cancel",
+            "Cancel the background job with <id>, the records not read yet are dropped",
+            "cancel <id>",
+            _cancel);
+}
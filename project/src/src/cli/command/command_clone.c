@@ -0,0 +1,57 @@
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_clone.h"
+#include "util/util_converter.h"
+#include "util/util_printer.h"
+
+/**
+ * Duplicate a device and its subtree under the same parent
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _clone(char **args) {
+    ConverterResult device_id;
+    ConverterResult count;
+    long spawned;
+
+    if (domus_system_is_active()) {
+        if (args[1] == NULL) {
+            println("\tPlease add a device id");
+        } else if (args[2] != NULL && args[3] != NULL) {
+            println("\tPlease add only a device id and the number of copies");
+        } else if (!domus_has_devices()) {
+            println("\tNo Devices");
+        } else {
+            device_id = converter_string_to_long(args[1]);
+            count.error = false;
+            count.data.Long = 1;
+            if (args[2] != NULL) count = converter_string_to_long(args[2]);
+
+            if (device_id.error) {
+                println("\tDevice Conversion Error: %s", device_id.error_message);
+            } else if (count.error) {
+                println("\tCount Conversion Error: %s", count.error_message);
+            } else if (count.data.Long < 1) {
+                println("\tPlease add at least one copy");
+            } else if (device_id.data.Long == CONTROLLER_ID) {
+                println("\tCannot Clone the Controller");
+            } else if ((spawned = domus_clone(device_id.data.Long, count.data.Long)) == -1) {
+                println_color(COLOR_RED, "\tCannot find a Device with id %ld", device_id.data.Long);
+            } else {
+                println_color(COLOR_GREEN, "\tCloned %ld %ld times, %ld devices spawned", device_id.data.Long,
+                              count.data.Long, spawned);
+            }
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_clone(void) {
+    return new_command(
+            "clone",
+            "Duplicate a device and its subtree under the same parent with new ids, [count] times. "
+            "The forks and the init values of the copies are sent in bulk",
+            "clone <id> [count]",
+            _clone);
+}
@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_commit.h"
+#include "util/util_printer.h"
+
+/**
+ * Apply the switches staged by the open transaction to all their devices or to none
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _commit(char **args) {
+    size_t staged = domus_transaction_staged();
+    long switched;
+
+    if (!domus_transaction_is_open()) {
+        println("\tNo transaction is open");
+        println_color(COLOR_YELLOW, "\t\tbegin [timeout]");
+    } else if (staged == 0) {
+        domus_transaction_abort();
+        println("\tNothing staged, transaction closed");
+    } else if (!domus_system_is_active()) {
+        domus_transaction_abort();
+    } else if ((switched = domus_transaction_commit()) < 0) {
+        println_color(COLOR_RED, "\tTransaction aborted, no device switched");
+    } else {
+        println("\t%ld of %lu devices switched", switched, staged);
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_commit(void) {
+    return new_command(
+            "commit",
+            "Apply the switches staged since begin to all their devices or, if one cannot be switched, to none",
+            "commit",
+            _commit);
+}
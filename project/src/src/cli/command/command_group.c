@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <string.h>
+#include "domus.h"
+#include "domus_scene.h"
+#include "cli/cli.h"
+#include "cli/command/command_group.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Show every group
+ */
+static void command_group_print(void);
+
+/**
+ * Create a group
+ * @param args Arguments, the name is args[2] and the ids follow
+ */
+static void command_group_create(char **args);
+
+static void command_group_print(void) {
+    const List *groups = domus_groups();
+    DomusGroup *group;
+    size_t i;
+
+    if (list_is_empty(groups)) {
+        println("\tNo groups");
+        return;
+    }
+
+    list_for_each(group, groups) {
+        print("\t%-*s", DOMUS_SCENE_NAME_LENGTH, group->name);
+        for (i = 0; i < group->count; ++i) {
+            print(" %lu", group->ids[i]);
+        }
+        println("");
+    }
+}
+
+static void command_group_create(char **args) {
+    size_t ids[DEVICE_COMMUNICATION_SCENE_TARGETS];
+    ConverterResult id;
+    size_t count = 0;
+    size_t i;
+
+    if (args[2] == NULL || args[3] == NULL) {
+        println("\tPlease specify a name and at least one device id");
+        return;
+    }
+
+    for (i = 3; args[i] != NULL; ++i) {
+        if ((id = converter_string_to_long(args[i])).error) {
+            println("\tConversion Error: %s", id.error_message);
+            return;
+        }
+        if (count == DEVICE_COMMUNICATION_SCENE_TARGETS) {
+            println("\tA group has at most %d devices", DEVICE_COMMUNICATION_SCENE_TARGETS);
+            return;
+        }
+        ids[count++] = (size_t) id.data.Long;
+    }
+
+    if (!domus_group_create(args[2], ids, count)) {
+        println_color(COLOR_RED, "\tCannot create group %s, names are at most %d characters", args[2],
+                      DOMUS_SCENE_NAME_LENGTH - 1);
+    } else {
+        println_color(COLOR_GREEN, "\tGroup %s has %lu devices", args[2], count);
+    }
+}
+
+/**
+ * Manage groups of devices and switch them together
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _group(char **args) {
+    long switched;
+
+    if (args[1] == NULL) {
+        command_group_print();
+    } else if (strcmp(args[1], COMMAND_GROUP_CREATE) == 0) {
+        command_group_create(args);
+    } else if (strcmp(args[1], COMMAND_GROUP_DEL) == 0) {
+        if (args[2] == NULL) println("\tPlease specify a group");
+        else if (domus_group_delete(args[2])) println_color(COLOR_GREEN, "\tGroup %s has been deleted", args[2]);
+        else println("\tCannot find group %s", args[2]);
+    } else if (strcmp(args[1], COMMAND_GROUP_SWITCH) == 0) {
+        if (args[2] == NULL || args[3] == NULL || args[4] == NULL) {
+            println_color(COLOR_RED, "\tPlease type a valid pattern:");
+            println_color(COLOR_YELLOW, "\t\tgroup " COMMAND_GROUP_SWITCH " <name> <label> <pos>");
+        } else if (domus_group_get(args[2]) == NULL) {
+            println("\tCannot find group %s", args[2]);
+        } else if (domus_system_is_active()) {
+            if ((switched = domus_group_switch(args[2], args[3], args[4])) == -1) println("\tNo Devices");
+            else if (domus_transaction_is_open())
+                println("\t%ld of %lu switches staged", switched, domus_group_get(args[2])->count);
+            else println("\t%ld of %lu devices switched", switched, domus_group_get(args[2])->count);
+        }
+    } else {
+        println("\tUnknown group command %s", args[1]);
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_group(void) {
+    return new_command(
+            "group",
+            "Show the groups. [" COMMAND_GROUP_CREATE " <name> <id>...] creates group <name> of devices <id>, "
+            "replacing it if it exists. [" COMMAND_GROUP_DEL " <name>] deletes it. [" COMMAND_GROUP_SWITCH
+            " <name> <label> <pos>] switches every device of group <name> with a single message",
+            "group [subcommand]",
+            _group);
+}
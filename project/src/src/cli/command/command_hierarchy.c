@@ -4,6 +4,7 @@
 #include "domus.h"
 #include "cli/cli.h"
 #include "util/util_printer.h"
+#include "util/util_output.h"
 
 /**
  * Display the current Device hierarchy in the system
@@ -12,8 +13,10 @@
  */
 static int _hierarchy(char **args) {
     if (domus_system_is_active()) {
-        device_print_legend();
-        println("");
+        if (output_format() == OUTPUT_FORMAT_TABLE) {
+            device_print_legend();
+            println("");
+        }
         domus_hierarchy();
     }
 
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "domus.h"
+#include "domus_history.h"
+#include "cli/cli.h"
+#include "cli/command/command_history.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+#include "util/util_output.h"
+
+/**
+ * Convert a time of a history query
+ *  now, seconds since the epoch, a date like 2020-01-31_23:59:00 or relative to now like -30s, -15m, -2h, -7d
+ * @param text The time to convert
+ * @param now The current time
+ * @param result The converted time
+ * @return true if converted, false otherwise
+ */
+static bool command_history_time(const char *text, time_t now, time_t *result);
+
+/**
+ * Print the aggregates of a history query
+ * @param buckets The aggregates
+ * @param count The number of aggregates
+ */
+static void command_history_print(const DomusHistoryBucket *buckets, long count);
+
+/**
+ * Start recording the history of every Device
+ * @param args Arguments, the directory is args[2]
+ */
+static void command_history_start(char **args);
+
+static bool command_history_time(const char *text, time_t now, time_t *result) {
+    ConverterResult value;
+    struct tm date;
+    char *unit;
+    long seconds;
+
+    if (strcmp(text, COMMAND_HISTORY_NOW) == 0) {
+        *result = now;
+        return true;
+    }
+
+    if (text[0] == '-') {
+        seconds = strtol(text + 1, &unit, 10);
+        if (unit == text + 1 || seconds < 0 || strlen(unit) > 1) return false;
+        switch (*unit) {
+            case 'd': {
+                seconds *= 24;
+            }
+            /* FALLTHROUGH */
+            case 'h': {
+                seconds *= 60;
+            }
+            /* FALLTHROUGH */
+            case 'm': {
+                seconds *= 60;
+            }
+            /* FALLTHROUGH */
+            case 's':
+            case '\0': {
+                break;
+            }
+            default: {
+                return false;
+            }
+        }
+        *result = now - seconds;
+        return true;
+    }
+
+    value = converter_string_to_long(text);
+    if (!value.error) {
+        *result = (time_t) value.data.Long;
+        return true;
+    }
+
+    /* Same layout as CONVERTER_DATE_FORMAT, the converter refuses dates in the past */
+    memset(&date, 0, sizeof(struct tm));
+    if (sscanf(text, "%d-%d-%d_%d:%d:%d", &date.tm_year, &date.tm_mon, &date.tm_mday, &date.tm_hour, &date.tm_min,
+               &date.tm_sec) != 6)
+        return false;
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+    date.tm_isdst = -1;
+    *result = mktime(&date);
+
+    return *result != (time_t) -1;
+}
+
+static void command_history_print(const DomusHistoryBucket *buckets, long count) {
+    char from[COMMAND_HISTORY_DATE_LENGTH];
+    char to[COMMAND_HISTORY_DATE_LENGTH];
+    long i;
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) {
+        output_begin();
+        for (i = 0; i < count; ++i) {
+            output_record();
+            output_long("from", (long) buckets[i].from);
+            output_long("to", (long) buckets[i].to);
+            output_long("count", (long) buckets[i].count);
+            output_double("min", buckets[i].min);
+            output_double("avg", buckets[i].sum / (double) buckets[i].count);
+            output_double("max", buckets[i].max);
+            output_double("last", buckets[i].last);
+        }
+        output_end();
+        return;
+    }
+
+    println_color(COLOR_BOLD, "\t%-*s | %-*s | %6s | %12s | %12s | %12s | %12s",
+                  COMMAND_HISTORY_DATE_LENGTH - 1, "FROM", COMMAND_HISTORY_DATE_LENGTH - 1, "TO", "COUNT", "MIN",
+                  "AVG", "MAX", "LAST");
+    for (i = 0; i < count; ++i) {
+        strftime(from, COMMAND_HISTORY_DATE_LENGTH, CONVERTER_DATE_FORMAT, localtime(&buckets[i].from));
+        strftime(to, COMMAND_HISTORY_DATE_LENGTH, CONVERTER_DATE_FORMAT, localtime(&buckets[i].to));
+        println("\t%-*s | %-*s | %6lu | %12.2f | %12.2f | %12.2f | %12.2f",
+                COMMAND_HISTORY_DATE_LENGTH - 1, from, COMMAND_HISTORY_DATE_LENGTH - 1, to, buckets[i].count,
+                buckets[i].min, buckets[i].sum / (double) buckets[i].count, buckets[i].max, buckets[i].last);
+    }
+}
+
+static void command_history_start(char **args) {
+    ConverterResult interval;
+    ConverterResult retention;
+
+    interval.error = false;
+    interval.data.Long = DOMUS_HISTORY_INTERVAL;
+    retention.error = false;
+    retention.data.Long = DOMUS_HISTORY_RETENTION;
+
+    if (args[2] == NULL) {
+        println("\tPlease specify the directory of the history");
+        return;
+    }
+    if (args[3] != NULL) interval = converter_string_to_long(args[3]);
+    if (args[3] != NULL && args[4] != NULL) retention = converter_string_to_long(args[4]);
+
+    if (interval.error || retention.error) {
+        println("\tConversion Error: %s", (interval.error) ? interval.error_message : retention.error_message);
+    } else if (interval.data.Long < 1 || retention.data.Long < 1) {
+        println("\tInterval and retention must be at least 1");
+    } else if (!domus_history_enable(args[2], (unsigned long) interval.data.Long,
+                                     (unsigned long) retention.data.Long)) {
+        println_color(COLOR_RED, "\tCannot record the history in %s", args[2]);
+    } else {
+        println_color(COLOR_GREEN, "\tHistory is recorded in %s every %lds for %ld days", args[2],
+                      interval.data.Long, retention.data.Long);
+    }
+}
+
+/**
+ * Record the history of the metrics of every Device and query it
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _history(char **args) {
+    DomusHistoryBucket buckets[DOMUS_HISTORY_BUCKETS];
+    ConverterResult id;
+    time_t now = time(NULL);
+    time_t from;
+    time_t to = now;
+    long count;
+
+    if (args[1] == NULL) {
+        if (domus_history_directory() == NULL) {
+            println("\tHistory is not recorded");
+        } else {
+            println("\tHistory is recorded in %s every %lus for %lu days, %lu series", domus_history_directory(),
+                    domus_history_interval(), domus_history_retention(), domus_history_series());
+        }
+    } else if (strcmp(args[1], COMMAND_HISTORY_START) == 0) {
+        command_history_start(args);
+    } else if (strcmp(args[1], COMMAND_HISTORY_STOP) == 0) {
+        if (domus_history_disable()) println("\tHistory is no longer recorded");
+        else println("\tHistory is not recorded");
+    } else if (domus_history_directory() == NULL) {
+        println("\tHistory is not recorded");
+    } else if (args[2] == NULL) {
+        println("\tPlease specify a device id and a metric");
+    } else if ((id = converter_string_to_long(args[1])).error) {
+        println("\tConversion Error: %s", id.error_message);
+    } else if (!domus_history_is_metric(args[2])) {
+        println("\tUnknown metric %s, use state, active_time, open_time, filling or temperature", args[2]);
+    } else {
+        from = now - (time_t) domus_history_retention() * 86400;
+        if (args[3] != NULL && !command_history_time(args[3], now, &from)) {
+            println("\tInvalid time %s", args[3]);
+        } else if (args[3] != NULL && args[4] != NULL && !command_history_time(args[4], now, &to)) {
+            println("\tInvalid time %s", args[4]);
+        } else if ((count = domus_history_query((size_t) id.data.Long, args[2], from, to, buckets)) <= 0) {
+            println("\tNo history of %s under id %ld", args[2], id.data.Long);
+        } else {
+            command_history_print(buckets, count);
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_history(void) {
+    return new_command(
+            "history",
+            "Record metrics with [" COMMAND_HISTORY_START " <directory> [interval] [retention]], every 60 s for 7 "
+            "days by default, end with [" COMMAND_HISTORY_STOP "]. Query [<id> <metric> [from] [to]], at most 20 "
+            "aggregates, a time is " COMMAND_HISTORY_NOW ", epoch seconds, " CONVERTER_DATE_FORMAT
+            " or -30m, -2h, -7d",
+            "history [subcommand]",
+            _history);
+}
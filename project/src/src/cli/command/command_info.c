@@ -3,7 +3,9 @@
 #include <string.h>
 #include "domus.h"
 #include "cli/cli.h"
+#include "cli/cli_job.h"
 #include "cli/command/command_info.h"
+#include "cli/command/command_list.h"
 #include "util/util_printer.h"
 #include "util/util_converter.h"
 
@@ -14,21 +16,50 @@
  */
 static int _info(char **args) {
     ConverterResult result;
+    DeviceCommunicationFilter filter;
+    bool resources = false;
+    size_t i;
 
     if (domus_system_is_active()) {
+        device_communication_filter_init(&filter);
+        for (i = 2; args[1] != NULL && args[i] != NULL; ++i) {
+            if (strcmp(args[i], COMMAND_LIST_RESOURCES) == 0) {
+                resources = true;
+            } else if (!device_communication_filter_add_predicate(&filter, args[i])) {
+                println("\tPredicate %s is not valid", args[i]);
+                println_color(COLOR_YELLOW, "\t\t%s", COMMAND_LIST_PREDICATES);
+                return CLI_CONTINUE;
+            }
+        }
+
         if (args[1] == NULL) {
             println("\tPlease add a device id");
         } else if (!domus_has_devices()) {
             println("\tNo Devices");
+        } else if (resources && command_is_background()) {
+            println("\tResources cannot be shown in the background");
         } else if (strcmp(args[1], COMMAND_INFO_ALL) == 0) {
-            domus_info_all();
+            if (command_is_background()) {
+                cli_job_start(args, domus_walk_start(DEVICE_MESSAGE_TO_ALL_DEVICES, &filter));
+            } else if (resources) {
+                if (!domus_resources(DEVICE_MESSAGE_TO_ALL_DEVICES, &filter, false)) println("\tNo Devices match");
+            } else if (device_communication_filter_is_empty(&filter)) domus_info_all();
+            else if (!domus_info_filter(DEVICE_MESSAGE_TO_ALL_DEVICES, &filter)) println("\tNo Devices match");
         } else {
             result = converter_string_to_long(args[1]);
 
             if (result.error) {
                 println("\tConversion Error: %s", result.error_message);
-            } else if (!domus_info_by_id(result.data.Long)) {
-                println("\tCannot find a Device with id %ld", result.data.Long);
+            } else if (command_is_background()) {
+                cli_job_start(args, domus_walk_start(result.data.Long, &filter));
+            } else if (resources) {
+                if (!domus_resources(result.data.Long, &filter, false))
+                    println("\tCannot find a matching Device under id %ld", result.data.Long);
+            } else if (device_communication_filter_is_empty(&filter)) {
+                if (!domus_info_by_id(result.data.Long))
+                    println("\tCannot find a Device with id %ld", result.data.Long);
+            } else if (!domus_info_filter(result.data.Long, &filter)) {
+                println("\tNo Devices match under id %ld", result.data.Long);
             }
         }
     }
@@ -37,9 +68,13 @@ static int _info(char **args) {
 }
 
 Command *command_info(void) {
-    return new_command(
+    Command *command = new_command(
             "info",
-            "Show device info with <id>. Show all devices info with [--all]",
-            "info <id> [--all]",
+            "Show device info with <id>. Show all devices info with [--all]. [options] are "
+            "[" COMMAND_LIST_RESOURCES "], what the device processes cost, and [predicates] like list",
+            "info <id> [--all] [options]",
             _info);
+
+    command->background = true;
+    return command;
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include <stdbool.h>
+#include "cli/cli.h"
+#include "cli/cli_job.h"
+#include "cli/command/command_jobs.h"
+
+/**
+ * Show the commands running in the background
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _jobs(char **args) {
+    cli_job_run();
+    cli_job_print();
+
+    return CLI_CONTINUE;
+}
+
+Command *command_jobs(void) {
+    return new_command(
+            "jobs",
+            "Show the commands running in the background, started with a trailing " COMMAND_BACKGROUND,
+            "jobs",
+            _jobs);
+}
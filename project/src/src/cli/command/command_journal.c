@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <string.h>
+#include "domus_journal.h"
+#include "cli/cli.h"
+#include "cli/command/command_journal.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Journal every mutation to a file
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _journal(char **args) {
+    ConverterResult window;
+
+    if (args[1] == NULL) {
+        if (domus_journal_file_name() == NULL) {
+            println("\tMutations are not journaled");
+        } else {
+            println("\tMutations are journaled to %s, synced every %lums", domus_journal_file_name(),
+                    domus_journal_window());
+            println("\t%lu bytes since the last compaction, last entry %llu", domus_journal_size(),
+                    (unsigned long long) domus_journal_sequence());
+        }
+    } else if (strcmp(args[1], COMMAND_JOURNAL_OFF) == 0) {
+        if (domus_journal_disable()) println("\tMutations are no longer journaled");
+        else println("\tMutations are not journaled");
+    } else if (args[2] != NULL && args[3] != NULL) {
+        println("\tPlease specify a file and at most a window");
+    } else {
+        window.error = false;
+        window.data.Long = DOMUS_JOURNAL_WINDOW;
+        if (args[2] != NULL) window = converter_string_to_long(args[2]);
+
+        if (window.error) {
+            println("\tConversion Error: %s", window.error_message);
+        } else if (window.data.Long < 1) {
+            println("\tThe window must be at least 1 millisecond");
+        } else if (domus_journal_enable(args[1], (unsigned long) window.data.Long, false) == -1) {
+            println_color(COLOR_RED, "\tCannot journal to %s", args[1]);
+        } else {
+            println_color(COLOR_GREEN, "\tMutations are journaled to %s, synced every %ldms", args[1],
+                          window.data.Long);
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_journal(void) {
+    return new_command(
+            "journal",
+            "Journal every add, del, link, clone and switch to <file>, synced every [window] milliseconds, default 50. "
+            "The current Devices are saved to <file>.snap, start Domus with --journal <file> to recover them. "
+            "Stop with off",
+            "journal [<file> [window] | " COMMAND_JOURNAL_OFF "]",
+            _journal);
+}
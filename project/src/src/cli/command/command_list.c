@@ -1,21 +1,50 @@
 
 #include <stdio.h>
+#include <string.h>
 #include "domus.h"
 #include "cli/cli.h"
+#include "cli/cli_job.h"
 #include "cli/command/command_list.h"
 #include "util/util_printer.h"
 
 /**
  * Display all available devices and their features
+ *  Predicates are evaluated inside the Devices tree
  * @param args Arguments
  * @return CLI status code
  */
 static int _list(char **args) {
+    DeviceCommunicationFilter filter;
+    bool resources = false;
+    size_t i;
+
     if (domus_system_is_active()) {
+        device_communication_filter_init(&filter);
+        for (i = 1; args[i] != NULL; ++i) {
+            if (strcmp(args[i], COMMAND_LIST_RESOURCES) == 0) {
+                resources = true;
+            } else if (!device_communication_filter_add_predicate(&filter, args[i])) {
+                println("\tPredicate %s is not valid", args[i]);
+                println_color(COLOR_YELLOW, "\t\t%s", COMMAND_LIST_PREDICATES);
+                return CLI_CONTINUE;
+            }
+        }
+
         if (!domus_has_devices()) {
             println("\tNo Devices");
-        } else {
+        } else if (command_is_background()) {
+            if (resources) println("\tResources cannot be shown in the background");
+            else cli_job_start(args, domus_walk_start((filter.under == DEVICE_COMMUNICATION_FILTER_UNDER_ANY)
+                                                      ? DEVICE_MESSAGE_TO_ALL_DEVICES : filter.under, &filter));
+        } else if (resources) {
+            if (!domus_resources((filter.under == DEVICE_COMMUNICATION_FILTER_UNDER_ANY)
+                                 ? DEVICE_MESSAGE_TO_ALL_DEVICES : filter.under, &filter, false))
+                println("\tNo Devices match");
+        } else if (device_communication_filter_is_empty(&filter)) {
             domus_list();
+        } else if (!domus_info_filter((filter.under == DEVICE_COMMUNICATION_FILTER_UNDER_ANY)
+                                      ? DEVICE_MESSAGE_TO_ALL_DEVICES : filter.under, &filter)) {
+            println("\tNo Devices match");
         }
     }
 
@@ -23,9 +52,13 @@ static int _list(char **args) {
 }
 
 Command *command_list(void) {
-    return new_command(
-            "list",
-            "Display all available devices and their features",
+    Command *command = new_command(
             "list",
+            "Display all available devices and their features. Show what every device process costs with "
+            "[" COMMAND_LIST_RESOURCES "]. Filter with [predicates]: " COMMAND_LIST_PREDICATES,
+            "list [" COMMAND_LIST_RESOURCES "] [predicates]",
             _list);
-}
\ No newline at end of file
+
+    command->background = true;
+    return command;
+}
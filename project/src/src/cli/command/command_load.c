@@ -0,0 +1,40 @@
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_load.h"
+#include "util/util_printer.h"
+#include "util/util_stopwatch.h"
+
+/**
+ * Replace every Device with the ones of a snapshot file
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _load(char **args) {
+    Stopwatch start;
+    long restored;
+
+    if (args[1] == NULL) {
+        println("\tPlease specify the snapshot file");
+    } else if (args[2] != NULL) {
+        println("\tPlease specify only the snapshot file");
+    } else {
+        start = stopwatch_now();
+        if ((restored = domus_load(args[1])) == -1) {
+            println_color(COLOR_RED, "\tCannot load %s: not a valid snapshot", args[1]);
+        } else {
+            println_color(COLOR_GREEN, "\tRestored %ld devices in %.1f ms", restored,
+                          (double) stopwatch_elapsed(start) / 1000000.0);
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_load(void) {
+    return new_command(
+            "load",
+            "Replace every Device with the ones saved in the snapshot <file>. "
+            "The Devices directly connected to Domus are forked in parallel",
+            "load <file>",
+            _load);
+}
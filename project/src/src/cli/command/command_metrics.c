@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <string.h>
+#include "domus_metrics.h"
+#include "cli/cli.h"
+#include "cli/command/command_metrics.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Write metrics to a Prometheus text file periodically
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _metrics(char **args) {
+    ConverterResult interval;
+
+    if (args[1] == NULL) {
+        if (domus_metrics_file_name() == NULL) println("\tMetrics are not written");
+        else println("\tMetrics are written to %s every %lus", domus_metrics_file_name(), domus_metrics_interval());
+    } else if (strcmp(args[1], COMMAND_METRICS_OFF) == 0) {
+        if (domus_metrics_disable()) println("\tMetrics are no longer written");
+        else println("\tMetrics are not written");
+    } else if (args[2] != NULL && args[3] != NULL) {
+        println("\tPlease specify a file and at most an interval");
+    } else {
+        interval.error = false;
+        interval.data.Long = DOMUS_METRICS_INTERVAL;
+        if (args[2] != NULL) interval = converter_string_to_long(args[2]);
+
+        if (interval.error) {
+            println("\tConversion Error: %s", interval.error_message);
+        } else if (interval.data.Long < 1) {
+            println("\tThe interval must be at least 1 second");
+        } else if (!domus_metrics_enable(args[1], (unsigned long) interval.data.Long)) {
+            println_color(COLOR_RED, "\tCannot write metrics to %s", args[1]);
+        } else {
+            println_color(COLOR_GREEN, "\tMetrics are written to %s every %lus", args[1], interval.data.Long);
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_metrics(void) {
+    return new_command(
+            "metrics",
+            "Write metrics to <file> every [interval] seconds, default 15, in the Prometheus text format. "
+            "The file is replaced atomically, point the node_exporter textfile collector to it. Stop with off",
+            "metrics [<file> [interval] | " COMMAND_METRICS_OFF "]",
+            _metrics);
+}
@@ -0,0 +1,33 @@
+#include "cli/cli.h"
+#include "cli/command/command_output.h"
+#include "util/util_output.h"
+#include "util/util_printer.h"
+
+/**
+ * Show or set the output format of the session
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _output(char **args) {
+    int format;
+
+    if (args[1] == NULL) {
+        println("\tOutput format is %s", output_format_name(output_format()));
+    } else if ((format = output_format_by_name(args[1])) == -1 || !output_set_format(format)) {
+        println("\tOutput format %s is not supported", args[1]);
+        println_color(COLOR_YELLOW, "\t\toutput [%s|%s|%s]", OUTPUT_FORMAT_NAME_TABLE, OUTPUT_FORMAT_NAME_JSON,
+                      OUTPUT_FORMAT_NAME_CSV);
+    } else {
+        println("\tOutput format set to %s", output_format_name(format));
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_output(void) {
+    return new_command(
+            "output",
+            "Show or set the output format [table|json|csv] of the session. Add --json or --csv to a single command",
+            "output [format]",
+            _output);
+}
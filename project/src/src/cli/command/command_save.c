@@ -0,0 +1,34 @@
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_save.h"
+#include "util/util_printer.h"
+
+/**
+ * Save the topology and the state of every Device to a snapshot file
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _save(char **args) {
+    long saved;
+
+    if (args[1] == NULL) {
+        println("\tPlease specify the snapshot file");
+    } else if (args[2] != NULL) {
+        println("\tPlease specify only the snapshot file");
+    } else if ((saved = domus_save(args[1])) == -1) {
+        println_color(COLOR_RED, "\tCannot save the snapshot to %s", args[1]);
+    } else {
+        println_color(COLOR_GREEN, "\tSaved %ld devices to %s", saved, args[1]);
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_save(void) {
+    return new_command(
+            "save",
+            "Save the topology and the state of every Device to <file> in a compact binary snapshot, "
+            "restore it with load",
+            "save <file>",
+            _save);
+}
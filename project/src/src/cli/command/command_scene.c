@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+#include "domus.h"
+#include "domus_scene.h"
+#include "cli/cli.h"
+#include "cli/command/command_scene.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Show every scene
+ */
+static void command_scene_print(void);
+
+/**
+ * Create a scene
+ * @param args Arguments, the name is args[2] and the <id|group> <label> <pos> triples follow
+ */
+static void command_scene_create(char **args);
+
+static void command_scene_print(void) {
+    const List *scenes = domus_scenes();
+    DomusScene *domus_scene;
+    const DeviceCommunicationScene *scene;
+    size_t i;
+
+    if (list_is_empty(scenes)) {
+        println("\tNo scenes");
+        return;
+    }
+
+    list_for_each(domus_scene, scenes) {
+        scene = &domus_scene->scene;
+        print("\t%-*s", DOMUS_SCENE_NAME_LENGTH, domus_scene->name);
+        for (i = 0; i < scene->targets_count; ++i) {
+            print(" %lu:%s:%s", scene->targets[i].id, scene->actions[scene->targets[i].action].label,
+                  scene->actions[scene->targets[i].action].pos);
+        }
+        println("");
+    }
+}
+
+static void command_scene_create(char **args) {
+    DeviceCommunicationScene scene;
+    const DomusGroup *group;
+    ConverterResult id;
+    size_t i;
+    size_t j;
+
+    if (args[2] == NULL || args[3] == NULL) {
+        println("\tPlease specify a name and at least one <id|group> <label> <pos>");
+        return;
+    }
+
+    device_communication_scene_init(&scene);
+    for (i = 3; args[i] != NULL; i += 3) {
+        if (args[i + 1] == NULL || args[i + 2] == NULL) {
+            println("\tPlease specify <label> and <pos> of %s", args[i]);
+            return;
+        }
+
+        /* A group stands for all of its Devices */
+        if ((group = domus_group_get(args[i])) != NULL) {
+            for (j = 0; j < group->count; ++j) {
+                if (!device_communication_scene_add(&scene, group->ids[j], args[i + 1], args[i + 2])) break;
+            }
+            if (j == group->count) continue;
+        } else if ((id = converter_string_to_long(args[i])).error) {
+            println("\tCannot find group %s", args[i]);
+            return;
+        } else if (device_communication_scene_add(&scene, (size_t) id.data.Long, args[i + 1], args[i + 2])) {
+            continue;
+        }
+
+        println_color(COLOR_RED, "\tA scene has at most %d devices and %d label and position pairs",
+                      DEVICE_COMMUNICATION_SCENE_TARGETS, DEVICE_COMMUNICATION_SCENE_ACTIONS);
+        return;
+    }
+
+    if (!domus_scene_create(args[2], &scene)) {
+        println_color(COLOR_RED, "\tCannot create scene %s, names are at most %d characters", args[2],
+                      DOMUS_SCENE_NAME_LENGTH - 1);
+    } else {
+        println_color(COLOR_GREEN, "\tScene %s has %lu devices", args[2], scene.targets_count);
+    }
+}
+
+/**
+ * Manage scenes of devices and apply them
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _scene(char **args) {
+    long switched;
+
+    if (args[1] == NULL) {
+        command_scene_print();
+    } else if (strcmp(args[1], COMMAND_SCENE_CREATE) == 0) {
+        command_scene_create(args);
+    } else if (strcmp(args[1], COMMAND_SCENE_DEL) == 0) {
+        if (args[2] == NULL) println("\tPlease specify a scene");
+        else if (domus_scene_delete(args[2])) println_color(COLOR_GREEN, "\tScene %s has been deleted", args[2]);
+        else println("\tCannot find scene %s", args[2]);
+    } else if (strcmp(args[1], COMMAND_SCENE_APPLY) == 0) {
+        if (args[2] == NULL) {
+            println("\tPlease specify a scene");
+        } else if (domus_scene_get(args[2]) == NULL) {
+            println("\tCannot find scene %s", args[2]);
+        } else if (domus_system_is_active()) {
+            if ((switched = domus_scene_apply(args[2])) == -1) println("\tNo Devices");
+            else if (domus_transaction_is_open())
+                println("\t%ld of %lu switches staged", switched, domus_scene_get(args[2])->scene.targets_count);
+            else println("\t%ld of %lu devices switched", switched, domus_scene_get(args[2])->scene.targets_count);
+        }
+    } else {
+        println("\tUnknown scene command %s", args[1]);
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_scene(void) {
+    return new_command(
+            "scene",
+            "Show the scenes. [" COMMAND_SCENE_CREATE " <name> <id|group> <label> <pos>...] creates scene <name> "
+            "switching every device <id>, or of <group>, the feature <label> into <pos>, replacing it. ["
+            COMMAND_SCENE_DEL " <name>] deletes it. [" COMMAND_SCENE_APPLY " <name>] applies it with a single message",
+            "scene [subcommand]",
+            _scene);
+}
@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <string.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_source.h"
+#include "collection/collection_list.h"
+#include "util/util_printer.h"
+#include "util/util_stopwatch.h"
+
+/**
+ * Commands that do not change the hierarchy and can share a batch
+ */
+static const char *source_groupable[] = {"add", "aggregate", "device", "help", "hierarchy", "info", "list", "switch", NULL};
+
+/**
+ * Script line Struct
+ */
+typedef struct SourceLine {
+    size_t number;
+    char text[CLI_READ_LINE_BUFFER_SIZE];
+    char *buffer;
+    char **args;
+} SourceLine;
+
+/**
+ * Command latency Struct
+ */
+typedef struct SourceStatistic {
+    char name[COMMAND_NAME_LENGTH];
+    size_t count;
+    double total;
+    double min;
+    double max;
+} SourceStatistic;
+
+/**
+ * Free a Script line
+ * @param source_line The Script line to free
+ */
+static void free_source_line(SourceLine *source_line);
+
+/**
+ * Read and validate the whole Script before executing anything
+ * @param script The Script stream
+ * @param valid Set to false if at least one line is not valid
+ * @return The List of Script lines, comments and empty lines are skipped
+ */
+static List *source_parse(FILE *script, bool *valid);
+
+/**
+ * Check if a Script line can be executed in a batch
+ * @param source_line The Script line
+ * @return true if groupable, false if it must be executed alone
+ */
+static bool source_line_is_groupable(const SourceLine *source_line);
+
+/**
+ * Find the end of the group starting at first
+ *  A group ends on a command that cannot be batched or
+ *  on a second switch of the same Device
+ * @param first The first Node of the group
+ * @return The first Node after the group, NULL if the Script ends
+ */
+static Node *source_group_end(Node *first);
+
+/**
+ * Add a latency sample of a Command
+ * @param statistics The List of Command latencies
+ * @param name The Command name
+ * @param elapsed The latency in milliseconds
+ */
+static void source_statistic_add(List *statistics, const char *name, double elapsed);
+
+/**
+ * Print the Script summary
+ * @param file_name The Script file name
+ * @param statistics The List of Command latencies
+ * @param lines Number of executed lines
+ * @param groups Number of executed groups
+ * @param elapsed Total time in milliseconds
+ */
+static void
+source_print_summary(const char *file_name, const List *statistics, size_t lines, size_t groups, double elapsed);
+
+static void free_source_line(SourceLine *source_line) {
+    if (source_line == NULL) return;
+
+    free(source_line->args);
+    free(source_line->buffer);
+    free(source_line);
+}
+
+static List *source_parse(FILE *script, bool *valid) {
+    List *lines;
+    SourceLine *source_line;
+    char text[CLI_READ_LINE_BUFFER_SIZE];
+    size_t number = 0;
+
+    lines = new_list((void (*)(void *)) free_source_line, NULL);
+    *valid = true;
+
+    while (fgets(text, CLI_READ_LINE_BUFFER_SIZE, script) != NULL) {
+        number++;
+        text[strcspn(text, "\r\n")] = CLI_STRING_TERMINATOR;
+
+        source_line = (SourceLine *) malloc(sizeof(SourceLine));
+        if (source_line == NULL) {
+            perror("Source Line Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+        source_line->buffer = (char *) malloc(sizeof(char) * CLI_READ_LINE_BUFFER_SIZE);
+        if (source_line->buffer == NULL) {
+            perror("Source Line Buffer Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+
+        source_line->number = number;
+        strncpy(source_line->text, text, CLI_READ_LINE_BUFFER_SIZE);
+        strncpy(source_line->buffer, text, CLI_READ_LINE_BUFFER_SIZE);
+        source_line->args = cli_split_line(source_line->buffer);
+
+        /* Skip empty lines & comments */
+        if (source_line->args[0] == NULL || source_line->args[0][0] == CLI_CHARACTER_COMMENT) {
+            free_source_line(source_line);
+            continue;
+        }
+
+        if (strcmp(source_line->args[0], COMMAND_SOURCE_NAME) == 0) {
+            println_color(COLOR_RED, "\tLine %ld: a script cannot source another script", number);
+            *valid = false;
+        } else if (command_find(source_line->args[0]) == NULL) {
+            println_color(COLOR_RED, "\tLine %ld: Command '%s' not found", number, source_line->args[0]);
+            *valid = false;
+        }
+
+        list_add_last(lines, source_line);
+    }
+
+    return lines;
+}
+
+static bool source_line_is_groupable(const SourceLine *source_line) {
+    size_t i;
+
+    for (i = 0; source_groupable[i] != NULL; ++i) {
+        if (strcmp(source_line->args[0], source_groupable[i]) == 0) return true;
+    }
+
+    return false;
+}
+
+static Node *source_group_end(Node *first) {
+    Node *node;
+    Node *previous;
+    const SourceLine *source_line;
+    const SourceLine *previous_line;
+
+    if (first == NULL) return NULL;
+    if (!source_line_is_groupable((SourceLine *) first->data)) return first->next;
+
+    for (node = first->next; node != NULL; node = node->next) {
+        source_line = (SourceLine *) node->data;
+        if (!source_line_is_groupable(source_line)) return node;
+
+        if (strcmp(source_line->args[0], "switch") == 0 && source_line->args[1] != NULL) {
+            /* The same Device switched twice, the order matters */
+            for (previous = first; previous != node; previous = previous->next) {
+                previous_line = (SourceLine *) previous->data;
+                if (strcmp(previous_line->args[0], "switch") == 0 && previous_line->args[1] != NULL &&
+                    strcmp(previous_line->args[1], source_line->args[1]) == 0) {
+                    return node;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void source_statistic_add(List *statistics, const char *name, double elapsed) {
+    SourceStatistic *data;
+    SourceStatistic *statistic = NULL;
+
+    list_for_each(data, statistics) {
+        if (strcmp(data->name, name) == 0) {
+            statistic = data;
+            break;
+        }
+    }
+
+    if (statistic == NULL) {
+        statistic = (SourceStatistic *) malloc(sizeof(SourceStatistic));
+        if (statistic == NULL) {
+            perror("Source Statistic Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+
+        strncpy(statistic->name, name, COMMAND_NAME_LENGTH);
+        statistic->count = 0;
+        statistic->total = 0;
+        statistic->min = elapsed;
+        statistic->max = elapsed;
+        list_add_last(statistics, statistic);
+    }
+
+    statistic->count++;
+    statistic->total += elapsed;
+    if (elapsed < statistic->min) statistic->min = elapsed;
+    if (elapsed > statistic->max) statistic->max = elapsed;
+}
+
+static void
+source_print_summary(const char *file_name, const List *statistics, size_t lines, size_t groups, double elapsed) {
+    SourceStatistic *data;
+
+    println("");
+    println_color(COLOR_BOLD, "\tSOURCE %s", file_name);
+    println("\t%ld lines in %ld groups, total %.3lf ms", lines, groups, elapsed);
+    println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %-*s | %-*s | %-*s",
+                  COMMAND_NAME_LENGTH / 2, "COMMAND",
+                  6, "COUNT",
+                  10, "TOTAL(ms)",
+                  10, "AVG(ms)",
+                  10, "MIN(ms)",
+                  10, "MAX(ms)");
+
+    list_for_each(data, statistics) {
+        println("\t%-*s | %-*ld | %-*.3lf | %-*.3lf | %-*.3lf | %-*.3lf",
+                COMMAND_NAME_LENGTH / 2, data->name,
+                6, data->count,
+                10, data->total,
+                10, data->total / data->count,
+                10, data->min,
+                10, data->max);
+    }
+}
+
+/**
+ * Execute a Script, independent commands are grouped and share one batch
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _source(char **args) {
+    FILE *script;
+    List *lines;
+    List *statistics;
+    Node *node;
+    Node *group_end;
+    SourceLine *source_line;
+    Stopwatch start;
+    Stopwatch line_start;
+    double elapsed;
+    size_t executed = 0;
+    size_t groups = 0;
+    bool valid;
+    int status = CLI_CONTINUE;
+
+    if (args[1] == NULL) {
+        println("\tPlease enter a script file");
+        return CLI_CONTINUE;
+    }
+    if ((script = fopen(args[1], "r")) == NULL) {
+        println_color(COLOR_RED, "\tCannot open script %s", args[1]);
+        return CLI_CONTINUE;
+    }
+
+    lines = source_parse(script, &valid);
+    fclose(script);
+
+    if (!valid) {
+        println_color(COLOR_RED, "\tScript %s has not been executed", args[1]);
+        free_list(lines);
+        return CLI_CONTINUE;
+    }
+
+    statistics = new_list(NULL, NULL);
+    start = stopwatch_now();
+    node = lines->head;
+
+    while (node != NULL && status != CLI_TERMINATE) {
+        group_end = source_group_end(node);
+        groups++;
+
+        domus_batch_begin();
+        for (; node != group_end && status != CLI_TERMINATE; node = node->next) {
+            source_line = (SourceLine *) node->data;
+            println_color(COLOR_CYAN, "\t[%ld] %s", source_line->number, source_line->text);
+
+            line_start = stopwatch_now();
+            status = command_execute(source_line->args);
+            elapsed = stopwatch_elapsed_ms(line_start);
+
+            println_color(COLOR_MAGENTA, "\t[%ld] %.3lf ms", source_line->number, elapsed);
+            source_statistic_add(statistics, source_line->args[0], elapsed);
+            executed++;
+            fflush(stdout);
+        }
+        domus_batch_end();
+    }
+
+    source_print_summary(args[1], statistics, executed, groups, stopwatch_elapsed_ms(start));
+
+    free_list(statistics);
+    free_list(lines);
+
+    return status;
+}
+
+Command *command_source(void) {
+    return new_command(
+            COMMAND_SOURCE_NAME,
+            "Execute the commands in <file>, independent commands are dispatched in groups",
+            "source <file>",
+            _source);
+}
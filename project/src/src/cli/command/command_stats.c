@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_stats.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Show send to ack latency statistics of every message type
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _stats(char **args) {
+    ConverterResult result;
+
+    if (args[1] == NULL) {
+        if (!domus_stats(DEVICE_MESSAGE_TO_ALL_DEVICES)) println("\tNo messages recorded");
+    } else if (args[2] != NULL) {
+        println("\tPlease specify at most one device id");
+    } else if (!domus_has_devices()) {
+        println("\tNo Devices");
+    } else {
+        result = converter_string_to_long(args[1]);
+
+        if (result.error) {
+            println("\tConversion Error: %s", result.error_message);
+        } else if (!domus_stats(result.data.Long)) {
+            println("\tNo messages recorded under id %ld", result.data.Long);
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_stats(void) {
+    return new_command(
+            "stats",
+            "Show COUNT, ERRORS, P50, P90, P99 and MAX latency of every message type, measured from send to ack by "
+            "Domus and every control device. Show only the subtree of control device with [id]",
+            "stats [id]",
+            _stats);
+}
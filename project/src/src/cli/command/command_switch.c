@@ -1,29 +1,80 @@
-
 #include "domus.h"
 #include <stdio.h>
+#include <string.h>
 #include "cli/cli.h"
 #include "cli/command/command_switch.h"
+#include "cli/command/command_list.h"
 #include "util/util_converter.h"
 #include "util/util_printer.h"
 
 /**
- * Switch the device with id the feature label into the position pos
+ * Switch the device with id, or every device matching the predicates, the feature label into the position pos
+ *  A switch by id can be conditional: switch <id> <label> <pos> if <state=on|off> <version=n>
  * @param args Arguments
  * @return CLI status code
  */
 static int _switch(char **args) {
     ConverterResult device_id;
+    DeviceCommunicationFilter filter;
+    DeviceCommunicationCondition condition;
+    long switched;
+    size_t length;
+    size_t i;
 
     if (domus_system_is_active()) {
+        for (length = 0; args[length] != NULL; ++length);
+
         if (args[1] == NULL) {
             println("\tPlease enter a Device id");
-        } else if ((device_id = converter_string_to_long(args[1])).error) {
-            println("\tConversion Error: %s", device_id.error_message);
-        } else if (args[2] == NULL || args[3] == NULL) {
+        } else if (length < 4) {
             println_color(COLOR_RED, "\tPlease type a valid pattern:");
-            println_color(COLOR_YELLOW, "\t\tswitch <id> <label> <pos>");
+            println_color(COLOR_YELLOW, "\t\tswitch <id|predicates> <label> <pos>");
+        } else if (length > 5 && strcmp(args[4], DEVICE_COMMUNICATION_CONDITION_KEYWORD) == 0 &&
+                   !(device_id = converter_string_to_long(args[1])).error) {
+            /* The Device checks the condition and switches in the same step */
+            device_communication_condition_init(&condition);
+            for (i = 5; i < length; ++i) {
+                if (!device_communication_condition_add_predicate(&condition, args[i])) {
+                    println("\tCondition %s is not valid", args[i]);
+                    println_color(COLOR_YELLOW, "\t\tstate=<on|off> version=<version>");
+                    return CLI_CONTINUE;
+                }
+            }
+
+            if (domus_transaction_is_open()) {
+                println("\tA conditional switch cannot be staged, commit or abort the transaction first");
+            } else {
+                domus_switch(device_id.data.Long, args[2], args[3], &condition);
+            }
+        } else if (length == 4 && !(device_id = converter_string_to_long(args[1])).error) {
+            if (!domus_transaction_is_open()) {
+                domus_switch(device_id.data.Long, args[2], args[3], NULL);
+            } else if (domus_transaction_stage(device_id.data.Long, args[2], args[3])) {
+                println("\tStaged, %lu switches in the transaction", domus_transaction_staged());
+            } else {
+                println("\tCannot stage the switch of Device %ld", device_id.data.Long);
+            }
+        } else if (domus_transaction_is_open()) {
+            /* The selected Devices are known only after the walk */
+            println("\tA selector switch cannot be staged, commit or abort the transaction first");
         } else {
-            domus_switch(device_id.data.Long, args[2], args[3]);
+            /* Predicates, the Devices decide if they are selected */
+            device_communication_filter_init(&filter);
+            for (i = 1; i < length - 2; ++i) {
+                if (!device_communication_filter_add_predicate(&filter, args[i])) {
+                    println("\tPredicate %s is not valid", args[i]);
+                    println_color(COLOR_YELLOW, "\t\t%s", COMMAND_LIST_PREDICATES);
+                    return CLI_CONTINUE;
+                }
+            }
+
+            if ((switched = domus_switch_select(&filter, args[length - 2], args[length - 1])) < 0) {
+                println("\tCannot switch the selected Devices");
+            } else if (switched == 0) {
+                println("\tNo Devices switched");
+            } else {
+                println("\t%ld devices switched", switched);
+            }
         }
     }
 
@@ -33,7 +84,8 @@ static int _switch(char **args) {
 Command *command_switch(void) {
     return new_command(
             "switch",
-            "Switch the device with <id> the feature <label> into <pos>",
-            "switch <id> <label> <pos>",
+            "Switch the feature <label> of <target> into <pos>. <target> is a device <id> or [predicates], in one "
+            "walk: " COMMAND_LIST_PREDICATES ". With [if " COMMAND_SWITCH_CONDITIONS "] only if they hold",
+            "switch <target> <label> <pos> [if]",
             _switch);
-}
\ No newline at end of file
+}
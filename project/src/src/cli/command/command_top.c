@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_top.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+#include "util/util_output.h"
+
+/**
+ * Sleep for some seconds, resuming after the signals sent by Devices
+ * @param seconds The seconds to sleep
+ */
+static void command_top_sleep(long seconds);
+
+static void command_top_sleep(long seconds) {
+    struct timespec remaining;
+
+    remaining.tv_sec = seconds;
+    remaining.tv_nsec = 0;
+    while (nanosleep(&remaining, &remaining) == -1 && errno == EINTR);
+}
+
+/**
+ * Show every device process sorted by CPU usage, refreshed every [interval] seconds for [iterations] times
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _top(char **args) {
+    ConverterResult interval;
+    ConverterResult iterations;
+    long i;
+
+    interval.error = false;
+    interval.data.Long = COMMAND_TOP_INTERVAL;
+    iterations.error = false;
+    iterations.data.Long = COMMAND_TOP_ITERATIONS;
+
+    if (args[1] != NULL) interval = converter_string_to_long(args[1]);
+    if (args[1] != NULL && args[2] != NULL) iterations = converter_string_to_long(args[2]);
+
+    if (interval.error || iterations.error) {
+        println("\tConversion Error: %s", (interval.error) ? interval.error_message : iterations.error_message);
+    } else if (interval.data.Long < 1 || iterations.data.Long < 1) {
+        println("\tInterval and iterations must be at least 1");
+    } else if (!domus_has_devices()) {
+        println("\tNo Devices");
+    } else {
+        for (i = 0; i < iterations.data.Long; ++i) {
+            if (i > 0) command_top_sleep(interval.data.Long);
+
+            /* Every frame is written as soon as it is complete, the Command output is not */
+            printer_buffer_begin();
+            /* Redraw in place only on a terminal, scripts get one snapshot after another */
+            if (output_format() == OUTPUT_FORMAT_TABLE && isatty(STDOUT_FILENO)) print_plain("\x1b[H\x1b[2J");
+            if (output_format() == OUTPUT_FORMAT_TABLE)
+                println_color(COLOR_BOLD, "\ttop %ld/%ld, every %lds", i + 1, iterations.data.Long,
+                              interval.data.Long);
+            if (!domus_resources(DEVICE_MESSAGE_TO_ALL_DEVICES, NULL, true)) {
+                println("\tNo Devices");
+                printer_buffer_end();
+                break;
+            }
+            printer_buffer_end();
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_top(void) {
+    return new_command(
+            "top",
+            "Show RSS, CPU time, CPU usage, context switches and open file descriptors of every device process, "
+            "busiest first. Refresh every [interval] seconds for [iterations] times, default 1 and 5",
+            "top [interval] [iterations]",
+            _top);
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <string.h>
+#include "domus.h"
+#include "cli/cli.h"
+#include "cli/command/command_trace.h"
+#include "util/util_printer.h"
+
+/**
+ * Execute a command tracing its messages hop by hop and show where the time has been spent
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _trace(char **args) {
+    const char *export_file_name = NULL;
+    char name[COMMAND_TRACE_NAME_LENGTH] = "";
+    size_t trace_id;
+    size_t first = 1;
+    size_t i;
+    int status;
+
+    if (args[1] != NULL && strcmp(args[1], COMMAND_TRACE_EXPORT) == 0) {
+        if (args[2] == NULL) {
+            println("\tPlease enter a file to export to");
+            return CLI_CONTINUE;
+        }
+        export_file_name = args[2];
+        first = 3;
+    }
+
+    if (args[first] == NULL) {
+        println("\tPlease enter a command to trace");
+        return CLI_CONTINUE;
+    }
+    if (command_find(args[first]) == NULL || strcmp(args[first], args[0]) == 0) {
+        println("\tCannot trace %s", args[first]);
+        return CLI_CONTINUE;
+    }
+
+    /* The command line is kept before its execution changes it */
+    for (i = first; args[i] != NULL; ++i) {
+        if (i > first) strncat(name, " ", COMMAND_TRACE_NAME_LENGTH - strlen(name) - 1);
+        strncat(name, args[i], COMMAND_TRACE_NAME_LENGTH - strlen(name) - 1);
+    }
+
+    trace_id = domus_trace_begin();
+    status = command_execute(&args[first]);
+    if (!domus_trace_end(trace_id, name, export_file_name)) {
+        println_color(COLOR_RED, "\tCannot export trace to %s", export_file_name);
+    } else if (export_file_name != NULL) {
+        println_color(COLOR_GREEN, "\tTrace exported to %s", export_file_name);
+    }
+
+    return status;
+}
+
+Command *command_trace(void) {
+    return new_command(
+            "trace",
+            "Execute <command> tracing its messages hop by hop and show the time spent by every device. "
+            "Export the spans as Chrome trace JSON with [--export <file>]",
+            "trace [--export <file>] <command>",
+            _trace);
+}
@@ -0,0 +1,42 @@
+#include <stdbool.h>
+#include "cli/cli.h"
+#include "cli/cli_job.h"
+#include "cli/command/command_wait.h"
+#include "util/util_printer.h"
+#include "util/util_converter.h"
+
+/**
+ * Wait for a command running in the background to finish
+ * @param args Arguments
+ * @return CLI status code
+ */
+static int _wait(char **args) {
+    ConverterResult result;
+
+    if (args[1] == NULL) {
+        if (cli_job_count() == 0) println("\tNo jobs");
+        else if (!cli_job_wait(CLI_JOB_ALL)) println("\tStopped waiting, the jobs keep running");
+    } else if (args[2] != NULL) {
+        println("\tToo many arguments");
+    } else {
+        result = converter_string_to_long(args[1]);
+
+        if (result.error || result.data.Long <= 0) {
+            println("\tPlease add a valid job id");
+        } else if (!cli_job_wait(result.data.Long)) {
+            if (cli_job_count() == 0) println("\tNo jobs");
+            else println("\tStopped waiting or job %ld not found", result.data.Long);
+        }
+    }
+
+    return CLI_CONTINUE;
+}
+
+Command *command_wait(void) {
+    return new_command(
+            "wait",
+            "Wait for the background job with [id] to finish, printing its records. Wait for every job if no id "
+            "is given. Ctrl + C stops waiting",
+            "wait [id]",
+            _wait);
+}
@@ -126,7 +126,7 @@ bool list_add(List *list, size_t index, void *data) {
     if (index == 0) {
         return list_add_first(list, data);
     }
-    if (index == list->size - 1) {
+    if (index == list->size) {
         return list_add_last(list, data);
     }
 
@@ -255,6 +255,7 @@ void *list_remove_last(List *list) {
 
 bool list_remove(List *list, const void *data) {
     Node *node;
+    Node *next;
     size_t index;
     void *element;
     if (list == NULL || data == NULL) return false;
@@ -268,6 +269,8 @@ bool list_remove(List *list, const void *data) {
     node = list->head;
     index = 0;
     while (node != NULL) {
+        /* node is released by list_remove_index, save the next one */
+        next = node->next;
         if (list->equals(node->data, data)) {
             element = list_remove_index(list, index);
             if (list->destroy == NULL) {
@@ -275,10 +278,12 @@ bool list_remove(List *list, const void *data) {
             } else {
                 list->destroy(element);
             }
-            index--;
+            /* data has been released, cannot compare anymore */
+            if (element == data) break;
+        } else {
+            index++;
         }
-        node = node->next;
-        index++;
+        node = next;
     }
 
     return true;
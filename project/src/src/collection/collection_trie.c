@@ -16,6 +16,12 @@
  */
 static char *trie_find_possible(Trie_node *node, char *tmp, char *dat);
 
+/**
+ * Free a node and all its children
+ * @param node The node to free
+ */
+static void free_trie_node(Trie_node *node);
+
 Trie *new_trie(void (*destroy)(void *), bool(*equals)(const void *, const void *)) {
     Trie *trie = (Trie *) malloc(sizeof(Trie));
     if (trie == NULL) {
@@ -30,8 +36,28 @@ Trie *new_trie(void (*destroy)(void *), bool(*equals)(const void *, const void *
     return trie;
 }
 
+bool free_trie(Trie *trie) {
+    if (trie == NULL) return false;
+
+    free_trie_node(trie->root);
+    free(trie);
+
+    return true;
+}
+
+static void free_trie_node(Trie_node *node) {
+    size_t i;
+    if (node == NULL) return;
+
+    for (i = 0; i < TRIE_ALPHABET; ++i) {
+        free_trie_node(node->array[i]);
+    }
+    free(node);
+}
+
 Trie_node *new_trie_node(void) {
-    Trie_node *trie_node = (Trie_node *) malloc(sizeof(Trie_node));
+    /* Children must start NULL, insert and search rely on it */
+    Trie_node *trie_node = (Trie_node *) calloc(1, sizeof(Trie_node));
     if (trie_node == NULL) {
         perror("New Trie Node Memory Allocation");
         exit(EXIT_FAILURE);
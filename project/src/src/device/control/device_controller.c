@@ -51,7 +51,8 @@ static void controller_message_handler(DeviceCommunicationMessage in_message) {
                                                 ((ControllerRegistry *) controller->device->registry)->directly_connected_devices);
             break;
         }
-        case MESSAGE_TYPE_SPAWN_DEVICE: {
+        case MESSAGE_TYPE_SPAWN_DEVICE:
+        case MESSAGE_TYPE_SPAWN_SUBTREE: {
             device_child_set_device_to_spawn(in_message);
             return;
         }
@@ -71,6 +72,7 @@ static int controller_set_switch_state(const char *name, bool state) {
 
         controller_switch->state = (void * ) state;
         controller->device->state = state;
+        controller->device->version++;
 
         return 1;
     }
@@ -117,7 +119,10 @@ static void queue_message_handler() {
     sender_pid = converter_string_to_long(fields[0]);
     snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_CONTROLLER, MESSAGE_RETURN_NAME_ERROR);
 
-    if (strcmp(fields[1], CONTROLLER_SWITCH_STATE) == 0) {
+    /* Held by a transaction, a switch from the queue is refused like one from the pipe */
+    if (device_child_transaction_is_held()) {
+        snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_CONTROLLER, MESSAGE_RETURN_LOCKED_ERROR);
+    } else if (strcmp(fields[1], CONTROLLER_SWITCH_STATE) == 0) {
         snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_CONTROLLER, MESSAGE_RETURN_VALUE_ERROR);
         if (strcmp(fields[2], CONTROLLER_SWITCH_STATE_OFF) == 0) {
             if (controller_set_switch_state(CONTROLLER_SWITCH_STATE, false)) {
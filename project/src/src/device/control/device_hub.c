@@ -3,6 +3,7 @@
 #include <string.h>
 #include "device/control/device_hub.h"
 #include "device/device_child.h"
+#include "device/device_communication_subtree.h"
 #include "util/util_converter.h"
 
 /**
@@ -69,19 +70,56 @@ static void hub_message_handler(DeviceCommunicationMessage in_message) {
 
             break;
         }
+        case MESSAGE_TYPE_SPAWN_SUBTREE: {
+            DeviceCommunicationSubtree subtree;
+            DeviceCommunicationMessage child_out_message;
+            DeviceCommunicationMessage child_in_message;
+            size_t roots_descriptor_id = 0;
+
+            /* All the children of a Hub have the same type, the roots too */
+            if (device_communication_subtree_from_message(&subtree, in_message.message)) {
+                device_communication_subtree_roots(&subtree, &roots_descriptor_id);
+            }
+
+            if (roots_descriptor_id != 0 && !list_is_empty(hub->devices)) {
+                device_communication_message_init(hub->device, &child_out_message);
+                device_communication_message_modify(&child_out_message, hub->device->id, MESSAGE_TYPE_INFO, "");
+
+                child_in_message = device_communication_write_message_with_ack(
+                        (DeviceCommunication *) list_get_first(hub->devices), &child_out_message);
+                if (child_in_message.id_device_descriptor != roots_descriptor_id) roots_descriptor_id = 0;
+            }
+
+            if (roots_descriptor_id != 0) {
+                device_child_set_device_to_spawn(in_message);
+                return;
+            }
+
+            device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_ERROR,
+                                                "Cannot attach a device with different type");
+            break;
+        }
         case MESSAGE_TYPE_SWITCH: {
             char **fields = device_communication_split_message_fields(in_message.message);
+            const char *result = MESSAGE_RETURN_NAME_ERROR;
 
             if (fields[2] == NULL) {
                 if (strcmp(fields[0], "turn") == 0 || strcmp(fields[0], "state") == 0 ||
                     strcmp(fields[0], "open") == 0) {
+                    result = MESSAGE_RETURN_SUCCESS;
                     if (strcmp(fields[1], "on") == 0) {
                         hub->device->state = true;
+                        hub->device->version++;
                     } else if (strcmp(fields[1], "off") == 0) {
                         hub->device->state = false;
+                        hub->device->version++;
+                    } else {
+                        result = MESSAGE_RETURN_VALUE_ERROR;
                     }
                 }
             }
+            /* Answer like every other Device, a scene counts the Hub among the switched ones */
+            device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_SWITCH, "%s", result);
             free(fields);
             break;
         }
@@ -158,8 +196,13 @@ static void queue_message_handler() {
     device_out_message.flag_force = true;
     device_out_message.override = true;
 
-    list_for_each(data, hub->devices) {
-        control_device_propagate_message_logic(message_list, data, &device_out_message, MESSAGE_TYPE_SWITCH);
+    /* Held by a transaction, a switch from the queue is refused like one from the pipe */
+    bool held = device_child_transaction_is_held();
+
+    if (!held) {
+        list_for_each(data, hub->devices) {
+            control_device_propagate_message_logic(message_list, data, &device_out_message, MESSAGE_TYPE_SWITCH);
+        }
     }
 
     size_t i;
@@ -172,8 +215,11 @@ static void queue_message_handler() {
         }
     }
 
-    if (success) {
+    if (held) {
+        snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_HUB, MESSAGE_RETURN_LOCKED_ERROR);
+    } else if (success) {
         snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_HUB, MESSAGE_RETURN_SUCCESS);
+        hub->device->version++;
         if (strcmp(fields[2], "off") == 0) {
             hub->device->state = false;
         }
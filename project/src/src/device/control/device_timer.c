@@ -3,6 +3,7 @@
 #include <string.h>
 #include "device/control/device_timer.h"
 #include "device/device_child.h"
+#include "device/device_communication_subtree.h"
 #include "util/util_converter.h"
 #include "device/device_communication.h"
 
@@ -125,6 +126,7 @@ static int timer_set_switch_state(const char *name, char *dates) {
     } else {
         return -5;
     }
+    timer->device->version++;
     return 1;
 }
 
@@ -256,6 +258,22 @@ static void timer_message_handler(DeviceCommunicationMessage in_message) {
             break;
         }
 
+        case MESSAGE_TYPE_SPAWN_SUBTREE: {
+            DeviceCommunicationSubtree subtree;
+
+            if (!list_is_empty(timer->devices) ||
+                !device_communication_subtree_from_message(&subtree, in_message.message) ||
+                device_communication_subtree_roots(&subtree, NULL) != 1) {
+                device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_ERROR,
+                                                    "Cannot attach more than one device per timer");
+            } else {
+                device_child_set_device_to_spawn(in_message);
+                return;
+            }
+
+            break;
+        }
+
         default: {
             device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_UNKNOWN, "%s",
                                                 in_message.message);
@@ -365,7 +383,10 @@ static void queue_message_handler() {
 
     snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_TIMER, MESSAGE_RETURN_NAME_ERROR);
 
-    if (strcmp(fields[1], TIMER_SWITCH_TIME) == 0) {
+    /* Held by a transaction, a switch from the queue is refused like one from the pipe */
+    if (device_child_transaction_is_held()) {
+        snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_TIMER, MESSAGE_RETURN_LOCKED_ERROR);
+    } else if (strcmp(fields[1], TIMER_SWITCH_TIME) == 0) {
         snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_TIMER, MESSAGE_RETURN_VALUE_ERROR);
 
         int res;
@@ -4,6 +4,7 @@
 #include <string.h>
 #include "device/device.h"
 #include "device/device_child.h"
+#include "device/device_communication_filter.h"
 #include "util/util_printer.h"
 
 /**
@@ -35,6 +36,16 @@ static bool device_device_communication_equals(const DeviceCommunication *data_1
  */
 static bool device_switch_equals(const char *data_1, const char *data_2);
 
+/**
+ * Fork a child without waiting for it, its Device Communication is added at the end of the devices list
+ * @param control_device The control device
+ * @param id the child id
+ * @param device_descriptor The Device Descriptor of the child
+ * @param custom_name The custom name, can be NULL
+ */
+static void control_device_fork_start(const ControlDevice *control_device, size_t id,
+                                      const DeviceDescriptor *device_descriptor, const char *custom_name);
+
 /**
  * Replaces the current running process with a new device process described in the Device Descriptor
  * @param child_id The child id
@@ -148,6 +159,7 @@ Device *new_device(size_t device_id, size_t device_descriptor_id, const char *na
         strncpy(device->name, name, DEVICE_NAME_LENGTH);
     device->state = state;
     device->registry = registry;
+    device->version = 0;
     device->switches = new_list(NULL, (bool (*)(const void *, const void *)) device_switch_equals);
 
     return device;
@@ -314,11 +326,62 @@ bool device_check_control_device(const ControlDevice *control_device) {
 
 bool control_device_fork(const ControlDevice *control_device, size_t id, const DeviceDescriptor *device_descriptor,
                          const char *custom_name) {
+    if (!device_check_control_device(control_device) || device_descriptor == NULL) return false;
+    if (id < 0) return false;
+
+    control_device_fork_start(control_device, id, device_descriptor, custom_name);
+
+    if (device_communication_read_message(
+            (DeviceCommunication *) list_get_last(control_device->devices)).type != MESSAGE_TYPE_I_AM_ALIVE) {
+        list_remove_last(control_device->devices);
+        return false;
+    }
+
+    return true;
+}
+
+size_t control_device_fork_all(const ControlDevice *control_device, DeviceFork *forks, size_t count) {
+    DeviceCommunication *device_communication;
+    Node *node;
+    size_t forked = 0;
+    size_t i;
+    if (!device_check_control_device(control_device) || forks == NULL) return 0;
+
+    /* Every child executes and initializes while the next one is forked */
+    for (i = 0; i < count; ++i) {
+        forks[i].forked = forks[i].device_descriptor != NULL;
+        if (!forks[i].forked) continue;
+
+        control_device_fork_start(control_device, forks[i].id, forks[i].device_descriptor, forks[i].name);
+        forked++;
+    }
+
+    /* The new children are at the end of the list, in the same order */
+    node = control_device->devices->head;
+    for (i = control_device->devices->size - forked; i > 0; --i) {
+        node = node->next;
+    }
+
+    for (i = 0; i < count; ++i) {
+        if (!forks[i].forked) continue;
+
+        device_communication = (DeviceCommunication *) node->data;
+        node = node->next;
+        if (device_communication_read_message(device_communication).type != MESSAGE_TYPE_I_AM_ALIVE) {
+            forks[i].forked = false;
+            list_remove(control_device->devices, device_communication);
+            forked--;
+        }
+    }
+
+    return forked;
+}
+
+static void control_device_fork_start(const ControlDevice *control_device, size_t id,
+                                      const DeviceDescriptor *device_descriptor, const char *custom_name) {
     pid_t child_pid;
     int write_parent_read_child[2];
     int write_child_read_parent[2];
-    if (!device_check_control_device(control_device) || device_descriptor == NULL) return false;
-    if (id < 0) return false;
 
     if (pipe(write_parent_read_child) == -1
         || pipe(write_child_read_parent) == -1) {
@@ -350,18 +413,11 @@ bool control_device_fork(const ControlDevice *control_device, size_t id, const D
 
             list_add_last(control_device->devices,
                           new_device_communication(child_pid, write_child_read_parent[0], write_parent_read_child[1]));
-
-            if (device_communication_read_message(
-                    (DeviceCommunication *) list_get_last(control_device->devices)).type != MESSAGE_TYPE_I_AM_ALIVE) {
-                list_remove_last(control_device->devices);
-                return false;
-            }
-
+            ((DeviceCommunication *) list_get_last(control_device->devices))->types =
+                    DEVICE_COMMUNICATION_FILTER_TYPE(device_descriptor->id);
             break;
         }
     }
-
-    return true;
 }
 
 static void
@@ -4,7 +4,16 @@
 #include <string.h>
 #include <errno.h>
 #include "device/device_child.h"
+#include "device/device_communication_filter.h"
+#include "device/device_communication_aggregate.h"
+#include "device/device_communication_stats.h"
+#include "device/device_communication_trace.h"
+#include "device/device_communication_scene.h"
+#include "device/device_communication_transaction.h"
+#include "device/device_communication_condition.h"
+#include "device/device_communication_subtree.h"
 #include "util/util_converter.h"
+#include "util/util_stopwatch.h"
 #include "domus.h"
 
 /**
@@ -13,7 +22,7 @@
 static volatile sig_atomic_t _device_child_run = true;
 
 /**
- * The Device to clone, only for a Control Device
+ * The Device or subtree to clone, only for a Control Device
  */
 static DeviceCommunicationMessage _device_to_spawn;
 
@@ -22,6 +31,13 @@ static DeviceCommunicationMessage _device_to_spawn;
  */
 static void device_child_control_device_spawn();
 
+/**
+ * Spawn the roots of a subtree together, set their values and send each one the subtree below it
+ *  Every level of the subtree is spawned in parallel, the sender gets a single ack
+ * @param out_message The ack to fill
+ */
+static void device_child_control_device_spawn_subtree(DeviceCommunicationMessage *out_message);
+
 /**
  * A pointer to the child Device for easy of use
  */
@@ -42,6 +58,65 @@ static DeviceCommunication *device_child_communication = NULL;
  */
 static bool device_child_lock = false;
 
+/**
+ * The transaction this Device is prepared for, DEVICE_COMMUNICATION_TRANSACTION_NONE if none
+ */
+static size_t device_child_transaction_id = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+
+/**
+ * When the prepared transaction releases this Device if it has not been committed
+ */
+static Stopwatch device_child_transaction_deadline = 0;
+
+/**
+ * The last delta info walk this Device answered in full and its version then
+ */
+static size_t device_child_info_epoch = 0;
+static size_t device_child_info_version = 0;
+
+/**
+ * The version the parent has been told about
+ */
+static size_t device_child_notified_version = 0;
+
+/**
+ * Control Device only
+ * Set when something in the subtree may have changed since the last delta info walk
+ */
+static volatile sig_atomic_t control_device_child_changed = true;
+
+/**
+ * Tell the parent that this Device changed, when its version moved since the last time
+ *  Switches from the pipe are seen by the Control Devices they go through, this covers queues and timers
+ */
+static void device_child_notify_change(void);
+
+/**
+ * Control Device only
+ * Function for handling signal when a child changed, the parent is told in turn
+ * @param signal_number The signal number to identify as macro DEVICE_COMMUNICATION_CHANGED
+ */
+static void control_device_child_changed_signal(int signal_number);
+
+/**
+ * Check if a message can change the Devices it goes through
+ * @param type The message type
+ * @return true if it can, false if it only reads
+ */
+static bool device_child_message_changes(size_t type);
+
+/**
+ * Control Device only
+ * Answer a delta info walk: a single unchanged record if nothing changed in the subtree,
+ *  otherwise the records of every child, asked with the same delta, and the one of this Control Device
+ * @param in_message The incoming info message
+ * @param child_out_message The message to send to the children
+ * @param filter The delta of the walk
+ */
+static void control_device_child_info_delta(DeviceCommunicationMessage *in_message,
+                                            const DeviceCommunicationMessage *child_out_message,
+                                            const DeviceCommunicationFilter *filter);
+
 /**
  * Function for handling signal when receiving a message
  * @param signal_number The signal number to identify as macro DEVICE_COMMUNICATION_READ_PIPE
@@ -61,6 +136,142 @@ static void devive_child_middleware_message_handler(DeviceCommunicationMessage i
  */
 static void control_device_child_middleware_message_handler(void);
 
+/**
+ * Control Device only
+ * Check if a child record must be forwarded to the parent
+ *  Info records not matching the filter and stream closing records are dropped
+ * @param type The type of the incoming message from parent
+ * @param filter The info filter
+ * @param record The child record
+ * @return true if the record must be forwarded, false otherwise
+ */
+static bool control_device_child_forward_record(size_t type, const DeviceCommunicationFilter *filter,
+                                                const DeviceCommunicationMessage *record);
+
+/**
+ * Control Device only
+ * Terminate all children together, then send the records of the whole subtree to the parent
+ *  Children that do not terminate are killed, this Control Device is left without children
+ * @param in_message The incoming terminate message, the timeout is the message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_terminate(const DeviceCommunicationMessage *in_message,
+                                           const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Control Device only
+ * Fold the records of all children and this Control Device into partial aggregates and send them to the parent,
+ *  one record per Device type and state
+ * @param in_message The incoming aggregate message, the filter is the message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_aggregate(const DeviceCommunicationMessage *in_message,
+                                           const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Control Device only
+ * Merge the latency statistics of all children and this Control Device and send them to the parent
+ * @param in_message The incoming stats message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_stats(const DeviceCommunicationMessage *in_message,
+                                       const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Control Device only
+ * Relay the spans of a trace recorded by all children, then send the spans of this Control Device
+ * @param in_message The incoming trace message, the trace id is the message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_trace(const DeviceCommunicationMessage *in_message,
+                                       const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Control Device only
+ * Switch the targets of a multi target switch found under every child, asking a child only for the targets not
+ *  found yet, then switch this Control Device if it is a target, closing the stream
+ * @param in_message The incoming multi target switch message, the scene is the message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_switch_multi(const DeviceCommunicationMessage *in_message,
+                                              const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Control Device only
+ * Switch every Device selected under every child, or this Control Device and all its children if it is selected,
+ *  closing the stream
+ * @param in_message The incoming switch by selector message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_switch_select(const DeviceCommunicationMessage *in_message,
+                                               const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Control Device only
+ * Relay the records of a child to the parent
+ * @param device_communication The Device Communication of the child
+ * @param child_out_message The message to send to the child
+ * @param type The type of the records to relay
+ * @param id_recipient The id of the parent
+ * @param scene The scene to remove the answering Devices from, can be NULL
+ * @return true if at least one Device succeeded or is held by a transaction, false otherwise
+ */
+static bool control_device_child_switch_relay(DeviceCommunication *device_communication,
+                                              const DeviceCommunicationMessage *child_out_message, size_t type,
+                                              size_t id_recipient, DeviceCommunicationScene *scene);
+
+/**
+ * Control Device only
+ * Prepare or abort a transaction for the targets found under every child, asking a child only for the targets not
+ *  found yet, then send the vote of this Control Device if it is a target, closing the stream
+ * @param in_message The incoming prepare or abort message
+ * @param child_out_message The message to send to the children
+ */
+static void control_device_child_transaction(const DeviceCommunicationMessage *in_message,
+                                             const DeviceCommunicationMessage *child_out_message);
+
+/**
+ * Device only
+ * Send the vote of this Device for a prepare or abort message, closing the stream
+ * @param in_message The incoming prepare or abort message
+ */
+static void device_child_transaction(const DeviceCommunicationMessage *in_message);
+
+/**
+ * Vote for a transaction
+ *  A prepare checks the switch and holds this Device until the commit or the deadline, an abort releases it
+ * @param device This Device
+ * @param type MESSAGE_TYPE_PREPARE or MESSAGE_TYPE_ABORT
+ * @param transaction The transaction id
+ * @param timeout The milliseconds to wait for the commit
+ * @param switch_message The switch of this Device, label and position
+ * @return The vote, MESSAGE_RETURN_SUCCESS if prepared or released
+ */
+static const char *device_child_transaction_vote(const Device *device, size_t type, size_t transaction,
+                                                 unsigned long timeout, const char *switch_message);
+
+/**
+ * Check if a transaction holds this Device, releasing it if the deadline has passed
+ * @param transaction The transaction id, DEVICE_COMMUNICATION_TRANSACTION_NONE for any transaction
+ * @return true if held, false otherwise
+ */
+static bool device_child_transaction_holds(size_t transaction);
+
+/**
+ * Check a switch against the Device Descriptor without applying it
+ *  Placeholder positions like <temp> accept any value, only the Device itself can check them
+ * @param device The Device
+ * @param switch_message The switch, label and position
+ * @return MESSAGE_RETURN_SUCCESS if the switch is described, the error status otherwise
+ */
+static const char *device_child_transaction_check(const Device *device, const char *switch_message);
+
+/**
+ * Send the spans of a trace recorded by this process to the parent, closing the stream
+ * @param in_message The incoming trace message, the trace id is the message
+ */
+static void device_child_trace(const DeviceCommunicationMessage *in_message);
+
 /**
  * A function pointer to the child Message Handler for easy of use
  */
@@ -77,6 +288,8 @@ static bool device_child_check_args(int argc, char **args);
 
 void device_child_run(void (*do_on_wake_up)(void)) {
     DeviceCommunicationMessage out_message;
+    sigset_t read_pipe_mask;
+    sigset_t wait_mask;
     if (control_device_child != NULL && device_child == NULL) {
         device_communication_message_init(control_device_child->device, &_device_to_spawn);
         device_communication_message_init(control_device_child->device, &out_message);
@@ -88,25 +301,40 @@ void device_child_run(void (*do_on_wake_up)(void)) {
         exit(EXIT_FAILURE);
     }
 
+    /*
+     * Messages are handled only while waiting, otherwise a message received
+     * between the checks and pause() is lost and the spawn never happens
+     */
+    sigemptyset(&read_pipe_mask);
+    sigaddset(&read_pipe_mask, DEVICE_COMMUNICATION_READ_PIPE);
+    sigprocmask(SIG_BLOCK, &read_pipe_mask, &wait_mask);
+    sigdelset(&wait_mask, DEVICE_COMMUNICATION_READ_PIPE);
+
     device_communication_message_modify(&out_message, 0, MESSAGE_TYPE_I_AM_ALIVE, "");
     device_communication_write_message(device_child_communication, &out_message);
 
     while (_device_child_run) {
-        pause();
+        sigsuspend(&wait_mask);
         if (control_device_child != NULL) device_child_control_device_spawn();
         if (do_on_wake_up != NULL) do_on_wake_up();
+        device_child_notify_change();
     }
 }
 
 bool device_child_set_device_to_spawn(DeviceCommunicationMessage message) {
-    if (message.type != MESSAGE_TYPE_SPAWN_DEVICE) return false;
-    if (_device_to_spawn.type == MESSAGE_TYPE_SPAWN_DEVICE) return false;
+    if (message.type != MESSAGE_TYPE_SPAWN_DEVICE && message.type != MESSAGE_TYPE_SPAWN_SUBTREE) return false;
+    if (_device_to_spawn.type == MESSAGE_TYPE_SPAWN_DEVICE || _device_to_spawn.type == MESSAGE_TYPE_SPAWN_SUBTREE)
+        return false;
     if (control_device_child == NULL) return false;
 
     _device_to_spawn = message;
     return true;
 }
 
+bool device_child_transaction_is_held(void) {
+    return device_child_transaction_holds(DEVICE_COMMUNICATION_TRANSACTION_NONE);
+}
+
 static void device_child_control_device_spawn() {
     DeviceCommunication *device_communication;
     DeviceCommunicationMessage out_message;
@@ -115,7 +343,12 @@ static void device_child_control_device_spawn() {
     ConverterResult child_descriptor_id;
     char **fields;
 
-    if (_device_to_spawn.type == MESSAGE_TYPE_SPAWN_DEVICE) {
+    if (_device_to_spawn.type == MESSAGE_TYPE_SPAWN_SUBTREE) {
+        device_communication_message_init(control_device_child->device, &out_message);
+        device_child_control_device_spawn_subtree(&out_message);
+        device_communication_message_init(control_device_child->device, &_device_to_spawn);
+        device_communication_write_message(device_child_communication, &out_message);
+    } else if (_device_to_spawn.type == MESSAGE_TYPE_SPAWN_DEVICE) {
         device_communication_message_init(control_device_child->device, &out_message);
         device_communication_message_init(control_device_child->device, &child_out_message);
         fields = device_communication_split_message_fields(_device_to_spawn.message);
@@ -159,7 +392,95 @@ static void device_child_control_device_spawn() {
     }
 }
 
+static void device_child_control_device_spawn_subtree(DeviceCommunicationMessage *out_message) {
+    DeviceCommunicationSubtree subtree;
+    DeviceCommunicationSubtree descendants;
+    DeviceCommunicationMessage child_out_message;
+    DeviceCommunicationMessage child_in_message;
+    DeviceCommunication *children[DEVICE_COMMUNICATION_SUBTREE_NODES];
+    DeviceFork forks[DEVICE_COMMUNICATION_SUBTREE_NODES];
+    size_t roots[DEVICE_COMMUNICATION_SUBTREE_NODES];
+    size_t below[DEVICE_COMMUNICATION_SUBTREE_NODES];
+    Node *node;
+    size_t count = 0;
+    size_t forked;
+    size_t spawned = 0;
+    size_t i;
+
+    if (!device_communication_subtree_from_message(&subtree, _device_to_spawn.message)) {
+        device_communication_message_modify(out_message, _device_to_spawn.id_sender, MESSAGE_TYPE_ERROR,
+                                            "Subtree Decoding Error");
+        return;
+    }
+
+    for (i = 0; i < subtree.count; ++i) {
+        if (subtree.nodes[i].parent != DEVICE_COMMUNICATION_SUBTREE_ROOT) continue;
+
+        forks[count].id = subtree.nodes[i].id;
+        forks[count].device_descriptor = device_is_supported_by_id(subtree.nodes[i].id_device_descriptor);
+        strncpy(forks[count].name, subtree.nodes[i].name, DEVICE_NAME_LENGTH);
+        roots[count++] = i;
+    }
+
+    /* The roots alive are the last children, in the same order */
+    forked = control_device_fork_all(control_device_child, forks, count);
+    node = control_device_child->devices->head;
+    for (i = control_device_child->devices->size - forked; i > 0; --i) node = node->next;
+    for (i = 0; i < count; ++i) {
+        children[i] = NULL;
+        if (!forks[i].forked) continue;
+        children[i] = (DeviceCommunication *) node->data;
+        node = node->next;
+    }
+
+    /* Every root has its own pipe, all the init values are in flight together */
+    device_communication_message_init(control_device_child->device, &child_out_message);
+    for (i = 0; i < count; ++i) {
+        if (children[i] == NULL) continue;
+        device_communication_message_modify(&child_out_message, forks[i].id, MESSAGE_TYPE_SET_INIT_VALUES, "");
+        device_communication_subtree_to_init_values(&subtree, roots[i], child_out_message.message,
+                                                    DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        device_communication_write_message_notify(children[i], &child_out_message);
+    }
+    for (i = 0; i < count; ++i) {
+        if (children[i] == NULL) continue;
+        if (device_communication_read_message(children[i]).type == MESSAGE_TYPE_SET_INIT_VALUES) spawned++;
+    }
+
+    /* Then every Control Device root spawns the part below it, again together */
+    for (i = 0; i < count; ++i) {
+        below[i] = 0;
+        if (children[i] == NULL) continue;
+
+        device_communication_subtree_descendants(&subtree, roots[i], &descendants);
+        if (descendants.count == 0) continue;
+        device_communication_message_modify(&child_out_message, forks[i].id, MESSAGE_TYPE_SPAWN_SUBTREE, "");
+        device_communication_subtree_to_message(&descendants, child_out_message.message,
+                                                DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        device_communication_filter_track_spawn(children[i], &child_out_message);
+        device_communication_write_message_notify(children[i], &child_out_message);
+        below[i] = descendants.count;
+    }
+    for (i = 0; i < count; ++i) {
+        if (below[i] == 0) continue;
+        if ((child_in_message = device_communication_read_message(children[i])).type == MESSAGE_TYPE_SPAWN_SUBTREE) {
+            spawned += below[i];
+        } else if (child_in_message.type == MESSAGE_TYPE_ERROR) {
+            /* The child spawned what it could, its count is in the error */
+            spawned += strtoul(child_in_message.message, NULL, 10);
+        }
+    }
+
+    if (spawned == subtree.count) {
+        device_communication_message_modify(out_message, _device_to_spawn.id_sender, MESSAGE_TYPE_SPAWN_SUBTREE, "");
+    } else {
+        device_communication_message_modify(out_message, _device_to_spawn.id_sender, MESSAGE_TYPE_ERROR,
+                                            "%lu of %lu Devices spawned", spawned, subtree.count);
+    }
+}
+
 static void device_child_read_pipe(int signal_number) {
+    DeviceCommunicationMessage in_message;
     if (signal_number == DEVICE_COMMUNICATION_READ_PIPE) {
         if (device_child_communication == NULL || device_child_message_handler == NULL) return;
         if (control_device_child == NULL && device_child == NULL) {
@@ -172,8 +493,14 @@ static void device_child_read_pipe(int signal_number) {
             control_device_child_middleware_message_handler();
         } else if (device_child != NULL && control_device_child == NULL) {
             /* Middleware for Device */
-            devive_child_middleware_message_handler(device_communication_read_message(device_child_communication));
+            in_message = device_communication_read_message(device_child_communication);
+            device_communication_trace_begin(in_message.trace_id, device_child->id, device_child->device_descriptor->id,
+                                             in_message.type);
+            devive_child_middleware_message_handler(in_message);
         }
+
+        /* The span of a traced message ends when its reply has been sent */
+        device_communication_trace_end();
     }
 }
 
@@ -218,11 +545,23 @@ Device *device_child_new_device(int argc, char **args, size_t device_descriptor_
 
 DeviceCommunication *
 device_child_new_device_communication(int argc, char **args, void (*message_handler)(DeviceCommunicationMessage)) {
+    struct sigaction read_pipe_action;
     if (!device_child_check_args(argc, args)) return NULL;
     if (message_handler == NULL || device_child_message_handler != NULL) return NULL;
 
     device_child_message_handler = message_handler;
-    if (signal(DEVICE_COMMUNICATION_READ_PIPE, device_child_read_pipe) == SIG_ERR) {
+
+    /* A manual switch waits for the message being handled, a conditional switch is checked and applied at once */
+    read_pipe_action.sa_handler = device_child_read_pipe;
+    read_pipe_action.sa_flags = SA_RESTART;
+    sigemptyset(&read_pipe_action.sa_mask);
+    sigaddset(&read_pipe_action.sa_mask, DEVICE_COMMUNICATION_READ_QUEUE);
+    if (sigaction(DEVICE_COMMUNICATION_READ_PIPE, &read_pipe_action, NULL) != 0) {
+        perror("Signal Device Child Error");
+        EXIT_FAILURE;
+    }
+    if (control_device_child != NULL &&
+        signal(DEVICE_COMMUNICATION_CHANGED, control_device_child_changed_signal) == SIG_ERR) {
         perror("Signal Device Child Error");
         EXIT_FAILURE;
     }
@@ -234,6 +573,13 @@ device_child_new_device_communication(int argc, char **args, void (*message_hand
 
 static void devive_child_middleware_message_handler(DeviceCommunicationMessage in_message) {
     DeviceCommunicationMessage out_message;
+    DeviceCommunicationScene scene;
+    const DeviceCommunicationSceneTarget *target;
+    DeviceCommunicationFilter filter;
+    DeviceCommunicationCondition condition;
+    char switch_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    size_t transaction;
+    unsigned long timeout;
     if (device_child == NULL || device_child_communication == NULL) return;
 
     device_communication_message_init(device_child, &out_message);
@@ -251,6 +597,76 @@ static void devive_child_middleware_message_handler(DeviceCommunicationMessage i
         else in_message.type = MESSAGE_TYPE_RECIPIENT_ID_MISLEADING;
     } else if (in_message.type == MESSAGE_TYPE_UNLOCK) {
         if (!device_child_lock) in_message.type = MESSAGE_TYPE_RECIPIENT_ID_MISLEADING;
+    } else if (in_message.type == MESSAGE_TYPE_AGGREGATE) {
+        /* A Device takes part in an aggregate with its info record, the Control Device folds it */
+        in_message.type = MESSAGE_TYPE_INFO;
+    } else if (in_message.type == MESSAGE_TYPE_INFO) {
+        device_communication_filter_from_message(&filter, in_message.message);
+        if (device_communication_filter_is_delta(&filter)) {
+            if (device_child_info_epoch != 0 && device_child_info_epoch <= filter.since &&
+                device_child_info_version == device_child->version) {
+                /* The asker still holds the record of this Device */
+                device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_INFO, "");
+                out_message.flag_unchanged = true;
+                out_message.override = device_child->override;
+                device_communication_write_message(device_child_communication, &out_message);
+                return;
+            }
+            device_child_info_epoch = filter.epoch;
+            device_child_info_version = device_child->version;
+        }
+    } else if (in_message.type == MESSAGE_TYPE_SWITCH_MULTI) {
+        /* A target handles its part of a multi target switch as a plain switch */
+        if (device_communication_scene_from_message(&scene, in_message.message) &&
+            (target = device_communication_scene_find(&scene, device_child->id)) != NULL) {
+            in_message.type = MESSAGE_TYPE_SWITCH;
+            device_communication_scene_to_switch(&scene, target, in_message.message,
+                                                 DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        }
+    } else if (in_message.type == MESSAGE_TYPE_SWITCH_SELECT) {
+        /* A selected Device handles a switch by selector as a plain switch */
+        if (device_communication_filter_from_selector(&filter, in_message.message, switch_message,
+                                                      DEVICE_COMMUNICATION_MESSAGE_LENGTH) &&
+            device_communication_filter_select(&filter, device_child->id, device_child->device_descriptor->id,
+                                               device_child->name, device_child->state)) {
+            in_message.type = MESSAGE_TYPE_SWITCH;
+            strcpy(in_message.message, switch_message);
+        }
+    } else if (in_message.type == MESSAGE_TYPE_COMMIT) {
+        /* A target switches what it prepared, a target the transaction no longer holds refuses */
+        if (device_communication_transaction_from_message(in_message.message, &transaction, &timeout, &scene) &&
+            (target = device_communication_scene_find(&scene, device_child->id)) != NULL) {
+            if (!device_child_transaction_holds(transaction)) {
+                device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_SWITCH, "%s",
+                                                    MESSAGE_RETURN_TRANSACTION_ERROR);
+                device_communication_write_message(device_child_communication, &out_message);
+                return;
+            }
+            device_child_transaction_id = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+            in_message.type = MESSAGE_TYPE_SWITCH;
+            device_communication_scene_to_switch(&scene, target, in_message.message,
+                                                 DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        }
+    }
+
+    /* Held by a transaction, every other switch is refused until its commit or its deadline */
+    if (in_message.type == MESSAGE_TYPE_SWITCH &&
+        device_child_transaction_holds(DEVICE_COMMUNICATION_TRANSACTION_NONE)) {
+        device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_SWITCH, "%s",
+                                            MESSAGE_RETURN_LOCKED_ERROR);
+        device_communication_write_message(device_child_communication, &out_message);
+        return;
+    }
+
+    if (in_message.type == MESSAGE_TYPE_SWITCH &&
+        device_communication_condition_from_message(&condition, in_message.message) &&
+        !device_communication_condition_holds(&condition, device_child->state, device_child->version)) {
+        /* The condition does not hold, answer with what the Device is now */
+        device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_SWITCH, "%s\n%d\n%lu\n",
+                                            MESSAGE_RETURN_CONDITION_ERROR, device_child->state,
+                                            device_child->version);
+        device_communication_write_message(device_child_communication, &out_message);
+        return;
     }
 
     switch (in_message.type) {
@@ -267,7 +683,8 @@ static void devive_child_middleware_message_handler(DeviceCommunicationMessage i
             device_child_lock = false;
             break;
         }
-        case MESSAGE_TYPE_SPAWN_DEVICE: {
+        case MESSAGE_TYPE_SPAWN_DEVICE:
+        case MESSAGE_TYPE_SPAWN_SUBTREE: {
             in_message.type = MESSAGE_TYPE_ERROR;
             device_communication_message_modify_message(&out_message, "This is not a Control Device");
             break;
@@ -277,6 +694,30 @@ static void devive_child_middleware_message_handler(DeviceCommunicationMessage i
                                                 getpid());
             break;
         }
+        case MESSAGE_TYPE_TRACE: {
+            device_child_trace(&in_message);
+            return;
+        }
+        case MESSAGE_TYPE_PREPARE:
+        case MESSAGE_TYPE_ABORT: {
+            device_child_transaction(&in_message);
+            return;
+        }
+        case MESSAGE_TYPE_SWITCH_MULTI:
+        case MESSAGE_TYPE_SWITCH_SELECT:
+        case MESSAGE_TYPE_COMMIT: {
+            /* Not a target, close the stream without a record */
+            in_message.type = MESSAGE_TYPE_SWITCH;
+            device_communication_message_modify_message(&out_message, "");
+            out_message.flag_skip = true;
+            break;
+        }
+        case MESSAGE_TYPE_STATS: {
+            /* A Device never waits for an ack, it has no statistics */
+            device_communication_message_modify_message(&out_message, "");
+            out_message.flag_skip = true;
+            break;
+        }
         case MESSAGE_TYPE_RECIPIENT_ID_MISLEADING: {
             break;
         }
@@ -336,6 +777,7 @@ static void control_device_child_middleware_message_handler(void) {
     DeviceCommunicationMessage out_message;
     DeviceCommunicationMessage child_in_message;
     DeviceCommunicationMessage child_out_message;
+    DeviceCommunicationCondition condition;
     bool terminate_controller = false;
     bool child_override = false;
     if (control_device_child == NULL || device_child_communication == NULL) return;
@@ -364,6 +806,12 @@ static void control_device_child_middleware_message_handler(void) {
         return;
     }
 
+    device_communication_trace_begin(in_message.trace_id, control_device_child->device->id,
+                                     control_device_child->device->device_descriptor->id, in_message.type);
+
+    /* Whatever it finds below, the next delta info walk looks again */
+    if (device_child_message_changes(in_message.type)) control_device_child_changed = true;
+
     /* Adjust hop count for child out message */
     child_out_message = in_message;
     child_out_message.ctr_hop = 0;
@@ -394,6 +842,12 @@ static void control_device_child_middleware_message_handler(void) {
                     } while (child_in_message.flag_continue);
                 }
 
+                /* Remember the Device types reachable through this child */
+                if (child_in_message.type == MESSAGE_TYPE_SPAWN_DEVICE ||
+                    child_in_message.type == MESSAGE_TYPE_SPAWN_SUBTREE) {
+                    device_communication_filter_track_spawn(data, &child_out_message);
+                }
+
                 /* If it's a Terminate Message and is directly connected, close & remove */
                 if (child_in_message.type == MESSAGE_TYPE_TERMINATE &&
                     device_communication_device_is_directly_connected(&child_in_message)) {
@@ -419,6 +873,30 @@ static void control_device_child_middleware_message_handler(void) {
         in_message.type = MESSAGE_TYPE_TERMINATE;
     }
 
+    /* Held by a transaction, a switch of this Control Device and its children is refused until the commit */
+    if (in_message.type == MESSAGE_TYPE_SWITCH &&
+        device_child_transaction_holds(DEVICE_COMMUNICATION_TRANSACTION_NONE)) {
+        device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_SWITCH, "%s",
+                                            MESSAGE_RETURN_LOCKED_ERROR);
+        device_communication_write_message(device_child_communication, &out_message);
+        return;
+    }
+
+    /* A conditional switch is checked before the cascade, the children only receive the plain switch */
+    if (in_message.type == MESSAGE_TYPE_SWITCH &&
+        device_communication_condition_from_message(&condition, in_message.message)) {
+        if (!device_communication_condition_holds(&condition, control_device_child->device->state,
+                                                  control_device_child->device->version)) {
+            device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_SWITCH,
+                                                "%s\n%d\n%lu\n", MESSAGE_RETURN_CONDITION_ERROR,
+                                                control_device_child->device->state,
+                                                control_device_child->device->version);
+            device_communication_write_message(device_child_communication, &out_message);
+            return;
+        }
+        strcpy(child_out_message.message, in_message.message);
+    }
+
     /* Incoming Message is Forced or it's for this Control Device */
     child_out_message.id_sender = control_device_child->device->id;
     child_out_message.id_device_descriptor = control_device_child->device->device_descriptor->id;
@@ -430,13 +908,36 @@ static void control_device_child_middleware_message_handler(void) {
                                                 getpid());
             break;
         }
-        case MESSAGE_TYPE_TERMINATE:
+        case MESSAGE_TYPE_TERMINATE: {
+            control_device_child_terminate(&in_message, &child_out_message);
+
+            if (control_device_child->device->device_descriptor->id == DEVICE_TYPE_CONTROLLER &&
+                !terminate_controller) {
+                in_message.type = MESSAGE_TYPE_RECIPIENT_ID_MISLEADING;
+            } else {
+                /* Stop the Device */
+                _device_child_run = false;
+            }
+            break;
+        }
         case MESSAGE_TYPE_INFO:
         case MESSAGE_TYPE_SWITCH: {
 
             bool all_error_messages = true;
+            DeviceCommunicationFilter filter;
+
+            device_communication_filter_from_message(&filter, (in_message.type == MESSAGE_TYPE_INFO)
+                                                              ? in_message.message : "");
+            if (device_communication_filter_is_delta(&filter)) {
+                control_device_child_info_delta(&in_message, &child_out_message, &filter);
+                return;
+            }
 
             list_for_each(data, control_device_child->devices) {
+                /* Prune subtrees that cannot contain a Device matching the filter */
+                if (in_message.type == MESSAGE_TYPE_INFO && !device_communication_filter_may_match(&filter, data->types))
+                    continue;
+
                 child_in_message = device_communication_write_message_with_ack(data, &child_out_message);
                 child_in_message.id_recipient = in_message.id_sender;
                 if (child_in_message.type == MESSAGE_TYPE_INFO) {
@@ -447,8 +948,10 @@ static void control_device_child_middleware_message_handler(void) {
                     all_error_messages = false;
 
                 if (child_in_message.flag_continue) {
-                    device_communication_write_message_with_ack_silent(device_child_communication,
-                                                                       &child_in_message);
+                    if (control_device_child_forward_record(in_message.type, &filter, &child_in_message)) {
+                        device_communication_write_message_with_ack_silent(device_child_communication,
+                                                                           &child_in_message);
+                    }
                     do {
                         child_in_message = device_communication_write_message_with_ack_silent(data,
                                                                                               &child_out_message);
@@ -457,30 +960,32 @@ static void control_device_child_middleware_message_handler(void) {
                             (strcmp(child_in_message.message, MESSAGE_RETURN_SUCCESS) == 0))
                             all_error_messages = false;
 
-                        if (child_in_message.flag_continue) {
+                        if (child_in_message.flag_continue &&
+                            control_device_child_forward_record(in_message.type, &filter, &child_in_message)) {
                             device_communication_write_message_with_ack_silent(device_child_communication,
                                                                                &child_in_message);
                         }
                     } while (child_in_message.flag_continue);
                 }
 
-                child_in_message.flag_continue = true;
-                device_communication_write_message_with_ack_silent(device_child_communication, &child_in_message);
-
-                if (in_message.type == MESSAGE_TYPE_TERMINATE) {
-                    device_communication_close_communication(data);
-                    list_remove(control_device_child->devices, data);
+                if (control_device_child_forward_record(in_message.type, &filter, &child_in_message)) {
+                    child_in_message.flag_continue = true;
+                    device_communication_write_message_with_ack_silent(device_child_communication,
+                                                                       &child_in_message);
                 }
             }
 
-            if (control_device_child->device->device_descriptor->id == DEVICE_TYPE_CONTROLLER &&
-                in_message.type == MESSAGE_TYPE_TERMINATE && !terminate_controller) {
-                in_message.type = MESSAGE_TYPE_RECIPIENT_ID_MISLEADING;
-            } else if (in_message.type == MESSAGE_TYPE_TERMINATE) {
-                /* Stop the Device */
-                _device_child_run = false;
-                break;
-            } else if (in_message.type == MESSAGE_TYPE_INFO) {
+            if (in_message.type == MESSAGE_TYPE_INFO) {
+                if (!device_communication_filter_match(&filter, control_device_child->device->id,
+                                                       control_device_child->device->device_descriptor->id,
+                                                       control_device_child->device->name,
+                                                       control_device_child->device->state)) {
+                    /* This Control Device does not match, close the stream without a record */
+                    device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_INFO, "");
+                    out_message.flag_skip = true;
+                    device_communication_write_message(device_child_communication, &out_message);
+                    return;
+                }
                 in_message.override = child_override;
                 device_child_message_handler(in_message);
                 return;
@@ -494,6 +999,32 @@ static void control_device_child_middleware_message_handler(void) {
 
             break;
         }
+        case MESSAGE_TYPE_AGGREGATE: {
+            control_device_child_aggregate(&in_message, &child_out_message);
+            return;
+        }
+        case MESSAGE_TYPE_STATS: {
+            control_device_child_stats(&in_message, &child_out_message);
+            return;
+        }
+        case MESSAGE_TYPE_TRACE: {
+            control_device_child_trace(&in_message, &child_out_message);
+            return;
+        }
+        case MESSAGE_TYPE_SWITCH_MULTI:
+        case MESSAGE_TYPE_COMMIT: {
+            control_device_child_switch_multi(&in_message, &child_out_message);
+            return;
+        }
+        case MESSAGE_TYPE_PREPARE:
+        case MESSAGE_TYPE_ABORT: {
+            control_device_child_transaction(&in_message, &child_out_message);
+            return;
+        }
+        case MESSAGE_TYPE_SWITCH_SELECT: {
+            control_device_child_switch_select(&in_message, &child_out_message);
+            return;
+        }
         case MESSAGE_TYPE_SYSTEM_STATUS: {
             if (control_device_child->device->device_descriptor->id != DEVICE_TYPE_CONTROLLER) {
                 in_message.type = MESSAGE_TYPE_RECIPIENT_ID_MISLEADING;
@@ -528,4 +1059,627 @@ static void control_device_child_middleware_message_handler(void) {
     out_message.override = in_message.override;
 
     device_communication_write_message(device_child_communication, &out_message);
-}
\ No newline at end of file
+}
+
+static void device_child_notify_change(void) {
+    const Device *device = (control_device_child != NULL) ? control_device_child->device : device_child;
+    if (device == NULL || device->version == device_child_notified_version) return;
+
+    device_child_notified_version = device->version;
+    kill(getppid(), DEVICE_COMMUNICATION_CHANGED);
+}
+
+static void control_device_child_changed_signal(int signal_number) {
+    if (signal_number != DEVICE_COMMUNICATION_CHANGED) return;
+
+    control_device_child_changed = true;
+    kill(getppid(), DEVICE_COMMUNICATION_CHANGED);
+}
+
+static bool device_child_message_changes(size_t type) {
+    switch (type) {
+        case MESSAGE_TYPE_TERMINATE:
+        case MESSAGE_TYPE_TERMINATE_CONTROLLER:
+        case MESSAGE_TYPE_SWITCH:
+        case MESSAGE_TYPE_SPAWN_DEVICE:
+        case MESSAGE_TYPE_SPAWN_SUBTREE:
+        case MESSAGE_TYPE_SET_INIT_VALUES:
+        case MESSAGE_TYPE_LOCK:
+        case MESSAGE_TYPE_UNLOCK:
+        case MESSAGE_TYPE_UNLOCK_AND_TERMINATE:
+        case MESSAGE_TYPE_SWITCH_MULTI:
+        case MESSAGE_TYPE_SWITCH_SELECT:
+        case MESSAGE_TYPE_COMMIT: {
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+static void control_device_child_info_delta(DeviceCommunicationMessage *in_message,
+                                            const DeviceCommunicationMessage *child_out_message,
+                                            const DeviceCommunicationFilter *filter) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage child_message = *child_out_message;
+    DeviceCommunicationMessage child_in_message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationFilter child_filter;
+    const Device *device = control_device_child->device;
+    Node *node;
+    bool unchanged;
+    bool first;
+    bool live;
+    bool last;
+    bool override = false;
+
+    unchanged = !control_device_child_changed && device_child_info_epoch != 0 &&
+                device_child_info_epoch <= filter->since && device_child_info_version == device->version;
+    for (node = control_device_child->devices->head; node != NULL && unchanged; node = node->next) {
+        data = (DeviceCommunication *) node->data;
+        if (data->info_epoch == 0 || data->info_epoch > filter->since || data->info_live) unchanged = false;
+    }
+
+    if (unchanged) {
+        /* No fan-out, the asker still holds every record of the subtree */
+        device_communication_message_init(device, &out_message);
+        device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_INFO, "");
+        out_message.flag_unchanged = true;
+        if (!list_is_empty(control_device_child->devices))
+            out_message.override = ((DeviceCommunication *) list_get_first(control_device_child->devices))->info_override;
+        device_communication_write_message(device_child_communication, &out_message);
+        return;
+    }
+
+    /* Cleared before asking, a change signaled during the walk is seen by the next one */
+    control_device_child_changed = false;
+
+    for (node = control_device_child->devices->head; node != NULL; node = node->next) {
+        data = (DeviceCommunication *) node->data;
+
+        /* A subtree with a record changing with time is asked in full */
+        child_filter = *filter;
+        if (data->info_live) child_filter.since = 0;
+        device_communication_filter_to_message(&child_filter, child_message.message,
+                                               DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+
+        child_in_message = device_communication_write_message_with_ack(data, &child_message);
+        if (child_in_message.type != MESSAGE_TYPE_INFO) {
+            data->info_epoch = 0;
+            control_device_child_changed = true;
+            continue;
+        }
+
+        first = true;
+        live = false;
+        do {
+            if (first) data->info_override = child_in_message.override;
+            first = false;
+            live |= child_in_message.flag_live;
+
+            last = !child_in_message.flag_continue;
+            if (!child_in_message.flag_skip) {
+                child_in_message.id_recipient = in_message->id_sender;
+                child_in_message.flag_continue = true;
+                device_communication_write_message_with_ack_silent(device_child_communication, &child_in_message);
+            }
+            if (!last) child_in_message = device_communication_write_message_with_ack_silent(data, &child_message);
+        } while (!last);
+
+        data->info_epoch = filter->epoch;
+        data->info_live = live;
+        override |= data->info_override;
+    }
+
+    /* The own record closes the stream */
+    device_child_info_epoch = filter->epoch;
+    device_child_info_version = device->version;
+    in_message->override = override;
+    device_child_message_handler(*in_message);
+}
+
+static bool control_device_child_forward_record(size_t type, const DeviceCommunicationFilter *filter,
+                                                const DeviceCommunicationMessage *record) {
+    if (type != MESSAGE_TYPE_INFO) return true;
+    if (record->flag_skip) return false;
+
+    return device_communication_filter_match_message(filter, record);
+}
+
+static void control_device_child_terminate(const DeviceCommunicationMessage *in_message,
+                                           const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage *record;
+    List *records = new_list(NULL, NULL);
+
+    device_communication_terminate_all(control_device_child->devices, child_out_message,
+                                       device_communication_terminate_timeout(in_message), records);
+    while (!list_is_empty(control_device_child->devices)) {
+        data = (DeviceCommunication *) list_remove_first(control_device_child->devices);
+        device_communication_kill(data);
+        free(data);
+    }
+
+    /* The whole subtree is gone, its records go up in one stream */
+    list_for_each(record, records) {
+        record->id_recipient = in_message->id_sender;
+        record->flag_continue = true;
+        device_communication_write_message_with_ack_silent(device_child_communication, record);
+    }
+    free_list(records);
+}
+
+static void control_device_child_aggregate(const DeviceCommunicationMessage *in_message,
+                                           const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage child_in_message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationFilter filter;
+    List *aggregates;
+    Node *node;
+
+    device_communication_filter_from_message(&filter, in_message->message);
+    aggregates = new_list(NULL, NULL);
+
+    list_for_each(data, control_device_child->devices) {
+        /* Prune subtrees that cannot contain a Device matching the filter */
+        if (!device_communication_filter_may_match(&filter, data->types)) continue;
+
+        child_in_message = device_communication_write_message_with_ack(data, child_out_message);
+        device_communication_aggregate_add_message(aggregates, &filter, &child_in_message);
+        while (child_in_message.flag_continue) {
+            child_in_message = device_communication_write_message_with_ack_silent(data, child_out_message);
+            device_communication_aggregate_add_message(aggregates, &filter, &child_in_message);
+        }
+    }
+
+    if (device_communication_filter_match(&filter, control_device_child->device->id,
+                                          control_device_child->device->device_descriptor->id,
+                                          control_device_child->device->name,
+                                          control_device_child->device->state)) {
+        device_communication_aggregate_add(aggregates, control_device_child->device->device_descriptor->id,
+                                           control_device_child->device->state, NULL);
+    }
+
+    device_communication_message_init(control_device_child->device, &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_AGGREGATE, "");
+
+    if (list_is_empty(aggregates)) {
+        /* Nothing matches, close the stream without a record */
+        out_message.flag_skip = true;
+        device_communication_write_message(device_child_communication, &out_message);
+    } else {
+        for (node = aggregates->head; node != NULL; node = node->next) {
+            device_communication_aggregate_to_message((DeviceCommunicationAggregate *) node->data,
+                                                      out_message.message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+            out_message.flag_continue = node->next != NULL;
+            if (out_message.flag_continue) {
+                device_communication_write_message_with_ack_silent(device_child_communication, &out_message);
+            } else {
+                device_communication_write_message(device_child_communication, &out_message);
+            }
+        }
+    }
+
+    free_list(aggregates);
+}
+
+static void control_device_child_stats(const DeviceCommunicationMessage *in_message,
+                                       const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage child_in_message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationMessage record;
+    DeviceCommunicationFilter filter;
+    DeviceCommunicationStats *stats;
+    size_t cursor = 0;
+    bool next;
+
+    device_communication_filter_init(&filter);
+    filter.types = DEVICE_COMMUNICATION_STATS_DEVICE_TYPES;
+    stats = new_device_communication_stats();
+
+    list_for_each(data, control_device_child->devices) {
+        /* Prune subtrees without Control Devices */
+        if (!device_communication_filter_may_match(&filter, data->types)) continue;
+
+        child_in_message = device_communication_write_message_with_ack(data, child_out_message);
+        device_communication_stats_add_message(stats, &child_in_message);
+        while (child_in_message.flag_continue) {
+            child_in_message = device_communication_write_message_with_ack_silent(data, child_out_message);
+            device_communication_stats_add_message(stats, &child_in_message);
+        }
+    }
+
+    device_communication_stats_merge(stats, device_communication_stats());
+
+    device_communication_message_init(control_device_child->device, &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_STATS, "");
+
+    if (!device_communication_stats_to_message(stats, &cursor, out_message.message,
+                                               DEVICE_COMMUNICATION_MESSAGE_LENGTH)) {
+        /* Nothing recorded, close the stream without a record */
+        out_message.flag_skip = true;
+        device_communication_write_message(device_child_communication, &out_message);
+    } else {
+        do {
+            /* Encode the next record before sending, the last one closes the stream */
+            record = out_message;
+            next = device_communication_stats_to_message(stats, &cursor, out_message.message,
+                                                         DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+            record.flag_continue = next;
+            if (next) {
+                device_communication_write_message_with_ack_silent(device_child_communication, &record);
+            } else {
+                device_communication_write_message(device_child_communication, &record);
+            }
+        } while (next);
+    }
+
+    free(stats);
+}
+
+static void control_device_child_trace(const DeviceCommunicationMessage *in_message,
+                                       const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage child_in_message;
+
+    /* Every Device may have spans, no subtree is pruned */
+    list_for_each(data, control_device_child->devices) {
+        child_in_message = device_communication_write_message_with_ack(data, child_out_message);
+        while (true) {
+            if (child_in_message.type == MESSAGE_TYPE_TRACE && !child_in_message.flag_skip) {
+                child_in_message.flag_continue = true;
+                device_communication_write_message_with_ack_silent(device_child_communication, &child_in_message);
+            } else if (!child_in_message.flag_continue) {
+                break;
+            }
+
+            child_in_message = device_communication_write_message_with_ack_silent(data, child_out_message);
+        }
+    }
+
+    device_child_trace(in_message);
+}
+
+static void control_device_child_switch_multi(const DeviceCommunicationMessage *in_message,
+                                              const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunicationMessage scene_out_message = *child_out_message;
+    DeviceCommunicationMessage switch_out_message = *child_out_message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationScene scene;
+    const DeviceCommunicationSceneTarget *target;
+    const char *refused = NULL;
+    bool commit = in_message->type == MESSAGE_TYPE_COMMIT;
+    bool targeted = false;
+    bool all_error_messages = true;
+    size_t transaction = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+    unsigned long timeout = 0;
+    size_t length;
+    Node *node;
+
+    if (!((commit) ? device_communication_transaction_from_message(in_message->message, &transaction, &timeout,
+                                                                   &scene)
+                   : device_communication_scene_from_message(&scene, in_message->message)))
+        device_communication_scene_init(&scene);
+
+    /* This Control Device is switched last, its record closes the stream */
+    if ((target = device_communication_scene_find(&scene, control_device_child->device->id)) != NULL) {
+        switch_out_message.type = MESSAGE_TYPE_SWITCH;
+        device_communication_scene_to_switch(&scene, target, switch_out_message.message,
+                                             DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        device_communication_scene_remove(&scene, control_device_child->device->id);
+
+        /* A commit switches only what it prepared, any other switch is refused while a transaction holds it */
+        if (commit && device_child_transaction_holds(transaction)) {
+            device_child_transaction_id = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+        } else if (commit) {
+            refused = MESSAGE_RETURN_TRANSACTION_ERROR;
+        } else if (device_child_transaction_holds(DEVICE_COMMUNICATION_TRANSACTION_NONE)) {
+            refused = MESSAGE_RETURN_LOCKED_ERROR;
+        }
+        targeted = refused == NULL;
+    }
+
+    /* Same as a switch of this Control Device, every child follows it before the targets under it */
+    for (node = control_device_child->devices->head; node != NULL && targeted; node = node->next) {
+        if (control_device_child_switch_relay((DeviceCommunication *) node->data, &switch_out_message,
+                                              MESSAGE_TYPE_SWITCH, in_message->id_sender, NULL))
+            all_error_messages = false;
+    }
+
+    /* Stop as soon as every target has been found, the remaining subtrees are not visited */
+    for (node = control_device_child->devices->head;
+         node != NULL && !device_communication_scene_is_empty(&scene); node = node->next) {
+        if (commit) {
+            device_communication_transaction_to_message(transaction, timeout, &scene, 0, scene_out_message.message,
+                                                        DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        } else {
+            device_communication_scene_to_message(&scene, 0, scene_out_message.message,
+                                                  DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        }
+        control_device_child_switch_relay((DeviceCommunication *) node->data, &scene_out_message,
+                                          MESSAGE_TYPE_SWITCH, in_message->id_sender, &scene);
+    }
+
+    if (targeted) {
+        out_message = *in_message;
+        out_message.type = MESSAGE_TYPE_SWITCH;
+        strcpy(out_message.message, switch_out_message.message);
+        length = strlen(out_message.message);
+        if (all_error_messages)
+            strncat(out_message.message, "ERRORS\n", DEVICE_COMMUNICATION_MESSAGE_LENGTH - length - 1);
+        device_child_message_handler(out_message);
+        return;
+    }
+
+    /* Not a target or refused, close the stream */
+    device_communication_message_init(control_device_child->device, &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_SWITCH, "%s",
+                                        (refused == NULL) ? "" : refused);
+    out_message.flag_skip = refused == NULL;
+    device_communication_write_message(device_child_communication, &out_message);
+}
+
+static void control_device_child_switch_select(const DeviceCommunicationMessage *in_message,
+                                               const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunicationMessage select_out_message = *child_out_message;
+    DeviceCommunicationMessage switch_out_message = *child_out_message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationFilter filter;
+    bool all_error_messages = true;
+    bool decoded;
+    size_t length;
+    Node *node;
+
+    decoded = device_communication_filter_from_selector(&filter, in_message->message, switch_out_message.message,
+                                                        DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+
+    if (decoded && device_communication_filter_select(&filter, control_device_child->device->id,
+                                                      control_device_child->device->device_descriptor->id,
+                                                      control_device_child->device->name,
+                                                      control_device_child->device->state)) {
+        /* Held by a transaction, neither this Control Device nor its children are switched */
+        if (device_child_transaction_holds(DEVICE_COMMUNICATION_TRANSACTION_NONE)) {
+            device_communication_message_init(control_device_child->device, &out_message);
+            device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_SWITCH, "%s",
+                                                MESSAGE_RETURN_LOCKED_ERROR);
+            device_communication_write_message(device_child_communication, &out_message);
+            return;
+        }
+
+        /* Same as a switch of this Control Device, every child follows it whether selected or not */
+        switch_out_message.type = MESSAGE_TYPE_SWITCH;
+        for (node = control_device_child->devices->head; node != NULL; node = node->next) {
+            if (control_device_child_switch_relay((DeviceCommunication *) node->data, &switch_out_message,
+                                                  MESSAGE_TYPE_SWITCH, in_message->id_sender, NULL))
+                all_error_messages = false;
+        }
+
+        out_message = *in_message;
+        out_message.type = MESSAGE_TYPE_SWITCH;
+        strcpy(out_message.message, switch_out_message.message);
+        length = strlen(out_message.message);
+        if (all_error_messages)
+            strncat(out_message.message, "ERRORS\n", DEVICE_COMMUNICATION_MESSAGE_LENGTH - length - 1);
+        device_child_message_handler(out_message);
+        return;
+    }
+
+    /* Every Device below the under Control Device is under it */
+    if (decoded && filter.under == control_device_child->device->id) {
+        filter.under = DEVICE_COMMUNICATION_FILTER_UNDER_ANY;
+        strcpy(select_out_message.message, switch_out_message.message);
+        length = strlen(select_out_message.message);
+        device_communication_filter_to_message(&filter, select_out_message.message + length,
+                                               DEVICE_COMMUNICATION_MESSAGE_LENGTH - length);
+    }
+
+    for (node = control_device_child->devices->head; node != NULL && decoded; node = node->next) {
+        /* Prune subtrees that cannot contain a selected Device */
+        if (!device_communication_filter_may_match(&filter, ((DeviceCommunication *) node->data)->types)) continue;
+        control_device_child_switch_relay((DeviceCommunication *) node->data, &select_out_message,
+                                          MESSAGE_TYPE_SWITCH, in_message->id_sender, NULL);
+    }
+
+    /* Not selected, close the stream without a record */
+    device_communication_message_init(control_device_child->device, &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_SWITCH, "");
+    out_message.flag_skip = true;
+    device_communication_write_message(device_child_communication, &out_message);
+}
+
+static void control_device_child_transaction(const DeviceCommunicationMessage *in_message,
+                                             const DeviceCommunicationMessage *child_out_message) {
+    DeviceCommunicationMessage transaction_out_message = *child_out_message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationScene scene;
+    const DeviceCommunicationSceneTarget *target;
+    char switch_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    const char *vote = NULL;
+    size_t transaction = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+    unsigned long timeout = 0;
+    Node *node;
+
+    if (!device_communication_transaction_from_message(in_message->message, &transaction, &timeout, &scene))
+        device_communication_scene_init(&scene);
+
+    /* This Control Device votes first and answers last, its record closes the stream */
+    if ((target = device_communication_scene_find(&scene, control_device_child->device->id)) != NULL) {
+        device_communication_scene_to_switch(&scene, target, switch_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        vote = device_child_transaction_vote(control_device_child->device, in_message->type, transaction, timeout,
+                                             switch_message);
+        device_communication_scene_remove(&scene, control_device_child->device->id);
+    }
+
+    /* Stop as soon as every target has voted, the remaining subtrees are not visited */
+    for (node = control_device_child->devices->head;
+         node != NULL && !device_communication_scene_is_empty(&scene); node = node->next) {
+        device_communication_transaction_to_message(transaction, timeout, &scene, 0, transaction_out_message.message,
+                                                    DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        control_device_child_switch_relay((DeviceCommunication *) node->data, &transaction_out_message,
+                                          in_message->type, in_message->id_sender, &scene);
+    }
+
+    device_communication_message_init(control_device_child->device, &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, in_message->type, "%s",
+                                        (vote == NULL) ? "" : vote);
+    out_message.flag_skip = vote == NULL;
+    device_communication_write_message(device_child_communication, &out_message);
+}
+
+static bool control_device_child_switch_relay(DeviceCommunication *device_communication,
+                                              const DeviceCommunicationMessage *child_out_message, size_t type,
+                                              size_t id_recipient, DeviceCommunicationScene *scene) {
+    DeviceCommunicationMessage child_in_message;
+    bool switched = false;
+    bool next;
+
+    child_in_message = device_communication_write_message_with_ack(device_communication, child_out_message);
+    while (true) {
+        /* The last record of a Device has no continue flag, save it before relaying */
+        next = child_in_message.flag_continue;
+
+        if (child_in_message.type == type && !child_in_message.flag_skip) {
+            /* A child refused because a transaction holds it is switched by its own commit, it is not a failure */
+            if (strcmp(child_in_message.message, MESSAGE_RETURN_SUCCESS) == 0 ||
+                strcmp(child_in_message.message, MESSAGE_RETURN_LOCKED_ERROR) == 0)
+                switched = true;
+            if (scene != NULL) device_communication_scene_remove(scene, child_in_message.id_sender);
+
+            child_in_message.id_recipient = id_recipient;
+            child_in_message.flag_continue = true;
+            device_communication_write_message_with_ack_silent(device_child_communication, &child_in_message);
+        }
+        if (!next) break;
+
+        child_in_message = device_communication_write_message_with_ack_silent(device_communication,
+                                                                              child_out_message);
+    }
+
+    return switched;
+}
+
+static void device_child_transaction(const DeviceCommunicationMessage *in_message) {
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationScene scene;
+    const DeviceCommunicationSceneTarget *target;
+    char switch_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    size_t transaction;
+    unsigned long timeout;
+
+    device_communication_message_init(device_child, &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, in_message->type, "");
+
+    if (device_communication_transaction_from_message(in_message->message, &transaction, &timeout, &scene) &&
+        (target = device_communication_scene_find(&scene, device_child->id)) != NULL) {
+        device_communication_scene_to_switch(&scene, target, switch_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        device_communication_message_modify_message(&out_message, "%s",
+                                                    device_child_transaction_vote(device_child, in_message->type,
+                                                                                  transaction, timeout,
+                                                                                  switch_message));
+    } else {
+        /* Not a target, close the stream without a record */
+        out_message.flag_skip = true;
+    }
+
+    device_communication_write_message(device_child_communication, &out_message);
+}
+
+static const char *device_child_transaction_vote(const Device *device, size_t type, size_t transaction,
+                                                 unsigned long timeout, const char *switch_message) {
+    const char *vote;
+
+    if (type == MESSAGE_TYPE_ABORT) {
+        if (device_child_transaction_id == transaction)
+            device_child_transaction_id = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+        return MESSAGE_RETURN_SUCCESS;
+    }
+
+    if (device_child_transaction_holds(DEVICE_COMMUNICATION_TRANSACTION_NONE) &&
+        device_child_transaction_id != transaction)
+        return MESSAGE_RETURN_LOCKED_ERROR;
+    if (strcmp((vote = device_child_transaction_check(device, switch_message)), MESSAGE_RETURN_SUCCESS) != 0)
+        return vote;
+
+    device_child_transaction_id = transaction;
+    device_child_transaction_deadline = stopwatch_now() + (Stopwatch) timeout * (Stopwatch) STOPWATCH_NS_PER_MS;
+
+    return MESSAGE_RETURN_SUCCESS;
+}
+
+static bool device_child_transaction_holds(size_t transaction) {
+    if (device_child_transaction_id == DEVICE_COMMUNICATION_TRANSACTION_NONE) return false;
+
+    /* The commit never came, the Domus that prepared it may be gone */
+    if (stopwatch_now() >= device_child_transaction_deadline) {
+        device_child_transaction_id = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+        return false;
+    }
+
+    return transaction == DEVICE_COMMUNICATION_TRANSACTION_NONE || transaction == device_child_transaction_id;
+}
+
+static const char *device_child_transaction_check(const Device *device, const char *switch_message) {
+    DeviceDescriptorSwitch *device_switch = NULL;
+    DeviceDescriptorSwitchPosition *position;
+    const char *status = MESSAGE_RETURN_NAME_ERROR;
+    char **fields;
+    Node *node;
+
+    fields = device_communication_split_message_fields(switch_message);
+    if (fields == NULL || fields[0] == NULL || fields[1] == NULL) {
+        device_communication_free_message_fields(fields);
+        return MESSAGE_RETURN_NAME_ERROR;
+    }
+
+    /* A Control Device like the Hub describes no switch, it accepts the ones of its children */
+    if (list_is_empty(device->device_descriptor->switches)) status = MESSAGE_RETURN_SUCCESS;
+
+    for (node = device->device_descriptor->switches->head; node != NULL; node = node->next) {
+        if (strcmp(((DeviceDescriptorSwitch *) node->data)->name, fields[0]) == 0) {
+            device_switch = (DeviceDescriptorSwitch *) node->data;
+            status = MESSAGE_RETURN_VALUE_ERROR;
+            break;
+        }
+    }
+
+    for (node = (device_switch == NULL) ? NULL : device_switch->positions->head; node != NULL; node = node->next) {
+        position = (DeviceDescriptorSwitchPosition *) node->data;
+        if (strpbrk(position->name, DEVICE_CHILD_TRANSACTION_PLACEHOLDERS) != NULL ||
+            strcmp(position->name, fields[1]) == 0) {
+            status = MESSAGE_RETURN_SUCCESS;
+            break;
+        }
+    }
+
+    device_communication_free_message_fields(fields);
+    return status;
+}
+
+static void device_child_trace(const DeviceCommunicationMessage *in_message) {
+    const DeviceCommunicationTraceSpan *span;
+    DeviceCommunicationMessage out_message;
+    ConverterResult trace_id;
+    size_t cursor = 0;
+
+    device_communication_message_init((control_device_child != NULL) ? control_device_child->device : device_child,
+                                      &out_message);
+    device_communication_message_modify(&out_message, in_message->id_sender, MESSAGE_TYPE_TRACE, "");
+
+    trace_id = converter_string_to_long(in_message->message);
+    if (!trace_id.error) {
+        out_message.flag_continue = true;
+        while ((span = device_communication_trace_next((size_t) trace_id.data.Long, &cursor)) != NULL) {
+            device_communication_trace_span_to_message(span, out_message.message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+            device_communication_write_message_with_ack_silent(device_child_communication, &out_message);
+        }
+    }
+
+    /* Close the stream without a record */
+    device_communication_message_modify_message(&out_message, "");
+    out_message.flag_continue = false;
+    out_message.flag_skip = true;
+    device_communication_write_message(device_child_communication, &out_message);
+}
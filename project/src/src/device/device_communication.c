@@ -2,11 +2,15 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <errno.h>
+#include <poll.h>
 #include <string.h>
+#include <time.h>
 #include <sys/signal.h>
 #include <sys/wait.h>
 #include <sys/msg.h>
 #include "device/device_communication.h"
+#include "device/device_communication_stats.h"
+#include "device/device_communication_trace.h"
 #include "util/util_printer.h"
 
 /**
@@ -15,6 +19,14 @@
  */
 static void device_communication_notify(pid_t pid);
 
+/**
+ * Wait until a message of a Device can be read or a deadline expires
+ * @param device_communication The Device Communication
+ * @param deadline The time point the Device is not waited after
+ * @return true if a message can be read, false if the deadline expired or the Device is gone
+ */
+static bool device_communication_wait_message(const DeviceCommunication *device_communication, Stopwatch deadline);
+
 /**
  * Modify a Message message
  * @param message The message to change
@@ -35,6 +47,10 @@ new_device_communication(pid_t pid, int com_read, int com_write) {
     device_communication->pid = pid;
     device_communication->com_read = com_read;
     device_communication->com_write = com_write;
+    device_communication->types = 0;
+    device_communication->info_epoch = 0;
+    device_communication->info_live = false;
+    device_communication->info_override = false;
 
     return device_communication;
 }
@@ -52,6 +68,143 @@ bool device_communication_close_communication(DeviceCommunication *device_commun
     return true;
 }
 
+bool device_communication_kill(DeviceCommunication *device_communication) {
+    if (device_communication == NULL) return false;
+
+    kill(device_communication->pid, SIGKILL);
+    return device_communication_close_communication(device_communication);
+}
+
+static bool device_communication_wait_message(const DeviceCommunication *device_communication, Stopwatch deadline) {
+    struct pollfd input;
+    Stopwatch now;
+    int ready;
+
+    input.fd = device_communication->com_read;
+    input.events = POLLIN;
+    do {
+        /* Once the deadline expired a message already there is still read. Rounded up, the last wait does not spin */
+        now = stopwatch_now();
+        ready = poll(&input, 1, (now >= deadline) ? 0 : (int) ((deadline - now + 999999) / 1000000));
+    } while (ready == -1 && errno == EINTR);
+
+    /* A Device gone without answering only hangs up */
+    return ready > 0 && (input.revents & POLLIN);
+}
+
+size_t device_communication_terminate_all(List *devices, const DeviceCommunicationMessage *out_message,
+                                          unsigned long timeout, List *records) {
+    DeviceCommunication *data;
+    DeviceCommunication **children;
+    DeviceCommunicationMessage child_out_message;
+    DeviceCommunicationMessage in_message;
+    struct pollfd *exits;
+    Stopwatch start = stopwatch_now();
+    Stopwatch deadline = start + (Stopwatch) timeout * 1000000;
+    Stopwatch now;
+    size_t pending = 0;
+    size_t done = 0;
+    size_t count;
+    size_t i = 0;
+    int ready;
+    if (devices == NULL || out_message == NULL || list_is_empty(devices)) return 0;
+
+    count = devices->size;
+    children = (DeviceCommunication **) malloc(count * sizeof(DeviceCommunication *));
+    exits = (struct pollfd *) malloc(count * sizeof(struct pollfd));
+    if (children == NULL || exits == NULL) {
+        perror("Device Communication Terminate Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The children get a shorter timeout, they kill their own stragglers before being killed */
+    child_out_message = *out_message;
+    child_out_message.type = MESSAGE_TYPE_TERMINATE;
+    snprintf(child_out_message.message, DEVICE_COMMUNICATION_MESSAGE_LENGTH, "%lu",
+             (timeout > 2 * DEVICE_COMMUNICATION_TERMINATE_MARGIN) ? timeout - DEVICE_COMMUNICATION_TERMINATE_MARGIN
+                                                                   : (timeout / 2 > 0) ? timeout / 2 : 1);
+
+    /* Every Device tears its subtree down at the same time */
+    device_communication_trace_forward();
+    list_for_each(data, devices) {
+        children[i] = data;
+        /* Only a hang up is reported, the descriptor is set once the Device answered TERMINATE */
+        exits[i].fd = -1;
+        exits[i].events = 0;
+        device_communication_write_message_notify(data, &child_out_message);
+        i++;
+    }
+
+    /* Records are collected one Device at a time, the others keep terminating meanwhile */
+    for (i = 0; i < count; ++i) {
+        do {
+            if (!device_communication_wait_message(children[i], deadline)) {
+                device_communication_kill(children[i]);
+                list_remove(devices, children[i]);
+                children[i] = NULL;
+                break;
+            }
+
+            in_message = device_communication_read_message(children[i]);
+            if (records != NULL && in_message.type == MESSAGE_TYPE_TERMINATE && !in_message.flag_skip)
+                list_add_last(records, device_communication_message_copy(&in_message));
+            if (in_message.flag_continue) device_communication_write_message(children[i], &child_out_message);
+        } while (in_message.flag_continue);
+        if (children[i] == NULL) continue;
+
+        device_communication_stats_record(child_out_message.type, stopwatch_elapsed(start), &in_message);
+        if (in_message.type != MESSAGE_TYPE_TERMINATE) continue;
+
+        if (close(children[i]->com_write) == -1) {
+            perror("Error closing pipe in Terminate");
+            exit(EXIT_FAILURE);
+        }
+        exits[i].fd = children[i]->com_read;
+        pending++;
+        done++;
+    }
+
+    /* A Device hangs up its pipe when it exits, all the terminated ones are waited together */
+    while (pending > 0 && (now = stopwatch_now()) < deadline) {
+        ready = poll(exits, count, (int) ((deadline - now + 999999) / 1000000));
+        if (ready == -1 && errno == EINTR) continue;
+        if (ready <= 0) break;
+
+        for (i = 0; i < count; ++i) {
+            if (exits[i].fd == -1 || exits[i].revents == 0) continue;
+
+            waitpid(children[i]->pid, 0, 0);
+            exits[i].fd = -1;
+            pending--;
+            close(children[i]->com_read);
+            list_remove(devices, children[i]);
+        }
+    }
+
+    /* Stragglers are killed */
+    for (i = 0; i < count; ++i) {
+        if (exits[i].fd == -1) continue;
+
+        kill(children[i]->pid, SIGKILL);
+        waitpid(children[i]->pid, 0, 0);
+        close(children[i]->com_read);
+        list_remove(devices, children[i]);
+    }
+
+    free(children);
+    free(exits);
+
+    return done;
+}
+
+unsigned long device_communication_terminate_timeout(const DeviceCommunicationMessage *message) {
+    unsigned long timeout;
+    if (message == NULL) return DEVICE_COMMUNICATION_TERMINATE_TIMEOUT;
+
+    timeout = strtoul(message->message, NULL, 10);
+    return (timeout == 0) ? DEVICE_COMMUNICATION_TERMINATE_TIMEOUT : timeout;
+}
+
 bool device_communication_device_is_directly_connected(const DeviceCommunicationMessage *message) {
     if (message == NULL) return false;
     return message->ctr_hop == 1;
@@ -87,6 +240,7 @@ DeviceCommunicationMessage device_communication_read_message(DeviceCommunication
         }
         default: {
             /* Message was correctly received */
+            device_communication_stats_count(in_message.type, false);
             break;
         }
     }
@@ -98,17 +252,24 @@ DeviceCommunicationMessage device_communication_read_message(DeviceCommunication
 DeviceCommunicationMessage device_communication_write_message_with_ack(DeviceCommunication *device_communication,
                                                                        const DeviceCommunicationMessage *out_message) {
     DeviceCommunicationMessage in_message;
+    Stopwatch start;
     if (device_communication == NULL || out_message == NULL) {
         device_communication_message_modify(&in_message, 0, MESSAGE_TYPE_ERROR,
                                             "Device Communication OR Message has not been initialized");
         return in_message;
     }
 
+    start = stopwatch_now();
+    device_communication_trace_forward();
+
     device_communication_write_message(device_communication, out_message);
 
     device_communication_notify(device_communication->pid);
 
-    return device_communication_read_message(device_communication);
+    in_message = device_communication_read_message(device_communication);
+    device_communication_stats_record(out_message->type, stopwatch_elapsed(start), &in_message);
+
+    return in_message;
 }
 
 DeviceCommunicationMessage device_communication_write_message_with_ack_silent(DeviceCommunication *device_communication,
@@ -129,10 +290,20 @@ void device_communication_write_message(const DeviceCommunication *device_commun
                                         const DeviceCommunicationMessage *out_message) {
     if (device_communication == NULL || out_message == NULL) return;
 
+    device_communication_trace_reply(device_communication->pid);
     if (write(device_communication->com_write, out_message, sizeof(DeviceCommunicationMessage)) == -1) {
         perror("Error Writing Message");
         exit(EXIT_FAILURE);
     }
+    device_communication_stats_count(out_message->type, true);
+}
+
+void device_communication_write_message_notify(const DeviceCommunication *device_communication,
+                                               const DeviceCommunicationMessage *out_message) {
+    if (device_communication == NULL || out_message == NULL) return;
+
+    device_communication_write_message(device_communication, out_message);
+    device_communication_notify(device_communication->pid);
 }
 
 static void device_communication_notify(pid_t pid) {
@@ -144,10 +315,15 @@ void device_communication_message_init(const Device *device, DeviceCommunication
 
     message->type = MESSAGE_TYPE_ERROR;
     message->ctr_hop = 0;
+    message->trace_id = device_communication_trace_current();
     message->id_sender = device->id;
     message->id_device_descriptor = device->device_descriptor->id;
+    message->pid_sender = getpid();
     message->flag_force = false;
     message->flag_continue = false;
+    message->flag_skip = false;
+    message->flag_unchanged = false;
+    message->flag_live = false;
     message->override = false;
     strncpy(message->device_name, device->name, DEVICE_NAME_LENGTH);
 
@@ -195,11 +371,16 @@ DeviceCommunicationMessage *device_communication_message_copy(const DeviceCommun
 
     message_copy->type = message->type;
     message_copy->ctr_hop = message->ctr_hop;
+    message_copy->trace_id = message->trace_id;
     message_copy->id_sender = message->id_sender;
     message_copy->id_recipient = message->id_recipient;
     message_copy->id_device_descriptor = message->id_device_descriptor;
+    message_copy->pid_sender = message->pid_sender;
     message_copy->flag_force = message->flag_force;
     message_copy->flag_continue = message->flag_continue;
+    message_copy->flag_skip = message->flag_skip;
+    message_copy->flag_unchanged = message->flag_unchanged;
+    message_copy->flag_live = message->flag_live;
     message_copy->override = message->override;
     strncpy(message_copy->message, message->message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
     strncpy(message_copy->device_name, message->device_name, DEVICE_NAME_LENGTH);
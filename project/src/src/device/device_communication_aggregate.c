@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "device/device_communication_aggregate.h"
+#include "util/util_converter.h"
+
+/**
+ * Struct Device Communication Aggregate Metric Descriptor, where a metric is found in the info record of a Device
+ */
+typedef struct DeviceCommunicationAggregateMetricDescriptor {
+    size_t id_device_descriptor;
+    size_t field;
+    char name[DEVICE_COMMUNICATION_AGGREGATE_METRIC_NAME_LENGTH];
+} DeviceCommunicationAggregateMetricDescriptor;
+
+/**
+ * Numeric metrics of every Device type, in info record order
+ */
+static const DeviceCommunicationAggregateMetricDescriptor device_communication_aggregate_metric_descriptors[] = {
+        {DEVICE_TYPE_BULB,   1, "active_time"},
+        {DEVICE_TYPE_WINDOW, 1, "open_time"},
+        {DEVICE_TYPE_FRIDGE, 1, "open_time"},
+        {DEVICE_TYPE_FRIDGE, 2, "delay_time"},
+        {DEVICE_TYPE_FRIDGE, 3, "filling"},
+        {DEVICE_TYPE_FRIDGE, 4, "temperature"}
+};
+
+#define DEVICE_COMMUNICATION_AGGREGATE_METRIC_DESCRIPTORS \
+    (sizeof(device_communication_aggregate_metric_descriptors) / sizeof(DeviceCommunicationAggregateMetricDescriptor))
+
+/**
+ * Return the metric descriptor of a Device type
+ * @param id_device_descriptor The Device Descriptor id
+ * @param index The metric index
+ * @return The metric descriptor, NULL if not exists
+ */
+static const DeviceCommunicationAggregateMetricDescriptor *
+device_communication_aggregate_metric_descriptor(size_t id_device_descriptor, size_t index);
+
+/**
+ * Find the aggregate of a group or create it if not exists
+ * @param aggregates The List of aggregates
+ * @param id_device_descriptor The Device Descriptor id
+ * @param state The Device state
+ * @return The aggregate of the group
+ */
+static DeviceCommunicationAggregate *
+device_communication_aggregate_group(List *aggregates, size_t id_device_descriptor, bool state);
+
+/**
+ * Merge an aggregate record into a List of aggregates
+ * @param aggregates The List of aggregates
+ * @param message The aggregate record
+ * @return true if merged, false if the record is not valid
+ */
+static bool device_communication_aggregate_merge_message(List *aggregates, const DeviceCommunicationMessage *message);
+
+/**
+ * Add an info record into a List of aggregates
+ * @param aggregates The List of aggregates
+ * @param message The info record
+ * @return true if added, false if the record is not valid
+ */
+static bool device_communication_aggregate_add_info(List *aggregates, const DeviceCommunicationMessage *message);
+
+static const DeviceCommunicationAggregateMetricDescriptor *
+device_communication_aggregate_metric_descriptor(size_t id_device_descriptor, size_t index) {
+    size_t i;
+
+    for (i = 0; i < DEVICE_COMMUNICATION_AGGREGATE_METRIC_DESCRIPTORS; ++i) {
+        if (device_communication_aggregate_metric_descriptors[i].id_device_descriptor != id_device_descriptor)
+            continue;
+        if (index == 0) return &device_communication_aggregate_metric_descriptors[i];
+        index--;
+    }
+
+    return NULL;
+}
+
+size_t device_communication_aggregate_metrics(size_t id_device_descriptor) {
+    size_t metrics = 0;
+
+    while (device_communication_aggregate_metric_descriptor(id_device_descriptor, metrics) != NULL) metrics++;
+
+    return metrics;
+}
+
+const char *device_communication_aggregate_metric_name(size_t id_device_descriptor, size_t index) {
+    const DeviceCommunicationAggregateMetricDescriptor *metric_descriptor;
+
+    metric_descriptor = device_communication_aggregate_metric_descriptor(id_device_descriptor, index);
+    return (metric_descriptor == NULL) ? NULL : metric_descriptor->name;
+}
+
+static DeviceCommunicationAggregate *
+device_communication_aggregate_group(List *aggregates, size_t id_device_descriptor, bool state) {
+    DeviceCommunicationAggregate *data;
+    size_t index = 0;
+
+    /* Groups are kept ordered by Device type and state */
+    list_for_each(data, aggregates) {
+        if (data->id_device_descriptor == id_device_descriptor && data->state == state) return data;
+        if (data->id_device_descriptor > id_device_descriptor ||
+            (data->id_device_descriptor == id_device_descriptor && data->state > state))
+            break;
+        index++;
+    }
+
+    data = (DeviceCommunicationAggregate *) malloc(sizeof(DeviceCommunicationAggregate));
+    if (data == NULL) {
+        perror("Device Communication Aggregate Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    data->id_device_descriptor = id_device_descriptor;
+    data->state = state;
+    data->count = 0;
+    data->metrics = device_communication_aggregate_metrics(id_device_descriptor);
+    if (data->metrics > DEVICE_COMMUNICATION_AGGREGATE_METRICS_MAX)
+        data->metrics = DEVICE_COMMUNICATION_AGGREGATE_METRICS_MAX;
+    list_add(aggregates, index, data);
+
+    return data;
+}
+
+void device_communication_aggregate_add(List *aggregates, size_t id_device_descriptor, bool state,
+                                        const double *values) {
+    DeviceCommunicationAggregate *aggregate;
+    size_t i;
+    if (aggregates == NULL) return;
+
+    aggregate = device_communication_aggregate_group(aggregates, id_device_descriptor, state);
+
+    for (i = 0; i < aggregate->metrics; ++i) {
+        double value = (values == NULL) ? 0 : values[i];
+
+        if (aggregate->count == 0 || value < aggregate->metric[i].min) aggregate->metric[i].min = value;
+        if (aggregate->count == 0 || value > aggregate->metric[i].max) aggregate->metric[i].max = value;
+        aggregate->metric[i].sum = (aggregate->count == 0) ? value : aggregate->metric[i].sum + value;
+    }
+    aggregate->count++;
+}
+
+static bool device_communication_aggregate_add_info(List *aggregates, const DeviceCommunicationMessage *message) {
+    const DeviceCommunicationAggregateMetricDescriptor *metric_descriptor;
+    double values[DEVICE_COMMUNICATION_AGGREGATE_METRICS_MAX];
+    ConverterResult result;
+    char **fields;
+    size_t size;
+    size_t i;
+
+    if ((fields = device_communication_split_message_fields(message->message)) == NULL) return false;
+    for (size = 0; fields[size] != NULL; ++size);
+
+    for (i = 0; i < DEVICE_COMMUNICATION_AGGREGATE_METRICS_MAX; ++i) {
+        values[i] = 0;
+        metric_descriptor = device_communication_aggregate_metric_descriptor(message->id_device_descriptor, i);
+        if (metric_descriptor == NULL || metric_descriptor->field >= size) continue;
+
+        result = converter_string_to_double(fields[metric_descriptor->field]);
+        if (!result.error) values[i] = result.data.Double;
+    }
+
+    device_communication_aggregate_add(aggregates, message->id_device_descriptor,
+                                       converter_char_to_bool(fields[0][0]).data.Bool, values);
+
+    device_communication_free_message_fields(fields);
+    return true;
+}
+
+static bool device_communication_aggregate_merge_message(List *aggregates, const DeviceCommunicationMessage *message) {
+    DeviceCommunicationAggregate *aggregate;
+    ConverterResult id_device_descriptor;
+    ConverterResult count;
+    DeviceCommunicationAggregateMetric metric;
+    char **fields;
+    size_t i;
+
+    if ((fields = device_communication_split_message_fields(message->message)) == NULL) return false;
+
+    if (fields[0] == NULL || fields[1] == NULL || fields[2] == NULL ||
+        (id_device_descriptor = converter_string_to_long(fields[0])).error ||
+        (count = converter_string_to_long(fields[2])).error || count.data.Long <= 0) {
+        device_communication_free_message_fields(fields);
+        return false;
+    }
+
+    aggregate = device_communication_aggregate_group(aggregates, (size_t) id_device_descriptor.data.Long,
+                                                     converter_char_to_bool(fields[1][0]).data.Bool);
+
+    for (i = 0; i < aggregate->metrics && fields[3 + i] != NULL; ++i) {
+        if (sscanf(fields[3 + i], "%lf %lf %lf", &metric.sum, &metric.min, &metric.max) != 3) continue;
+
+        if (aggregate->count == 0 || metric.min < aggregate->metric[i].min) aggregate->metric[i].min = metric.min;
+        if (aggregate->count == 0 || metric.max > aggregate->metric[i].max) aggregate->metric[i].max = metric.max;
+        aggregate->metric[i].sum = (aggregate->count == 0) ? metric.sum : aggregate->metric[i].sum + metric.sum;
+    }
+    aggregate->count += (size_t) count.data.Long;
+
+    device_communication_free_message_fields(fields);
+    return true;
+}
+
+bool device_communication_aggregate_add_message(List *aggregates, const DeviceCommunicationFilter *filter,
+                                                const DeviceCommunicationMessage *message) {
+    if (aggregates == NULL || message == NULL || message->flag_skip) return false;
+
+    switch (message->type) {
+        case MESSAGE_TYPE_INFO: {
+            if (!device_communication_filter_match_message(filter, message)) return false;
+            return device_communication_aggregate_add_info(aggregates, message);
+        }
+        case MESSAGE_TYPE_AGGREGATE: {
+            return device_communication_aggregate_merge_message(aggregates, message);
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+void device_communication_aggregate_to_message(const DeviceCommunicationAggregate *aggregate, char *message,
+                                               size_t length) {
+    size_t used;
+    size_t i;
+    if (message == NULL || length == 0) return;
+
+    message[0] = '\0';
+    if (aggregate == NULL) return;
+
+    used = snprintf(message, length, "%ld\n%d\n%ld\n", aggregate->id_device_descriptor, aggregate->state,
+                    aggregate->count);
+    for (i = 0; i < aggregate->metrics && used < length; ++i) {
+        used += snprintf(message + used, length - used, "%.10g %.10g %.10g\n", aggregate->metric[i].sum,
+                         aggregate->metric[i].min, aggregate->metric[i].max);
+    }
+}
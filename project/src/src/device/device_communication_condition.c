@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include "device/device_communication.h"
+#include "device/device_communication_condition.h"
+#include "util/util_converter.h"
+
+void device_communication_condition_init(DeviceCommunicationCondition *condition) {
+    if (condition == NULL) return;
+
+    condition->state = DEVICE_COMMUNICATION_CONDITION_ANY;
+    condition->version = DEVICE_COMMUNICATION_CONDITION_ANY;
+}
+
+bool device_communication_condition_is_empty(const DeviceCommunicationCondition *condition) {
+    if (condition == NULL) return true;
+
+    return condition->state == DEVICE_COMMUNICATION_CONDITION_ANY &&
+           condition->version == DEVICE_COMMUNICATION_CONDITION_ANY;
+}
+
+bool device_communication_condition_add_predicate(DeviceCommunicationCondition *condition, const char *predicate) {
+    ConverterResult result;
+    const char *value;
+    if (condition == NULL || predicate == NULL) return false;
+
+    if (strncmp(predicate, DEVICE_COMMUNICATION_CONDITION_KEY_STATE,
+                strlen(DEVICE_COMMUNICATION_CONDITION_KEY_STATE)) == 0) {
+        value = predicate + strlen(DEVICE_COMMUNICATION_CONDITION_KEY_STATE);
+        if (strcmp(value, "on") == 0 || strcmp(value, "1") == 0) condition->state = true;
+        else if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0) condition->state = false;
+        else return false;
+        return true;
+    }
+    if (strncmp(predicate, DEVICE_COMMUNICATION_CONDITION_KEY_VERSION,
+                strlen(DEVICE_COMMUNICATION_CONDITION_KEY_VERSION)) == 0) {
+        value = predicate + strlen(DEVICE_COMMUNICATION_CONDITION_KEY_VERSION);
+        result = converter_string_to_long(value);
+        if (result.error || result.data.Long < 0) return false;
+        condition->version = result.data.Long;
+        return true;
+    }
+
+    return false;
+}
+
+bool device_communication_condition_to_message(const DeviceCommunicationCondition *condition,
+                                               const char *switch_label, const char *switch_pos, char *message,
+                                               size_t length) {
+    int used;
+    if (switch_label == NULL || switch_pos == NULL || message == NULL || length == 0) return false;
+
+    used = snprintf(message, length, "%s\n%s\n", switch_label, switch_pos);
+    if (used < 0 || (size_t) used >= length) return false;
+
+    if (condition != NULL && condition->state != DEVICE_COMMUNICATION_CONDITION_ANY) {
+        used += snprintf(message + used, length - used, "%s%s\n", DEVICE_COMMUNICATION_CONDITION_KEY_STATE,
+                         (condition->state) ? "on" : "off");
+        if ((size_t) used >= length) return false;
+    }
+    if (condition != NULL && condition->version != DEVICE_COMMUNICATION_CONDITION_ANY) {
+        used += snprintf(message + used, length - used, "%s%ld\n", DEVICE_COMMUNICATION_CONDITION_KEY_VERSION,
+                         condition->version);
+        if ((size_t) used >= length) return false;
+    }
+
+    return true;
+}
+
+bool device_communication_condition_from_message(DeviceCommunicationCondition *condition, char *message) {
+    char *predicates;
+    char **fields;
+    size_t i;
+    if (condition == NULL || message == NULL) return false;
+
+    device_communication_condition_init(condition);
+
+    /* Skip the label and the position */
+    if ((predicates = strchr(message, '\n')) == NULL || (predicates = strchr(predicates + 1, '\n')) == NULL)
+        return false;
+    if (*(++predicates) == '\0') return false;
+
+    fields = device_communication_split_message_fields(predicates);
+    for (i = 0; fields != NULL && fields[i] != NULL; ++i) {
+        device_communication_condition_add_predicate(condition, fields[i]);
+    }
+    device_communication_free_message_fields(fields);
+
+    /* The Device handlers only know the plain switch */
+    *predicates = '\0';
+
+    return true;
+}
+
+bool device_communication_condition_holds(const DeviceCommunicationCondition *condition, bool state,
+                                          size_t version) {
+    if (condition == NULL) return true;
+
+    if (condition->state != DEVICE_COMMUNICATION_CONDITION_ANY && condition->state != state) return false;
+    if (condition->version != DEVICE_COMMUNICATION_CONDITION_ANY && (size_t) condition->version != version)
+        return false;
+
+    return true;
+}
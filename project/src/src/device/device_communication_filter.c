@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <string.h>
+#include <fnmatch.h>
+#include "device/device_communication_filter.h"
+#include "device/device_communication_subtree.h"
+#include "util/util_converter.h"
+
+/**
+ * Check if a predicate has the given key and return its value
+ * @param predicate The predicate
+ * @param key The key
+ * @param op The operator following the key
+ * @return The value, NULL if the predicate has a different key or operator
+ */
+static const char *device_communication_filter_value(const char *predicate, const char *key, char op);
+
+void device_communication_filter_init(DeviceCommunicationFilter *filter) {
+    if (filter == NULL) return;
+
+    filter->types = 0;
+    filter->state = DEVICE_COMMUNICATION_FILTER_ANY;
+    filter->under = DEVICE_COMMUNICATION_FILTER_UNDER_ANY;
+    filter->name_glob = false;
+    filter->name[0] = '\0';
+    filter->since = 0;
+    filter->epoch = 0;
+}
+
+bool device_communication_filter_is_empty(const DeviceCommunicationFilter *filter) {
+    if (filter == NULL) return true;
+
+    return filter->types == 0 && filter->state == DEVICE_COMMUNICATION_FILTER_ANY &&
+           filter->under == DEVICE_COMMUNICATION_FILTER_UNDER_ANY && filter->name[0] == '\0';
+}
+
+bool device_communication_filter_is_delta(const DeviceCommunicationFilter *filter) {
+    if (filter == NULL) return false;
+
+    return filter->epoch != 0;
+}
+
+static const char *device_communication_filter_value(const char *predicate, const char *key, char op) {
+    size_t key_length = strlen(key);
+
+    if (strncmp(predicate, key, key_length) != 0 || predicate[key_length] != op) return NULL;
+    return predicate + key_length + 1;
+}
+
+bool device_communication_filter_add_predicate(DeviceCommunicationFilter *filter, const char *predicate) {
+    const char *value;
+    ConverterResult result;
+    if (filter == NULL || predicate == NULL) return false;
+
+    if ((value = device_communication_filter_value(predicate, DEVICE_COMMUNICATION_FILTER_KEY_TYPE,
+                                                   DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL) {
+        char types[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+        char *token;
+        const DeviceDescriptor *device_descriptor;
+
+        strncpy(types, value, DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1);
+        types[DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1] = '\0';
+        for (token = strtok(types, DEVICE_COMMUNICATION_FILTER_TYPE_DELIMITER); token != NULL;
+             token = strtok(NULL, DEVICE_COMMUNICATION_FILTER_TYPE_DELIMITER)) {
+            if ((device_descriptor = device_is_supported_by_name(token)) == NULL) return false;
+            filter->types |= DEVICE_COMMUNICATION_FILTER_TYPE(device_descriptor->id);
+        }
+        return filter->types != 0;
+    }
+    if ((value = device_communication_filter_value(predicate, DEVICE_COMMUNICATION_FILTER_KEY_TYPES,
+                                                   DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL) {
+        result = converter_string_to_long(value);
+        if (result.error || result.data.Long < 0) return false;
+        filter->types = (unsigned int) result.data.Long;
+        return true;
+    }
+    if ((value = device_communication_filter_value(predicate, DEVICE_COMMUNICATION_FILTER_KEY_STATE,
+                                                   DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL) {
+        if (strcmp(value, "on") == 0 || strcmp(value, "1") == 0) filter->state = true;
+        else if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0) filter->state = false;
+        else return false;
+        return true;
+    }
+    if ((value = device_communication_filter_value(predicate, DEVICE_COMMUNICATION_FILTER_KEY_UNDER,
+                                                   DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL) {
+        result = converter_string_to_long(value);
+        if (result.error || result.data.Long < 0) return false;
+        filter->under = (size_t) result.data.Long;
+        return true;
+    }
+    if ((value = device_communication_filter_value(predicate, DEVICE_COMMUNICATION_FILTER_KEY_NAME,
+                                                   DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL ||
+        (value = device_communication_filter_value(predicate, DEVICE_COMMUNICATION_FILTER_KEY_NAME,
+                                                   DEVICE_COMMUNICATION_FILTER_GLOB)) != NULL) {
+        if (strlen(value) == 0 || strlen(value) >= DEVICE_NAME_LENGTH) return false;
+        filter->name_glob = predicate[strlen(DEVICE_COMMUNICATION_FILTER_KEY_NAME)] == DEVICE_COMMUNICATION_FILTER_GLOB ||
+                            strpbrk(value, DEVICE_COMMUNICATION_FILTER_WILDCARDS) != NULL;
+        strncpy(filter->name, value, DEVICE_NAME_LENGTH);
+        return true;
+    }
+
+    return false;
+}
+
+void device_communication_filter_to_message(const DeviceCommunicationFilter *filter, char *message, size_t length) {
+    size_t used = 0;
+    if (message == NULL || length == 0) return;
+
+    message[0] = '\0';
+    if (filter == NULL) return;
+
+    if (filter->types != 0)
+        used += snprintf(message + used, length - used, "%s%c%u\n", DEVICE_COMMUNICATION_FILTER_KEY_TYPES,
+                         DEVICE_COMMUNICATION_FILTER_EQUALS, filter->types);
+    if (filter->state != DEVICE_COMMUNICATION_FILTER_ANY && used < length)
+        used += snprintf(message + used, length - used, "%s%c%d\n", DEVICE_COMMUNICATION_FILTER_KEY_STATE,
+                         DEVICE_COMMUNICATION_FILTER_EQUALS, filter->state);
+    if (filter->under != DEVICE_COMMUNICATION_FILTER_UNDER_ANY && used < length)
+        used += snprintf(message + used, length - used, "%s%c%lu\n", DEVICE_COMMUNICATION_FILTER_KEY_UNDER,
+                         DEVICE_COMMUNICATION_FILTER_EQUALS, filter->under);
+    if (filter->name[0] != '\0' && used < length)
+        used += snprintf(message + used, length - used, "%s%c%s\n", DEVICE_COMMUNICATION_FILTER_KEY_NAME,
+                         (filter->name_glob) ? DEVICE_COMMUNICATION_FILTER_GLOB : DEVICE_COMMUNICATION_FILTER_EQUALS,
+                         filter->name);
+    if (filter->epoch != 0 && used < length)
+        snprintf(message + used, length - used, "%s%c%lu\n%s%c%lu\n", DEVICE_COMMUNICATION_FILTER_KEY_SINCE,
+                 DEVICE_COMMUNICATION_FILTER_EQUALS, filter->since, DEVICE_COMMUNICATION_FILTER_KEY_EPOCH,
+                 DEVICE_COMMUNICATION_FILTER_EQUALS, filter->epoch);
+}
+
+void device_communication_filter_from_message(DeviceCommunicationFilter *filter, const char *message) {
+    const char *value;
+    ConverterResult result;
+    char **fields;
+    size_t i;
+
+    device_communication_filter_init(filter);
+    if ((fields = device_communication_split_message_fields(message)) == NULL) return;
+
+    for (i = 0; fields[i] != NULL; ++i) {
+        if ((value = device_communication_filter_value(fields[i], DEVICE_COMMUNICATION_FILTER_KEY_SINCE,
+                                                       DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL) {
+            if (!(result = converter_string_to_long(value)).error && result.data.Long >= 0)
+                filter->since = (size_t) result.data.Long;
+        } else if ((value = device_communication_filter_value(fields[i], DEVICE_COMMUNICATION_FILTER_KEY_EPOCH,
+                                                              DEVICE_COMMUNICATION_FILTER_EQUALS)) != NULL) {
+            if (!(result = converter_string_to_long(value)).error && result.data.Long >= 0)
+                filter->epoch = (size_t) result.data.Long;
+        } else {
+            device_communication_filter_add_predicate(filter, fields[i]);
+        }
+    }
+
+    device_communication_free_message_fields(fields);
+}
+
+bool device_communication_filter_match(const DeviceCommunicationFilter *filter, size_t id,
+                                       size_t id_device_descriptor, const char *device_name, bool state) {
+    if (filter == NULL) return true;
+
+    if (filter->under != DEVICE_COMMUNICATION_FILTER_UNDER_ANY && id == filter->under) return false;
+    if (filter->types != 0 && !(filter->types & DEVICE_COMMUNICATION_FILTER_TYPE(id_device_descriptor))) return false;
+    if (filter->state != DEVICE_COMMUNICATION_FILTER_ANY && filter->state != state) return false;
+    if (filter->name[0] != '\0') {
+        if (device_name == NULL) return false;
+        if (filter->name_glob && fnmatch(filter->name, device_name, 0) != 0) return false;
+        if (!filter->name_glob && strcmp(filter->name, device_name) != 0) return false;
+    }
+
+    return true;
+}
+
+bool device_communication_filter_match_message(const DeviceCommunicationFilter *filter,
+                                               const DeviceCommunicationMessage *message) {
+    if (message == NULL) return false;
+
+    return device_communication_filter_match(filter, message->id_sender, message->id_device_descriptor,
+                                             message->device_name,
+                                             converter_char_to_bool(message->message[0]).data.Bool);
+}
+
+bool device_communication_filter_may_match(const DeviceCommunicationFilter *filter, unsigned int types) {
+    if (filter == NULL || filter->types == 0 || types == 0) return true;
+
+    return (filter->types & types) != 0;
+}
+
+bool device_communication_filter_select(const DeviceCommunicationFilter *filter, size_t id,
+                                        size_t id_device_descriptor, const char *device_name, bool state) {
+    if (filter != NULL && filter->under != DEVICE_COMMUNICATION_FILTER_UNDER_ANY) return false;
+    /* Switching the Controller switches every Device, it must be asked for by type */
+    if (id_device_descriptor == DEVICE_TYPE_CONTROLLER &&
+        (filter == NULL || !(filter->types & DEVICE_COMMUNICATION_FILTER_TYPE(DEVICE_TYPE_CONTROLLER))))
+        return false;
+
+    return device_communication_filter_match(filter, id, id_device_descriptor, device_name, state);
+}
+
+bool device_communication_filter_to_selector(const DeviceCommunicationFilter *filter, const char *switch_label,
+                                             const char *switch_pos, char *message, size_t length) {
+    size_t used;
+    if (switch_label == NULL || switch_pos == NULL || message == NULL) return false;
+
+    used = snprintf(message, length, "%s\n%s\n", switch_label, switch_pos);
+    if (used >= length) return false;
+
+    device_communication_filter_to_message(filter, message + used, length - used);
+    return strlen(message) < length - 1;
+}
+
+bool device_communication_filter_from_selector(DeviceCommunicationFilter *filter, const char *message,
+                                               char *switch_message, size_t length) {
+    char **fields;
+    bool decoded = false;
+    size_t i;
+
+    device_communication_filter_init(filter);
+    if (switch_message == NULL || length == 0) return false;
+    if ((fields = device_communication_split_message_fields(message)) == NULL) return false;
+
+    if (fields[0] != NULL && fields[1] != NULL) {
+        decoded = (size_t) snprintf(switch_message, length, "%s\n%s\n", fields[0], fields[1]) < length;
+        for (i = 2; fields[i] != NULL; ++i) {
+            device_communication_filter_add_predicate(filter, fields[i]);
+        }
+    }
+
+    device_communication_free_message_fields(fields);
+    return decoded;
+}
+
+void device_communication_filter_track_spawn(DeviceCommunication *device_communication,
+                                             const DeviceCommunicationMessage *spawn_message) {
+    char **fields;
+    ConverterResult id_device_descriptor;
+    DeviceCommunicationSubtree subtree;
+    size_t i;
+    if (device_communication == NULL || spawn_message == NULL) return;
+
+    if (spawn_message->type == MESSAGE_TYPE_SPAWN_SUBTREE) {
+        if (!device_communication_subtree_from_message(&subtree, spawn_message->message)) return;
+
+        for (i = 0; i < subtree.count; ++i) {
+            device_communication->types |= DEVICE_COMMUNICATION_FILTER_TYPE(subtree.nodes[i].id_device_descriptor);
+        }
+        return;
+    }
+
+    if ((fields = device_communication_split_message_fields(spawn_message->message)) == NULL) return;
+
+    if (fields[0] != NULL && fields[1] != NULL &&
+        !(id_device_descriptor = converter_string_to_long(fields[1])).error) {
+        device_communication->types |= DEVICE_COMMUNICATION_FILTER_TYPE(id_device_descriptor.data.Long);
+    }
+
+    device_communication_free_message_fields(fields);
+}
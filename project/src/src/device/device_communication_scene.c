@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "device/device_communication_scene.h"
+
+/**
+ * Return the index of an action, adding it if missing
+ * @param scene The scene
+ * @param label The switch label
+ * @param pos The switch position
+ * @return The index of the action, DEVICE_COMMUNICATION_SCENE_ACTIONS if the scene has no room for it
+ */
+static size_t device_communication_scene_action(DeviceCommunicationScene *scene, const char *label, const char *pos);
+
+/**
+ * Decode the comma separated ids of an action
+ * @param scene The scene
+ * @param action The index of the action
+ * @param ids The ids
+ * @return true if decoded, false if not valid
+ */
+static bool device_communication_scene_ids(DeviceCommunicationScene *scene, size_t action, const char *ids);
+
+void device_communication_scene_init(DeviceCommunicationScene *scene) {
+    if (scene == NULL) return;
+
+    scene->targets_count = 0;
+    scene->actions_count = 0;
+}
+
+bool device_communication_scene_is_empty(const DeviceCommunicationScene *scene) {
+    return scene == NULL || scene->targets_count == 0;
+}
+
+static size_t device_communication_scene_action(DeviceCommunicationScene *scene, const char *label, const char *pos) {
+    size_t i;
+
+    for (i = 0; i < scene->actions_count; ++i) {
+        if (strcmp(scene->actions[i].label, label) == 0 && strcmp(scene->actions[i].pos, pos) == 0) return i;
+    }
+    if (scene->actions_count == DEVICE_COMMUNICATION_SCENE_ACTIONS) return DEVICE_COMMUNICATION_SCENE_ACTIONS;
+
+    strcpy(scene->actions[scene->actions_count].label, label);
+    strcpy(scene->actions[scene->actions_count].pos, pos);
+    return scene->actions_count++;
+}
+
+bool device_communication_scene_add(DeviceCommunicationScene *scene, size_t id, const char *label, const char *pos) {
+    size_t action;
+    if (scene == NULL || label == NULL || pos == NULL) return false;
+    if (strlen(label) == 0 || strlen(label) >= DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH ||
+        strlen(pos) == 0 || strlen(pos) >= DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH)
+        return false;
+    if (scene->targets_count == DEVICE_COMMUNICATION_SCENE_TARGETS) return false;
+    if ((action = device_communication_scene_action(scene, label, pos)) == DEVICE_COMMUNICATION_SCENE_ACTIONS)
+        return false;
+
+    scene->targets[scene->targets_count].id = id;
+    scene->targets[scene->targets_count].action = action;
+    scene->targets_count++;
+
+    return true;
+}
+
+const DeviceCommunicationSceneTarget *device_communication_scene_find(const DeviceCommunicationScene *scene, size_t id) {
+    size_t i;
+    if (scene == NULL) return NULL;
+
+    for (i = 0; i < scene->targets_count; ++i) {
+        if (scene->targets[i].id == id) return &scene->targets[i];
+    }
+
+    return NULL;
+}
+
+bool device_communication_scene_remove(DeviceCommunicationScene *scene, size_t id) {
+    size_t i;
+    size_t kept = 0;
+    if (scene == NULL) return false;
+
+    /* Keep the order, targets of the same action stay together */
+    for (i = 0; i < scene->targets_count; ++i) {
+        if (scene->targets[i].id != id) scene->targets[kept++] = scene->targets[i];
+    }
+    if (kept == scene->targets_count) return false;
+
+    scene->targets_count = kept;
+    return true;
+}
+
+size_t device_communication_scene_to_message(const DeviceCommunicationScene *scene, size_t from, char *message,
+                                             size_t length) {
+    const DeviceCommunicationSceneTarget *target;
+    char piece[2 * DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH + 32];
+    size_t position = 0;
+    size_t piece_length;
+    size_t i;
+    if (scene == NULL || message == NULL || length == 0) return from;
+
+    message[0] = '\0';
+    for (i = from; i < scene->targets_count; ++i) {
+        target = &scene->targets[i];
+
+        if (i == from || target->action != scene->targets[i - 1].action) {
+            snprintf(piece, sizeof(piece), "%s%s\n%s\n%lu", (i == from) ? "" : "\n",
+                     scene->actions[target->action].label, scene->actions[target->action].pos, target->id);
+        } else {
+            snprintf(piece, sizeof(piece), DEVICE_COMMUNICATION_SCENE_ID_DELIMITER "%lu", target->id);
+        }
+
+        /* Room for the last new line and the terminator */
+        piece_length = strlen(piece);
+        if (position + piece_length + 2 > length) break;
+        memcpy(message + position, piece, piece_length);
+        position += piece_length;
+    }
+
+    if (position > 0) message[position++] = '\n';
+    message[position] = '\0';
+
+    return i;
+}
+
+static bool device_communication_scene_ids(DeviceCommunicationScene *scene, size_t action, const char *ids) {
+    const char *cursor = ids;
+    char *end;
+    unsigned long id;
+
+    while (*cursor != '\0') {
+        id = strtoul(cursor, &end, 10);
+        if (end == cursor || scene->targets_count == DEVICE_COMMUNICATION_SCENE_TARGETS) return false;
+
+        scene->targets[scene->targets_count].id = id;
+        scene->targets[scene->targets_count].action = action;
+        scene->targets_count++;
+
+        if (*end == DEVICE_COMMUNICATION_SCENE_ID_DELIMITER[0]) end++;
+        else if (*end != '\0') return false;
+        cursor = end;
+    }
+
+    return true;
+}
+
+bool device_communication_scene_from_message(DeviceCommunicationScene *scene, const char *message) {
+    char buffer[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    char *lines[3];
+    char *token;
+    size_t line = 0;
+    size_t action;
+    if (scene == NULL || message == NULL) return false;
+
+    device_communication_scene_init(scene);
+    strncpy(buffer, message, DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1);
+    buffer[DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1] = '\0';
+
+    /* Label, position and ids, repeated */
+    for (token = strtok(buffer, DEVICE_COMMUNICATION_MESSAGE_FIELDS_DELIMITER); token != NULL;
+         token = strtok(NULL, DEVICE_COMMUNICATION_MESSAGE_FIELDS_DELIMITER)) {
+        lines[line++] = token;
+        if (line < 3) continue;
+
+        line = 0;
+        if (strlen(lines[0]) >= DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH ||
+            strlen(lines[1]) >= DEVICE_COMMUNICATION_SCENE_FIELD_LENGTH)
+            return false;
+        if ((action = device_communication_scene_action(scene, lines[0], lines[1])) ==
+            DEVICE_COMMUNICATION_SCENE_ACTIONS)
+            return false;
+        if (!device_communication_scene_ids(scene, action, lines[2])) return false;
+    }
+
+    return line == 0;
+}
+
+void device_communication_scene_to_switch(const DeviceCommunicationScene *scene,
+                                          const DeviceCommunicationSceneTarget *target, char *message, size_t length) {
+    if (scene == NULL || target == NULL || message == NULL || length == 0) return;
+
+    snprintf(message, length, "%s\n%s\n", scene->actions[target->action].label, scene->actions[target->action].pos);
+}
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "device/device_communication_stats.h"
+#include "util/util_converter.h"
+
+#define DEVICE_COMMUNICATION_STATS_ERROR "ERROR"
+/* Type, errors, max and sum come before the buckets */
+#define DEVICE_COMMUNICATION_STATS_MESSAGE_HEADER 4
+
+/**
+ * Struct Device Communication Stats Type Name, the name of a message type
+ */
+typedef struct DeviceCommunicationStatsTypeName {
+    size_t type;
+    char name[DEVICE_COMMUNICATION_STATS_TYPE_NAME_LENGTH];
+} DeviceCommunicationStatsTypeName;
+
+/**
+ * Names of the message types
+ */
+static const DeviceCommunicationStatsTypeName device_communication_stats_type_names[] = {
+        {MESSAGE_TYPE_NO_MESSAGE,              "NO_MESSAGE"},
+        {MESSAGE_TYPE_ERROR,                   "ERROR"},
+        {MESSAGE_TYPE_TERMINATE,               "TERMINATE"},
+        {MESSAGE_TYPE_TERMINATE_CONTROLLER,    "TERMINATE_CONTROLLER"},
+        {MESSAGE_TYPE_INFO,                    "INFO"},
+        {MESSAGE_TYPE_SWITCH,                  "SWITCH"},
+        {MESSAGE_TYPE_SPAWN_DEVICE,            "SPAWN_DEVICE"},
+        {MESSAGE_TYPE_SET_INIT_VALUES,         "SET_INIT_VALUES"},
+        {MESSAGE_TYPE_LOCK,                    "LOCK"},
+        {MESSAGE_TYPE_UNLOCK,                  "UNLOCK"},
+        {MESSAGE_TYPE_UNLOCK_AND_TERMINATE,    "UNLOCK_AND_TERMINATE"},
+        {MESSAGE_TYPE_AGGREGATE,               "AGGREGATE"},
+        {MESSAGE_TYPE_STATS,                   "STATS"},
+        {MESSAGE_TYPE_TRACE,                   "TRACE"},
+        {MESSAGE_TYPE_SWITCH_MULTI,            "SWITCH_MULTI"},
+        {MESSAGE_TYPE_SWITCH_SELECT,           "SWITCH_SELECT"},
+        {MESSAGE_TYPE_PREPARE,                 "PREPARE"},
+        {MESSAGE_TYPE_COMMIT,                  "COMMIT"},
+        {MESSAGE_TYPE_ABORT,                   "ABORT"},
+        {MESSAGE_TYPE_SPAWN_SUBTREE,           "SPAWN_SUBTREE"},
+        {MESSAGE_TYPE_SYSTEM_STATUS,           "SYSTEM_STATUS"},
+        {MESSAGE_TYPE_UNKNOWN,                 "UNKNOWN"},
+        {MESSAGE_TYPE_GET_PID,                 "GET_PID"},
+        {MESSAGE_TYPE_I_AM_ALIVE,              "I_AM_ALIVE"},
+        {MESSAGE_TYPE_RECIPIENT_ID_MISLEADING, "RECIPIENT_ID_MISLEADING"}
+};
+
+#define DEVICE_COMMUNICATION_STATS_TYPE_NAMES \
+    (sizeof(device_communication_stats_type_names) / sizeof(DeviceCommunicationStatsTypeName))
+
+/**
+ * The statistics of this process
+ */
+static DeviceCommunicationStats device_communication_stats_process;
+
+/**
+ * The message counters of this process
+ */
+static DeviceCommunicationStatsCounters device_communication_stats_process_counters;
+
+/**
+ * Return the bucket of a latency
+ * @param value The latency in nanoseconds
+ * @return The bucket
+ */
+static size_t device_communication_stats_bucket(Stopwatch value);
+
+/**
+ * Return the greatest latency of a bucket
+ * @param bucket The bucket
+ * @return The latency in nanoseconds
+ */
+static Stopwatch device_communication_stats_bucket_upper(size_t bucket);
+
+DeviceCommunicationStats *new_device_communication_stats(void) {
+    DeviceCommunicationStats *stats = (DeviceCommunicationStats *) calloc(1, sizeof(DeviceCommunicationStats));
+    if (stats == NULL) {
+        perror("Device Communication Stats Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    return stats;
+}
+
+const DeviceCommunicationStats *device_communication_stats(void) {
+    return &device_communication_stats_process;
+}
+
+size_t device_communication_stats_index(size_t type) {
+    if (type < DEVICE_COMMUNICATION_STATS_TYPES - 8) return type;
+    if (type >= MESSAGE_TYPE_SYSTEM_STATUS && type < MESSAGE_TYPE_SYSTEM_STATUS + 8)
+        return DEVICE_COMMUNICATION_STATS_TYPES - 8 + type - MESSAGE_TYPE_SYSTEM_STATUS;
+
+    return DEVICE_COMMUNICATION_STATS_TYPES;
+}
+
+size_t device_communication_stats_type(size_t index) {
+    if (index < DEVICE_COMMUNICATION_STATS_TYPES - 8) return index;
+
+    return MESSAGE_TYPE_SYSTEM_STATUS + index - (DEVICE_COMMUNICATION_STATS_TYPES - 8);
+}
+
+const char *device_communication_stats_type_name(size_t type) {
+    size_t i;
+
+    for (i = 0; i < DEVICE_COMMUNICATION_STATS_TYPE_NAMES; ++i) {
+        if (device_communication_stats_type_names[i].type == type) return device_communication_stats_type_names[i].name;
+    }
+
+    return NULL;
+}
+
+static size_t device_communication_stats_bucket(Stopwatch value) {
+    size_t magnitude;
+    if (value < DEVICE_COMMUNICATION_STATS_SUB_BUCKETS) return (size_t) value;
+
+    /* Position of the highest bit, the sub bucket is given by the bits that follow it */
+    magnitude = (size_t) (63 - __builtin_clzll(value)) - DEVICE_COMMUNICATION_STATS_SUB_BUCKET_BITS + 1;
+    if (magnitude >= DEVICE_COMMUNICATION_STATS_MAGNITUDES) return DEVICE_COMMUNICATION_STATS_BUCKETS - 1;
+
+    return magnitude * DEVICE_COMMUNICATION_STATS_SUB_BUCKETS +
+           (size_t) ((value >> (magnitude - 1)) & (DEVICE_COMMUNICATION_STATS_SUB_BUCKETS - 1));
+}
+
+static Stopwatch device_communication_stats_bucket_upper(size_t bucket) {
+    size_t magnitude = bucket / DEVICE_COMMUNICATION_STATS_SUB_BUCKETS;
+    size_t sub_bucket = bucket % DEVICE_COMMUNICATION_STATS_SUB_BUCKETS;
+    if (magnitude == 0) return sub_bucket;
+
+    return ((Stopwatch) (DEVICE_COMMUNICATION_STATS_SUB_BUCKETS + sub_bucket + 1) << (magnitude - 1)) - 1;
+}
+
+void device_communication_stats_record(size_t type, Stopwatch elapsed, const DeviceCommunicationMessage *ack) {
+    DeviceCommunicationStatsHistogram *histogram;
+    size_t index = device_communication_stats_index(type);
+    if (index >= DEVICE_COMMUNICATION_STATS_TYPES) return;
+
+    histogram = &device_communication_stats_process.histogram[index];
+    histogram->count++;
+    histogram->bucket[device_communication_stats_bucket(elapsed)]++;
+    if (elapsed > histogram->max) histogram->max = elapsed;
+    histogram->sum += elapsed;
+    if (ack != NULL && (ack->type == MESSAGE_TYPE_ERROR ||
+                        strncmp(ack->message, DEVICE_COMMUNICATION_STATS_ERROR,
+                                sizeof(DEVICE_COMMUNICATION_STATS_ERROR) - 1) == 0))
+        histogram->errors++;
+}
+
+void device_communication_stats_count(size_t type, bool written) {
+    size_t index = device_communication_stats_index(type);
+    if (index >= DEVICE_COMMUNICATION_STATS_TYPES) return;
+
+    if (written) device_communication_stats_process_counters.written[index]++;
+    else device_communication_stats_process_counters.read[index]++;
+}
+
+const DeviceCommunicationStatsCounters *device_communication_stats_counters(void) {
+    return &device_communication_stats_process_counters;
+}
+
+void device_communication_stats_merge(DeviceCommunicationStats *stats, const DeviceCommunicationStats *other) {
+    size_t i;
+    size_t j;
+    if (stats == NULL || other == NULL) return;
+
+    for (i = 0; i < DEVICE_COMMUNICATION_STATS_TYPES; ++i) {
+        if (other->histogram[i].count == 0) continue;
+
+        stats->histogram[i].count += other->histogram[i].count;
+        stats->histogram[i].errors += other->histogram[i].errors;
+        if (other->histogram[i].max > stats->histogram[i].max) stats->histogram[i].max = other->histogram[i].max;
+        stats->histogram[i].sum += other->histogram[i].sum;
+        for (j = 0; j < DEVICE_COMMUNICATION_STATS_BUCKETS; ++j) {
+            stats->histogram[i].bucket[j] += other->histogram[i].bucket[j];
+        }
+    }
+}
+
+bool device_communication_stats_add_message(DeviceCommunicationStats *stats, const DeviceCommunicationMessage *message) {
+    DeviceCommunicationStatsHistogram *histogram;
+    ConverterResult type;
+    unsigned long errors;
+    unsigned long bucket;
+    unsigned int count;
+    Stopwatch max;
+    Stopwatch sum;
+    char **fields;
+    size_t index;
+    size_t i;
+    if (stats == NULL || message == NULL) return false;
+    if (message->type != MESSAGE_TYPE_STATS || message->flag_skip) return false;
+
+    if ((fields = device_communication_split_message_fields(message->message)) == NULL) return false;
+
+    if (fields[0] == NULL || fields[1] == NULL || fields[2] == NULL || fields[3] == NULL ||
+        (type = converter_string_to_long(fields[0])).error ||
+        (index = device_communication_stats_index((size_t) type.data.Long)) >= DEVICE_COMMUNICATION_STATS_TYPES ||
+        sscanf(fields[1], "%lu", &errors) != 1 || sscanf(fields[2], "%llu", &max) != 1 ||
+        sscanf(fields[3], "%llu", &sum) != 1) {
+        device_communication_free_message_fields(fields);
+        return false;
+    }
+
+    histogram = &stats->histogram[index];
+    histogram->errors += errors;
+    if (max > histogram->max) histogram->max = max;
+    histogram->sum += sum;
+    for (i = DEVICE_COMMUNICATION_STATS_MESSAGE_HEADER; fields[i] != NULL; ++i) {
+        if (sscanf(fields[i], "%lu %u", &bucket, &count) != 2 || bucket >= DEVICE_COMMUNICATION_STATS_BUCKETS)
+            continue;
+
+        histogram->bucket[bucket] += count;
+        histogram->count += count;
+    }
+
+    device_communication_free_message_fields(fields);
+    return true;
+}
+
+bool device_communication_stats_to_message(const DeviceCommunicationStats *stats, size_t *cursor, char *message,
+                                           size_t length) {
+    const DeviceCommunicationStatsHistogram *histogram;
+    size_t index;
+    size_t first;
+    size_t bucket;
+    size_t buckets = 0;
+    size_t used;
+    bool first_record;
+    if (stats == NULL || cursor == NULL || message == NULL || length == 0) return false;
+
+    message[0] = '\0';
+
+    /* Skip empty buckets */
+    while (*cursor < DEVICE_COMMUNICATION_STATS_TYPES * DEVICE_COMMUNICATION_STATS_BUCKETS &&
+           stats->histogram[*cursor / DEVICE_COMMUNICATION_STATS_BUCKETS]
+                   .bucket[*cursor % DEVICE_COMMUNICATION_STATS_BUCKETS] == 0)
+        (*cursor)++;
+    if (*cursor >= DEVICE_COMMUNICATION_STATS_TYPES * DEVICE_COMMUNICATION_STATS_BUCKETS) return false;
+
+    index = *cursor / DEVICE_COMMUNICATION_STATS_BUCKETS;
+    histogram = &stats->histogram[index];
+
+    /* Errors, max and sum travel only once per type, they are summed and maxed when merged */
+    for (first = 0; histogram->bucket[first] == 0; ++first);
+    first_record = *cursor % DEVICE_COMMUNICATION_STATS_BUCKETS == first;
+
+    used = snprintf(message, length, "%ld\n%lu\n%llu\n%llu\n", device_communication_stats_type(index),
+                    (first_record) ? histogram->errors : 0, (first_record) ? histogram->max : 0,
+                    (first_record) ? histogram->sum : 0);
+    for (bucket = *cursor % DEVICE_COMMUNICATION_STATS_BUCKETS;
+         bucket < DEVICE_COMMUNICATION_STATS_BUCKETS && used < length &&
+         buckets < DEVICE_COMMUNICATION_MESSAGE_FIELDS_MAX - DEVICE_COMMUNICATION_STATS_MESSAGE_HEADER; ++bucket) {
+        if (histogram->bucket[bucket] == 0) continue;
+
+        used += snprintf(message + used, length - used, "%ld %u\n", bucket, histogram->bucket[bucket]);
+        buckets++;
+    }
+
+    *cursor = index * DEVICE_COMMUNICATION_STATS_BUCKETS + bucket;
+    return true;
+}
+
+Stopwatch device_communication_stats_percentile(const DeviceCommunicationStatsHistogram *histogram, double percentile) {
+    unsigned long rank;
+    unsigned long seen = 0;
+    size_t bucket;
+    Stopwatch upper;
+    if (histogram == NULL || histogram->count == 0) return 0;
+
+    /* Nearest rank */
+    rank = (unsigned long) (percentile / 100.0 * histogram->count);
+    if ((double) rank < percentile / 100.0 * histogram->count) rank++;
+    if (rank == 0) rank = 1;
+
+    for (bucket = 0; bucket < DEVICE_COMMUNICATION_STATS_BUCKETS; ++bucket) {
+        seen += histogram->bucket[bucket];
+        if (seen >= rank) break;
+    }
+
+    upper = device_communication_stats_bucket_upper(bucket);
+    return (upper > histogram->max) ? histogram->max : upper;
+}
+
+unsigned long device_communication_stats_cumulative(const DeviceCommunicationStatsHistogram *histogram, Stopwatch bound) {
+    unsigned long count = 0;
+    size_t bucket;
+    if (histogram == NULL) return 0;
+
+    for (bucket = 0; bucket < DEVICE_COMMUNICATION_STATS_BUCKETS &&
+                     device_communication_stats_bucket_upper(bucket) <= bound; ++bucket) {
+        count += histogram->bucket[bucket];
+    }
+
+    return count;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "device/device_communication_subtree.h"
+#include "util/util_converter.h"
+
+/**
+ * Decode a node from a line of a message
+ * @param subtree The subtree
+ * @param line The line, its fields are separated by tabs and modified in place
+ * @return true if decoded, false if not valid
+ */
+static bool device_communication_subtree_node(DeviceCommunicationSubtree *subtree, char *line);
+
+void device_communication_subtree_init(DeviceCommunicationSubtree *subtree) {
+    if (subtree == NULL) return;
+
+    subtree->count = 0;
+}
+
+bool device_communication_subtree_add(DeviceCommunicationSubtree *subtree, size_t id, size_t id_device_descriptor,
+                                      long parent, const char *name, const char *values) {
+    DeviceCommunicationSubtreeNode *node;
+    size_t length;
+    if (subtree == NULL || name == NULL || values == NULL) return false;
+    if (subtree->count >= DEVICE_COMMUNICATION_SUBTREE_NODES) return false;
+    if (parent < DEVICE_COMMUNICATION_SUBTREE_ROOT || parent >= (long) subtree->count) return false;
+    if (strlen(name) == 0 || strlen(name) >= DEVICE_NAME_LENGTH || strpbrk(name, "\t\n") != NULL) return false;
+    if ((length = strlen(values)) >= DEVICE_COMMUNICATION_MESSAGE_LENGTH || strchr(values, '\t') != NULL) return false;
+
+    node = &subtree->nodes[subtree->count++];
+    node->id = id;
+    node->id_device_descriptor = id_device_descriptor;
+    node->parent = parent;
+    strcpy(node->name, name);
+    strcpy(node->values, values);
+    /* Every field ends with a new line, the last one of an INFO message may not */
+    if (length > 0 && node->values[length - 1] == '\n') node->values[length - 1] = '\0';
+
+    return true;
+}
+
+long device_communication_subtree_find(const DeviceCommunicationSubtree *subtree, size_t id) {
+    size_t i;
+    if (subtree == NULL) return DEVICE_COMMUNICATION_SUBTREE_ROOT;
+
+    for (i = 0; i < subtree->count; ++i) {
+        if (subtree->nodes[i].id == id) return (long) i;
+    }
+
+    return DEVICE_COMMUNICATION_SUBTREE_ROOT;
+}
+
+size_t device_communication_subtree_roots(const DeviceCommunicationSubtree *subtree, size_t *id_device_descriptor) {
+    size_t roots = 0;
+    size_t i;
+    if (id_device_descriptor != NULL) *id_device_descriptor = 0;
+    if (subtree == NULL) return 0;
+
+    for (i = 0; i < subtree->count; ++i) {
+        if (subtree->nodes[i].parent != DEVICE_COMMUNICATION_SUBTREE_ROOT) continue;
+
+        if (id_device_descriptor != NULL) {
+            if (roots == 0) *id_device_descriptor = subtree->nodes[i].id_device_descriptor;
+            else if (*id_device_descriptor != subtree->nodes[i].id_device_descriptor) *id_device_descriptor = 0;
+        }
+        roots++;
+    }
+
+    return roots;
+}
+
+void device_communication_subtree_descendants(const DeviceCommunicationSubtree *subtree, size_t index,
+                                              DeviceCommunicationSubtree *descendants) {
+    long mapped[DEVICE_COMMUNICATION_SUBTREE_NODES];
+    const DeviceCommunicationSubtreeNode *node;
+    size_t i;
+    if (descendants == NULL) return;
+
+    device_communication_subtree_init(descendants);
+    if (subtree == NULL || index >= subtree->count) return;
+
+    /* Parents come first, a node is a descendant if its parent is the node or a descendant */
+    for (i = index + 1; i < subtree->count; ++i) {
+        node = &subtree->nodes[i];
+        mapped[i] = DEVICE_COMMUNICATION_SUBTREE_ROOT - 1;
+
+        if (node->parent == (long) index) {
+            mapped[i] = (long) descendants->count;
+            descendants->nodes[descendants->count] = *node;
+            descendants->nodes[descendants->count++].parent = DEVICE_COMMUNICATION_SUBTREE_ROOT;
+        } else if (node->parent > (long) index && mapped[node->parent] >= 0) {
+            mapped[i] = (long) descendants->count;
+            descendants->nodes[descendants->count] = *node;
+            descendants->nodes[descendants->count++].parent = mapped[node->parent];
+        }
+    }
+}
+
+bool device_communication_subtree_to_message(const DeviceCommunicationSubtree *subtree, char *message,
+                                             size_t length) {
+    const DeviceCommunicationSubtreeNode *node;
+    size_t used = 0;
+    size_t start;
+    size_t i;
+    int written;
+    if (subtree == NULL || message == NULL || length == 0) return false;
+
+    message[0] = '\0';
+    for (i = 0; i < subtree->count; ++i) {
+        node = &subtree->nodes[i];
+        start = used;
+
+        written = snprintf(message + used, length - used, "%ld\t%lu\t%lu\t%s\t%s\n", node->parent, node->id,
+                           node->id_device_descriptor, node->name, node->values);
+        if (written < 0 || (size_t) written >= length - used) {
+            message[start] = '\0';
+            return false;
+        }
+        used += written;
+
+        /* Fields of the values are separated by tabs too, the new line ends the node */
+        for (; start < used - 1; ++start) {
+            if (message[start] == '\n') message[start] = DEVICE_COMMUNICATION_SUBTREE_FIELD_DELIMITER;
+        }
+    }
+
+    return true;
+}
+
+static bool device_communication_subtree_node(DeviceCommunicationSubtree *subtree, char *line) {
+    char *fields[4];
+    char *values;
+    char *field;
+    ConverterResult parent;
+    ConverterResult id;
+    ConverterResult id_device_descriptor;
+    size_t i;
+
+    field = line;
+    for (i = 0; i < 4; ++i) {
+        fields[i] = field;
+        if ((field = strchr(field, DEVICE_COMMUNICATION_SUBTREE_FIELD_DELIMITER)) == NULL) return false;
+        *field++ = '\0';
+    }
+    values = field;
+
+    parent = converter_string_to_long(fields[0]);
+    id = converter_string_to_long(fields[1]);
+    id_device_descriptor = converter_string_to_long(fields[2]);
+    if (parent.error || id.error || id.data.Long <= 0 || id_device_descriptor.error ||
+        id_device_descriptor.data.Long <= 0)
+        return false;
+
+    for (field = values; *field != '\0'; ++field) {
+        if (*field == DEVICE_COMMUNICATION_SUBTREE_FIELD_DELIMITER) *field = '\n';
+    }
+
+    return device_communication_subtree_add(subtree, (size_t) id.data.Long, (size_t) id_device_descriptor.data.Long,
+                                            parent.data.Long, fields[3], values);
+}
+
+bool device_communication_subtree_from_message(DeviceCommunicationSubtree *subtree, const char *message) {
+    char message_copy[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    char *line;
+    char *end;
+    if (subtree == NULL || message == NULL) return false;
+
+    device_communication_subtree_init(subtree);
+    strncpy(message_copy, message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+    message_copy[DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1] = '\0';
+
+    for (line = message_copy; *line != '\0'; line = end + 1) {
+        if ((end = strchr(line, '\n')) == NULL) return false;
+        *end = '\0';
+        if (!device_communication_subtree_node(subtree, line)) return false;
+    }
+
+    return subtree->count > 0;
+}
+
+void device_communication_subtree_to_init_values(const DeviceCommunicationSubtree *subtree, size_t index,
+                                                 char *message, size_t length) {
+    const DeviceCommunicationSubtreeNode *node;
+    if (subtree == NULL || message == NULL || length == 0) return;
+    if (index >= subtree->count) {
+        message[0] = '\0';
+        return;
+    }
+
+    node = &subtree->nodes[index];
+    snprintf(message, length, "%lu\n%lu\n%s\n", node->id, node->id_device_descriptor, node->values);
+}
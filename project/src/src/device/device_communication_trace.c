@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "device/device_communication_trace.h"
+
+/**
+ * Ring buffer of the spans of this process
+ *  Only the process itself writes and reads it, the total count is never reset
+ */
+static DeviceCommunicationTraceSpan device_communication_trace_spans[DEVICE_COMMUNICATION_TRACE_SPANS];
+static size_t device_communication_trace_spans_count = 0;
+
+/**
+ * The span in progress
+ */
+static DeviceCommunicationTraceSpan device_communication_trace_span;
+static bool device_communication_trace_active = false;
+static pid_t device_communication_trace_parent = 0;
+
+/**
+ * Trace ids generated by this process
+ */
+static size_t device_communication_trace_ids = 0;
+
+size_t device_communication_trace_new_id(void) {
+    /* The pid makes it unique among processes */
+    return ((size_t) getpid() << 24) | (++device_communication_trace_ids & 0xFFFFFF);
+}
+
+size_t device_communication_trace_current(void) {
+    return (device_communication_trace_active) ? device_communication_trace_span.trace_id
+                                               : DEVICE_COMMUNICATION_TRACE_NONE;
+}
+
+void device_communication_trace_begin(size_t trace_id, size_t id_device, size_t id_device_descriptor, size_t type) {
+    if (trace_id == DEVICE_COMMUNICATION_TRACE_NONE) return;
+
+    device_communication_trace_span.arrival = stopwatch_now();
+    device_communication_trace_span.trace_id = trace_id;
+    device_communication_trace_span.id_device = id_device;
+    device_communication_trace_span.id_device_descriptor = id_device_descriptor;
+    device_communication_trace_span.pid = getpid();
+    device_communication_trace_span.type = type;
+    device_communication_trace_span.forward = 0;
+    device_communication_trace_span.reply = 0;
+    device_communication_trace_span.depth = 0;
+    device_communication_trace_parent = getppid();
+    device_communication_trace_active = true;
+}
+
+void device_communication_trace_forward(void) {
+    if (!device_communication_trace_active || device_communication_trace_span.forward != 0) return;
+
+    device_communication_trace_span.forward = stopwatch_now();
+}
+
+void device_communication_trace_reply(pid_t pid) {
+    if (!device_communication_trace_active || pid != device_communication_trace_parent) return;
+
+    device_communication_trace_span.reply = stopwatch_now();
+}
+
+void device_communication_trace_end(void) {
+    if (!device_communication_trace_active) return;
+
+    /* Nothing has been written to the parent, like for Domus */
+    if (device_communication_trace_span.reply == 0) device_communication_trace_span.reply = stopwatch_now();
+    device_communication_trace_spans[device_communication_trace_spans_count++ % DEVICE_COMMUNICATION_TRACE_SPANS] =
+            device_communication_trace_span;
+    device_communication_trace_active = false;
+}
+
+const DeviceCommunicationTraceSpan *device_communication_trace_next(size_t trace_id, size_t *cursor) {
+    const DeviceCommunicationTraceSpan *span;
+    if (cursor == NULL) return NULL;
+
+    /* Overwritten spans are lost */
+    if (device_communication_trace_spans_count > DEVICE_COMMUNICATION_TRACE_SPANS &&
+        *cursor < device_communication_trace_spans_count - DEVICE_COMMUNICATION_TRACE_SPANS)
+        *cursor = device_communication_trace_spans_count - DEVICE_COMMUNICATION_TRACE_SPANS;
+
+    while (*cursor < device_communication_trace_spans_count) {
+        span = &device_communication_trace_spans[(*cursor)++ % DEVICE_COMMUNICATION_TRACE_SPANS];
+        if (span->trace_id == trace_id) return span;
+    }
+
+    return NULL;
+}
+
+void device_communication_trace_span_to_message(const DeviceCommunicationTraceSpan *span, char *message,
+                                                size_t length) {
+    if (span == NULL || message == NULL || length == 0) return;
+
+    snprintf(message, length, "%lu\n%lu\n%lu\n%d\n%lu\n%llu\n%llu\n%llu\n", span->trace_id, span->id_device,
+             span->id_device_descriptor, span->pid, span->type, span->arrival, span->forward, span->reply);
+}
+
+bool device_communication_trace_span_from_message(DeviceCommunicationTraceSpan *span,
+                                                  const DeviceCommunicationMessage *message) {
+    if (span == NULL || message == NULL) return false;
+    if (message->type != MESSAGE_TYPE_TRACE || message->flag_skip) return false;
+
+    span->depth = 0;
+    return sscanf(message->message, "%lu\n%lu\n%lu\n%d\n%lu\n%llu\n%llu\n%llu", &span->trace_id,
+                  &span->id_device, &span->id_device_descriptor, &span->pid, &span->type, &span->arrival,
+                  &span->forward, &span->reply) == 8;
+}
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "device/device_communication_transaction.h"
+
+size_t device_communication_transaction_to_message(size_t id, unsigned long timeout,
+                                                   const DeviceCommunicationScene *scene, size_t from,
+                                                   char *message, size_t length) {
+    size_t used;
+    if (message == NULL || length == 0) return from;
+
+    used = snprintf(message, length, "%lu\n%lu\n", id, timeout);
+    if (used >= length) return from;
+
+    return device_communication_scene_to_message(scene, from, message + used, length - used);
+}
+
+bool device_communication_transaction_from_message(const char *message, size_t *id, unsigned long *timeout,
+                                                   DeviceCommunicationScene *scene) {
+    char *end;
+    if (message == NULL || id == NULL || timeout == NULL) return false;
+
+    *id = strtoul(message, &end, 10);
+    if (end == message || *end != '\n' || *id == DEVICE_COMMUNICATION_TRANSACTION_NONE) return false;
+    message = end + 1;
+
+    *timeout = strtoul(message, &end, 10);
+    if (end == message || *end != '\n') return false;
+
+    return device_communication_scene_from_message(scene, end + 1);
+}
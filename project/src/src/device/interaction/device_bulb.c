@@ -74,6 +74,7 @@ static bool bulb_set_switch_state(const char *name, bool state) {
     bulb_registry = (BulbRegistry *) bulb->registry;
 
     bulb->state = state;
+    bulb->version++;
     bulb_switch->state = (bool *) state;
     if (state && start == 0) {
         start = time(NULL);
@@ -102,6 +103,8 @@ static void bulb_message_handler(DeviceCommunicationMessage in_message) {
             device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_INFO,
                                                 "%d\n%.0lf\n%d\n",
                                                 bulb->state, time_difference, switch_state);
+            /* The active time grows while on */
+            out_message.flag_live = switch_state;
             break;
         }
         case MESSAGE_TYPE_SET_INIT_VALUES: {
@@ -185,7 +188,10 @@ static void queue_message_handler() {
 
     snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_BULB, MESSAGE_RETURN_NAME_ERROR);
 
-    if (strcmp(fields[1], BULB_SWITCH_TURN) == 0) {
+    /* Held by a transaction, a switch from the queue is refused like one from the pipe */
+    if (device_child_transaction_is_held()) {
+        snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_BULB, MESSAGE_RETURN_LOCKED_ERROR);
+    } else if (strcmp(fields[1], BULB_SWITCH_TURN) == 0) {
         snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_BULB, MESSAGE_RETURN_VALUE_ERROR);
         if (strcmp(fields[2], BULB_SWITCH_TURN_OFF) == 0) {
             if (bulb_set_switch_state(BULB_SWITCH_TURN, false)) {
@@ -118,6 +118,7 @@ static int fridge_set_switch_state(const char *name, void *state) {
                 timer_settime(door_timer, 0, &t, NULL);
             }
         }
+        fridge->version++;
         return true;
     } else if (strcmp(name, FRIDGE_SWITCH_THERMO) == 0) {
         fridge_switch = device_get_device_switch(fridge->switches, name);
@@ -132,13 +133,14 @@ static int fridge_set_switch_state(const char *name, void *state) {
         fridge_registry = (FridgeRegistry *) fridge->registry;
         fridge_switch->state = (double *) state;
         fridge_registry->temp = *((double *) state);
-
+        fridge->version++;
         return true;
     } else if (strcmp(name, FRIDGE_SWITCH_STATE) == 0) {
         fridge_switch = device_get_device_switch(fridge->switches, name);
 
         fridge_switch->state = (bool *) state;
         fridge->state = state;
+        fridge->version++;
         return true;
     } else if (strcmp(name, FRIDGE_SWITCH_DELAY) == 0) {
         fridge_switch = device_get_device_switch(fridge->switches, name);
@@ -146,8 +148,7 @@ static int fridge_set_switch_state(const char *name, void *state) {
         fridge_registry = (FridgeRegistry *) fridge->registry;
         fridge_switch->state = (long *) state;
         fridge_registry->delay = *((long *) state);
-
-
+        fridge->version++;
         return true;
     } else if (strcmp(name, FRIDGE_SWITCH_FILLING) == 0) {
         fridge_registry = (FridgeRegistry *) fridge->registry;
@@ -163,7 +164,7 @@ static int fridge_set_switch_state(const char *name, void *state) {
         }
 
         fridge_registry->perc = (((float) fridge_registry->items) / DEVICE_FRIDGE_MAX_ITEM) * 100;
-
+        fridge->version++;
         return true;
     }
     return false;
@@ -197,6 +198,8 @@ static void fridge_message_handler(DeviceCommunicationMessage in_message) {
             device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_INFO,
                                                 "%d\n%.0lf\n%ld\n%.2f\n%.2lf\n%d\n",
                                                 fridge->state, time_difference, delay, perc, temp, switch_door);
+            /* The open time grows while the door is open */
+            out_message.flag_live = switch_door;
 
             break;
         }
@@ -358,7 +361,10 @@ static void queue_message_handler() {
 
     snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_FRIDGE, MESSAGE_RETURN_NAME_ERROR);
 
-    if (strcmp(fields[1], FRIDGE_SWITCH_DOOR) == 0) {
+    /* Held by a transaction, a switch from the queue is refused like one from the pipe */
+    if (device_child_transaction_is_held()) {
+        snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_FRIDGE, MESSAGE_RETURN_LOCKED_ERROR);
+    } else if (strcmp(fields[1], FRIDGE_SWITCH_DOOR) == 0) {
         snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_FRIDGE, MESSAGE_RETURN_VALUE_ERROR);
         if (strcmp(fields[2], FRIDGE_SWITCH_DOOR_OFF) == 0) {
             if (fridge_set_switch_state(FRIDGE_SWITCH_DOOR, (void *) false)) {
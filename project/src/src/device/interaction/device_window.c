@@ -75,6 +75,7 @@ static bool window_set_switch_state(const char *name, bool state) {
 
     window_switch->state = (bool *) true;
     window->state = state;
+    window->version++;
 
     if (state && start == 0) {
         start = time(NULL);
@@ -105,6 +106,8 @@ static void window_message_handler(DeviceCommunicationMessage in_message) {
             device_communication_message_modify(&out_message, in_message.id_sender, MESSAGE_TYPE_INFO,
                                                 "%d\n%.0lf\n%d\n",
                                                 window->state, time_difference, switch_state);
+            /* The open time grows while open */
+            out_message.flag_live = window->state;
 
             break;
         }
@@ -185,7 +188,10 @@ static void queue_message_handler(){
 
     snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_WINDOW, MESSAGE_RETURN_NAME_ERROR);
 
-    if(strcmp(fields[1], WINDOW_SWITCH_OPEN) == 0){
+    /* Held by a transaction, a switch from the queue is refused like one from the pipe */
+    if (device_child_transaction_is_held()) {
+        snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_WINDOW, MESSAGE_RETURN_LOCKED_ERROR);
+    } else if(strcmp(fields[1], WINDOW_SWITCH_OPEN) == 0){
         snprintf(text, 64, "%d\n%s\n", DEVICE_TYPE_WINDOW, MESSAGE_RETURN_VALUE_ERROR);
         if(strcmp(fields[2], WINDOW_SWITCH_OPEN_OFF) == 0){
             if(window_set_switch_state(WINDOW_SWITCH_OPEN, false)){
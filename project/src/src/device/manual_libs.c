@@ -128,6 +128,8 @@ void manual_control_set_device(size_t device_id, char *switch_label, char *switc
             println_color(COLOR_RED, "Cannot set internal temperature : too high");
         } else if (strcmp(text, MESSAGE_RETURN_VALUE_MINTHERMO_FRIDGE_ERROR) == 0) {
             println_color(COLOR_RED, "Cannot set internal temperature : too low");
+        } else if (strcmp(text, MESSAGE_RETURN_LOCKED_ERROR) == 0) {
+            println_color(COLOR_RED, "Held by another transaction");
         } else {
             println_color(COLOR_RED, "Unknown Error");
         }
@@ -1,11 +1,26 @@
 
+#include <stdlib.h>
 #include <string.h>
+#include <poll.h>
 #include <sys/wait.h>
 #include "domus.h"
+#include "domus_metrics.h"
+#include "domus_journal.h"
+#include "domus_snapshot.h"
+#include "domus_history.h"
+#include "domus_scene.h"
 #include "device/device_communication.h"
+#include "device/device_communication_filter.h"
+#include "device/device_communication_aggregate.h"
+#include "device/device_communication_stats.h"
+#include "device/device_communication_trace.h"
+#include "device/device_communication_transaction.h"
+#include "device/device_communication_subtree.h"
+#include "device/control/device_controller.h"
 #include "cli/command/command.h"
 #include "util/util_printer.h"
 #include "util/util_converter.h"
+#include "util/util_output.h"
 #include "cli/cli.h"
 #include "author.h"
 
@@ -15,6 +30,68 @@
  */
 static ControlDevice *domus = NULL;
 
+/**
+ * Flag if a batch of independent commands is running
+ */
+static bool domus_batch = false;
+
+/**
+ * System status cached in the current batch: -1 unknown, 0 unavailable, 1 active
+ */
+static int domus_batch_system_status = -1;
+
+/**
+ * Info of all Devices cached in the current batch, NULL if not taken or stale
+ */
+static List *domus_batch_snapshot = NULL;
+
+/**
+ * Records of the last delta info walk of all Devices, NULL if none, and the walks counter
+ */
+static List *domus_info_cache = NULL;
+static size_t domus_info_cache_epoch = 0;
+static size_t domus_info_epoch = 0;
+
+/**
+ * Walks not ended yet, a Device is read by one walk at a time
+ */
+static List *domus_walks = NULL;
+
+/**
+ * Struct Domus Info Stream, a record handler behind the filter evaluated by Domus
+ */
+typedef struct DomusInfoStream {
+    const DeviceCommunicationFilter *filter;
+    DomusRecordHandler handler;
+    void *context;
+    size_t records;
+} DomusInfoStream;
+
+/**
+ * Flag if a transaction is open, its switches are staged until the commit
+ */
+static bool domus_transaction_open = false;
+
+/**
+ * The switches staged by the open transaction
+ */
+static DeviceCommunicationScene domus_transaction_scene;
+
+/**
+ * Milliseconds a prepared Device waits for the commit of the open transaction
+ */
+static unsigned long domus_transaction_timeout = DEVICE_COMMUNICATION_TRANSACTION_TIMEOUT;
+
+/**
+ * The id of the last transaction
+ */
+static size_t domus_transaction_id = DEVICE_COMMUNICATION_TRANSACTION_NONE;
+
+/**
+ * Journal to recover at startup, empty if none
+ */
+static char domus_journal_startup[DOMUS_JOURNAL_FILE_NAME_LENGTH] = "";
+
 /**
  * Initialize all Domus Components
  */
@@ -38,15 +115,292 @@ static List *
 domus_propagate_message(size_t id, size_t out_message_type, const char *out_message_message, size_t in_message_type);
 
 /**
- * Propagate a message into the system and populate the List of received messages
- * @param list The list to populate
+ * Propagate a message into the system handing every received message as soon as it arrives
+ * @param id The id of the recipient Device
+ * @param out_message_type The out message type
+ * @param out_message_message The out message string message
+ * @param in_message_type Incoming message type from Device/s
+ * @param handler The handler of the received messages
+ * @param context The context of the handler
+ * @return The number of received messages
+ */
+static size_t domus_propagate_stream(size_t id, size_t out_message_type, const char *out_message_message,
+                                     size_t in_message_type, DomusRecordHandler handler, void *context);
+
+/**
+ * Propagate a message to a Device handing every received message, skip records are not handed
  * @param device_communication The Device Communication
  * @param out_message The out message
  * @param in_message_type The incoming message type
- * @return true if propagate goes well, false otherwise
+ * @param handler The handler of the received messages
+ * @param context The context of the handler
+ * @return The number of received messages
+ */
+static size_t domus_propagate_message_logic(DeviceCommunication *device_communication,
+                                            const DeviceCommunicationMessage *out_message, size_t in_message_type,
+                                            DomusRecordHandler handler, void *context);
+
+/**
+ * Record handler adding a copy of the message first in a List, so the List is in hierarchy order
+ * @param message The received message
+ * @param context The List
+ */
+static void domus_record_collect(const DeviceCommunicationMessage *message, void *context);
+
+/**
+ * Ask the Controller if the System is active
+ * @return true if the Controller is active, false otherwise
+ */
+static bool domus_system_status(void);
+
+/**
+ * Collect the info messages of a Device and its subtree
+ *  The filter is pushed down to the Control Devices, only matching records come back
+ *  Inside a batch the messages are served from the snapshot of all Devices if available
+ *  Remember to free the List using free_list function
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The info filter, can be NULL
+ * @return The List of info messages, can be empty, NULL otherwise
+ */
+static List *domus_info_messages(size_t id, const DeviceCommunicationFilter *filter);
+
+/**
+ * Refresh the cache of all Devices with a delta info walk, handing every record
+ *  Subtrees that did not change since the previous walk answer with a single unchanged record
+ *  and their records are taken from the cache, if one is missing a full walk is done instead
+ *  and the records of the missing subtrees are handed once it ends
+ * @param handler The record handler, can be NULL
+ * @param context The context of the handler
+ */
+static void domus_info_delta(DomusRecordHandler handler, void *context);
+
+/**
+ * Walk all Devices once asking for the records changed since a cached walk
+ * @param since The cached walk, 0 to ask for every record
+ * @param missing Filled with the unchanged records whose subtree is not in the cache, can be NULL
+ * @param handler The record handler, can be NULL
+ * @param context The context of the handler
+ * @return The List of info messages
+ */
+static List *domus_info_delta_walk(size_t since, List *missing, DomusRecordHandler handler, void *context);
+
+/**
+ * Move the cached records of an unchanged subtree in the List, as if they had been received
+ * @param message_list The List of info messages being received
+ * @param unchanged The unchanged record of the subtree root
+ * @param handler The record handler, can be NULL
+ * @param context The context of the handler
+ * @return true if the subtree is in the cache, false otherwise
+ */
+static bool domus_info_delta_splice(List *message_list, const DeviceCommunicationMessage *unchanged,
+                                    DomusRecordHandler handler, void *context);
+
+/**
+ * Record handler of domus_info_each, forward a record matching the filter
+ * @param message The info record
+ * @param context The Domus Info Stream
+ */
+static void domus_info_stream_record(const DeviceCommunicationMessage *message, void *context);
+
+/**
+ * Print the info of a Device and its subtree in the current output format
+ *  Table rows are printed as soon as they arrive
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param filter The info filter, can be NULL
+ * @return true if at least one record has been printed, false otherwise
+ */
+static bool domus_info_print(size_t id, const DeviceCommunicationFilter *filter);
+
+/**
+ * Record handler of domus_info_print, print or collect a record
+ * @param message The info record
+ * @param context The number of records printed
+ */
+static void domus_info_print_row(const DeviceCommunicationMessage *message, void *context);
+
+/**
+ * Print the legend and the header of the info table
+ */
+static void domus_info_print_header(void);
+
+/**
+ * Print an info message as a row of the info table
+ * @param data The info message
+ */
+static void domus_info_print_record(const DeviceCommunicationMessage *data);
+
+/**
+ * Ask the next Device of a walk for its info, skipping the Devices that are gone or cannot match
+ * @param walk The walk
+ * @return DOMUS_WALK_PENDING if a Device has been asked or another walk is reading it,
+ *  DOMUS_WALK_DONE if no Device is left
+ */
+static int domus_walk_ask(DomusWalk *walk);
+
+/**
+ * Check if a walk is reading a Device
+ * @param device_communication The Device communication
+ * @return true if reading, false otherwise
+ */
+static bool domus_walk_is_reading(const DeviceCommunication *device_communication);
+
+/**
+ * Print or collect a matching record of a walk
+ * @param walk The walk
+ * @param message The info record
+ */
+static void domus_walk_record(DomusWalk *walk, const DeviceCommunicationMessage *message);
+
+/**
+ * Copy the messages of a Device and its subtree from a snapshot of all Devices
+ * @param snapshot The snapshot, in hierarchy order
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @return The List of copied messages, can be empty
+ */
+static List *domus_snapshot_subtree(const List *snapshot, size_t id);
+
+/**
+ * Hand the messages of a Device and its subtree from a snapshot of all Devices, in arrival order
+ * @param snapshot The snapshot, in hierarchy order
+ * @param id The Device id or DEVICE_MESSAGE_TO_ALL_DEVICES
+ * @param handler The record handler
+ * @param context The context of the handler
+ * @return true if the Device is in the snapshot, false otherwise
+ */
+static bool domus_snapshot_each(const List *snapshot, size_t id, DomusRecordHandler handler, void *context);
+
+/**
+ * Drop the info snapshot of the current batch, the hierarchy has changed
+ */
+static void domus_batch_invalidate(void);
+
+/**
+ * Add the identity fields of a Device to the current output record
+ * @param message The info message of the Device
+ */
+static void domus_output_device(const DeviceCommunicationMessage *message);
+
+/**
+ * Add a typed field parsed from an info message field to the current output record
+ *  A missing or malformed value is added as null
+ * @param key The field key
+ * @param field The info message field, can be NULL
+ * @param type The output field type
+ */
+static void domus_output_field(const char *key, const char *field, int type);
+
+/**
+ * Render the info messages as output records
+ * @param message_list The List of info messages
+ */
+static void domus_info_output(const List *message_list);
+
+/**
+ * Add the fields of an info message to the current output record
+ * @param message The info message
+ */
+static void domus_info_output_fields(const DeviceCommunicationMessage *message);
+
+/**
+ * Compare two resource rows by CPU usage, highest first
+ * @param row1 The first row
+ * @param row2 The second row
+ * @return Negative if row1 comes first, positive if row2 comes first, 0 otherwise
+ */
+static int domus_resources_compare(const void *row1, const void *row2);
+
+/**
+ * Print the resource rows in the current output format
+ * @param rows The rows
+ * @param count The number of rows
+ */
+static void domus_resources_print(const DomusResourcesRow *rows, size_t count);
+
+/**
+ * Print the aggregates in the current output format and free the List
+ * @param aggregates The List of aggregates
+ * @return true if the List was not empty, false otherwise
+ */
+static bool domus_aggregate_print(List *aggregates);
+
+/**
+ * Print latency statistics and free them
+ * @param stats The statistics
+ * @return true if something has been recorded, false otherwise
+ */
+static bool domus_stats_print(DeviceCommunicationStats *stats);
+
+/**
+ * Add a span to a List of spans ordered by arrival
+ * @param spans The List of spans
+ * @param span The span to copy
+ */
+static void domus_trace_add(List *spans, const DeviceCommunicationTraceSpan *span);
+
+/**
+ * Collect the spans of a trace recorded by Domus and every Device
+ *  A span is nested in the latest span that has not replied yet when it arrives
+ * @param trace_id The trace id
+ * @return The List of spans ordered by arrival, with their depth
+ */
+static List *domus_trace_spans(size_t trace_id);
+
+/**
+ * Return the label of a span, the traced command for the span of Domus
+ * @param span The span
+ * @param name The traced command
+ * @return The label
+ */
+static const char *domus_trace_label(const DeviceCommunicationTraceSpan *span, const char *name);
+
+/**
+ * Print the spans of a trace as a timeline
+ * @param spans The List of spans ordered by arrival
+ * @param name The traced command
  */
-static bool domus_propagate_message_logic(List *list, DeviceCommunication *device_communication,
-                                          const DeviceCommunicationMessage *out_message, size_t in_message_type);
+static void domus_trace_print(const List *spans, const char *name);
+
+/**
+ * Export the spans of a trace as Chrome trace JSON
+ * @param spans The List of spans ordered by arrival
+ * @param name The traced command
+ * @param file_name The file to write
+ * @return true if written, false otherwise
+ */
+static bool domus_trace_export(const List *spans, const char *name, const char *file_name);
+
+/**
+ * Write a string as a JSON string
+ * @param file The file
+ * @param string The string
+ */
+static void domus_trace_export_string(FILE *file, const char *string);
+
+/**
+ * Print the result of a switch record
+ * @param data The switch record
+ * @param switch_label The switch label, NULL if the Device followed a Control Device
+ * @param switch_pos The switch position, NULL if the Device followed a Control Device
+ * @return true if switched, false otherwise
+ */
+static bool domus_switch_print(const DeviceCommunicationMessage *data, const char *switch_label,
+                               const char *switch_pos);
+
+/**
+ * Print the records of a multi target switch, journaling every switched target
+ * @param message_list The records
+ * @param scene The scene
+ * @param remaining The targets without a record yet, the ones answering are removed
+ * @return The number of switched targets
+ */
+static long domus_switch_multi_print(const List *message_list, const DeviceCommunicationScene *scene,
+                                     DeviceCommunicationScene *remaining);
+
+/**
+ * Print the state and the version a Device answered with when the condition of a switch did not hold
+ * @param current The state and the version fields of the answer
+ */
+static void domus_switch_print_condition(const char *current);
 
 /**
  * The queue_message_handler, it handles the incoming
@@ -61,6 +415,8 @@ void domus_start(void) {
 }
 
 static void domus_init(void) {
+    long replayed;
+
     /* Create Domus, only once in the entire program with id 0 */
     domus = new_control_device(
             new_device(DOMUS_ID, DEVICE_TYPE_DOMUS, NULL,
@@ -72,13 +428,24 @@ static void domus_init(void) {
     device_init();
     signal(DEVICE_COMMUNICATION_READ_QUEUE, queue_message_handler);
     control_device_fork(domus, CONTROLLER_ID, device_is_supported_by_id(DEVICE_TYPE_CONTROLLER), NULL);
+
+    if (domus_journal_startup[0] != '\0') {
+        replayed = domus_journal_enable(domus_journal_startup, DOMUS_JOURNAL_WINDOW, true);
+        if (replayed == -1) println_color(COLOR_RED, "\tCannot recover the journal %s", domus_journal_startup);
+        else println("\tJournal %s recovered, %ld entries replayed", domus_journal_startup, replayed);
+    }
 }
 
 static void domus_tini(void) {
+    domus_journal_disable();
+    domus_history_disable();
+    free_list(domus_walks);
+    domus_walks = NULL;
     free_list(domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_TERMINATE, "",
                                       MESSAGE_TYPE_TERMINATE));
     free_list(domus_propagate_message(CONTROLLER_ID, MESSAGE_TYPE_TERMINATE_CONTROLLER, "", MESSAGE_TYPE_TERMINATE));
     free_control_device(domus);
+    domus_scene_tini();
     command_tini();
     author_tini();
     device_tini();
@@ -105,15 +472,44 @@ bool domus_has_devices(void) {
 
 size_t domus_fork_device(const DeviceDescriptor *device_descriptor, const char *custom_name) {
     size_t child_id;
+    Stopwatch start = stopwatch_now();
     if (!device_check_control_device(domus) || device_descriptor == NULL) return -1;
 
     child_id = ((DomusRegistry *) domus->device->registry)->next_id++;
-    if (!control_device_fork(domus, child_id, device_descriptor, custom_name)) return -1;
+    domus_batch_invalidate();
+    if (!control_device_fork(domus, child_id, device_descriptor, custom_name)) {
+        domus_metrics_operation(DOMUS_METRICS_OPERATION_SPAWN, start, false);
+        return -1;
+    }
+    domus_metrics_operation(DOMUS_METRICS_OPERATION_SPAWN, start, true);
+    domus_journal_append(DOMUS_JOURNAL_ENTRY_ADD, child_id, device_descriptor->id, custom_name);
 
     return child_id;
 }
 
 bool domus_system_is_active(void) {
+    bool toRtn;
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    if (domus_batch && domus_batch_system_status != -1) {
+        toRtn = domus_batch_system_status;
+    } else {
+        toRtn = domus_system_status();
+        if (domus_batch) domus_batch_system_status = toRtn;
+    }
+
+    if (!toRtn) {
+        println_color(COLOR_RED, "\tTHE SYSTEM IS UNAVAILABLE");
+        println("\tPlease enable the controller using Domus Manual");
+        println("\tPlease type:");
+        println_color(COLOR_YELLOW, "\t\tswitch %ld system on", CONTROLLER_ID);
+    }
+
+    return toRtn;
+}
+
+static bool domus_system_status(void) {
     List *message_list;
     const DeviceCommunicationMessage *message;
     char **fields;
@@ -149,109 +545,402 @@ bool domus_system_is_active(void) {
 
     free_list(message_list);
 
-    if (!toRtn) {
-        println_color(COLOR_RED, "\tTHE SYSTEM IS UNAVAILABLE");
-        println("\tPlease enable the controller using Domus Manual");
-        println("\tPlease type:");
-        println_color(COLOR_YELLOW, "\t\tswitch %ld system on", CONTROLLER_ID);
-    }
-
     return toRtn;
 }
 
-static List *
-domus_propagate_message(size_t id, size_t out_message_type, const char *out_message_message, size_t in_message_type) {
+void domus_batch_begin(void) {
+    domus_batch_end();
+    domus_batch = true;
+}
+
+void domus_batch_end(void) {
+    domus_batch_invalidate();
+    domus_batch_system_status = -1;
+    domus_batch = false;
+}
+
+static void domus_batch_invalidate(void) {
+    free_list(domus_batch_snapshot);
+    domus_batch_snapshot = NULL;
+}
+
+static List *domus_info_messages(size_t id, const DeviceCommunicationFilter *filter) {
     List *message_list;
-    DeviceCommunication *data;
-    DeviceCommunicationMessage out_message;
-    if (!device_check_control_device(domus)) return NULL;
-    if (!control_device_has_devices(domus)) return NULL;
+    List *match_list;
+    DeviceCommunicationMessage *data;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+
+    if (domus_batch && domus_batch_snapshot != NULL) {
+        message_list = domus_snapshot_subtree(domus_batch_snapshot, id);
+    } else if (id == DEVICE_MESSAGE_TO_ALL_DEVICES && device_communication_filter_is_empty(filter)) {
+        domus_info_delta(NULL, NULL);
+        message_list = domus_snapshot_subtree(domus_info_cache, DEVICE_MESSAGE_TO_ALL_DEVICES);
+
+        /* Only a full walk is worth caching, single Devices are cheaper to ask directly */
+        if (domus_batch) {
+            domus_batch_snapshot = message_list;
+            message_list = domus_snapshot_subtree(domus_batch_snapshot, id);
+        }
+    } else {
+        device_communication_filter_to_message(filter, out_message_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        message_list = domus_propagate_message(id, MESSAGE_TYPE_INFO, out_message_message, MESSAGE_TYPE_INFO);
+    }
 
-    message_list = new_list(NULL, NULL);
-    device_communication_message_init(domus->device, &out_message);
-    device_communication_message_modify(&out_message, id, out_message_type, out_message_message);
-    if (id == DEVICE_MESSAGE_TO_ALL_DEVICES) out_message.flag_force = true;
+    if (message_list == NULL || device_communication_filter_is_empty(filter)) return message_list;
 
-    if (out_message_type == MESSAGE_TYPE_SWITCH) {
-        data = (DeviceCommunication *) list_get_first(domus->devices);
-        domus_propagate_message_logic(message_list, data, &out_message, in_message_type);
+    /* Records of Devices directly connected to Domus are not filtered by anyone else */
+    match_list = new_list(NULL, NULL);
+    while (!list_is_empty(message_list)) {
+        data = (DeviceCommunicationMessage *) list_remove_first(message_list);
+        if (device_communication_filter_match_message(filter, data)) list_add_last(match_list, data);
+        else free(data);
+    }
+    free_list(message_list);
+
+    return match_list;
+}
+
+size_t domus_info_each(size_t id, const DeviceCommunicationFilter *filter, DomusRecordHandler handler,
+                       void *context) {
+    DomusInfoStream stream;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    if (!device_check_control_device(domus)) return 0;
+    if (!control_device_has_devices(domus)) return 0;
+    if (handler == NULL) return 0;
+
+    stream.filter = filter;
+    stream.handler = handler;
+    stream.context = context;
+    stream.records = 0;
+
+    if (domus_batch && domus_batch_snapshot != NULL) {
+        domus_snapshot_each(domus_batch_snapshot, id, domus_info_stream_record, &stream);
+    } else if (id == DEVICE_MESSAGE_TO_ALL_DEVICES && device_communication_filter_is_empty(filter)) {
+        domus_info_delta(domus_info_stream_record, &stream);
+
+        /* Only a full walk is worth caching, single Devices are cheaper to ask directly */
+        if (domus_batch) domus_batch_snapshot = domus_snapshot_subtree(domus_info_cache, id);
     } else {
-        list_for_each(data, domus->devices) {
-            domus_propagate_message_logic(message_list, data, &out_message, in_message_type);
-            if (message_list->size > 0 && id != DEVICE_MESSAGE_TO_ALL_DEVICES) return message_list;
-        }
+        device_communication_filter_to_message(filter, out_message_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        domus_propagate_stream(id, MESSAGE_TYPE_INFO, out_message_message, MESSAGE_TYPE_INFO,
+                               domus_info_stream_record, &stream);
     }
 
-    return message_list;
+    return stream.records;
 }
 
-static bool domus_propagate_message_logic(List *list, DeviceCommunication *device_communication,
-                                          const DeviceCommunicationMessage *out_message, size_t in_message_type) {
-    DeviceCommunicationMessage in_message;
-    if (!device_check_control_device(domus)) return false;
-    if (!control_device_has_devices(domus)) return false;
-    if (list == NULL || device_communication == NULL || out_message == NULL) return false;
+static void domus_info_stream_record(const DeviceCommunicationMessage *message, void *context) {
+    DomusInfoStream *stream = (DomusInfoStream *) context;
 
+    /* Records of Devices directly connected to Domus are not filtered by anyone else */
+    if (!device_communication_filter_match_message(stream->filter, message)) return;
 
-    if ((in_message = device_communication_write_message_with_ack(device_communication, out_message)).type ==
-        in_message_type) {
-        list_add_first(list, device_communication_message_copy(&in_message));
+    stream->handler(message, stream->context);
+    stream->records++;
+}
 
-        if (in_message.flag_continue) {
-            do {
-                in_message = device_communication_write_message_with_ack_silent(device_communication, out_message);
-                list_add_first(list, device_communication_message_copy(&in_message));
-            } while (in_message.flag_continue);
-        }
+static void domus_info_delta(DomusRecordHandler handler, void *context) {
+    List *message_list;
+    List *missing;
+    DeviceCommunicationMessage *data;
 
-        /* Delete only if type is TERMINATE & is directly connected */
-        if (in_message.type == MESSAGE_TYPE_TERMINATE &&
-            device_communication_device_is_directly_connected(&in_message)) {
-            device_communication_close_communication(device_communication);
-            list_remove(domus->devices, device_communication);
-        }
+    missing = new_list(NULL, NULL);
+    message_list = domus_info_delta_walk((domus_info_cache == NULL) ? 0 : domus_info_cache_epoch, missing,
+                                         handler, context);
+    if (!list_is_empty(missing)) {
+        free_list(message_list);
+        message_list = domus_info_delta_walk(0, NULL, NULL, NULL);
     }
 
-    return true;
+    free_list(domus_info_cache);
+    domus_info_cache = message_list;
+    domus_info_cache_epoch = domus_info_epoch;
+
+    /* Every other record has already been handed by the first walk */
+    if (handler != NULL) {
+        list_for_each(data, missing) {
+            domus_snapshot_each(domus_info_cache, data->id_sender, handler, context);
+        }
+    }
+    free_list(missing);
 }
 
-bool domus_del_by_id(size_t id) {
+static List *domus_info_delta_walk(size_t since, List *missing, DomusRecordHandler handler, void *context) {
     List *message_list;
-    DeviceCommunicationMessage *data;
-    DeviceDescriptor *device_descriptor;
-    bool toRtn;
-    if (!device_check_control_device(domus)) return false;
-    if (!control_device_has_devices(domus)) return false;
+    DeviceCommunication *data;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationMessage in_message;
+    DeviceCommunicationFilter filter;
+    bool live;
+    bool last;
 
-    message_list = domus_propagate_message(id, MESSAGE_TYPE_TERMINATE, "", MESSAGE_TYPE_TERMINATE);
+    message_list = new_list(NULL, NULL);
+    device_communication_filter_init(&filter);
+    filter.epoch = ++domus_info_epoch;
+    device_communication_message_init(domus->device, &out_message);
 
-    list_for_each(data, message_list) {
-        if (data->type == MESSAGE_TYPE_TERMINATE) {
-            device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
-            if (device_descriptor == NULL) {
-                println_color(COLOR_RED, "\tDeletion Command: Device with unknown Device Descriptor id %ld",
-                              data->id_device_descriptor);
+    list_for_each(data, domus->devices) {
+        /* A subtree with a record changing with time is asked in full */
+        filter.since = (data->info_live) ? 0 : since;
+        device_communication_filter_to_message(&filter, out_message.message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        out_message.type = MESSAGE_TYPE_INFO;
+        out_message.id_recipient = DEVICE_MESSAGE_TO_ALL_DEVICES;
+        out_message.flag_force = true;
+
+        if ((in_message = device_communication_write_message_with_ack(data, &out_message)).type != MESSAGE_TYPE_INFO)
+            continue;
+
+        live = false;
+        do {
+            live |= in_message.flag_live;
+            last = !in_message.flag_continue;
+
+            if (in_message.flag_unchanged) {
+                if (!domus_info_delta_splice(message_list, &in_message, handler, context) && missing != NULL)
+                    list_add_last(missing, device_communication_message_copy(&in_message));
+            } else if (!in_message.flag_skip) {
+                list_add_first(message_list, device_communication_message_copy(&in_message));
+                if (handler != NULL) handler(&in_message, context);
             }
 
-            println_color(COLOR_GREEN,
-                          "\t%s with id %ld has been deleted",
-                          (device_descriptor == NULL) ? "?" : device_descriptor->name,
-                          data->id_sender);
-        }
+            if (!last) in_message = device_communication_write_message_with_ack_silent(data, &out_message);
+        } while (!last);
+
+        data->info_live = live;
     }
 
-    (list_is_empty(message_list)) ? (toRtn = false) : (toRtn = true);
+    return message_list;
+}
 
-    free_list(message_list);
+static bool domus_info_delta_splice(List *message_list, const DeviceCommunicationMessage *unchanged,
+                                    DomusRecordHandler handler, void *context) {
+    List *subtree;
+    DeviceCommunicationMessage *data;
+    DeviceCommunicationMessage *copy;
+    Node *node;
+    size_t root_hop = 0;
+    bool found = false;
+    if (domus_info_cache == NULL) return false;
+
+    /* The cache is in List order, the subtree follows its root */
+    subtree = new_list(NULL, NULL);
+    for (node = domus_info_cache->head; node != NULL; node = node->next) {
+        data = (DeviceCommunicationMessage *) node->data;
+        if (found && data->ctr_hop <= root_hop) break;
+        if (!found && data->id_sender == unchanged->id_sender) {
+            found = true;
+            root_hop = data->ctr_hop;
+        }
+        if (!found) continue;
 
-    return toRtn;
-}
+        /* The subtree may have been linked somewhere else */
+        copy = device_communication_message_copy(data);
+        copy->ctr_hop = copy->ctr_hop - root_hop + unchanged->ctr_hop;
+        list_add_first(subtree, copy);
+    }
 
-bool domus_del_all(void) {
-    if (!device_check_control_device(domus)) return false;
-    if (!control_device_has_devices(domus)) return false;
+    /* Records are added first as they arrive, the root arrives last */
+    while (!list_is_empty(subtree)) {
+        if (handler != NULL) handler((DeviceCommunicationMessage *) list_get_first(subtree), context);
+        list_add_first(message_list, list_remove_first(subtree));
+    }
+    free_list(subtree);
 
-    return domus_del_by_id(DEVICE_MESSAGE_TO_ALL_DEVICES);
+    return found;
+}
+
+static List *domus_snapshot_subtree(const List *snapshot, size_t id) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    bool found = false;
+    size_t root_hop = 0;
+
+    message_list = new_list(NULL, NULL);
+
+    list_for_each(data, snapshot) {
+        if (found && data->ctr_hop <= root_hop) break;
+        if (!found && (id == DEVICE_MESSAGE_TO_ALL_DEVICES || data->id_sender == id)) {
+            found = true;
+            root_hop = (id == DEVICE_MESSAGE_TO_ALL_DEVICES) ? 0 : data->ctr_hop;
+        }
+        if (found) list_add_last(message_list, device_communication_message_copy(data));
+    }
+
+    return message_list;
+}
+
+static bool domus_snapshot_each(const List *snapshot, size_t id, DomusRecordHandler handler, void *context) {
+    Node *first = NULL;
+    Node *last = NULL;
+    Node *node;
+    DeviceCommunicationMessage *data;
+    size_t root_hop = 0;
+    if (snapshot == NULL) return false;
+
+    for (node = snapshot->head; node != NULL; node = node->next) {
+        data = (DeviceCommunicationMessage *) node->data;
+        if (first != NULL && data->ctr_hop <= root_hop) break;
+        if (first == NULL && (id == DEVICE_MESSAGE_TO_ALL_DEVICES || data->id_sender == id)) {
+            first = node;
+            root_hop = (id == DEVICE_MESSAGE_TO_ALL_DEVICES) ? 0 : data->ctr_hop;
+        }
+        if (first != NULL) last = node;
+    }
+    if (first == NULL) return false;
+
+    /* The snapshot is in hierarchy order, the root arrives last */
+    for (node = last; node != first->prev; node = node->prev) {
+        handler((DeviceCommunicationMessage *) node->data, context);
+    }
+
+    return true;
+}
+
+static List *
+domus_propagate_message(size_t id, size_t out_message_type, const char *out_message_message, size_t in_message_type) {
+    List *message_list;
+    DeviceCommunicationMessage out_message;
+    if (!device_check_control_device(domus)) return NULL;
+    if (!control_device_has_devices(domus)) return NULL;
+
+    message_list = new_list(NULL, NULL);
+    if (out_message_type == MESSAGE_TYPE_TERMINATE && id == DEVICE_MESSAGE_TO_ALL_DEVICES) {
+        device_communication_message_init(domus->device, &out_message);
+        device_communication_message_modify(&out_message, id, out_message_type, out_message_message);
+        out_message.flag_force = true;
+
+        /* Every Device directly connected to Domus tears its subtree down at the same time */
+        device_communication_terminate_all(domus->devices, &out_message, DEVICE_COMMUNICATION_TERMINATE_TIMEOUT,
+                                           message_list);
+    } else {
+        domus_propagate_stream(id, out_message_type, out_message_message, in_message_type, domus_record_collect,
+                               message_list);
+    }
+
+    return message_list;
+}
+
+static size_t domus_propagate_stream(size_t id, size_t out_message_type, const char *out_message_message,
+                                     size_t in_message_type, DomusRecordHandler handler, void *context) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationFilter filter;
+    Node *node;
+    Node *next;
+    size_t records = 0;
+    if (!device_check_control_device(domus)) return 0;
+    if (!control_device_has_devices(domus)) return 0;
+
+    device_communication_message_init(domus->device, &out_message);
+    device_communication_message_modify(&out_message, id, out_message_type, out_message_message);
+    if (id == DEVICE_MESSAGE_TO_ALL_DEVICES) out_message.flag_force = true;
+
+    device_communication_filter_from_message(&filter, (out_message_type == MESSAGE_TYPE_INFO)
+                                                      ? out_message_message : "");
+
+    if (out_message_type == MESSAGE_TYPE_SWITCH || out_message_type == MESSAGE_TYPE_SWITCH_MULTI ||
+        out_message_type == MESSAGE_TYPE_SWITCH_SELECT || out_message_type == MESSAGE_TYPE_PREPARE ||
+        out_message_type == MESSAGE_TYPE_COMMIT || out_message_type == MESSAGE_TYPE_ABORT) {
+        data = (DeviceCommunication *) list_get_first(domus->devices);
+        records = domus_propagate_message_logic(data, &out_message, in_message_type, handler, context);
+    } else {
+        /* A terminated Device is removed from the list, save the next node before propagating */
+        for (node = domus->devices->head; node != NULL; node = next) {
+            next = node->next;
+            data = (DeviceCommunication *) node->data;
+            if (!device_communication_filter_may_match(&filter, data->types)) continue;
+            records += domus_propagate_message_logic(data, &out_message, in_message_type, handler, context);
+            if (records > 0 && id != DEVICE_MESSAGE_TO_ALL_DEVICES) return records;
+        }
+    }
+
+    return records;
+}
+
+static size_t domus_propagate_message_logic(DeviceCommunication *device_communication,
+                                            const DeviceCommunicationMessage *out_message, size_t in_message_type,
+                                            DomusRecordHandler handler, void *context) {
+    DeviceCommunicationMessage in_message;
+    size_t records = 0;
+    if (!device_check_control_device(domus)) return 0;
+    if (!control_device_has_devices(domus)) return 0;
+    if (device_communication == NULL || out_message == NULL || handler == NULL) return 0;
+
+    if ((in_message = device_communication_write_message_with_ack(device_communication, out_message)).type ==
+        in_message_type) {
+        /* Skip records only close a stream filtered by a Control Device */
+        if (!in_message.flag_skip) {
+            handler(&in_message, context);
+            records++;
+        }
+
+        while (in_message.flag_continue) {
+            in_message = device_communication_write_message_with_ack_silent(device_communication, out_message);
+            if (!in_message.flag_skip) {
+                handler(&in_message, context);
+                records++;
+            }
+        }
+
+        /* Delete only if type is TERMINATE & is directly connected */
+        if (in_message.type == MESSAGE_TYPE_TERMINATE &&
+            device_communication_device_is_directly_connected(&in_message)) {
+            device_communication_close_communication(device_communication);
+            list_remove(domus->devices, device_communication);
+        }
+    }
+
+    return records;
+}
+
+static void domus_record_collect(const DeviceCommunicationMessage *message, void *context) {
+    list_add_first((List *) context, device_communication_message_copy(message));
+}
+
+bool domus_del_by_id(size_t id) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    DeviceDescriptor *device_descriptor;
+    bool toRtn;
+    Stopwatch start = stopwatch_now();
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    message_list = domus_propagate_message(id, MESSAGE_TYPE_TERMINATE, "", MESSAGE_TYPE_TERMINATE);
+    domus_batch_invalidate();
+
+    list_for_each(data, message_list) {
+        if (data->type == MESSAGE_TYPE_TERMINATE) {
+            device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+            if (device_descriptor == NULL) {
+                println_color(COLOR_RED, "\tDeletion Command: Device with unknown Device Descriptor id %ld",
+                              data->id_device_descriptor);
+            }
+
+            println_color(COLOR_GREEN,
+                          "\t%s with id %ld has been deleted",
+                          (device_descriptor == NULL) ? "?" : device_descriptor->name,
+                          data->id_sender);
+        }
+    }
+
+    (list_is_empty(message_list)) ? (toRtn = false) : (toRtn = true);
+    domus_metrics_operation(DOMUS_METRICS_OPERATION_DEL, start, toRtn);
+    if (toRtn) {
+        domus_journal_append(DOMUS_JOURNAL_ENTRY_DEL,
+                             (id == DEVICE_MESSAGE_TO_ALL_DEVICES) ? DOMUS_JOURNAL_ALL : id, 0, NULL);
+    }
+
+    free_list(message_list);
+
+    return toRtn;
+}
+
+bool domus_del_all(void) {
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    return domus_del_by_id(DEVICE_MESSAGE_TO_ALL_DEVICES);
 }
 
 static void device_table_print_divider(void) {
@@ -267,236 +956,1369 @@ static void device_table_print_divider(void) {
     println("");
 }
 
-bool domus_info_by_id(size_t id) {
-    List *message_list;
+static void domus_output_device(const DeviceCommunicationMessage *message) {
+    const DeviceDescriptor *device_descriptor = device_is_supported_by_id(message->id_device_descriptor);
+
+    output_long("id", (long) message->id_sender);
+    output_string("type", (device_descriptor == NULL) ? NULL : device_descriptor->name);
+    output_string("name", message->device_name);
+}
+
+static void domus_output_field(const char *key, const char *field, int type) {
+    ConverterResult result;
+
+    if (field == NULL) {
+        output_null(key);
+        return;
+    }
+
+    switch (type) {
+        case OUTPUT_FIELD_TYPE_BOOL: {
+            result = converter_char_to_bool(field[0]);
+            (result.error) ? output_null(key) : output_bool(key, result.data.Bool);
+            break;
+        }
+        case OUTPUT_FIELD_TYPE_LONG: {
+            result = converter_string_to_long(field);
+            (result.error) ? output_null(key) : output_long(key, result.data.Long);
+            break;
+        }
+        case OUTPUT_FIELD_TYPE_DOUBLE: {
+            result = converter_string_to_double(field);
+            (result.error) ? output_null(key) : output_double(key, result.data.Double);
+            break;
+        }
+        default: {
+            output_string(key, field);
+            break;
+        }
+    }
+}
+
+static void domus_info_output(const List *message_list) {
     DeviceCommunicationMessage *data;
-    DeviceDescriptor *device_descriptor;
+
+    output_begin();
+
+    list_for_each(data, message_list) {
+        output_record();
+        domus_info_output_fields(data);
+    }
+
+    output_end();
+}
+
+static void domus_info_output_fields(const DeviceCommunicationMessage *message) {
     char **fields;
-    bool device_state;
-    const char *color;
-    bool toRtn;
+    size_t size;
+
+    fields = device_communication_split_message_fields(message->message);
+    for (size = 0; fields != NULL && fields[size] != NULL; ++size);
+
+    domus_output_device(message);
+    output_bool("override", message->override);
+    domus_output_field("state", (size > 0) ? fields[0] : NULL, OUTPUT_FIELD_TYPE_BOOL);
+
+    switch (message->id_device_descriptor) {
+        case DEVICE_TYPE_BULB: {
+            domus_output_field("active_time", (size > 1) ? fields[1] : NULL, OUTPUT_FIELD_TYPE_DOUBLE);
+            domus_output_field("switch_turn", (size > 2) ? fields[2] : NULL, OUTPUT_FIELD_TYPE_BOOL);
+            break;
+        }
+        case DEVICE_TYPE_WINDOW: {
+            domus_output_field("open_time", (size > 1) ? fields[1] : NULL, OUTPUT_FIELD_TYPE_DOUBLE);
+            domus_output_field("switch_open", (size > 2) ? fields[2] : NULL, OUTPUT_FIELD_TYPE_BOOL);
+            break;
+        }
+        case DEVICE_TYPE_FRIDGE: {
+            domus_output_field("open_time", (size > 1) ? fields[1] : NULL, OUTPUT_FIELD_TYPE_DOUBLE);
+            domus_output_field("delay_time", (size > 2) ? fields[2] : NULL, OUTPUT_FIELD_TYPE_LONG);
+            domus_output_field("filling", (size > 3) ? fields[3] : NULL, OUTPUT_FIELD_TYPE_DOUBLE);
+            domus_output_field("temperature", (size > 4) ? fields[4] : NULL, OUTPUT_FIELD_TYPE_DOUBLE);
+            domus_output_field("switch_door", (size > 5) ? fields[5] : NULL, OUTPUT_FIELD_TYPE_BOOL);
+            break;
+        }
+        case DEVICE_TYPE_CONTROLLER: {
+            domus_output_field("connected_devices", (size > 1) ? fields[1] : NULL, OUTPUT_FIELD_TYPE_LONG);
+            break;
+        }
+        case DEVICE_TYPE_TIMER: {
+            domus_output_field("start", (size > 1 && strcmp(fields[1], "NOT SET") != 0) ? fields[1] : NULL,
+                               OUTPUT_FIELD_TYPE_STRING);
+            domus_output_field("end", (size > 2 && strcmp(fields[2], "NOT SET") != 0) ? fields[2] : NULL,
+                               OUTPUT_FIELD_TYPE_STRING);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    device_communication_free_message_fields(fields);
+}
+
+List *domus_info_list(size_t id) {
+    List *message_list = NULL;
+
+    if (device_check_control_device(domus) && control_device_has_devices(domus))
+        message_list = domus_info_messages(id, NULL);
+
+    return (message_list == NULL) ? new_list(NULL, NULL) : message_list;
+}
+
+bool domus_info_by_id(size_t id) {
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    return domus_info_print(id, NULL);
+}
+
+bool domus_info_filter(size_t id, const DeviceCommunicationFilter *filter) {
     if (!device_check_control_device(domus)) return false;
     if (!control_device_has_devices(domus)) return false;
 
-    message_list = domus_propagate_message(id, MESSAGE_TYPE_INFO, "", MESSAGE_TYPE_INFO);
+    return domus_info_print(id, filter);
+}
 
-    if (!list_is_empty(message_list)) {
-        device_print_legend();
-        println("");
-        println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %-*s | %-*s | ",
-                      sizeof(size_t) + 1, "ID",
-                      DEVICE_NAME_LENGTH, "TYPE",
-                      DEVICE_NAME_LENGTH, "NAME",
-                      DEVICE_STATE_LENGTH, "OVERRIDE",
-                      DEVICE_STATE_LENGTH, "STATE");
+static bool domus_info_print(size_t id, const DeviceCommunicationFilter *filter) {
+    size_t rows = 0;
+
+    /* Other formats need every record, util_output collects them */
+    if (output_format() != OUTPUT_FORMAT_TABLE) output_begin();
+
+    domus_info_each(id, filter, domus_info_print_row, &rows);
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) (rows > 0) ? output_end() : output_discard();
+
+    return rows > 0;
+}
+
+static void domus_info_print_row(const DeviceCommunicationMessage *message, void *context) {
+    size_t *rows = (size_t *) context;
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) {
+        output_record();
+        domus_info_output_fields(message);
+    } else {
+        /* The Command output is buffered, every row is written as soon as it is printed */
+        printer_buffer_begin();
+        if (*rows == 0) domus_info_print_header();
+        domus_info_print_record(message);
+        printer_buffer_end();
     }
 
-    list_for_each(data, message_list) {
-        device_table_print_divider();
-        device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
-        if (device_descriptor == NULL) {
-            println_color(COLOR_RED, "\tInfo Command: Device with unknown Device Descriptor id %ld",
-                          data->id_device_descriptor);
-        }
+    (*rows)++;
+}
 
-        fields = device_communication_split_message_fields(data->message);
-        device_state = converter_char_to_bool(fields[0][0]).data.Bool;
-        color = COLOR_WHITE;
+static void domus_info_print_header(void) {
+    device_print_legend();
+    println("");
+    println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %-*s | %-*s | ",
+                  sizeof(size_t) + 1, "ID",
+                  DEVICE_NAME_LENGTH, "TYPE",
+                  DEVICE_NAME_LENGTH, "NAME",
+                  DEVICE_STATE_LENGTH, "OVERRIDE",
+                  DEVICE_STATE_LENGTH, "STATE");
+}
 
-        if (device_descriptor != NULL) {
-            switch (device_descriptor->id) {
-                case DEVICE_TYPE_CONTROLLER:
-                case DEVICE_TYPE_DOMUS: {
-                    color = COLOR_CYAN;
-                    break;
-                }
-                default: {
-                    if (device_descriptor->control_device) color = COLOR_YELLOW;
-                    break;
-                }
-            }
-        }
+static void domus_info_print_record(const DeviceCommunicationMessage *data) {
+    DeviceDescriptor *device_descriptor;
+    char **fields;
+    bool device_state;
+    const char *color;
 
-        print("\t%-*ld | ",
-              sizeof(size_t) + 1, data->id_sender);
-        print_color(color, "%-*s", DEVICE_NAME_LENGTH, (device_descriptor == NULL) ? "?" : device_descriptor->name);
-        print(" | %-*s | %-*s | ", DEVICE_NAME_LENGTH, data->device_name, DEVICE_STATE_LENGTH,
-              (data->override) ? "yes" : "no");
+    device_table_print_divider();
+    device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+    if (device_descriptor == NULL) {
+        println_color(COLOR_RED, "\tInfo Command: Device with unknown Device Descriptor id %ld",
+                      data->id_device_descriptor);
+    }
 
-        switch (data->id_device_descriptor) {
-            case DEVICE_TYPE_BULB: {
-                bool bulb_switch_state = converter_char_to_bool(fields[2][0]).data.Bool;
+    fields = device_communication_split_message_fields(data->message);
+    device_state = converter_char_to_bool(fields[0][0]).data.Bool;
+    color = COLOR_WHITE;
 
-                println("%-*s | %-*s: %-*s | %-*s: %s",
-                        DEVICE_STATE_LENGTH, (device_state) ? "on" : "off",
-                        DEVICE_STATE_LENGTH, "ACTIVE_TIME(s)",
-                        sizeof(double) + 1, fields[1],
-                        DEVICE_STATE_LENGTH, "SWITCH_TURN",
-                        (bulb_switch_state) ? "on" : "off");
-                break;
-            }
-            case DEVICE_TYPE_WINDOW : {
-                bool window_switch_state = converter_char_to_bool(fields[2][0]).data.Bool;
-
-                println("%-*s | %-*s: %-*s | %-*s: %s",
-                        DEVICE_STATE_LENGTH, (device_state) ? "open" : "close",
-                        DEVICE_STATE_LENGTH, "OPEN_TIME(s)",
-                        sizeof(double) + 1, fields[1],
-                        DEVICE_STATE_LENGTH, "SWITCH_OPEN",
-                        (window_switch_state) ? "on" : "off");
-                break;
-            }
-            case DEVICE_TYPE_FRIDGE: {
-                bool fridge_door_switch_state = converter_char_to_bool(fields[5][0]).data.Bool;
-
-                println("%-*s | %-*s: %-*s | %-*s: %-*s | %-*s: %-*s | %-*s: %-*s | %-*s: %s",
-                        DEVICE_STATE_LENGTH, (fridge_door_switch_state) ? "open" : "close",
-                        DEVICE_STATE_LENGTH, "SWITCH_STATE",
-                        sizeof(double) + 1, (device_state) ? "on" : "off",
-                        DEVICE_STATE_LENGTH, "OPEN_TIME(s)",
-                        sizeof(double) + 1, fields[1],
-                        DEVICE_STATE_LENGTH, "DELAY_TIME(s)",
-                        sizeof(double) + 1, fields[2],
-                        DEVICE_STATE_LENGTH, "FILLING(%)",
-                        sizeof(double) + 1, fields[3],
-                        DEVICE_STATE_LENGTH, "TEMP(C°)",
-                        fields[4]);
-                break;
-            }
-            case DEVICE_TYPE_CONTROLLER: {
-                println("%-*s | %-*s: %s",
-                        DEVICE_STATE_LENGTH, (device_state) ? "on" : "off",
-                        DEVICE_STATE_LENGTH, "DIR_CONN_DEV",
-                        fields[1]);
-                break;
-            }
-            case DEVICE_TYPE_HUB: {
-                println("%-*s |",
-                        DEVICE_STATE_LENGTH, (device_state) ? "on" : "off");
-                break;
-            }
-            case DEVICE_TYPE_TIMER: {
-                println("%-*s | %-*s: %-*s | %-*s: %-*s",
-                        DEVICE_STATE_LENGTH, (device_state) ? "on" : "off",
-                        DEVICE_STATE_LENGTH, "START_TIME",
-                        sizeof(double) + 1, fields[1],
-                        DEVICE_STATE_LENGTH, "END_TIME",
-                        sizeof(double) + 1, fields[2]);
+    if (device_descriptor != NULL) {
+        switch (device_descriptor->id) {
+            case DEVICE_TYPE_CONTROLLER:
+            case DEVICE_TYPE_DOMUS: {
+                color = COLOR_CYAN;
                 break;
             }
             default: {
-                println_color(COLOR_RED, "Unknown Device");
+                if (device_descriptor->control_device) color = COLOR_YELLOW;
                 break;
             }
         }
+    }
+
+    print("\t%-*ld | ",
+          sizeof(size_t) + 1, data->id_sender);
+    print_color(color, "%-*s", DEVICE_NAME_LENGTH, (device_descriptor == NULL) ? "?" : device_descriptor->name);
+    print(" | %-*s | %-*s | ", DEVICE_NAME_LENGTH, data->device_name, DEVICE_STATE_LENGTH,
+          (data->override) ? "yes" : "no");
+
+    switch (data->id_device_descriptor) {
+        case DEVICE_TYPE_BULB: {
+            bool bulb_switch_state = converter_char_to_bool(fields[2][0]).data.Bool;
+
+            println("%-*s | %-*s: %-*s | %-*s: %s",
+                    DEVICE_STATE_LENGTH, (device_state) ? "on" : "off",
+                    DEVICE_STATE_LENGTH, "ACTIVE_TIME(s)",
+                    sizeof(double) + 1, fields[1],
+                    DEVICE_STATE_LENGTH, "SWITCH_TURN",
+                    (bulb_switch_state) ? "on" : "off");
+            break;
+        }
+        case DEVICE_TYPE_WINDOW : {
+            bool window_switch_state = converter_char_to_bool(fields[2][0]).data.Bool;
+
+            println("%-*s | %-*s: %-*s | %-*s: %s",
+                    DEVICE_STATE_LENGTH, (device_state) ? "open" : "close",
+                    DEVICE_STATE_LENGTH, "OPEN_TIME(s)",
+                    sizeof(double) + 1, fields[1],
+                    DEVICE_STATE_LENGTH, "SWITCH_OPEN",
+                    (window_switch_state) ? "on" : "off");
+            break;
+        }
+        case DEVICE_TYPE_FRIDGE: {
+            bool fridge_door_switch_state = converter_char_to_bool(fields[5][0]).data.Bool;
+
+            println("%-*s | %-*s: %-*s | %-*s: %-*s | %-*s: %-*s | %-*s: %-*s | %-*s: %s",
+                    DEVICE_STATE_LENGTH, (fridge_door_switch_state) ? "open" : "close",
+                    DEVICE_STATE_LENGTH, "SWITCH_STATE",
+                    sizeof(double) + 1, (device_state) ? "on" : "off",
+                    DEVICE_STATE_LENGTH, "OPEN_TIME(s)",
+                    sizeof(double) + 1, fields[1],
+                    DEVICE_STATE_LENGTH, "DELAY_TIME(s)",
+                    sizeof(double) + 1, fields[2],
+                    DEVICE_STATE_LENGTH, "FILLING(%)",
+                    sizeof(double) + 1, fields[3],
+                    DEVICE_STATE_LENGTH, "TEMP(C°)",
+                    fields[4]);
+            break;
+        }
+        case DEVICE_TYPE_CONTROLLER: {
+            println("%-*s | %-*s: %s",
+                    DEVICE_STATE_LENGTH, (device_state) ? "on" : "off",
+                    DEVICE_STATE_LENGTH, "DIR_CONN_DEV",
+                    fields[1]);
+            break;
+        }
+        case DEVICE_TYPE_HUB: {
+            println("%-*s |",
+                    DEVICE_STATE_LENGTH, (device_state) ? "on" : "off");
+            break;
+        }
+        case DEVICE_TYPE_TIMER: {
+            println("%-*s | %-*s: %-*s | %-*s: %-*s",
+                    DEVICE_STATE_LENGTH, (device_state) ? "on" : "off",
+                    DEVICE_STATE_LENGTH, "START_TIME",
+                    sizeof(double) + 1, fields[1],
+                    DEVICE_STATE_LENGTH, "END_TIME",
+                    sizeof(double) + 1, fields[2]);
+            break;
+        }
+        default: {
+            println_color(COLOR_RED, "Unknown Device");
+            break;
+        }
+    }
+
+    device_communication_free_message_fields(fields);
+}
+
+bool domus_info_all(void) {
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    return domus_info_by_id(DEVICE_MESSAGE_TO_ALL_DEVICES);
+}
+
+DomusWalk *domus_walk_start(size_t id, const DeviceCommunicationFilter *filter) {
+    DomusWalk *walk;
+    DeviceCommunication *data;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    if (!device_check_control_device(domus)) return NULL;
+    if (!control_device_has_devices(domus)) return NULL;
+
+    walk = (DomusWalk *) malloc(sizeof(DomusWalk));
+    if (walk == NULL) {
+        perror("Domus Walk Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+    walk->pids = (pid_t *) malloc(sizeof(pid_t) * domus->devices->size);
+    if (walk->pids == NULL) {
+        perror("Domus Walk Pids Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    walk->id = id;
+    if (filter == NULL) device_communication_filter_init(&walk->filter);
+    else walk->filter = *filter;
+    device_communication_filter_to_message(&walk->filter, out_message_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+    device_communication_message_init(domus->device, &walk->out_message);
+    device_communication_message_modify(&walk->out_message, id, MESSAGE_TYPE_INFO, out_message_message);
+    if (id == DEVICE_MESSAGE_TO_ALL_DEVICES) walk->out_message.flag_force = true;
+
+    /* Devices added meanwhile are not asked, Devices deleted meanwhile are skipped */
+    walk->count = 0;
+    list_for_each(data, domus->devices) {
+        walk->pids[walk->count++] = data->pid;
+    }
+    walk->next = 0;
+    walk->current = NULL;
+    walk->first = false;
+    walk->sent = 0;
+    walk->done = false;
+    walk->cancelled = false;
+    walk->format = output_format();
+    walk->records = 0;
+    walk->collected = new_list(NULL, NULL);
+
+    if (domus_walks == NULL) domus_walks = new_list(NULL, NULL);
+    list_add_last(domus_walks, walk);
+
+    return walk;
+}
+
+int domus_walk_step(DomusWalk *walk, bool wait) {
+    DeviceCommunicationMessage in_message;
+    struct pollfd input;
+    if (walk == NULL || walk->done) return DOMUS_WALK_DONE;
+    if (walk->current == NULL && domus_walk_ask(walk) == DOMUS_WALK_DONE) return DOMUS_WALK_DONE;
+    if (walk->current == NULL) return DOMUS_WALK_PENDING;
+
+    if (!wait) {
+        input.fd = walk->current->com_read;
+        input.events = POLLIN;
+        if (poll(&input, 1, 0) <= 0) return DOMUS_WALK_PENDING;
+    }
+
+    in_message = device_communication_read_message(walk->current);
+    if (walk->first) {
+        walk->first = false;
+        device_communication_stats_record(MESSAGE_TYPE_INFO, stopwatch_elapsed(walk->sent), &in_message);
+        /* The Device is not in this subtree */
+        if (in_message.type != MESSAGE_TYPE_INFO) {
+            walk->current = NULL;
+            return DOMUS_WALK_PENDING;
+        }
+    }
+
+    if (!in_message.flag_skip && !walk->cancelled &&
+        device_communication_filter_match_message(&walk->filter, &in_message))
+        domus_walk_record(walk, &in_message);
+
+    if (in_message.flag_continue) {
+        /* The ack asks for the next record */
+        device_communication_write_message(walk->current, &walk->out_message);
+    } else {
+        walk->current = NULL;
+        /* Only one subtree contains the Device */
+        if (walk->id != DEVICE_MESSAGE_TO_ALL_DEVICES) walk->done = true;
+    }
+
+    return DOMUS_WALK_RECORD;
+}
+
+int domus_walk_descriptor(const DomusWalk *walk) {
+    if (walk == NULL || walk->current == NULL) return -1;
+
+    return walk->current->com_read;
+}
+
+void domus_walk_cancel(DomusWalk *walk) {
+    if (walk == NULL) return;
+
+    walk->cancelled = true;
+}
+
+size_t domus_walk_end(DomusWalk *walk) {
+    Node *node;
+    size_t index = 0;
+    size_t records;
+    int previous_format;
+    if (walk == NULL) return 0;
+
+    /* The Device answering waits for the acks of its remaining records */
+    while (walk->current != NULL) domus_walk_step(walk, true);
+
+    for (node = domus_walks->head; node != NULL && node->data != walk; node = node->next) index++;
+    if (node != NULL) list_remove_index(domus_walks, index);
+
+    if (!walk->cancelled && !list_is_empty(walk->collected)) {
+        previous_format = output_set_command_format(walk->format);
+        domus_info_output(walk->collected);
+        output_set_command_format(previous_format);
+    }
+
+    records = walk->records;
+    free_list(walk->collected);
+    free(walk->pids);
+    free(walk);
+
+    return records;
+}
+
+static int domus_walk_ask(DomusWalk *walk) {
+    DeviceCommunication *data;
+    Node *node;
+
+    while (!walk->cancelled && walk->next < walk->count) {
+        for (node = domus->devices->head; node != NULL; node = node->next) {
+            if (((DeviceCommunication *) node->data)->pid == walk->pids[walk->next]) break;
+        }
+
+        data = (node == NULL) ? NULL : (DeviceCommunication *) node->data;
+        if (data == NULL || !device_communication_filter_may_match(&walk->filter, data->types)) {
+            walk->next++;
+            continue;
+        }
+        if (domus_walk_is_reading(data)) return DOMUS_WALK_PENDING;
+
+        walk->next++;
+        walk->current = data;
+        walk->first = true;
+        walk->sent = stopwatch_now();
+        device_communication_trace_forward();
+        device_communication_write_message_notify(data, &walk->out_message);
+        return DOMUS_WALK_PENDING;
+    }
+
+    walk->done = true;
+    return DOMUS_WALK_DONE;
+}
+
+static bool domus_walk_is_reading(const DeviceCommunication *device_communication) {
+    DomusWalk *data;
+
+    list_for_each(data, domus_walks) {
+        if (data->current == device_communication) return true;
+    }
+
+    return false;
+}
+
+static void domus_walk_record(DomusWalk *walk, const DeviceCommunicationMessage *message) {
+    if (walk->format != OUTPUT_FORMAT_TABLE) {
+        /* Same order as the records of a single propagation */
+        list_add_first(walk->collected, device_communication_message_copy(message));
+    } else {
+        if (walk->records == 0) domus_info_print_header();
+        domus_info_print_record(message);
+    }
+
+    walk->records++;
+}
+
+bool domus_aggregate(size_t id, const DeviceCommunicationFilter *filter) {
+    List *aggregates;
+    List *message_list;
+    DeviceCommunication *data;
+    DeviceCommunicationMessage *message;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationMessage in_message;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    aggregates = new_list(NULL, NULL);
+
+    if (domus_batch && domus_batch_snapshot != NULL) {
+        /* The records are already here, fold them locally */
+        message_list = domus_snapshot_subtree(domus_batch_snapshot, id);
+        list_for_each(message, message_list) {
+            device_communication_aggregate_add_message(aggregates, filter, message);
+        }
+        free_list(message_list);
+
+        return domus_aggregate_print(aggregates);
+    }
+
+    device_communication_filter_to_message(filter, out_message_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+    device_communication_message_init(domus->device, &out_message);
+    device_communication_message_modify(&out_message, id, MESSAGE_TYPE_AGGREGATE, "%s", out_message_message);
+    if (id == DEVICE_MESSAGE_TO_ALL_DEVICES) out_message.flag_force = true;
+
+    list_for_each(data, domus->devices) {
+        if (!device_communication_filter_may_match(filter, data->types)) continue;
+
+        in_message = device_communication_write_message_with_ack(data, &out_message);
+        /* Devices directly connected to Domus answer with their info record */
+        device_communication_aggregate_add_message(aggregates, filter, &in_message);
+        while (in_message.flag_continue) {
+            in_message = device_communication_write_message_with_ack_silent(data, &out_message);
+            device_communication_aggregate_add_message(aggregates, filter, &in_message);
+        }
+
+        if (id != DEVICE_MESSAGE_TO_ALL_DEVICES && in_message.type == MESSAGE_TYPE_AGGREGATE) break;
+    }
+
+    return domus_aggregate_print(aggregates);
+}
+
+static bool domus_aggregate_print(List *aggregates) {
+    DeviceCommunicationAggregate *data;
+    const DeviceDescriptor *device_descriptor;
+    char key[OUTPUT_KEY_LENGTH];
+    size_t i;
+    bool toRtn;
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) {
+        if (!list_is_empty(aggregates)) {
+            output_begin();
+            list_for_each(data, aggregates) {
+                device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+
+                output_record();
+                output_string("type", (device_descriptor == NULL) ? NULL : device_descriptor->name);
+                output_bool("state", data->state);
+                output_long("count", (long) data->count);
+                for (i = 0; i < data->metrics; ++i) {
+                    const char *name = device_communication_aggregate_metric_name(data->id_device_descriptor, i);
+
+                    snprintf(key, OUTPUT_KEY_LENGTH, "%s_sum", name);
+                    output_double(key, data->metric[i].sum);
+                    snprintf(key, OUTPUT_KEY_LENGTH, "%s_min", name);
+                    output_double(key, data->metric[i].min);
+                    snprintf(key, OUTPUT_KEY_LENGTH, "%s_max", name);
+                    output_double(key, data->metric[i].max);
+                    snprintf(key, OUTPUT_KEY_LENGTH, "%s_avg", name);
+                    output_double(key, data->metric[i].sum / data->count);
+                }
+            }
+            output_end();
+        }
+        toRtn = !list_is_empty(aggregates);
+        free_list(aggregates);
+        return toRtn;
+    }
+
+    if (!list_is_empty(aggregates)) {
+        println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %-*s | %-*s | %-*s | %-*s | %-*s",
+                      DEVICE_NAME_LENGTH, "TYPE",
+                      5, "STATE",
+                      6, "COUNT",
+                      DEVICE_COMMUNICATION_AGGREGATE_METRIC_NAME_LENGTH, "METRIC",
+                      12, "SUM",
+                      12, "MIN",
+                      12, "MAX",
+                      12, "AVG");
+    }
+
+    list_for_each(data, aggregates) {
+        device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+
+        print("\t%-*s | %-*s | %-*ld | ",
+              DEVICE_NAME_LENGTH, (device_descriptor == NULL) ? "?" : device_descriptor->name,
+              5, (data->state) ? "on" : "off",
+              6, data->count);
+
+        if (data->metrics == 0) {
+            println("%-*s |", DEVICE_COMMUNICATION_AGGREGATE_METRIC_NAME_LENGTH, "-");
+        }
+        for (i = 0; i < data->metrics; ++i) {
+            if (i > 0) print("\t%-*s | %-*s | %-*s | ", DEVICE_NAME_LENGTH, "", 5, "", 6, "");
+            println("%-*s | %-*.3lf | %-*.3lf | %-*.3lf | %-*.3lf",
+                    DEVICE_COMMUNICATION_AGGREGATE_METRIC_NAME_LENGTH,
+                    device_communication_aggregate_metric_name(data->id_device_descriptor, i),
+                    12, data->metric[i].sum,
+                    12, data->metric[i].min,
+                    12, data->metric[i].max,
+                    12, data->metric[i].sum / data->count);
+        }
+    }
+
+    toRtn = !list_is_empty(aggregates);
+    free_list(aggregates);
+
+    return toRtn;
+}
+
+bool domus_resources(size_t id, const DeviceCommunicationFilter *filter, bool sort_by_cpu) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    DomusResourcesRow *rows;
+    pid_t *pids;
+    ProcessResources *resources;
+    size_t count;
+    size_t i;
+    if (!device_check_control_device(domus)) return false;
+    if (!control_device_has_devices(domus)) return false;
+
+    message_list = domus_info_messages(id, filter);
+    if (list_is_empty(message_list)) {
+        free_list(message_list);
+        return false;
+    }
+
+    count = message_list->size;
+    rows = (DomusResourcesRow *) malloc(sizeof(DomusResourcesRow) * count);
+    pids = (pid_t *) malloc(sizeof(pid_t) * count);
+    resources = (ProcessResources *) malloc(sizeof(ProcessResources) * count);
+    if (rows == NULL || pids == NULL || resources == NULL) {
+        perror("Domus Resources Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    i = 0;
+    list_for_each(data, message_list) {
+        rows[i].message = data;
+        pids[i++] = data->pid_sender;
+    }
+
+    process_resources_sample_all(pids, count, resources);
+    for (i = 0; i < count; ++i) rows[i].resources = resources[i];
+    if (sort_by_cpu) qsort(rows, count, sizeof(DomusResourcesRow), domus_resources_compare);
+
+    domus_resources_print(rows, count);
+
+    free(resources);
+    free(pids);
+    free(rows);
+    free_list(message_list);
+
+    return true;
+}
+
+static int domus_resources_compare(const void *row1, const void *row2) {
+    const ProcessResources *resources1 = &((const DomusResourcesRow *) row1)->resources;
+    const ProcessResources *resources2 = &((const DomusResourcesRow *) row2)->resources;
+
+    if (resources1->cpu_percent != resources2->cpu_percent)
+        return (resources1->cpu_percent > resources2->cpu_percent) ? -1 : 1;
+    if (resources1->rss != resources2->rss) return (resources1->rss > resources2->rss) ? -1 : 1;
+    return 0;
+}
+
+static void domus_resources_print(const DomusResourcesRow *rows, size_t count) {
+    const DeviceDescriptor *device_descriptor;
+    const ProcessResources *resources;
+    unsigned long rss = 0;
+    double cpu_percent = 0;
+    size_t processes = 0;
+    size_t i;
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) {
+        output_begin();
+        for (i = 0; i < count; ++i) {
+            resources = &rows[i].resources;
+            output_record();
+            domus_info_output_fields(rows[i].message);
+            output_long("pid", (long) rows[i].message->pid_sender);
+            if (resources->pid == 0) {
+                /* The process has terminated in the meantime */
+                output_null("rss_kib");
+                output_null("cpu_time_s");
+                output_null("cpu_percent");
+                output_null("voluntary_context_switches");
+                output_null("involuntary_context_switches");
+                output_null("fds");
+                continue;
+            }
+            output_long("rss_kib", (long) resources->rss);
+            output_double("cpu_time_s", (double) resources->cpu_time / 1000000000.0);
+            output_double("cpu_percent", resources->cpu_percent);
+            output_long("voluntary_context_switches", (long) resources->voluntary_context_switches);
+            output_long("involuntary_context_switches", (long) resources->involuntary_context_switches);
+            (resources->fds < 0) ? output_null("fds") : output_long("fds", resources->fds);
+        }
+        output_end();
+        return;
+    }
+
+    println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %*s | %*s | %*s | %*s | %*s | %*s | %*s",
+                  sizeof(size_t) + 1, "ID",
+                  DEVICE_NAME_LENGTH, "TYPE",
+                  DEVICE_NAME_LENGTH, "NAME",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "PID",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "RSS(KiB)",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "CPU(s)",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "CPU(%)",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "CTX_VOL",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "CTX_INVOL",
+                  DOMUS_RESOURCES_COLUMN_LENGTH, "FDS");
+
+    for (i = 0; i < count; ++i) {
+        resources = &rows[i].resources;
+        device_descriptor = device_is_supported_by_id(rows[i].message->id_device_descriptor);
+
+        print("\t%-*ld | %-*s | %-*s | %*d | ",
+              sizeof(size_t) + 1, rows[i].message->id_sender,
+              DEVICE_NAME_LENGTH, (device_descriptor == NULL) ? "?" : device_descriptor->name,
+              DEVICE_NAME_LENGTH, rows[i].message->device_name,
+              DOMUS_RESOURCES_COLUMN_LENGTH, rows[i].message->pid_sender);
+
+        if (resources->pid == 0) {
+            println_color(COLOR_RED, "%*s", DOMUS_RESOURCES_COLUMN_LENGTH, "gone");
+            continue;
+        }
+
+        println("%*lu | %*.2f | %*.1f | %*lu | %*lu | %*ld",
+                DOMUS_RESOURCES_COLUMN_LENGTH, resources->rss,
+                DOMUS_RESOURCES_COLUMN_LENGTH, (double) resources->cpu_time / 1000000000.0,
+                DOMUS_RESOURCES_COLUMN_LENGTH, resources->cpu_percent,
+                DOMUS_RESOURCES_COLUMN_LENGTH, resources->voluntary_context_switches,
+                DOMUS_RESOURCES_COLUMN_LENGTH, resources->involuntary_context_switches,
+                DOMUS_RESOURCES_COLUMN_LENGTH, resources->fds);
+
+        rss += resources->rss;
+        cpu_percent += resources->cpu_percent;
+        processes++;
+    }
+
+    println_color(COLOR_BOLD, "\t%ld processes, %lu KiB resident, %.1f%% CPU", processes, rss, cpu_percent);
+}
+
+bool domus_stats(size_t id) {
+    DeviceCommunication *data;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationMessage in_message;
+    DeviceCommunicationFilter filter;
+    DeviceCommunicationStats *stats;
+    if (!device_check_control_device(domus)) return false;
+
+    stats = new_device_communication_stats();
+    if (id == DEVICE_MESSAGE_TO_ALL_DEVICES) device_communication_stats_merge(stats, device_communication_stats());
+
+    device_communication_filter_init(&filter);
+    filter.types = DEVICE_COMMUNICATION_STATS_DEVICE_TYPES;
+    device_communication_message_init(domus->device, &out_message);
+    device_communication_message_modify(&out_message, id, MESSAGE_TYPE_STATS, "");
+    if (id == DEVICE_MESSAGE_TO_ALL_DEVICES) out_message.flag_force = true;
+
+    list_for_each(data, domus->devices) {
+        if (!device_communication_filter_may_match(&filter, data->types)) continue;
+
+        in_message = device_communication_write_message_with_ack(data, &out_message);
+        device_communication_stats_add_message(stats, &in_message);
+        while (in_message.flag_continue) {
+            in_message = device_communication_write_message_with_ack_silent(data, &out_message);
+            device_communication_stats_add_message(stats, &in_message);
+        }
+
+        if (id != DEVICE_MESSAGE_TO_ALL_DEVICES && in_message.type == MESSAGE_TYPE_STATS) break;
+    }
+
+    return domus_stats_print(stats);
+}
+
+static bool domus_stats_print(DeviceCommunicationStats *stats) {
+    const DeviceCommunicationStatsHistogram *histogram;
+    const char *name;
+    bool toRtn = false;
+    size_t i;
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) output_begin();
+
+    for (i = 0; i < DEVICE_COMMUNICATION_STATS_TYPES; ++i) {
+        histogram = &stats->histogram[i];
+        if (histogram->count == 0) continue;
+        name = device_communication_stats_type_name(device_communication_stats_type(i));
+
+        if (output_format() != OUTPUT_FORMAT_TABLE) {
+            output_record();
+            output_string("type", name);
+            output_long("count", (long) histogram->count);
+            output_long("errors", (long) histogram->errors);
+            output_double("p50_us", device_communication_stats_percentile(histogram, 50) / 1000.0);
+            output_double("p90_us", device_communication_stats_percentile(histogram, 90) / 1000.0);
+            output_double("p99_us", device_communication_stats_percentile(histogram, 99) / 1000.0);
+            output_double("max_us", histogram->max / 1000.0);
+        } else {
+            if (!toRtn) {
+                println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %-*s | %-*s | %-*s | %-*s",
+                              DEVICE_COMMUNICATION_STATS_TYPE_NAME_LENGTH, "TYPE",
+                              8, "COUNT",
+                              8, "ERRORS",
+                              12, "P50(us)",
+                              12, "P90(us)",
+                              12, "P99(us)",
+                              12, "MAX(us)");
+            }
+            println("\t%-*s | %-*ld | %-*ld | %-*.1lf | %-*.1lf | %-*.1lf | %-*.1lf",
+                    DEVICE_COMMUNICATION_STATS_TYPE_NAME_LENGTH, (name == NULL) ? "?" : name,
+                    8, histogram->count,
+                    8, histogram->errors,
+                    12, device_communication_stats_percentile(histogram, 50) / 1000.0,
+                    12, device_communication_stats_percentile(histogram, 90) / 1000.0,
+                    12, device_communication_stats_percentile(histogram, 99) / 1000.0,
+                    12, histogram->max / 1000.0);
+        }
+        toRtn = true;
+    }
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) output_end();
+
+    free(stats);
+    return toRtn;
+}
+
+size_t domus_trace_begin(void) {
+    size_t trace_id = device_communication_trace_new_id();
+
+    device_communication_trace_begin(trace_id, DOMUS_ID, DEVICE_TYPE_DOMUS, MESSAGE_TYPE_NO_MESSAGE);
+    return trace_id;
+}
+
+bool domus_trace_end(size_t trace_id, const char *name, const char *export_file_name) {
+    List *spans;
+    bool toRtn = true;
+
+    device_communication_trace_end();
+    spans = domus_trace_spans(trace_id);
+
+    domus_trace_print(spans, name);
+    if (export_file_name != NULL) toRtn = domus_trace_export(spans, name, export_file_name);
+
+    free_list(spans);
+    return toRtn;
+}
+
+static void domus_trace_add(List *spans, const DeviceCommunicationTraceSpan *span) {
+    DeviceCommunicationTraceSpan *data;
+    size_t index = 0;
+
+    list_for_each(data, spans) {
+        if (data->arrival > span->arrival) break;
+        index++;
+    }
+
+    data = (DeviceCommunicationTraceSpan *) malloc(sizeof(DeviceCommunicationTraceSpan));
+    if (data == NULL) {
+        perror("Domus Trace Span Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    *data = *span;
+    list_add(spans, index, data);
+}
+
+static List *domus_trace_spans(size_t trace_id) {
+    List *spans;
+    DeviceCommunication *data;
+    DeviceCommunicationMessage out_message;
+    DeviceCommunicationMessage in_message;
+    DeviceCommunicationTraceSpan span;
+    const DeviceCommunicationTraceSpan *own_span;
+    DeviceCommunicationTraceSpan *span_data;
+    Stopwatch open[DOMUS_TRACE_DEPTH_MAX];
+    Node *node;
+    size_t depth = 0;
+    size_t cursor = 0;
+
+    spans = new_list(NULL, NULL);
+    while ((own_span = device_communication_trace_next(trace_id, &cursor)) != NULL) domus_trace_add(spans, own_span);
+    if (!device_check_control_device(domus)) return spans;
+
+    device_communication_message_init(domus->device, &out_message);
+    device_communication_message_modify(&out_message, DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_TRACE, "%lu",
+                                        trace_id);
+    out_message.flag_force = true;
+
+    list_for_each(data, domus->devices) {
+        in_message = device_communication_write_message_with_ack(data, &out_message);
+        while (true) {
+            if (device_communication_trace_span_from_message(&span, &in_message)) domus_trace_add(spans, &span);
+            if (!in_message.flag_continue) break;
+            in_message = device_communication_write_message_with_ack_silent(data, &out_message);
+        }
+    }
+
+    for (node = spans->head; node != NULL; node = node->next) {
+        span_data = (DeviceCommunicationTraceSpan *) node->data;
+        while (depth > 0 && open[depth - 1] < span_data->arrival) depth--;
+        span_data->depth = depth;
+        if (depth < DOMUS_TRACE_DEPTH_MAX) open[depth++] = span_data->reply;
+    }
+
+    return spans;
+}
+
+static const char *domus_trace_label(const DeviceCommunicationTraceSpan *span, const char *name) {
+    const char *label;
+
+    if (span->id_device == DOMUS_ID && span->type == MESSAGE_TYPE_NO_MESSAGE) return name;
+    label = device_communication_stats_type_name(span->type);
+
+    return (label == NULL) ? "?" : label;
+}
+
+static void domus_trace_print(const List *spans, const char *name) {
+    const DeviceCommunicationTraceSpan *data;
+    const DeviceCommunicationTraceSpan *root;
+    const DeviceDescriptor *device_descriptor;
+    char timeline[DOMUS_TRACE_TIMELINE_LENGTH + 1];
+    char device[DOMUS_TRACE_DEVICE_LENGTH];
+    Stopwatch total;
+    size_t from;
+    size_t forward;
+    size_t to;
+    size_t i;
+
+    if (list_is_empty(spans)) return;
+    root = (const DeviceCommunicationTraceSpan *) list_get_first(spans);
+    total = (root->reply > root->arrival) ? root->reply - root->arrival : 1;
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) {
+        output_begin();
+        list_for_each(data, spans) {
+            device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+
+            output_record();
+            output_long("depth", (long) data->depth);
+            output_long("id", (long) data->id_device);
+            output_string("device", (device_descriptor == NULL) ? NULL : device_descriptor->name);
+            output_long("pid", (long) data->pid);
+            output_string("message", domus_trace_label(data, name));
+            output_double("start_us", (data->arrival - root->arrival) / 1000.0);
+            if (data->forward == 0) output_null("forward_us");
+            else output_double("forward_us", (data->forward - root->arrival) / 1000.0);
+            output_double("total_us", (data->reply - data->arrival) / 1000.0);
+        }
+        output_end();
+        return;
+    }
+
+    println_color(COLOR_BOLD, "\tTrace %lx: %s, %.3lf ms, %ld spans", root->trace_id, name,
+                  total / STOPWATCH_NS_PER_MS, spans->size);
+    println_color(COLOR_BOLD, "\t%-*s | %-*s | %-*s | %-*s | %-*s | %-*s | %-*s",
+                  DOMUS_TRACE_DEVICE_LENGTH, "DEVICE",
+                  8, "PID",
+                  DEVICE_COMMUNICATION_STATS_TYPE_NAME_LENGTH, "MESSAGE",
+                  12, "START(us)",
+                  12, "FORWARD(us)",
+                  12, "TOTAL(us)",
+                  DOMUS_TRACE_TIMELINE_LENGTH, "TIMELINE");
+
+    list_for_each(data, spans) {
+        device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+
+        /* Handling before forwarding is drawn with '-', waiting for children with '=' */
+        from = (size_t) ((data->arrival - root->arrival) * DOMUS_TRACE_TIMELINE_LENGTH / total);
+        to = (size_t) ((data->reply - root->arrival) * DOMUS_TRACE_TIMELINE_LENGTH / total);
+        forward = (data->forward == 0) ? to : (size_t) ((data->forward - root->arrival) * DOMUS_TRACE_TIMELINE_LENGTH
+                                                        / total);
+        for (i = 0; i < DOMUS_TRACE_TIMELINE_LENGTH; ++i) {
+            timeline[i] = (i < from || i > to) ? ' ' : (data->forward == 0 || i < forward) ? '-' : '=';
+        }
+        timeline[DOMUS_TRACE_TIMELINE_LENGTH] = '\0';
+
+        snprintf(device, DOMUS_TRACE_DEVICE_LENGTH, "%*s%s %ld", (int) data->depth * 2, "",
+                 (device_descriptor == NULL) ? "?" : device_descriptor->name, data->id_device);
+        print("\t%-*s | %-*d | %-*s | %-*.1lf | ",
+              DOMUS_TRACE_DEVICE_LENGTH, device,
+              8, data->pid,
+              DEVICE_COMMUNICATION_STATS_TYPE_NAME_LENGTH, domus_trace_label(data, name),
+              12, (data->arrival - root->arrival) / 1000.0);
+        if (data->forward == 0) print("%-*s | ", 12, "-");
+        else print("%-*.1lf | ", 12, (data->forward - root->arrival) / 1000.0);
+        println("%-*.1lf | %s", 12, (data->reply - data->arrival) / 1000.0, timeline);
+    }
+}
+
+static bool domus_trace_export(const List *spans, const char *name, const char *file_name) {
+    const DeviceCommunicationTraceSpan *data;
+    const DeviceCommunicationTraceSpan *root;
+    const DeviceDescriptor *device_descriptor;
+    FILE *file;
+    bool first = true;
+
+    if ((file = fopen(file_name, "w")) == NULL) return false;
+
+    root = (const DeviceCommunicationTraceSpan *) list_get_first(spans);
+
+    /* Complete events, one process per Device */
+    fprintf(file, "{\"traceEvents\":[");
+    list_for_each(data, spans) {
+        device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+
+        fprintf(file, "%s\n{\"name\":", (first) ? "" : ",");
+        domus_trace_export_string(file, domus_trace_label(data, name));
+        fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3lf,\"dur\":%.3lf,"
+                      "\"pid\":%d,\"tid\":%d,\"args\":{\"id\":%ld,\"depth\":%ld,\"forward_us\":%.3lf}}",
+                (device_descriptor == NULL) ? "?" : device_descriptor->name,
+                (data->arrival - root->arrival) / 1000.0,
+                (data->reply - data->arrival) / 1000.0,
+                data->pid, data->pid, data->id_device, data->depth,
+                (data->forward == 0) ? 0 : (data->forward - data->arrival) / 1000.0);
+        fprintf(file, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s %ld\"}}",
+                data->pid, (device_descriptor == NULL) ? "?" : device_descriptor->name, data->id_device);
+        first = false;
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"trace_id\":\"%lx\"}}\n", root->trace_id);
+
+    return fclose(file) == 0;
+}
+
+static void domus_trace_export_string(FILE *file, const char *string) {
+    fputc('"', file);
+    for (; *string != '\0'; ++string) {
+        if (*string == '"' || *string == '\\') fputc('\\', file);
+        if ((unsigned char) *string >= ' ') fputc(*string, file);
+    }
+    fputc('"', file);
+}
+
+void domus_list(void) {
+    domus_info_all();
+}
+
+static bool domus_switch_print(const DeviceCommunicationMessage *data, const char *switch_label,
+                               const char *switch_pos) {
+    DeviceDescriptor *device_descriptor;
+
+    device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+    if (device_descriptor == NULL) {
+        println_color(COLOR_RED, "\tSet On Command: Device with unknown Device Descriptor id %ld",
+                      data->id_device_descriptor);
+    }
+    print("\t[%3ld] %-*s ", data->id_sender, DEVICE_NAME_LENGTH,
+          (device_descriptor == NULL) ? "?" : device_descriptor->name);
+
+    if (strcmp(data->message, MESSAGE_RETURN_SUCCESS) == 0) {
+        if (switch_label == NULL) {
+            /* Followed a Control Device */
+            println_color(COLOR_GREEN, "Switched");
+            return true;
+        }
+        print_color(COLOR_GREEN, "Switched ");
+        print("'%s'", switch_label);
+        print_color(COLOR_GREEN, " to ");
+        println("'%s'", switch_pos);
+        return true;
+    } else if (strcmp(data->message, MESSAGE_RETURN_NAME_ERROR) == 0) {
+        println_color(COLOR_RED, "<label> %s doesn't exist",
+                      switch_label);
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_ERROR) == 0) {
+        println_color(COLOR_RED, "<pos> %s doesn't exist",
+                      switch_pos);
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_PASSED_DATE_ERROR) == 0) {
+        println_color(COLOR_RED, "The inserted date has already passed");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_ORDER_DATE_ERROR) == 0) {
+        println_color(COLOR_RED, "Please insert the dates in the right order");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_FORMAT_DATE_ERROR) == 0) {
+        println_color(COLOR_RED, "Date format not valid");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_ALREADY_DEFINED_DATE_ERROR) == 0) {
+        println_color(COLOR_RED, "Timer values already defined");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_SAME_DATE_ERROR) == 0) {
+        println_color(COLOR_RED, "The two dates should be different");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_EXCEEDED_FRIDGE_ERROR) == 0) {
+        println_color(COLOR_RED, "Maximum fridge capacity reached");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_EMPTY_FRIDGE_ERROR) == 0) {
+        println_color(COLOR_RED, "Fridge is empty");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_MAXTHERMO_FRIDGE_ERROR) == 0) {
+        println_color(COLOR_RED, "Cannot set internal temperature : too high");
+    } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_MINTHERMO_FRIDGE_ERROR) == 0) {
+        println_color(COLOR_RED, "Cannot set internal temperature : too low");
+    } else if (strcmp(data->message, MESSAGE_RETURN_LOCKED_ERROR) == 0) {
+        println_color(COLOR_RED, "Held by another transaction");
+    } else if (strcmp(data->message, MESSAGE_RETURN_TRANSACTION_ERROR) == 0) {
+        println_color(COLOR_RED, "Not prepared or its deadline has passed");
+    } else if (strncmp(data->message, MESSAGE_RETURN_CONDITION_ERROR, strlen(MESSAGE_RETURN_CONDITION_ERROR)) == 0) {
+        domus_switch_print_condition(data->message + strlen(MESSAGE_RETURN_CONDITION_ERROR));
+    } else {
+        println_color(COLOR_RED, "Unknown Error");
+    }
+
+    return false;
+}
+
+static void domus_switch_print_condition(const char *current) {
+    char **fields = device_communication_split_message_fields(current);
+    ConverterResult state;
+    ConverterResult version;
+
+    if (fields == NULL || fields[0] == NULL || fields[1] == NULL ||
+        (state = converter_char_to_bool(fields[0][0])).error ||
+        (version = converter_string_to_long(fields[1])).error) {
+        println_color(COLOR_RED, "Condition not satisfied");
+    } else {
+        print_color(COLOR_RED, "Condition not satisfied, ");
+        println("state '%s' version %ld", (state.data.Bool) ? "on" : "off", version.data.Long);
+    }
+
+    device_communication_free_message_fields(fields);
+}
+
+void domus_switch(size_t id, const char *switch_label, const char *switch_pos,
+                  const DeviceCommunicationCondition *condition) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    DeviceDescriptor *device_descriptor;
+    const char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    char conditional_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    const char controller_name[DEVICE_NAME_LENGTH];
+    bool switched = false;
+    if (!device_check_control_device(domus)) return;
+    if (!control_device_has_devices(domus)) return;
+
+    snprintf((char *) out_message_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH, "%s\n%s\n", switch_label, switch_pos);
+    /* The condition travels after the position, the journal keeps the plain switch that was applied */
+    if (!device_communication_condition_to_message(condition, switch_label, switch_pos, conditional_message,
+                                                   DEVICE_COMMUNICATION_MESSAGE_LENGTH)) {
+        println("\tThe switch does not fit in a message");
+        return;
+    }
+    strncpy((char *) controller_name, device_is_supported_by_id(DEVICE_TYPE_CONTROLLER)->name, DEVICE_NAME_LENGTH);
+    message_list = domus_propagate_message(id, MESSAGE_TYPE_SWITCH, conditional_message, MESSAGE_TYPE_SWITCH);
+
+    if (list_is_empty(message_list)) {
+        /* No Device under controller */
+        free_list(message_list);
+        message_list = domus_info_messages(id, NULL);
+        if (list_is_empty(message_list)) {
+            /* No Device in the entire System */
+            println("\tCannot find a Device with id %ld", id);
+        } else {
+            /* Device found but is not linked to the controller */
+            list_for_each(data, message_list) {
+                if (data->id_sender == id) {
+                    device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+                    if (device_descriptor == NULL) {
+                        println_color(COLOR_RED, "\tSwitch Command: Device with unknown Device Descriptor id %ld",
+                                      data->id_device_descriptor);
+                    }
+                    println("\tDevice %s has been found but is NOT linked to %s",
+                            (device_descriptor == NULL) ? "?" : device_descriptor->name, controller_name);
+                    println("\tPlease link %s with id %ld to the %s with id %ld",
+                            (device_descriptor == NULL) ? "?" : device_descriptor->name, id, controller_name,
+                            CONTROLLER_ID);
+                    println("\tTry type:");
+                    println_color(COLOR_YELLOW, "\t\tlink %ld to %ld", id, CONTROLLER_ID);
+                }
+            }
+        }
+    } else {
+        /* States have changed, the Controller itself can be the target */
+        domus_batch_invalidate();
+        if (id == CONTROLLER_ID) domus_batch_system_status = -1;
+
+        list_for_each(data, message_list) {
+            if (data->type == MESSAGE_TYPE_SWITCH && domus_switch_print(data, switch_label, switch_pos))
+                switched = true;
+        }
+    }
+
+    /* The same message is replayed, the Devices that answered are found again */
+    if (switched) domus_journal_append(DOMUS_JOURNAL_ENTRY_SWITCH, id, 0, out_message_message);
+
+    free_list(message_list);
+}
+
+static long domus_switch_multi_print(const List *message_list, const DeviceCommunicationScene *scene,
+                                     DeviceCommunicationScene *remaining) {
+    DeviceCommunicationMessage *data;
+    const DeviceCommunicationSceneTarget *target;
+    char switch_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    long switched = 0;
+
+    list_for_each(data, message_list) {
+        if (data->type != MESSAGE_TYPE_SWITCH) continue;
+        if (data->id_sender == CONTROLLER_ID) domus_batch_system_status = -1;
+
+        if ((target = device_communication_scene_find(scene, data->id_sender)) == NULL) {
+            domus_switch_print(data, NULL, NULL);
+            continue;
+        }
+
+        /* A target that followed a Control Device answers again with its own action, that one comes first */
+        if (!device_communication_scene_remove(remaining, data->id_sender)) continue;
+        if (!domus_switch_print(data, scene->actions[target->action].label, scene->actions[target->action].pos))
+            continue;
+
+        switched++;
+        device_communication_scene_to_switch(scene, target, switch_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+        domus_journal_append(DOMUS_JOURNAL_ENTRY_SWITCH, data->id_sender, 0, switch_message);
+    }
+
+    return switched;
+}
+
+long domus_switch_multi(const DeviceCommunicationScene *scene) {
+    List *message_list;
+    DeviceCommunicationScene remaining;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    size_t from = 0;
+    size_t next;
+    size_t i;
+    long switched = 0;
+    if (!device_check_control_device(domus)) return -1;
+    if (!control_device_has_devices(domus)) return -1;
+    if (scene == NULL) return -1;
+
+    remaining = *scene;
+    domus_batch_invalidate();
+
+    while (from < scene->targets_count) {
+        /* Every message is one walk of the Controller subtree */
+        if ((next = device_communication_scene_to_message(scene, from, out_message_message,
+                                                          DEVICE_COMMUNICATION_MESSAGE_LENGTH)) == from)
+            break;
+        from = next;
+
+        message_list = domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_SWITCH_MULTI,
+                                               out_message_message, MESSAGE_TYPE_SWITCH);
+        switched += domus_switch_multi_print(message_list, scene, &remaining);
+        free_list(message_list);
+    }
+
+    /* Not found without asking again, a Device can exist outside the Controller */
+    for (i = 0; i < remaining.targets_count; ++i) {
+        println_color(COLOR_RED, "\t[%3ld] Cannot find a Device with id %ld linked to %s", remaining.targets[i].id,
+                      remaining.targets[i].id, device_is_supported_by_id(DEVICE_TYPE_CONTROLLER)->name);
+    }
+
+    return switched;
+}
+
+long domus_switch_select(const DeviceCommunicationFilter *filter, const char *switch_label, const char *switch_pos) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    char switch_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    long switched = 0;
+    if (!device_check_control_device(domus)) return -1;
+    if (!control_device_has_devices(domus)) return -1;
+    if (!device_communication_filter_to_selector(filter, switch_label, switch_pos, out_message_message,
+                                                 DEVICE_COMMUNICATION_MESSAGE_LENGTH))
+        return -1;
+
+    snprintf(switch_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH, "%s\n%s\n", switch_label, switch_pos);
+    domus_batch_invalidate();
+
+    message_list = domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_SWITCH_SELECT,
+                                           out_message_message, MESSAGE_TYPE_SWITCH);
+    list_for_each(data, message_list) {
+        if (data->type != MESSAGE_TYPE_SWITCH) continue;
+        if (data->id_sender == CONTROLLER_ID) domus_batch_system_status = -1;
+        if (!domus_switch_print(data, switch_label, switch_pos)) continue;
 
-        device_communication_free_message_fields(fields);
+        /* Replayed one by one, the selector can match other Devices by then */
+        switched++;
+        domus_journal_append(DOMUS_JOURNAL_ENTRY_SWITCH, data->id_sender, 0, switch_message);
     }
+    free_list(message_list);
 
-    (list_is_empty(message_list)) ? (toRtn = false) : (toRtn = true);
+    return switched;
+}
 
-    free_list(message_list);
+bool domus_transaction_begin(unsigned long timeout) {
+    if (domus_transaction_open || timeout == 0) return false;
 
-    return toRtn;
+    domus_transaction_open = true;
+    domus_transaction_timeout = timeout;
+    device_communication_scene_init(&domus_transaction_scene);
+
+    return true;
 }
 
-bool domus_info_all(void) {
-    if (!device_check_control_device(domus)) return false;
-    if (!control_device_has_devices(domus)) return false;
+bool domus_transaction_is_open(void) {
+    return domus_transaction_open;
+}
 
-    return domus_info_by_id(DEVICE_MESSAGE_TO_ALL_DEVICES);
+size_t domus_transaction_staged(void) {
+    return (domus_transaction_open) ? domus_transaction_scene.targets_count : 0;
 }
 
-void domus_list(void) {
-    domus_info_all();
+bool domus_transaction_stage(size_t id, const char *switch_label, const char *switch_pos) {
+    if (!domus_transaction_open) return false;
+
+    /* The last switch of a Device wins */
+    device_communication_scene_remove(&domus_transaction_scene, id);
+    return device_communication_scene_add(&domus_transaction_scene, id, switch_label, switch_pos);
+}
+
+long domus_transaction_stage_scene(const DeviceCommunicationScene *scene) {
+    const DeviceCommunicationSceneTarget *target;
+    long staged = 0;
+    size_t i;
+    if (!domus_transaction_open || scene == NULL) return -1;
+
+    for (i = 0; i < scene->targets_count; ++i) {
+        target = &scene->targets[i];
+        if (domus_transaction_stage(target->id, scene->actions[target->action].label,
+                                    scene->actions[target->action].pos))
+            staged++;
+    }
+
+    return staged;
+}
+
+void domus_transaction_abort(void) {
+    /* Nothing has been sent yet, the staged switches are dropped */
+    domus_transaction_open = false;
+    device_communication_scene_init(&domus_transaction_scene);
 }
 
-void domus_switch(size_t id, const char *switch_label, const char *switch_pos) {
+long domus_transaction_commit(void) {
+    const DeviceCommunicationScene *scene = &domus_transaction_scene;
+    const DeviceCommunicationSceneTarget *target;
     List *message_list;
     DeviceCommunicationMessage *data;
-    DeviceDescriptor *device_descriptor;
-    const char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
-    const char controller_name[DEVICE_NAME_LENGTH];
-    if (!device_check_control_device(domus)) return;
-    if (!control_device_has_devices(domus)) return;
+    DeviceCommunicationScene remaining;
+    char out_message_message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    size_t from;
+    size_t next;
+    size_t i;
+    bool prepared = true;
+    long switched = 0;
+    if (!domus_transaction_open) return -1;
 
-    snprintf((char *) out_message_message, DEVICE_COMMUNICATION_MESSAGE_LENGTH, "%s\n%s\n", switch_label, switch_pos);
-    strncpy((char *) controller_name, device_is_supported_by_id(DEVICE_TYPE_CONTROLLER)->name, DEVICE_NAME_LENGTH);
-    message_list = domus_propagate_message(id, MESSAGE_TYPE_SWITCH, out_message_message, MESSAGE_TYPE_SWITCH);
+    domus_transaction_open = false;
+    if (!device_check_control_device(domus)) return -1;
+    if (!control_device_has_devices(domus)) return -1;
 
-    if (list_is_empty(message_list)) {
-        /* No Device under controller */
-        message_list = domus_propagate_message(id, MESSAGE_TYPE_INFO, "", MESSAGE_TYPE_INFO);
-        if (list_is_empty(message_list)) {
-            /* No Device in the entire System */
-            println("\tCannot find a Device with id %ld", id);
-        } else {
-            /* Device found but is not linked to the controller */
-            list_for_each(data, message_list) {
-                if (data->id_sender == id) {
-                    device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
-                    if (device_descriptor == NULL) {
-                        println_color(COLOR_RED, "\tSwitch Command: Device with unknown Device Descriptor id %ld",
-                                      data->id_device_descriptor);
-                    }
-                    println("\tDevice %s has been found but is NOT linked to %s",
-                            (device_descriptor == NULL) ? "?" : device_descriptor->name, controller_name);
-                    println("\tPlease link %s with id %ld to the %s with id %ld",
-                            (device_descriptor == NULL) ? "?" : device_descriptor->name, id, controller_name,
-                            CONTROLLER_ID);
-                    println("\tTry type:");
-                    println_color(COLOR_YELLOW, "\t\tlink %ld to %ld", id, CONTROLLER_ID);
-                }
-            }
-        }
-    } else {
+    domus_transaction_id++;
+    remaining = *scene;
+    domus_batch_invalidate();
+
+    /* First walk, every target checks its switch and is held until the second one or its deadline */
+    for (from = 0; from < scene->targets_count; from = next) {
+        if ((next = device_communication_transaction_to_message(domus_transaction_id, domus_transaction_timeout,
+                                                                scene, from, out_message_message,
+                                                                DEVICE_COMMUNICATION_MESSAGE_LENGTH)) == from)
+            break;
+
+        message_list = domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_PREPARE,
+                                               out_message_message, MESSAGE_TYPE_PREPARE);
         list_for_each(data, message_list) {
-            if (data->type == MESSAGE_TYPE_SWITCH) {
-                device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
-                if (device_descriptor == NULL) {
-                    println_color(COLOR_RED, "\tSet On Command: Device with unknown Device Descriptor id %ld",
-                                  data->id_device_descriptor);
-                }
-                print("\t[%3ld] %-*s ", data->id_sender, DEVICE_NAME_LENGTH,
-                      (device_descriptor == NULL) ? "?" : device_descriptor->name);
-
-                if (strcmp(data->message, MESSAGE_RETURN_SUCCESS) == 0) {
-                    print_color(COLOR_GREEN, "Switched ");
-                    print("'%s'", switch_label);
-                    print_color(COLOR_GREEN, " to ");
-                    println("'%s'", switch_pos);
-                } else if (strcmp(data->message, MESSAGE_RETURN_NAME_ERROR) == 0) {
-                    println_color(COLOR_RED, "<label> %s doesn't exist",
-                                  switch_label);
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_ERROR) == 0) {
-                    println_color(COLOR_RED, "<pos> %s doesn't exist",
-                                  switch_pos);
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_PASSED_DATE_ERROR) == 0) {
-                    println_color(COLOR_RED, "The inserted date has already passed");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_ORDER_DATE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Please insert the dates in the right order");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_FORMAT_DATE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Date format not valid");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_ALREADY_DEFINED_DATE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Timer values already defined");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_SAME_DATE_ERROR) == 0) {
-                    println_color(COLOR_RED, "The two dates should be different");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_EXCEEDED_FRIDGE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Maximum fridge capacity reached");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_EMPTY_FRIDGE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Fridge is empty");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_MAXTHERMO_FRIDGE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Cannot set internal temperature : too high");
-                } else if (strcmp(data->message, MESSAGE_RETURN_VALUE_MINTHERMO_FRIDGE_ERROR) == 0) {
-                    println_color(COLOR_RED, "Cannot set internal temperature : too low");
-                } else {
-                    println_color(COLOR_RED, "Unknown Error");
-                }
-            }
+            if (data->type != MESSAGE_TYPE_PREPARE) continue;
+            if ((target = device_communication_scene_find(scene, data->id_sender)) == NULL) continue;
+            if (!device_communication_scene_remove(&remaining, data->id_sender)) continue;
+            if (strcmp(data->message, MESSAGE_RETURN_SUCCESS) == 0) continue;
+
+            prepared = false;
+            domus_switch_print(data, scene->actions[target->action].label, scene->actions[target->action].pos);
         }
+        free_list(message_list);
     }
 
-    free_list(message_list);
+    for (i = 0; i < remaining.targets_count; ++i) {
+        prepared = false;
+        println_color(COLOR_RED, "\t[%3ld] Cannot find a Device with id %ld linked to %s", remaining.targets[i].id,
+                      remaining.targets[i].id, device_is_supported_by_id(DEVICE_TYPE_CONTROLLER)->name);
+    }
+
+    /* Second walk, commit everywhere or release everywhere */
+    remaining = *scene;
+    for (from = 0; from < scene->targets_count; from = next) {
+        if ((next = device_communication_transaction_to_message(domus_transaction_id, domus_transaction_timeout,
+                                                                scene, from, out_message_message,
+                                                                DEVICE_COMMUNICATION_MESSAGE_LENGTH)) == from)
+            break;
+
+        message_list = domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES,
+                                               (prepared) ? MESSAGE_TYPE_COMMIT : MESSAGE_TYPE_ABORT,
+                                               out_message_message,
+                                               (prepared) ? MESSAGE_TYPE_SWITCH : MESSAGE_TYPE_ABORT);
+        if (prepared) switched += domus_switch_multi_print(message_list, scene, &remaining);
+        free_list(message_list);
+    }
+
+    device_communication_scene_init(&domus_transaction_scene);
+    return (prepared) ? switched : -1;
 }
 
 /**
@@ -527,31 +2349,178 @@ static DeviceDad *new_device_dad(size_t id, size_t hop_distance) {
 }
 
 /**
- * Compare two Device Dad
- * @param data_1 first Device Dad
- * @param data_2 second Device Dad
- * @return true if equals, false otherwise
+ * Domus Subtree Structure, Devices to spawn sent in as few SPAWN_SUBTREE messages as possible
+ *  A message holds Devices whose parent is in the same message or is its target
+ */
+typedef struct DomusSubtree {
+    /* The Device directly connected to Domus the targets are below, NULL until one accepts a message */
+    DeviceCommunication *top;
+    /* The Device spawning the roots of the message */
+    size_t target;
+    size_t spawned;
+    size_t lost;
+    /* The last error answered, its type is MESSAGE_TYPE_NO_MESSAGE if none */
+    DeviceCommunicationMessage error;
+    DeviceCommunicationSubtree subtree;
+} DomusSubtree;
+
+/**
+ * Initialize a Domus Subtree
+ * @param domus_subtree The Domus Subtree
+ * @param top The Device directly connected to Domus the Devices are spawned below, NULL to ask all of them
  */
-static bool device_dad_equals(const DeviceDad *data_1, const DeviceDad *data_2) {
-    if (data_1 == NULL || data_2 == NULL) return false;
-    return data_1->hop_distance == data_2->hop_distance;
+static void domus_subtree_init(DomusSubtree *domus_subtree, DeviceCommunication *top) {
+    domus_subtree->top = top;
+    domus_subtree->target = 0;
+    domus_subtree->spawned = 0;
+    domus_subtree->lost = 0;
+    device_communication_message_init(domus->device, &domus_subtree->error);
+    domus_subtree->error.type = MESSAGE_TYPE_NO_MESSAGE;
+    device_communication_subtree_init(&domus_subtree->subtree);
 }
 
-int domus_link(size_t device_id, size_t control_device_id) {
-    List *device_list;
-    List *device_dad_list;
+/**
+ * Send the pending Devices of a Domus Subtree in a single SPAWN_SUBTREE message
+ * @param domus_subtree The Domus Subtree
+ */
+static void domus_subtree_flush(DomusSubtree *domus_subtree) {
     DeviceCommunication *data;
+    DeviceCommunicationMessage out_message;
     DeviceCommunicationMessage in_message;
+    size_t spawned = 0;
+    if (domus_subtree->subtree.count == 0) return;
+
+    device_communication_message_init(domus->device, &out_message);
+    device_communication_message_modify(&out_message, domus_subtree->target, MESSAGE_TYPE_SPAWN_SUBTREE, "");
+    device_communication_subtree_to_message(&domus_subtree->subtree, out_message.message,
+                                            DEVICE_COMMUNICATION_MESSAGE_LENGTH);
+    in_message.type = MESSAGE_TYPE_RECIPIENT_ID_MISLEADING;
+
+    list_for_each(data, domus->devices) {
+        if (domus_subtree->top != NULL && domus_subtree->top != data) continue;
+
+        in_message = device_communication_write_message_with_ack(data, &out_message);
+        if (in_message.type == MESSAGE_TYPE_SPAWN_SUBTREE || in_message.type == MESSAGE_TYPE_ERROR) {
+            domus_subtree->top = data;
+            break;
+        }
+    }
+
+    if (in_message.type == MESSAGE_TYPE_SPAWN_SUBTREE) {
+        spawned = domus_subtree->subtree.count;
+    } else if (in_message.type == MESSAGE_TYPE_ERROR) {
+        /* The Devices spawned before the error are counted at the beginning of it */
+        spawned = strtoul(in_message.message, NULL, 10);
+        domus_subtree->error = in_message;
+    }
+    if (spawned > 0) device_communication_filter_track_spawn(domus_subtree->top, &out_message);
+
+    domus_subtree->spawned += spawned;
+    domus_subtree->lost += domus_subtree->subtree.count - spawned;
+    device_communication_subtree_init(&domus_subtree->subtree);
+}
+
+/**
+ * Add a Device to a Domus Subtree, the pending ones are sent first if it does not fit with them
+ * @param domus_subtree The Domus Subtree
+ * @param id The Device id
+ * @param parent The id of the parent, spawned or added before
+ * @param id_device_descriptor The Device Descriptor id
+ * @param name The Device name
+ * @param values The init values
+ */
+static void domus_subtree_add(DomusSubtree *domus_subtree, size_t id, size_t parent, size_t id_device_descriptor,
+                              const char *name, const char *values) {
+    char message[DEVICE_COMMUNICATION_MESSAGE_LENGTH];
+    long index = device_communication_subtree_find(&domus_subtree->subtree, parent);
+    bool added;
+
+    /* A message has a single target */
+    if (index == DEVICE_COMMUNICATION_SUBTREE_ROOT && parent != domus_subtree->target)
+        domus_subtree_flush(domus_subtree);
+    if (domus_subtree->subtree.count == 0) domus_subtree->target = parent;
+
+    added = device_communication_subtree_add(&domus_subtree->subtree, id, id_device_descriptor, index, name, values);
+    if (added && device_communication_subtree_to_message(&domus_subtree->subtree, message,
+                                                         DEVICE_COMMUNICATION_MESSAGE_LENGTH))
+        return;
+    if (added) domus_subtree->subtree.count--;
+
+    /* The message is full, once sent the parent is spawned and becomes the target */
+    domus_subtree_flush(domus_subtree);
+    domus_subtree->target = parent;
+    added = device_communication_subtree_add(&domus_subtree->subtree, id, id_device_descriptor,
+                                             DEVICE_COMMUNICATION_SUBTREE_ROOT, name, values);
+    if (added && device_communication_subtree_to_message(&domus_subtree->subtree, message,
+                                                         DEVICE_COMMUNICATION_MESSAGE_LENGTH))
+        return;
+
+    device_communication_subtree_init(&domus_subtree->subtree);
+    domus_subtree->lost++;
+}
+
+/**
+ * Fork Devices directly connected to Domus together, then send all their init values in bulk
+ * @param forks The Devices to fork
+ * @param values The init values of every Device, the fields of its INFO message
+ * @param count The number of Devices
+ * @param tops Set to the Device Communication of every Device, NULL if it was not forked
+ * @return The number of Devices forked with their init values set
+ */
+static size_t domus_fork_all(DeviceFork *forks, const char **values, size_t count, DeviceCommunication **tops) {
     DeviceCommunicationMessage out_message;
-    DeviceCommunicationMessage *device_to_spawn;
+    DeviceCommunicationMessage in_message;
+    Node *node;
+    size_t forked;
+    size_t initialized = 0;
+    size_t i;
+    Stopwatch start = stopwatch_now();
+
+    /* The Devices alive are the last ones, in the same order */
+    forked = control_device_fork_all(domus, forks, count);
+    node = domus->devices->head;
+    for (i = domus->devices->size - forked; i > 0; --i) node = node->next;
+    for (i = 0; i < count; ++i) {
+        tops[i] = NULL;
+        if (!forks[i].forked) continue;
+        tops[i] = (DeviceCommunication *) node->data;
+        node = node->next;
+    }
+
+    /* Every Device has its own pipe, all the init values are in flight together */
+    device_communication_message_init(domus->device, &out_message);
+    for (i = 0; i < count; ++i) {
+        if (tops[i] == NULL) continue;
+        device_communication_message_modify(&out_message, forks[i].id, MESSAGE_TYPE_SET_INIT_VALUES,
+                                            "%lu\n%lu\n%s", forks[i].id, forks[i].device_descriptor->id, values[i]);
+        device_communication_write_message_notify(tops[i], &out_message);
+    }
+    for (i = 0; i < count; ++i) {
+        if (tops[i] == NULL) continue;
+        in_message = device_communication_read_message(tops[i]);
+        device_communication_stats_record(MESSAGE_TYPE_SET_INIT_VALUES, stopwatch_elapsed(start), &in_message);
+        if (in_message.type == MESSAGE_TYPE_SET_INIT_VALUES) initialized++;
+        else println_color(COLOR_RED, "\tCannot set the values of Device %lu", forks[i].id);
+    }
+
+    return initialized;
+}
+
+int domus_link(size_t device_id, size_t control_device_id) {
+    List *device_list;
+    DeviceCommunicationMessage *data;
+    DomusSubtree domus_subtree;
     DeviceDescriptor *device_descriptor;
+    size_t *parents;
+    size_t root_hop;
+    size_t depth;
     int toRtn;
+    Stopwatch start = stopwatch_now();
     if (!device_check_control_device(domus)) return -1;
     if (device_id == control_device_id) return -1;
 
+    domus_batch_invalidate();
     device_list = domus_propagate_message(device_id, MESSAGE_TYPE_INFO, "", MESSAGE_TYPE_INFO);
-    device_dad_list = new_list(NULL, (bool (*)(const void *, const void *)) device_dad_equals);
-    device_communication_message_init(domus->device, &out_message);
     toRtn = -1;
 
     /* No Device Found */
@@ -560,111 +2529,453 @@ int domus_link(size_t device_id, size_t control_device_id) {
         /* Lock The Device */
         free_list(domus_propagate_message(device_id, MESSAGE_TYPE_LOCK, "", MESSAGE_TYPE_LOCK));
 
-        /* Spawn Devices */
-        device_to_spawn = (DeviceCommunicationMessage *) list_get_first(device_list);
-        device_communication_message_modify(&out_message, control_device_id, MESSAGE_TYPE_SPAWN_DEVICE,
-                                            "%ld\n%ld\n%s",
-                                            device_to_spawn->id_sender,
-                                            device_to_spawn->id_device_descriptor,
-                                            device_to_spawn->message);
-        strncpy(out_message.device_name, device_to_spawn->device_name, DEVICE_NAME_LENGTH);
-
-        list_for_each(data, domus->devices) {
-            switch ((in_message = device_communication_write_message_with_ack(data, &out_message)).type) {
-                case MESSAGE_TYPE_ERROR: {
-                    /* Something goes wrong, Rollback */
-                    free_list(domus_propagate_message(device_id, MESSAGE_TYPE_UNLOCK, "", MESSAGE_TYPE_UNLOCK));
-                    device_descriptor = device_is_supported_by_id(in_message.id_device_descriptor);
-                    if (device_descriptor == NULL) {
-                        println_color(COLOR_RED, "\tLink Command: Device with unknown Device Descriptor id %ld",
-                                      in_message.id_device_descriptor);
-                    }
+        parents = (size_t *) malloc(sizeof(size_t) * device_list->size);
+        if (parents == NULL) {
+            perror("Domus Link Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
 
-                    println_color(COLOR_RED, "\t%s Error: %s",
-                                  (device_descriptor == NULL) ? "?" : device_descriptor->name,
-                                  in_message.message);
-                    toRtn = 3;
-                    break;
-                }
-                case MESSAGE_TYPE_SPAWN_DEVICE: {
-                    DeviceDad *device_dad;
-                    DeviceDad find_dad;
-                    size_t dad_id;
-
-                    list_add_last(device_dad_list,
-                                  new_device_dad(device_to_spawn->id_sender, device_to_spawn->ctr_hop));
-                    list_remove_first(device_list);
-
-                    while (!list_is_empty(device_list)) {
-                        device_to_spawn = (DeviceCommunicationMessage *) list_get_first(device_list);
-                        device_dad = new_device_dad(device_to_spawn->id_sender, device_to_spawn->ctr_hop);
-                        find_dad.id = device_dad->id;
-                        find_dad.hop_distance = device_dad->hop_distance - 1;
-
-                        if (((DeviceDad *) list_get_last(device_dad_list))->hop_distance >
-                            device_dad->hop_distance) {
-                            while (((DeviceDad *) list_get_last(device_dad_list))->hop_distance >=
-                                   device_dad->hop_distance) {
-                                list_remove_last(device_dad_list);
-                            }
-                        }
-
-                        list_add_last(device_dad_list, device_dad);
-
-                        dad_id = ((DeviceDad *) list_get(device_dad_list,
-                                                         list_get_index(device_dad_list, &find_dad)))->id;
-
-                        device_communication_message_modify(&out_message, dad_id, MESSAGE_TYPE_SPAWN_DEVICE,
-                                                            "%ld\n%ld\n%s",
-                                                            device_to_spawn->id_sender,
-                                                            device_to_spawn->id_device_descriptor,
-                                                            device_to_spawn->message);
-                        strncpy(out_message.device_name, device_to_spawn->device_name, DEVICE_NAME_LENGTH);
-
-                        device_communication_write_message_with_ack(data, &out_message);
-
-                        list_remove_first(device_list);
-                    }
+        /* The subtree comes in preorder, the parent of a Device is the last one a hop closer to the root */
+        domus_subtree_init(&domus_subtree, NULL);
+        root_hop = ((DeviceCommunicationMessage *) list_get_first(device_list))->ctr_hop;
+        list_for_each(data, device_list) {
+            depth = data->ctr_hop - root_hop;
+            parents[depth] = data->id_sender;
+            domus_subtree_add(&domus_subtree, data->id_sender, (depth == 0) ? control_device_id : parents[depth - 1],
+                              data->id_device_descriptor, data->device_name, data->message);
+        }
+        domus_subtree_flush(&domus_subtree);
+        free(parents);
 
-                    /* Unlock and delete previous Locked Devices */
-                    free_list(domus_propagate_message(device_id, MESSAGE_TYPE_UNLOCK_AND_TERMINATE, "",
-                                                      MESSAGE_TYPE_TERMINATE));
-                    toRtn = 0;
-                    break;
-                }
-                default: {
-                    break;
-                }
+        if (domus_subtree.spawned > 0) {
+            if (domus_subtree.lost > 0) {
+                println_color(COLOR_RED, "\tLink Command: %lu Devices below %ld could not be moved",
+                              domus_subtree.lost, device_id);
             }
 
-            if (toRtn != -1) break;
-        }
+            /* Unlock and delete previous Locked Devices */
+            free_list(domus_propagate_message(device_id, MESSAGE_TYPE_UNLOCK_AND_TERMINATE, "",
+                                              MESSAGE_TYPE_TERMINATE));
+            toRtn = 0;
+        } else if (domus_subtree.error.type == MESSAGE_TYPE_ERROR) {
+            /* Something goes wrong, Rollback */
+            free_list(domus_propagate_message(device_id, MESSAGE_TYPE_UNLOCK, "", MESSAGE_TYPE_UNLOCK));
+            device_descriptor = device_is_supported_by_id(domus_subtree.error.id_device_descriptor);
+            if (device_descriptor == NULL) {
+                println_color(COLOR_RED, "\tLink Command: Device with unknown Device Descriptor id %ld",
+                              domus_subtree.error.id_device_descriptor);
+            }
 
-        /* No Control Device Found, Rollback */
-        if (toRtn == -1) {
+            println_color(COLOR_RED, "\t%s Error: %s",
+                          (device_descriptor == NULL) ? "?" : device_descriptor->name,
+                          domus_subtree.error.message);
+            toRtn = 3;
+        } else {
+            /* No Control Device Found, Rollback */
             toRtn = 2;
             free_list(domus_propagate_message(device_id, MESSAGE_TYPE_UNLOCK, "", MESSAGE_TYPE_UNLOCK));
         }
     }
 
     free_list(device_list);
-    free_list(device_dad_list);
+    domus_metrics_operation(DOMUS_METRICS_OPERATION_LINK, start, toRtn == 0);
+    if (toRtn == 0) domus_journal_append(DOMUS_JOURNAL_ENTRY_LINK, device_id, control_device_id, NULL);
 
     return toRtn;
 }
 
-void domus_hierarchy(void) {
+long domus_clone(size_t id, size_t count) {
     List *device_list;
     DeviceCommunicationMessage *data;
+    const DeviceCommunicationMessage **nodes;
+    DeviceCommunication **tops;
+    DeviceFork *forks;
+    const char **values;
+    DomusSubtree domus_subtree;
+    size_t *ancestors;
+    size_t *parents;
+    size_t parent = DOMUS_ID;
+    size_t size = 0;
+    size_t first_id;
+    size_t copy;
+    size_t i;
+    long spawned = 0;
+    Stopwatch start = stopwatch_now();
+    if (!device_check_control_device(domus) || id == DOMUS_ID || id == CONTROLLER_ID || count == 0) return -1;
+
+    device_list = domus_info_list(DEVICE_MESSAGE_TO_ALL_DEVICES);
+    nodes = (const DeviceCommunicationMessage **) malloc(sizeof(DeviceCommunicationMessage *) * device_list->size);
+    ancestors = (size_t *) malloc(sizeof(size_t) * (device_list->size + 2));
+    parents = (size_t *) malloc(sizeof(size_t) * device_list->size);
+    if (nodes == NULL || ancestors == NULL || parents == NULL) {
+        perror("Domus Clone Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Devices come in preorder, the subtree is the Device and the ones after it farther from Domus */
+    list_for_each(data, device_list) {
+        if (size > 0 && data->ctr_hop <= nodes[0]->ctr_hop) break;
+        if (size == 0 && data->id_sender != id) {
+            ancestors[data->ctr_hop] = data->id_sender;
+            continue;
+        }
+
+        if (size == 0) parent = (data->ctr_hop > 1) ? ancestors[data->ctr_hop - 1] : DOMUS_ID;
+        else parents[size] = ancestors[data->ctr_hop - 1];
+        /* From the Device on, the stack holds indexes in the subtree instead of ids */
+        ancestors[data->ctr_hop] = size;
+        nodes[size++] = data;
+    }
+
+    if (size == 0) {
+        free(nodes);
+        free(ancestors);
+        free(parents);
+        free_list(device_list);
+        domus_metrics_operation(DOMUS_METRICS_OPERATION_CLONE, start, false);
+        return -1;
+    }
+
+    first_id = ((DomusRegistry *) domus->device->registry)->next_id;
+    ((DomusRegistry *) domus->device->registry)->next_id += size * count;
+    domus_batch_invalidate();
+
+    /* Copy number copy of the node i has id first_id + copy * size + i */
+    if (parent == DOMUS_ID) {
+        forks = (DeviceFork *) malloc(sizeof(DeviceFork) * count);
+        values = (const char **) malloc(sizeof(char *) * count);
+        tops = (DeviceCommunication **) malloc(sizeof(DeviceCommunication *) * count);
+        if (forks == NULL || values == NULL || tops == NULL) {
+            perror("Domus Clone Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+
+        for (copy = 0; copy < count; ++copy) {
+            forks[copy].id = first_id + copy * size;
+            forks[copy].device_descriptor = device_is_supported_by_id(nodes[0]->id_device_descriptor);
+            strncpy(forks[copy].name, nodes[0]->device_name, DEVICE_NAME_LENGTH);
+            values[copy] = nodes[0]->message;
+        }
+        spawned = (long) domus_fork_all(forks, values, count, tops);
+
+        for (copy = 0; copy < count; ++copy) {
+            if (tops[copy] == NULL) continue;
+
+            domus_subtree_init(&domus_subtree, tops[copy]);
+            for (i = 1; i < size; ++i) {
+                domus_subtree_add(&domus_subtree, first_id + copy * size + i, first_id + copy * size + parents[i],
+                                  nodes[i]->id_device_descriptor, nodes[i]->device_name, nodes[i]->message);
+            }
+            domus_subtree_flush(&domus_subtree);
+            spawned += (long) domus_subtree.spawned;
+        }
+
+        free(forks);
+        free(values);
+        free(tops);
+    } else {
+        /* All the copies are spawned by the same parent, its messages hold as many as fit */
+        domus_subtree_init(&domus_subtree, NULL);
+        for (copy = 0; copy < count; ++copy) {
+            for (i = 0; i < size; ++i) {
+                domus_subtree_add(&domus_subtree, first_id + copy * size + i,
+                                  (i == 0) ? parent : first_id + copy * size + parents[i],
+                                  nodes[i]->id_device_descriptor, nodes[i]->device_name, nodes[i]->message);
+            }
+        }
+        domus_subtree_flush(&domus_subtree);
+        spawned = (long) domus_subtree.spawned;
+
+        if (domus_subtree.error.type == MESSAGE_TYPE_ERROR)
+            println_color(COLOR_RED, "\tClone Command: %s", domus_subtree.error.message);
+    }
+
+    if (spawned < (long) (size * count))
+        println_color(COLOR_RED, "\tClone Command: %lu Devices could not be spawned", size * count - spawned);
+
+    free(nodes);
+    free(ancestors);
+    free(parents);
+    free_list(device_list);
+    domus_metrics_operation(DOMUS_METRICS_OPERATION_CLONE, start, spawned == (long) (size * count));
+    if (spawned > 0) domus_journal_append(DOMUS_JOURNAL_ENTRY_CLONE, id, count, NULL);
+
+    return spawned;
+}
+
+long domus_save(const char *file_name) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    long toRtn = 0;
+    Stopwatch start = stopwatch_now();
+    if (!device_check_control_device(domus)) return -1;
+
+    message_list = domus_info_list(DEVICE_MESSAGE_TO_ALL_DEVICES);
+    /* The Controller is saved but not counted, domus_load never spawns it */
+    list_for_each(data, message_list) {
+        if (data->id_sender != CONTROLLER_ID) toRtn++;
+    }
+    if (!domus_snapshot_write(file_name, message_list, ((DomusRegistry *) domus->device->registry)->next_id,
+                              domus_journal_sequence()))
+        toRtn = -1;
+    domus_metrics_operation(DOMUS_METRICS_OPERATION_SAVE, start, toRtn != -1);
+
+    free_list(message_list);
+
+    return toRtn;
+}
+
+/**
+ * Find the parent of a snapshot record in the stack of its ancestors, then push the record
+ * @param parents The stack of the ids of the ancestors of the previous record
+ * @param depth The size of the stack
+ * @param record The snapshot record
+ * @return true if the parent comes before the record, false otherwise
+ */
+static bool domus_load_parent(size_t *parents, size_t *depth, const DomusSnapshotRecord *record) {
+    while (*depth > 0 && parents[*depth - 1] != record->parent) (*depth)--;
+    if (*depth == 0 && record->parent != DOMUS_ID) return false;
+    if (record->id == DOMUS_ID || record->device_descriptor == DEVICE_TYPE_DOMUS) return false;
+    /* Only the Controller is a controller, always directly connected to Domus */
+    if ((record->id == CONTROLLER_ID) != (record->device_descriptor == DEVICE_TYPE_CONTROLLER)) return false;
+    if (record->id == CONTROLLER_ID && record->parent != DOMUS_ID) return false;
+
+    parents[(*depth)++] = record->id;
+    return true;
+}
+
+long domus_load(const char *file_name) {
+    DomusSnapshot *snapshot;
+    const DomusSnapshotRecord *record;
+    const char **values;
+    DeviceCommunication **tops;
+    DeviceCommunication *top = NULL;
+    DeviceFork *forks;
+    DomusSubtree domus_subtree;
+    size_t *parents;
+    size_t depth = 0;
+    size_t offset = 0;
+    size_t next_id;
+    size_t count = 0;
+    size_t devices = 0;
+    size_t lost = 0;
+    long restored = 0;
+    bool controller_state = DEVICE_STATE;
+    bool valid = true;
+    Stopwatch start = stopwatch_now();
+    if (!device_check_control_device(domus)) return -1;
+    if ((snapshot = domus_snapshot_open(file_name)) == NULL) return -1;
+
+    parents = (size_t *) malloc(sizeof(size_t) * (snapshot->header->count + 1));
+    forks = (DeviceFork *) malloc(sizeof(DeviceFork) * (snapshot->header->count + 1));
+    values = (const char **) malloc(sizeof(char *) * (snapshot->header->count + 1));
+    tops = (DeviceCommunication **) malloc(sizeof(DeviceCommunication *) * (snapshot->header->count + 1));
+    if (parents == NULL || forks == NULL || values == NULL || tops == NULL) {
+        perror("Domus Load Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Check the whole hierarchy before touching the running one */
+    next_id = snapshot->header->next_id;
+    while (valid && (record = domus_snapshot_next(snapshot, &offset)) != NULL) {
+        valid = domus_load_parent(parents, &depth, record);
+        if (record->id >= next_id) next_id = record->id + 1;
+
+        if (record->id == CONTROLLER_ID) {
+            controller_state = domus_snapshot_values(record)[0] != '0';
+            continue;
+        }
+
+        devices++;
+        if (record->parent == DOMUS_ID) {
+            forks[count].id = record->id;
+            forks[count].device_descriptor = device_is_supported_by_id(record->device_descriptor);
+            strncpy(forks[count].name, record->name, DEVICE_NAME_LENGTH);
+            values[count++] = domus_snapshot_values(record);
+        }
+    }
+
+    if (!valid) {
+        free(parents);
+        free(forks);
+        free(values);
+        free(tops);
+        free_domus_snapshot(snapshot);
+        domus_metrics_operation(DOMUS_METRICS_OPERATION_LOAD, start, false);
+        return -1;
+    }
+
+    /* The Controller survives, it only loses its children */
+    free_list(domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_TERMINATE, "",
+                                      MESSAGE_TYPE_TERMINATE));
+    domus_batch_invalidate();
+    domus_batch_system_status = -1;
+
+    restored = (long) domus_fork_all(forks, values, count, tops);
+
+    /* Nested Devices are spawned by their parent, whole subtrees at once through the Device directly connected */
+    offset = 0;
+    count = 0;
+    domus_subtree_init(&domus_subtree, NULL);
+    while ((record = domus_snapshot_next(snapshot, &offset)) != NULL) {
+        if (record->id == CONTROLLER_ID || record->parent == DOMUS_ID) {
+            domus_subtree_flush(&domus_subtree);
+            restored += (long) domus_subtree.spawned;
+            lost += domus_subtree.lost;
+
+            top = (record->id == CONTROLLER_ID) ? (DeviceCommunication *) list_get_first(domus->devices)
+                                                : tops[count++];
+            domus_subtree_init(&domus_subtree, top);
+            continue;
+        }
+
+        if (top != NULL) {
+            domus_subtree_add(&domus_subtree, record->id, record->parent, record->device_descriptor, record->name,
+                              domus_snapshot_values(record));
+        } else {
+            println_color(COLOR_RED, "\tLoad Command: cannot spawn Device %u under %u", record->id, record->parent);
+        }
+    }
+    domus_subtree_flush(&domus_subtree);
+    restored += (long) domus_subtree.spawned;
+    lost += domus_subtree.lost;
+    if (lost > 0) println_color(COLOR_RED, "\tLoad Command: cannot spawn %lu nested Devices", lost);
+
+    free_list(domus_propagate_message(CONTROLLER_ID, MESSAGE_TYPE_SWITCH,
+                                      (controller_state) ? CONTROLLER_SWITCH_STATE "\n" CONTROLLER_SWITCH_STATE_ON "\n"
+                                                         : CONTROLLER_SWITCH_STATE "\n" CONTROLLER_SWITCH_STATE_OFF "\n",
+                                      MESSAGE_TYPE_SWITCH));
+
+    if (((DomusRegistry *) domus->device->registry)->next_id < next_id)
+        ((DomusRegistry *) domus->device->registry)->next_id = next_id;
+    domus_batch_invalidate();
+    domus_metrics_operation(DOMUS_METRICS_OPERATION_LOAD, start, restored == (long) devices);
+    /* The journal cannot describe a load, the snapshot it is based on is replaced */
+    domus_journal_checkpoint();
+
+    free(parents);
+    free(forks);
+    free(values);
+    free(tops);
+    free_domus_snapshot(snapshot);
+
+    return restored;
+}
+
+bool domus_replay(const DomusJournalEntry *entry) {
+    List *message_list;
+    DomusRegistry *registry;
+    size_t id;
+    bool toRtn = false;
+    if (!device_check_control_device(domus) || entry == NULL) return false;
+
+    registry = (DomusRegistry *) domus->device->registry;
+    id = (entry->id == DOMUS_JOURNAL_ALL) ? DEVICE_MESSAGE_TO_ALL_DEVICES : entry->id;
+
+    switch (entry->type) {
+        case DOMUS_JOURNAL_ENTRY_ADD: {
+            /* Ids of failed adds are never journaled, the id is forced */
+            toRtn = control_device_fork(domus, id, device_is_supported_by_id(entry->argument),
+                                        (entry->text[0] == '\0') ? NULL : entry->text);
+            if (registry->next_id <= id) registry->next_id = id + 1;
+            break;
+        }
+        case DOMUS_JOURNAL_ENTRY_DEL: {
+            message_list = domus_propagate_message(id, MESSAGE_TYPE_TERMINATE, "", MESSAGE_TYPE_TERMINATE);
+            toRtn = !list_is_empty(message_list);
+            free_list(message_list);
+            break;
+        }
+        case DOMUS_JOURNAL_ENTRY_LINK: {
+            toRtn = domus_link(id, entry->argument) == 0;
+            break;
+        }
+        case DOMUS_JOURNAL_ENTRY_CLONE: {
+            /* Ids are taken in order from the next free one, as when it was journaled */
+            toRtn = domus_clone(id, entry->argument) > 0;
+            break;
+        }
+        case DOMUS_JOURNAL_ENTRY_SWITCH: {
+            message_list = domus_propagate_message(id, MESSAGE_TYPE_SWITCH, entry->text, MESSAGE_TYPE_SWITCH);
+            toRtn = !list_is_empty(message_list);
+            free_list(message_list);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    domus_batch_invalidate();
+    domus_batch_system_status = -1;
+
+    return toRtn;
+}
+
+size_t domus_next_id(void) {
+    if (!device_check_control_device(domus)) return CONTROLLER_ID + 1;
+
+    return ((DomusRegistry *) domus->device->registry)->next_id;
+}
+
+void domus_set_journal(const char *file_name) {
+    snprintf(domus_journal_startup, DOMUS_JOURNAL_FILE_NAME_LENGTH, "%s", (file_name == NULL) ? "" : file_name);
+}
+
+/**
+ * Render the hierarchy as output records with the depth and the parent of every Device
+ * @param device_list The List of info messages in hierarchy order
+ */
+static void domus_hierarchy_output(const List *device_list) {
+    List *device_dad_list;
+    DeviceCommunicationMessage *data;
+
+    device_dad_list = new_list(NULL, NULL);
+    output_begin();
+
+    list_for_each(data, device_list) {
+        while (!list_is_empty(device_dad_list) &&
+               ((DeviceDad *) list_get_last(device_dad_list))->hop_distance >= data->ctr_hop) {
+            free(list_remove_last(device_dad_list));
+        }
+
+        output_record();
+        domus_output_device(data);
+        output_long("depth", (long) data->ctr_hop);
+        output_long("parent", (list_is_empty(device_dad_list))
+                              ? DOMUS_ID : (long) ((DeviceDad *) list_get_last(device_dad_list))->id);
+
+        list_add_last(device_dad_list, new_device_dad(data->id_sender, data->ctr_hop));
+    }
+
+    output_end();
+    free_list(device_dad_list);
+}
+
+void domus_hierarchy(void) {
+    const List *device_list;
+    DeviceCommunicationMessage *data;
     DeviceDescriptor *device_descriptor;
     size_t i;
     const char *color;
-    int old_hop = 0;
+    size_t old_hop = 0;
 
     if (!device_check_control_device(domus)) return;
 
-    device_list = domus_propagate_message(DEVICE_MESSAGE_TO_ALL_DEVICES, MESSAGE_TYPE_INFO, "",
-                                          MESSAGE_TYPE_INFO);
+    /* Parents are printed before their children, the records are read in place from the cache */
+    if (domus_batch && domus_batch_snapshot != NULL) {
+        device_list = domus_batch_snapshot;
+    } else {
+        domus_info_delta(NULL, NULL);
+        device_list = domus_info_cache;
+        if (domus_batch) domus_batch_snapshot = domus_snapshot_subtree(domus_info_cache, DEVICE_MESSAGE_TO_ALL_DEVICES);
+    }
+
+    if (output_format() != OUTPUT_FORMAT_TABLE) {
+        domus_hierarchy_output(device_list);
+        return;
+    }
+
     println_color(COLOR_CYAN, "\tDOMUS");
 
     list_for_each(data, device_list) {
@@ -716,8 +3027,6 @@ void domus_hierarchy(void) {
     print("└─");
     print("\033[1B");
     print("\033[100D");
-
-    free_list(device_list);
 }
 
 pid_t domus_getpid(size_t device_id) {
@@ -757,6 +3066,7 @@ static void queue_message_handler() {
 
     switch (in_message->mesg_type) {
         case QUEUE_MESSAGE_TYPE_DOMUS_PID_REQUEST : {
+            domus_metrics_request(DOMUS_METRICS_REQUEST_DOMUS_PID);
 
             result = converter_string_to_long(in_message->mesg_text);
 
@@ -777,6 +3087,7 @@ static void queue_message_handler() {
             char **fields;
             __pid_t device_pid;
 
+            domus_metrics_request(DOMUS_METRICS_REQUEST_DEVICE_PID);
             fake_message = malloc(sizeof(DeviceCommunicationMessage));
             device_communication_message_modify_message(fake_message, in_message->mesg_text);
 
@@ -0,0 +1,536 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "domus.h"
+#include "domus_history.h"
+#include "util/util_crc.h"
+#include "util/util_converter.h"
+#include "util/util_periodic.h"
+
+#define DOMUS_HISTORY_SECONDS_PER_DAY 86400
+/* Largest block, header and both columns */
+#define DOMUS_HISTORY_BLOCK_LENGTH (sizeof(DomusHistoryBlock) + SERIES_TIMESTAMPS_LENGTH + SERIES_VALUES_LENGTH)
+
+/**
+ * Struct Domus History Metric, a numeric field of the info of a Device type
+ */
+typedef struct DomusHistoryMetric {
+    size_t id_device_descriptor;
+    /* Index of the field in the info message */
+    size_t field;
+    const char *name;
+} DomusHistoryMetric;
+
+static const DomusHistoryMetric domus_history_metrics[] = {
+        {DEVICE_TYPE_BULB,   0, "state"},
+        {DEVICE_TYPE_BULB,   1, "active_time"},
+        {DEVICE_TYPE_WINDOW, 0, "state"},
+        {DEVICE_TYPE_WINDOW, 1, "open_time"},
+        {DEVICE_TYPE_FRIDGE, 0, "state"},
+        {DEVICE_TYPE_FRIDGE, 1, "open_time"},
+        {DEVICE_TYPE_FRIDGE, 3, "filling"},
+        {DEVICE_TYPE_FRIDGE, 4, "temperature"}
+};
+
+#define DOMUS_HISTORY_METRICS (sizeof(domus_history_metrics) / sizeof(DomusHistoryMetric))
+
+/**
+ * The directory of the series files, empty if disabled
+ */
+static char domus_history_path[DOMUS_HISTORY_DIRECTORY_LENGTH] = "";
+static unsigned long domus_history_seconds = 0;
+static unsigned long domus_history_days = 0;
+
+/**
+ * The series being sampled, one for every metric of every Device
+ */
+static List *domus_history_list = NULL;
+
+/**
+ * Periodic task sampling every Device
+ */
+static void domus_history_task(void);
+
+/**
+ * Sample every Device with a single info walk and append a point to each of its series
+ *  The series of the Devices that did not answer are appended to their files and dropped
+ */
+static void domus_history_sample(void);
+
+/**
+ * Return the series of a metric of a Device, creating it if missing
+ * @param id The Device id
+ * @param metric The index of the metric
+ * @return The series
+ */
+static DomusHistorySeries *domus_history_series_get(size_t id, size_t metric);
+
+/**
+ * Append a point to a series, the block is appended to the file when full
+ * @param series The series
+ * @param timestamp The timestamp of the point
+ * @param value The value of the point
+ */
+static void domus_history_series_append(DomusHistorySeries *series, int64_t timestamp, double value);
+
+/**
+ * Append the block of a series to its file and start a new one
+ * @param series The series
+ * @return true if appended or empty, false otherwise
+ */
+static bool domus_history_series_flush(DomusHistorySeries *series);
+
+/**
+ * Build the name of the file of a series
+ * @param path The buffer of the name
+ * @param id The Device id
+ * @param metric The name of the metric
+ */
+static void domus_history_file(char *path, size_t id, const char *metric);
+
+/**
+ * Read a whole series file
+ * @param path The series file
+ * @param size The size of the file
+ * @return The content of the file, NULL if missing or empty
+ */
+static unsigned char *domus_history_read(const char *path, size_t *size);
+
+/**
+ * Validate the block at an offset of a series file
+ * @param data The content of the file
+ * @param size The size of the file
+ * @param offset The offset of the block
+ * @param block The header of the block
+ * @return The length of the block, 0 if not valid
+ */
+static size_t domus_history_block(const unsigned char *data, size_t size, size_t offset, DomusHistoryBlock *block);
+
+/**
+ * Drop the blocks older than the retention and a torn tail from a series file
+ *  The file is rewritten next to itself and renamed over it only if something is dropped
+ * @param path The series file
+ * @param cutoff The oldest second kept
+ * @return true if the file is ready to be appended to, false otherwise
+ */
+static bool domus_history_expire(const char *path, int64_t cutoff);
+
+/**
+ * Add a point to the bucket it falls in
+ * @param buckets The buckets
+ * @param from The first second of the range
+ * @param to The last second of the range
+ * @param width The width in seconds of a bucket
+ * @param timestamp The timestamp of the point
+ * @param value The value of the point
+ */
+static void domus_history_bucket_add(DomusHistoryBucket *buckets, time_t from, time_t to, time_t width,
+                                     int64_t timestamp, double value);
+
+/**
+ * Decode the points of a block and add them to the buckets
+ * @param decoder The decoder of the block
+ * @param buckets The buckets
+ * @param from The first second of the range
+ * @param to The last second of the range
+ * @param width The width in seconds of a bucket
+ */
+static void domus_history_bucket_decode(SeriesDecoder *decoder, DomusHistoryBucket *buckets, time_t from, time_t to,
+                                        time_t width);
+
+bool domus_history_enable(const char *directory, unsigned long interval, unsigned long retention) {
+    struct stat info;
+    if (directory == NULL || strlen(directory) == 0 || strlen(directory) >= DOMUS_HISTORY_DIRECTORY_LENGTH ||
+        interval == 0 || retention == 0)
+        return false;
+
+    if (mkdir(directory, 0755) == -1 && errno != EEXIST) return false;
+    if (stat(directory, &info) == -1 || !S_ISDIR(info.st_mode)) return false;
+
+    domus_history_disable();
+    strncpy(domus_history_path, directory, DOMUS_HISTORY_DIRECTORY_LENGTH);
+    domus_history_seconds = interval;
+    domus_history_days = retention;
+    domus_history_list = new_list(NULL, NULL);
+
+    domus_history_sample();
+    periodic_register(domus_history_task, interval * 1000);
+
+    return true;
+}
+
+bool domus_history_disable(void) {
+    DomusHistorySeries *series;
+    bool enabled = domus_history_path[0] != '\0';
+
+    periodic_unregister(domus_history_task);
+    if (domus_history_list != NULL) {
+        while ((series = (DomusHistorySeries *) list_remove_first(domus_history_list)) != NULL) {
+            domus_history_series_flush(series);
+            free(series);
+        }
+        free_list(domus_history_list);
+        domus_history_list = NULL;
+    }
+    domus_history_path[0] = '\0';
+    domus_history_seconds = 0;
+    domus_history_days = 0;
+
+    return enabled;
+}
+
+const char *domus_history_directory(void) {
+    return (domus_history_path[0] == '\0') ? NULL : domus_history_path;
+}
+
+unsigned long domus_history_interval(void) {
+    return domus_history_seconds;
+}
+
+unsigned long domus_history_retention(void) {
+    return domus_history_days;
+}
+
+size_t domus_history_series(void) {
+    return (domus_history_list == NULL) ? 0 : domus_history_list->size;
+}
+
+bool domus_history_is_metric(const char *metric) {
+    size_t i;
+    if (metric == NULL) return false;
+
+    for (i = 0; i < DOMUS_HISTORY_METRICS; ++i) {
+        if (strcmp(domus_history_metrics[i].name, metric) == 0) return true;
+    }
+
+    return false;
+}
+
+static void domus_history_task(void) {
+    domus_history_sample();
+}
+
+static void domus_history_sample(void) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    DomusHistorySeries *series;
+    ConverterResult value;
+    char **fields;
+    size_t count;
+    size_t field;
+    size_t i;
+    Node *node;
+    int64_t now = (int64_t) time(NULL);
+    if (domus_history_list == NULL) return;
+
+    for (node = domus_history_list->head; node != NULL; node = node->next) {
+        ((DomusHistorySeries *) node->data)->seen = false;
+    }
+
+    /* One walk answers for every Device, queries never reach them */
+    message_list = domus_info_list(DEVICE_MESSAGE_TO_ALL_DEVICES);
+    list_for_each(data, message_list) {
+        if ((fields = device_communication_split_message_fields(data->message)) == NULL) continue;
+        for (count = 0; fields[count] != NULL; ++count);
+
+        for (i = 0; i < DOMUS_HISTORY_METRICS; ++i) {
+            if (domus_history_metrics[i].id_device_descriptor != data->id_device_descriptor) continue;
+            if ((field = domus_history_metrics[i].field) >= count) continue;
+
+            /* The state is a bool, everything else a number */
+            if (field == 0) {
+                value = converter_char_to_bool(fields[0][0]);
+                if (!value.error) value.data.Double = (value.data.Bool) ? 1.0 : 0.0;
+            } else {
+                value = converter_string_to_double(fields[field]);
+            }
+            if (value.error) continue;
+
+            series = domus_history_series_get(data->id_sender, i);
+            series->seen = true;
+            domus_history_series_append(series, now, value.data.Double);
+        }
+
+        device_communication_free_message_fields(fields);
+    }
+    free_list(message_list);
+
+    for (count = domus_history_list->size; count > 0; --count) {
+        series = (DomusHistorySeries *) list_remove_first(domus_history_list);
+        if (series->seen) {
+            list_add_last(domus_history_list, series);
+            continue;
+        }
+        domus_history_series_flush(series);
+        free(series);
+    }
+}
+
+static DomusHistorySeries *domus_history_series_get(size_t id, size_t metric) {
+    DomusHistorySeries *series;
+
+    list_for_each(series, domus_history_list) {
+        if (series->id == id && series->metric == metric) return series;
+    }
+
+    series = (DomusHistorySeries *) malloc(sizeof(DomusHistorySeries));
+    if (series == NULL) {
+        perror("Domus History Series Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    series->id = id;
+    series->metric = metric;
+    series->seen = false;
+    series_encoder_reset(&series->encoder);
+    list_add_last(domus_history_list, series);
+
+    return series;
+}
+
+static void domus_history_series_append(DomusHistorySeries *series, int64_t timestamp, double value) {
+    /* The clock went back or the delta does not fit, start a new block */
+    if (!series_encoder_append(&series->encoder, timestamp, value)) {
+        domus_history_series_flush(series);
+        series_encoder_append(&series->encoder, timestamp, value);
+    }
+
+    if (series->encoder.count == SERIES_BLOCK_POINTS) domus_history_series_flush(series);
+}
+
+static bool domus_history_series_flush(DomusHistorySeries *series) {
+    DomusHistoryBlock block;
+    unsigned char buffer[DOMUS_HISTORY_BLOCK_LENGTH];
+    char path[DOMUS_HISTORY_PATH_LENGTH];
+    size_t timestamps_length;
+    size_t values_length;
+    size_t length;
+    int fd;
+    bool appended;
+    if (series->encoder.count == 0) return true;
+
+    domus_history_file(path, series->id, domus_history_metrics[series->metric].name);
+    domus_history_expire(path, (int64_t) time(NULL) - (int64_t) domus_history_days * DOMUS_HISTORY_SECONDS_PER_DAY);
+
+    timestamps_length = series_encoder_timestamps_length(&series->encoder);
+    values_length = series_encoder_values_length(&series->encoder);
+
+    memset(&block, 0, sizeof(DomusHistoryBlock));
+    memcpy(block.magic, DOMUS_HISTORY_BLOCK_MAGIC, sizeof(block.magic));
+    block.count = (uint32_t) series->encoder.count;
+    block.first = series->encoder.first;
+    block.last = series->encoder.last;
+    block.timestamps_length = (uint32_t) timestamps_length;
+    block.values_length = (uint32_t) values_length;
+    block.crc = crc32_update(CRC32_INIT, series->encoder.timestamps_data, timestamps_length);
+    block.crc = crc32_update(block.crc, series->encoder.values_data, values_length);
+
+    /* A single write, a crash leaves at most a torn tail */
+    memcpy(buffer, &block, sizeof(DomusHistoryBlock));
+    memcpy(buffer + sizeof(DomusHistoryBlock), series->encoder.timestamps_data, timestamps_length);
+    memcpy(buffer + sizeof(DomusHistoryBlock) + timestamps_length, series->encoder.values_data, values_length);
+    length = sizeof(DomusHistoryBlock) + timestamps_length + values_length;
+
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644)) == -1) {
+        series_encoder_reset(&series->encoder);
+        return false;
+    }
+    appended = write(fd, buffer, length) == (ssize_t) length;
+    close(fd);
+    series_encoder_reset(&series->encoder);
+
+    return appended;
+}
+
+static void domus_history_file(char *path, size_t id, const char *metric) {
+    snprintf(path, DOMUS_HISTORY_PATH_LENGTH, "%s/%lu.%s", domus_history_path, id, metric);
+}
+
+static unsigned char *domus_history_read(const char *path, size_t *size) {
+    unsigned char *data;
+    struct stat info;
+    int fd;
+    ssize_t bytes;
+    size_t total = 0;
+
+    if ((fd = open(path, O_RDONLY)) == -1) return NULL;
+    if (fstat(fd, &info) == -1 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    data = (unsigned char *) malloc((size_t) info.st_size);
+    if (data == NULL) {
+        perror("Domus History File Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    while (total < (size_t) info.st_size) {
+        bytes = read(fd, data + total, (size_t) info.st_size - total);
+        if (bytes == -1 && errno == EINTR) continue;
+        if (bytes <= 0) break;
+        total += (size_t) bytes;
+    }
+    close(fd);
+
+    *size = total;
+    return data;
+}
+
+static size_t domus_history_block(const unsigned char *data, size_t size, size_t offset, DomusHistoryBlock *block) {
+    const unsigned char *columns;
+    uint32_t crc;
+    if (offset + sizeof(DomusHistoryBlock) > size) return 0;
+
+    /* Blocks are not aligned */
+    memcpy(block, data + offset, sizeof(DomusHistoryBlock));
+    if (memcmp(block->magic, DOMUS_HISTORY_BLOCK_MAGIC, sizeof(block->magic)) != 0) return 0;
+    if (block->count == 0 || block->count > SERIES_BLOCK_POINTS || block->first > block->last) return 0;
+    if (block->timestamps_length > SERIES_TIMESTAMPS_LENGTH || block->values_length > SERIES_VALUES_LENGTH) return 0;
+    if (offset + sizeof(DomusHistoryBlock) + block->timestamps_length + block->values_length > size) return 0;
+
+    columns = data + offset + sizeof(DomusHistoryBlock);
+    crc = crc32_update(CRC32_INIT, columns, block->timestamps_length + block->values_length);
+    if (crc != block->crc) return 0;
+
+    return sizeof(DomusHistoryBlock) + block->timestamps_length + block->values_length;
+}
+
+static bool domus_history_expire(const char *path, int64_t cutoff) {
+    DomusHistoryBlock block;
+    unsigned char *data;
+    char temporary[DOMUS_HISTORY_PATH_LENGTH + 32];
+    size_t size;
+    size_t offset;
+    size_t length;
+    size_t kept = 0;
+    bool expired = false;
+    bool written = true;
+    int fd;
+
+    if ((data = domus_history_read(path, &size)) == NULL) return true;
+
+    for (offset = 0; (length = domus_history_block(data, size, offset, &block)) != 0; offset += length) {
+        if (block.last < cutoff) expired = true;
+        else kept++;
+    }
+
+    /* Nothing to drop, the common case costs a read of the file */
+    if (!expired && offset == size) {
+        free(data);
+        return true;
+    }
+
+    snprintf(temporary, sizeof(temporary), "%s.%d.tmp", path, getpid());
+    if ((fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1) {
+        free(data);
+        return false;
+    }
+
+    for (offset = 0; kept > 0 && (length = domus_history_block(data, size, offset, &block)) != 0; offset += length) {
+        if (block.last < cutoff) continue;
+        if (write(fd, data + offset, length) != (ssize_t) length) {
+            written = false;
+            break;
+        }
+    }
+    free(data);
+
+    if (close(fd) == -1) written = false;
+    if (written && rename(temporary, path) == 0) return true;
+
+    unlink(temporary);
+    return false;
+}
+
+long domus_history_query(size_t id, const char *metric, time_t from, time_t to, DomusHistoryBucket *buckets) {
+    DomusHistoryBlock block;
+    DomusHistorySeries *series;
+    SeriesDecoder decoder;
+    unsigned char *data;
+    const unsigned char *columns;
+    char path[DOMUS_HISTORY_PATH_LENGTH];
+    time_t cutoff;
+    time_t width;
+    size_t size;
+    size_t offset;
+    size_t length;
+    size_t i;
+    long filled = 0;
+    if (domus_history_path[0] == '\0' || !domus_history_is_metric(metric) || buckets == NULL) return -1;
+
+    cutoff = time(NULL) - (time_t) domus_history_days * DOMUS_HISTORY_SECONDS_PER_DAY;
+    if (from < cutoff) from = cutoff;
+    if (to < from) return 0;
+
+    width = (to - from) / DOMUS_HISTORY_BUCKETS + 1;
+    if (width < (time_t) domus_history_seconds) width = (time_t) domus_history_seconds;
+    memset(buckets, 0, sizeof(DomusHistoryBucket) * DOMUS_HISTORY_BUCKETS);
+
+    /* Points appended to the file come first, then the block still in memory */
+    domus_history_file(path, id, metric);
+    if ((data = domus_history_read(path, &size)) != NULL) {
+        for (offset = 0; (length = domus_history_block(data, size, offset, &block)) != 0; offset += length) {
+            if (block.last < from || block.first > to) continue;
+
+            columns = data + offset + sizeof(DomusHistoryBlock);
+            series_decoder_init(&decoder, columns, block.timestamps_length, columns + block.timestamps_length,
+                                block.values_length, block.count);
+            domus_history_bucket_decode(&decoder, buckets, from, to, width);
+        }
+        free(data);
+    }
+
+    list_for_each(series, domus_history_list) {
+        if (series->id != id || strcmp(domus_history_metrics[series->metric].name, metric) != 0) continue;
+
+        series_decoder_init(&decoder, series->encoder.timestamps_data,
+                            series_encoder_timestamps_length(&series->encoder), series->encoder.values_data,
+                            series_encoder_values_length(&series->encoder), series->encoder.count);
+        domus_history_bucket_decode(&decoder, buckets, from, to, width);
+    }
+
+    for (i = 0; i < DOMUS_HISTORY_BUCKETS; ++i) {
+        if (buckets[i].count > 0) buckets[filled++] = buckets[i];
+    }
+
+    return filled;
+}
+
+static void domus_history_bucket_add(DomusHistoryBucket *buckets, time_t from, time_t to, time_t width,
+                                     int64_t timestamp, double value) {
+    DomusHistoryBucket *bucket;
+    size_t index;
+    if (timestamp < (int64_t) from || timestamp > (int64_t) to) return;
+
+    index = (size_t) ((timestamp - (int64_t) from) / width);
+    if (index >= DOMUS_HISTORY_BUCKETS) index = DOMUS_HISTORY_BUCKETS - 1;
+    bucket = &buckets[index];
+
+    if (bucket->count == 0) {
+        bucket->from = from + (time_t) index * width;
+        bucket->to = bucket->from + width - 1;
+        if (bucket->to > to) bucket->to = to;
+        bucket->min = value;
+        bucket->max = value;
+    }
+    if (value < bucket->min) bucket->min = value;
+    if (value > bucket->max) bucket->max = value;
+    bucket->sum += value;
+    bucket->last = value;
+    bucket->count++;
+}
+
+static void domus_history_bucket_decode(SeriesDecoder *decoder, DomusHistoryBucket *buckets, time_t from, time_t to,
+                                        time_t width) {
+    int64_t timestamp;
+    double value;
+
+    while (series_decoder_next(decoder, &timestamp, &value)) {
+        domus_history_bucket_add(buckets, from, to, width, timestamp, value);
+    }
+}
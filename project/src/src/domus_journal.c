@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "domus.h"
+#include "domus_journal.h"
+#include "domus_snapshot.h"
+#include "util/util_crc.h"
+#include "util/util_periodic.h"
+
+/* Length of the entry without the text */
+#define DOMUS_JOURNAL_ENTRY_HEADER_LENGTH (offsetof(DomusJournalEntry, text))
+
+/**
+ * The journal file, empty if disabled
+ */
+static char domus_journal_file[DOMUS_JOURNAL_FILE_NAME_LENGTH] = "";
+static int domus_journal_fd = -1;
+static unsigned long domus_journal_ms = 0;
+
+/**
+ * The last sequence appended or replayed, sequences are never reused
+ */
+static uint64_t domus_journal_last = 0;
+
+/**
+ * Size of the journal and size that starts the next compaction
+ */
+static size_t domus_journal_bytes = 0;
+static size_t domus_journal_threshold = DOMUS_JOURNAL_COMPACT_SIZE;
+
+/**
+ * Entries not written yet, all of them are written and synced at the end of the window
+ */
+static char domus_journal_buffer[DOMUS_JOURNAL_BUFFER_LENGTH];
+static size_t domus_journal_buffered = 0;
+
+/**
+ * Flag if entries have been written since the last sync
+ */
+static bool domus_journal_dirty = false;
+
+/**
+ * Flag if the journal is being replayed, replayed mutations are not appended again
+ */
+static bool domus_journal_replaying = false;
+
+/**
+ * The process writing the compacted snapshot, 0 if none
+ */
+static pid_t domus_journal_compaction = 0;
+
+/**
+ * Build the name of a file next to the journal
+ * @param path The buffer of the name
+ * @param suffix The suffix added to the journal file name
+ */
+static void domus_journal_path(char *path, const char *suffix);
+
+/**
+ * Periodic task syncing the journal and starting a compaction when it is too big
+ */
+static void domus_journal_task(void);
+
+/**
+ * Write the buffered entries
+ * @return true if written, false otherwise
+ */
+static bool domus_journal_flush(void);
+
+/**
+ * Write the buffered entries and sync them to disk, one sync for the whole window
+ * @return true if synced, false otherwise
+ */
+static bool domus_journal_sync(void);
+
+/**
+ * Start a compaction: the journal is moved aside and a child process writes the snapshot and removes it
+ */
+static void domus_journal_compact(void);
+
+/**
+ * Wait for the process writing the compacted snapshot
+ * @param block true to wait until it ends, false to only check
+ */
+static void domus_journal_reap(bool block);
+
+/**
+ * Replay the entries of a journal file
+ * @param file_name The journal file
+ * @param after The last sequence already in the snapshot, older entries are skipped
+ * @param repair true to cut the file after the last valid entry
+ * @return The number of entries replayed
+ */
+static long domus_journal_replay(const char *file_name, uint64_t after, bool repair);
+
+/**
+ * Open the journal file for appending
+ * @return true if opened, false otherwise
+ */
+static bool domus_journal_open(void);
+
+static void domus_journal_path(char *path, const char *suffix) {
+    snprintf(path, DOMUS_JOURNAL_FILE_NAME_LENGTH + 8, "%s%s", domus_journal_file, suffix);
+}
+
+static bool domus_journal_open(void) {
+    struct stat file_stat;
+
+    if ((domus_journal_fd = open(domus_journal_file, O_WRONLY | O_CREAT | O_APPEND, 0644)) == -1) return false;
+    domus_journal_bytes = (fstat(domus_journal_fd, &file_stat) == 0) ? (size_t) file_stat.st_size : 0;
+
+    return true;
+}
+
+long domus_journal_enable(const char *file_name, unsigned long window, bool recover) {
+    DomusSnapshot *snapshot;
+    char path[DOMUS_JOURNAL_FILE_NAME_LENGTH + 8];
+    uint64_t after = 0;
+    long replayed = 0;
+    if (file_name == NULL || strlen(file_name) == 0 || strlen(file_name) >= DOMUS_JOURNAL_FILE_NAME_LENGTH ||
+        window == 0)
+        return -1;
+
+    domus_journal_disable();
+    strncpy(domus_journal_file, file_name, DOMUS_JOURNAL_FILE_NAME_LENGTH);
+
+    if (recover) {
+        domus_journal_path(path, DOMUS_JOURNAL_SNAPSHOT_SUFFIX);
+        if ((snapshot = domus_snapshot_open(path)) != NULL) {
+            after = snapshot->header->sequence;
+            free_domus_snapshot(snapshot);
+            domus_load(path);
+        } else if (access(path, F_OK) == 0) {
+            /* Replaying on anything but the right snapshot makes no sense */
+            domus_journal_file[0] = '\0';
+            return -1;
+        }
+        if (domus_journal_last < after) domus_journal_last = after;
+
+        domus_journal_replaying = true;
+        domus_journal_path(path, DOMUS_JOURNAL_OLD_SUFFIX);
+        replayed += domus_journal_replay(path, after, false);
+        replayed += domus_journal_replay(domus_journal_file, after, true);
+        domus_journal_replaying = false;
+    }
+
+    if (!domus_journal_open()) {
+        domus_journal_file[0] = '\0';
+        return -1;
+    }
+    if (!recover && !domus_journal_checkpoint()) {
+        domus_journal_disable();
+        return -1;
+    }
+
+    domus_journal_ms = window;
+    domus_journal_threshold = domus_journal_bytes + DOMUS_JOURNAL_COMPACT_SIZE;
+    periodic_register(domus_journal_task, window);
+
+    return replayed;
+}
+
+bool domus_journal_disable(void) {
+    if (domus_journal_fd == -1) return false;
+
+    periodic_unregister(domus_journal_task);
+    domus_journal_reap(true);
+    domus_journal_sync();
+    close(domus_journal_fd);
+    domus_journal_fd = -1;
+    domus_journal_file[0] = '\0';
+    domus_journal_ms = 0;
+
+    return true;
+}
+
+const char *domus_journal_file_name(void) {
+    return (domus_journal_fd == -1) ? NULL : domus_journal_file;
+}
+
+unsigned long domus_journal_window(void) {
+    return domus_journal_ms;
+}
+
+uint64_t domus_journal_sequence(void) {
+    return domus_journal_last;
+}
+
+size_t domus_journal_size(void) {
+    return domus_journal_bytes;
+}
+
+void domus_journal_append(uint16_t type, size_t id, size_t argument, const char *text) {
+    DomusJournalFrame frame;
+    DomusJournalEntry entry;
+    size_t length;
+    if (domus_journal_fd == -1 || domus_journal_replaying) return;
+
+    entry.sequence = ++domus_journal_last;
+    entry.type = type;
+    entry.id = (uint32_t) id;
+    entry.argument = (uint32_t) argument;
+    snprintf(entry.text, DOMUS_JOURNAL_TEXT_LENGTH, "%s", (text == NULL) ? "" : text);
+    entry.text_length = (uint16_t) (strlen(entry.text) + 1);
+
+    frame.length = (uint32_t) (DOMUS_JOURNAL_ENTRY_HEADER_LENGTH + entry.text_length);
+    frame.crc = crc32_update(CRC32_INIT, &entry, frame.length);
+
+    length = sizeof(DomusJournalFrame) + frame.length;
+    if (domus_journal_buffered + length > DOMUS_JOURNAL_BUFFER_LENGTH) domus_journal_flush();
+
+    memcpy(domus_journal_buffer + domus_journal_buffered, &frame, sizeof(DomusJournalFrame));
+    memcpy(domus_journal_buffer + domus_journal_buffered + sizeof(DomusJournalFrame), &entry, frame.length);
+    domus_journal_buffered += length;
+    domus_journal_bytes += length;
+}
+
+bool domus_journal_checkpoint(void) {
+    List *message_list;
+    char path[DOMUS_JOURNAL_FILE_NAME_LENGTH + 8];
+    bool toRtn;
+    if (domus_journal_fd == -1) return false;
+
+    domus_journal_reap(true);
+    domus_journal_sync();
+
+    message_list = domus_info_list(DEVICE_MESSAGE_TO_ALL_DEVICES);
+    domus_journal_path(path, DOMUS_JOURNAL_SNAPSHOT_SUFFIX);
+    toRtn = domus_snapshot_write(path, message_list, domus_next_id(), domus_journal_last);
+    free_list(message_list);
+    if (!toRtn) return false;
+
+    /* Every entry is in the snapshot now */
+    domus_journal_path(path, DOMUS_JOURNAL_OLD_SUFFIX);
+    unlink(path);
+    if (ftruncate(domus_journal_fd, 0) == -1) return false;
+    domus_journal_bytes = 0;
+    domus_journal_threshold = DOMUS_JOURNAL_COMPACT_SIZE;
+
+    return true;
+}
+
+static void domus_journal_task(void) {
+    domus_journal_sync();
+    domus_journal_reap(false);
+
+    if (domus_journal_compaction == 0 && domus_journal_bytes >= domus_journal_threshold) domus_journal_compact();
+}
+
+static bool domus_journal_flush(void) {
+    ssize_t written;
+    size_t offset = 0;
+    if (domus_journal_fd == -1) return false;
+
+    while (offset < domus_journal_buffered) {
+        if ((written = write(domus_journal_fd, domus_journal_buffer + offset, domus_journal_buffered - offset)) == -1) {
+            if (errno == EINTR) continue;
+            perror("Domus Journal Write");
+            break;
+        }
+        offset += (size_t) written;
+        domus_journal_dirty = true;
+    }
+    domus_journal_buffered = 0;
+
+    return offset > 0;
+}
+
+static bool domus_journal_sync(void) {
+    if (domus_journal_fd == -1) return false;
+
+    if (domus_journal_buffered > 0) domus_journal_flush();
+    if (!domus_journal_dirty) return true;
+
+    domus_journal_dirty = false;
+    return fdatasync(domus_journal_fd) == 0;
+}
+
+static void domus_journal_compact(void) {
+    List *message_list;
+    char old[DOMUS_JOURNAL_FILE_NAME_LENGTH + 8];
+    char snapshot[DOMUS_JOURNAL_FILE_NAME_LENGTH + 8];
+    size_t next_id;
+    uint64_t sequence;
+    pid_t pid;
+
+    domus_journal_sync();
+    domus_journal_path(old, DOMUS_JOURNAL_OLD_SUFFIX);
+    domus_journal_path(snapshot, DOMUS_JOURNAL_SNAPSHOT_SUFFIX);
+
+    /* The Devices are asked before any other mutation, their state matches the last sequence */
+    message_list = domus_info_list(DEVICE_MESSAGE_TO_ALL_DEVICES);
+    next_id = domus_next_id();
+    sequence = domus_journal_last;
+
+    /* A journal left aside by a failed compaction stays, the replay skips what the snapshot has */
+    if (access(old, F_OK) == -1 && errno == ENOENT && rename(domus_journal_file, old) == 0) {
+        close(domus_journal_fd);
+        if (!domus_journal_open()) {
+            perror("Domus Journal Open");
+            domus_journal_fd = -1;
+        }
+    }
+
+    switch (pid = fork()) {
+        case -1: {
+            domus_journal_threshold = domus_journal_bytes + DOMUS_JOURNAL_COMPACT_SIZE;
+            break;
+        }
+        case 0: {
+            /* Only the file is written, the Devices belong to the parent */
+            if (!domus_snapshot_write(snapshot, message_list, next_id, sequence)) _exit(EXIT_FAILURE);
+            unlink(old);
+            _exit(EXIT_SUCCESS);
+        }
+        default: {
+            domus_journal_compaction = pid;
+            domus_journal_threshold = domus_journal_bytes + DOMUS_JOURNAL_COMPACT_SIZE;
+            break;
+        }
+    }
+
+    free_list(message_list);
+}
+
+static void domus_journal_reap(bool block) {
+    int status;
+    pid_t pid;
+    if (domus_journal_compaction == 0) return;
+
+    while ((pid = waitpid(domus_journal_compaction, &status, (block) ? 0 : WNOHANG)) == -1 && errno == EINTR);
+    if (pid == 0) return;
+
+    domus_journal_compaction = 0;
+    /* Retry only after the journal has grown again */
+    if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        domus_journal_threshold = domus_journal_bytes + DOMUS_JOURNAL_COMPACT_SIZE;
+}
+
+static long domus_journal_replay(const char *file_name, uint64_t after, bool repair) {
+    FILE *file;
+    DomusJournalFrame frame;
+    DomusJournalEntry entry;
+    long offset = 0;
+    long replayed = 0;
+
+    if ((file = fopen(file_name, "r")) == NULL) return 0;
+
+    while (fread(&frame, sizeof(DomusJournalFrame), 1, file) == 1) {
+        if (frame.length <= DOMUS_JOURNAL_ENTRY_HEADER_LENGTH || frame.length > sizeof(DomusJournalEntry)) break;
+
+        memset(&entry, 0, sizeof(DomusJournalEntry));
+        if (fread(&entry, frame.length, 1, file) != 1) break;
+        if (crc32_update(CRC32_INIT, &entry, frame.length) != frame.crc) break;
+        if (DOMUS_JOURNAL_ENTRY_HEADER_LENGTH + entry.text_length != frame.length ||
+            entry.text[entry.text_length - 1] != '\0')
+            break;
+
+        offset += (long) (sizeof(DomusJournalFrame) + frame.length);
+        if (entry.sequence > domus_journal_last) domus_journal_last = entry.sequence;
+        if (entry.sequence <= after) continue;
+
+        domus_replay(&entry);
+        replayed++;
+    }
+
+    /* What follows the last valid entry is a torn write, new entries must not end up after it */
+    if (repair && fseek(file, 0, SEEK_END) == 0 && ftell(file) > offset) {
+        if (truncate(file_name, offset) == -1) perror("Domus Journal Truncate");
+    }
+    fclose(file);
+
+    return replayed;
+}
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "domus.h"
+#include "domus_metrics.h"
+#include "device/device_communication.h"
+#include "device/device_communication_stats.h"
+#include "util/util_converter.h"
+#include "util/util_periodic.h"
+
+/* Device Descriptor ids are small, Domus itself is never counted */
+#define DOMUS_METRICS_DEVICE_TYPES 8
+
+/**
+ * Counters of Domus, always updated since they cost an increment
+ */
+static DomusMetricsOperation domus_metrics_operations[DOMUS_METRICS_OPERATIONS];
+static unsigned long domus_metrics_requests[DOMUS_METRICS_REQUESTS];
+
+/**
+ * The metrics file, empty if disabled
+ */
+static char domus_metrics_file[DOMUS_METRICS_FILE_NAME_LENGTH] = "";
+static unsigned long domus_metrics_seconds = 0;
+
+static const char *domus_metrics_operation_names[DOMUS_METRICS_OPERATIONS] = {"spawn", "link", "del", "save", "load",
+                                                                                "clone"};
+static const char *domus_metrics_request_names[DOMUS_METRICS_REQUESTS] = {"domus_pid", "device_pid"};
+
+/**
+ * Periodic task writing the metrics file
+ */
+static void domus_metrics_task(void);
+
+/**
+ * Write the Device counts by type and state and the active time of every Device
+ * @param file The metrics file
+ */
+static void domus_metrics_write_devices(FILE *file);
+
+/**
+ * Write the message counters and the send to ack latency histograms of Domus
+ * @param file The metrics file
+ */
+static void domus_metrics_write_messages(FILE *file);
+
+/**
+ * Write the operation and Domus Manual request counters
+ * @param file The metrics file
+ */
+static void domus_metrics_write_operations(FILE *file);
+
+/**
+ * Write a Prometheus label value, escaping backslashes, quotes and new lines
+ * @param file The metrics file
+ * @param value The label value
+ */
+static void domus_metrics_write_label(FILE *file, const char *value);
+
+void domus_metrics_operation(size_t operation, Stopwatch start, bool success) {
+    if (operation >= DOMUS_METRICS_OPERATIONS) return;
+
+    domus_metrics_operations[operation].count++;
+    domus_metrics_operations[operation].duration += stopwatch_elapsed(start);
+    if (!success) domus_metrics_operations[operation].errors++;
+}
+
+void domus_metrics_request(size_t request) {
+    if (request >= DOMUS_METRICS_REQUESTS) return;
+
+    domus_metrics_requests[request]++;
+}
+
+bool domus_metrics_enable(const char *file_name, unsigned long interval) {
+    if (file_name == NULL || strlen(file_name) == 0 || strlen(file_name) >= DOMUS_METRICS_FILE_NAME_LENGTH ||
+        interval == 0)
+        return false;
+
+    strncpy(domus_metrics_file, file_name, DOMUS_METRICS_FILE_NAME_LENGTH);
+    if (!domus_metrics_write()) {
+        domus_metrics_disable();
+        return false;
+    }
+
+    domus_metrics_seconds = interval;
+    periodic_register(domus_metrics_task, interval * 1000);
+
+    return true;
+}
+
+bool domus_metrics_disable(void) {
+    bool enabled = domus_metrics_file[0] != '\0';
+
+    periodic_unregister(domus_metrics_task);
+    domus_metrics_file[0] = '\0';
+    domus_metrics_seconds = 0;
+
+    return enabled;
+}
+
+const char *domus_metrics_file_name(void) {
+    return (domus_metrics_file[0] == '\0') ? NULL : domus_metrics_file;
+}
+
+unsigned long domus_metrics_interval(void) {
+    return domus_metrics_seconds;
+}
+
+static void domus_metrics_task(void) {
+    domus_metrics_write();
+}
+
+bool domus_metrics_write(void) {
+    FILE *file;
+    char temporary[DOMUS_METRICS_FILE_NAME_LENGTH + 32];
+    bool written;
+    if (domus_metrics_file[0] == '\0') return false;
+
+    /* Same directory, so the rename is atomic */
+    snprintf(temporary, sizeof(temporary), "%s.%d.tmp", domus_metrics_file, getpid());
+    if ((file = fopen(temporary, "w")) == NULL) return false;
+
+    domus_metrics_write_devices(file);
+    domus_metrics_write_messages(file);
+    domus_metrics_write_operations(file);
+
+    written = fflush(file) == 0 && !ferror(file);
+    if (fclose(file) != 0) written = false;
+    if (written && rename(temporary, domus_metrics_file) == 0) return true;
+
+    unlink(temporary);
+    return false;
+}
+
+static void domus_metrics_write_devices(FILE *file) {
+    List *message_list;
+    DeviceCommunicationMessage *data;
+    const DeviceDescriptor *device_descriptor;
+    unsigned long devices[DOMUS_METRICS_DEVICE_TYPES][2];
+    ConverterResult state;
+    char **fields;
+    size_t type;
+
+    memset(devices, 0, sizeof(devices));
+    message_list = domus_info_list(DEVICE_MESSAGE_TO_ALL_DEVICES);
+
+    fprintf(file, "# HELP domus_device_active_seconds Seconds a bulb has been on or a window or fridge open\n");
+    fprintf(file, "# TYPE domus_device_active_seconds gauge\n");
+    list_for_each(data, message_list) {
+        fields = device_communication_split_message_fields(data->message);
+        if (fields == NULL || fields[0] == NULL) {
+            device_communication_free_message_fields(fields);
+            continue;
+        }
+
+        state = converter_char_to_bool(fields[0][0]);
+        if (data->id_device_descriptor < DOMUS_METRICS_DEVICE_TYPES && !state.error)
+            devices[data->id_device_descriptor][state.data.Bool]++;
+
+        switch (data->id_device_descriptor) {
+            case DEVICE_TYPE_BULB:
+            case DEVICE_TYPE_WINDOW:
+            case DEVICE_TYPE_FRIDGE: {
+                if (fields[1] == NULL || converter_string_to_double(fields[1]).error) break;
+
+                device_descriptor = device_is_supported_by_id(data->id_device_descriptor);
+                fprintf(file, "domus_device_active_seconds{id=\"%lu\",type=\"%s\",name=\"", data->id_sender,
+                        device_descriptor->name);
+                domus_metrics_write_label(file, data->device_name);
+                fprintf(file, "\"} %s\n", fields[1]);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+
+        device_communication_free_message_fields(fields);
+    }
+    free_list(message_list);
+
+    fprintf(file, "# HELP domus_devices Devices by type and state\n");
+    fprintf(file, "# TYPE domus_devices gauge\n");
+    for (type = DEVICE_TYPE_DOMUS + 1; type < DOMUS_METRICS_DEVICE_TYPES; ++type) {
+        if ((device_descriptor = device_is_supported_by_id(type)) == NULL) continue;
+
+        fprintf(file, "domus_devices{type=\"%s\",state=\"on\"} %lu\n", device_descriptor->name, devices[type][1]);
+        fprintf(file, "domus_devices{type=\"%s\",state=\"off\"} %lu\n", device_descriptor->name, devices[type][0]);
+    }
+}
+
+static void domus_metrics_write_messages(FILE *file) {
+    const DeviceCommunicationStats *stats = device_communication_stats();
+    const DeviceCommunicationStatsCounters *counters = device_communication_stats_counters();
+    const DeviceCommunicationStatsHistogram *histogram;
+    const double bounds[] = DOMUS_METRICS_LATENCY_BOUNDS;
+    const char *name;
+    size_t index;
+    size_t i;
+
+    fprintf(file, "# HELP domus_messages_written_total Messages written by Domus to its Devices\n");
+    fprintf(file, "# TYPE domus_messages_written_total counter\n");
+    for (index = 0; index < DEVICE_COMMUNICATION_STATS_TYPES; ++index) {
+        if (counters->written[index] == 0) continue;
+        if ((name = device_communication_stats_type_name(device_communication_stats_type(index))) == NULL) continue;
+        fprintf(file, "domus_messages_written_total{type=\"%s\"} %lu\n", name, counters->written[index]);
+    }
+
+    fprintf(file, "# HELP domus_messages_read_total Messages read by Domus from its Devices\n");
+    fprintf(file, "# TYPE domus_messages_read_total counter\n");
+    for (index = 0; index < DEVICE_COMMUNICATION_STATS_TYPES; ++index) {
+        if (counters->read[index] == 0) continue;
+        if ((name = device_communication_stats_type_name(device_communication_stats_type(index))) == NULL) continue;
+        fprintf(file, "domus_messages_read_total{type=\"%s\"} %lu\n", name, counters->read[index]);
+    }
+
+    fprintf(file, "# HELP domus_message_errors_total Acks of type error or with an ERROR status\n");
+    fprintf(file, "# TYPE domus_message_errors_total counter\n");
+    for (index = 0; index < DEVICE_COMMUNICATION_STATS_TYPES; ++index) {
+        histogram = &stats->histogram[index];
+        if (histogram->count == 0) continue;
+        if ((name = device_communication_stats_type_name(device_communication_stats_type(index))) == NULL) continue;
+        fprintf(file, "domus_message_errors_total{type=\"%s\"} %lu\n", name, histogram->errors);
+    }
+
+    fprintf(file, "# HELP domus_message_latency_seconds Send to ack latency of the messages written by Domus\n");
+    fprintf(file, "# TYPE domus_message_latency_seconds histogram\n");
+    for (index = 0; index < DEVICE_COMMUNICATION_STATS_TYPES; ++index) {
+        histogram = &stats->histogram[index];
+        if (histogram->count == 0) continue;
+        if ((name = device_communication_stats_type_name(device_communication_stats_type(index))) == NULL) continue;
+
+        for (i = 0; i < sizeof(bounds) / sizeof(double); ++i) {
+            fprintf(file, "domus_message_latency_seconds_bucket{type=\"%s\",le=\"%g\"} %lu\n", name, bounds[i],
+                    device_communication_stats_cumulative(histogram, (Stopwatch) (bounds[i] * 1000000000.0)));
+        }
+        fprintf(file, "domus_message_latency_seconds_bucket{type=\"%s\",le=\"+Inf\"} %lu\n", name, histogram->count);
+        fprintf(file, "domus_message_latency_seconds_sum{type=\"%s\"} %.9f\n", name,
+                (double) histogram->sum / 1000000000.0);
+        fprintf(file, "domus_message_latency_seconds_count{type=\"%s\"} %lu\n", name, histogram->count);
+    }
+}
+
+static void domus_metrics_write_operations(FILE *file) {
+    size_t i;
+
+    fprintf(file, "# HELP domus_operations_total Topology operations executed by Domus\n");
+    fprintf(file, "# TYPE domus_operations_total counter\n");
+    for (i = 0; i < DOMUS_METRICS_OPERATIONS; ++i) {
+        fprintf(file, "domus_operations_total{operation=\"%s\"} %lu\n", domus_metrics_operation_names[i],
+                domus_metrics_operations[i].count);
+    }
+
+    fprintf(file, "# HELP domus_operation_errors_total Topology operations that failed\n");
+    fprintf(file, "# TYPE domus_operation_errors_total counter\n");
+    for (i = 0; i < DOMUS_METRICS_OPERATIONS; ++i) {
+        fprintf(file, "domus_operation_errors_total{operation=\"%s\"} %lu\n", domus_metrics_operation_names[i],
+                domus_metrics_operations[i].errors);
+    }
+
+    fprintf(file, "# HELP domus_operation_duration_seconds_total Time spent executing topology operations\n");
+    fprintf(file, "# TYPE domus_operation_duration_seconds_total counter\n");
+    for (i = 0; i < DOMUS_METRICS_OPERATIONS; ++i) {
+        fprintf(file, "domus_operation_duration_seconds_total{operation=\"%s\"} %.9f\n",
+                domus_metrics_operation_names[i], (double) domus_metrics_operations[i].duration / 1000000000.0);
+    }
+
+    fprintf(file, "# HELP domus_manual_requests_total Requests received from Domus Manual\n");
+    fprintf(file, "# TYPE domus_manual_requests_total counter\n");
+    for (i = 0; i < DOMUS_METRICS_REQUESTS; ++i) {
+        fprintf(file, "domus_manual_requests_total{request=\"%s\"} %lu\n", domus_metrics_request_names[i],
+                domus_metrics_requests[i]);
+    }
+}
+
+static void domus_metrics_write_label(FILE *file, const char *value) {
+    for (; *value != '\0'; ++value) {
+        switch (*value) {
+            case '\\':
+            case '"': {
+                fprintf(file, "\\%c", *value);
+                break;
+            }
+            case '\n': {
+                fprintf(file, "\\n");
+                break;
+            }
+            default: {
+                fputc(*value, file);
+                break;
+            }
+        }
+    }
+}
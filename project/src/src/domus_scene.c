@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "domus.h"
+#include "domus_scene.h"
+
+/**
+ * Groups and scenes, created on first use
+ */
+static List *domus_scene_groups = NULL;
+static List *domus_scene_scenes = NULL;
+
+/**
+ * Compare a group with a name
+ * @param data1 The group
+ * @param data2 The name
+ * @return true if the group has the name, false otherwise
+ */
+static bool domus_group_equals(const void *data1, const void *data2);
+
+/**
+ * Compare a scene with a name
+ * @param data1 The scene
+ * @param data2 The name
+ * @return true if the scene has the name, false otherwise
+ */
+static bool domus_scene_equals(const void *data1, const void *data2);
+
+/**
+ * Check if a name is valid for a group or a scene
+ * @param name The name
+ * @return true if valid, false otherwise
+ */
+static bool domus_scene_is_name(const char *name);
+
+static bool domus_group_equals(const void *data1, const void *data2) {
+    if (data1 == NULL || data2 == NULL) return false;
+    return strcmp(((const DomusGroup *) data1)->name, (const char *) data2) == 0;
+}
+
+static bool domus_scene_equals(const void *data1, const void *data2) {
+    if (data1 == NULL || data2 == NULL) return false;
+    return strcmp(((const DomusScene *) data1)->name, (const char *) data2) == 0;
+}
+
+static bool domus_scene_is_name(const char *name) {
+    return name != NULL && strlen(name) > 0 && strlen(name) < DOMUS_SCENE_NAME_LENGTH;
+}
+
+bool domus_group_create(const char *name, const size_t *ids, size_t count) {
+    DomusGroup *group;
+    if (!domus_scene_is_name(name) || ids == NULL || count == 0 || count > DEVICE_COMMUNICATION_SCENE_TARGETS)
+        return false;
+
+    if ((group = (DomusGroup *) domus_group_get(name)) == NULL) {
+        if (domus_scene_groups == NULL) domus_scene_groups = new_list(NULL, domus_group_equals);
+
+        group = (DomusGroup *) malloc(sizeof(DomusGroup));
+        if (group == NULL) {
+            perror("Domus Group Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+        strcpy(group->name, name);
+        list_add_last(domus_scene_groups, group);
+    }
+
+    memcpy(group->ids, ids, sizeof(size_t) * count);
+    group->count = count;
+
+    return true;
+}
+
+bool domus_group_delete(const char *name) {
+    if (domus_scene_groups == NULL || name == NULL) return false;
+
+    return list_remove(domus_scene_groups, name);
+}
+
+const DomusGroup *domus_group_get(const char *name) {
+    DomusGroup *group;
+    if (domus_scene_groups == NULL || name == NULL) return NULL;
+
+    list_for_each(group, domus_scene_groups) {
+        if (strcmp(group->name, name) == 0) return group;
+    }
+
+    return NULL;
+}
+
+const List *domus_groups(void) {
+    if (domus_scene_groups == NULL) domus_scene_groups = new_list(NULL, domus_group_equals);
+
+    return domus_scene_groups;
+}
+
+long domus_group_switch(const char *name, const char *switch_label, const char *switch_pos) {
+    const DomusGroup *group;
+    DeviceCommunicationScene scene;
+    size_t i;
+    if ((group = domus_group_get(name)) == NULL) return -1;
+
+    device_communication_scene_init(&scene);
+    for (i = 0; i < group->count; ++i) {
+        if (!device_communication_scene_add(&scene, group->ids[i], switch_label, switch_pos)) return -1;
+    }
+
+    if (domus_transaction_is_open()) return domus_transaction_stage_scene(&scene);
+    return domus_switch_multi(&scene);
+}
+
+bool domus_scene_create(const char *name, const DeviceCommunicationScene *scene) {
+    DomusScene *domus_scene;
+    if (!domus_scene_is_name(name) || device_communication_scene_is_empty(scene)) return false;
+
+    if ((domus_scene = (DomusScene *) domus_scene_get(name)) == NULL) {
+        if (domus_scene_scenes == NULL) domus_scene_scenes = new_list(NULL, domus_scene_equals);
+
+        domus_scene = (DomusScene *) malloc(sizeof(DomusScene));
+        if (domus_scene == NULL) {
+            perror("Domus Scene Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+        strcpy(domus_scene->name, name);
+        list_add_last(domus_scene_scenes, domus_scene);
+    }
+
+    domus_scene->scene = *scene;
+
+    return true;
+}
+
+bool domus_scene_delete(const char *name) {
+    if (domus_scene_scenes == NULL || name == NULL) return false;
+
+    return list_remove(domus_scene_scenes, name);
+}
+
+const DomusScene *domus_scene_get(const char *name) {
+    DomusScene *domus_scene;
+    if (domus_scene_scenes == NULL || name == NULL) return NULL;
+
+    list_for_each(domus_scene, domus_scene_scenes) {
+        if (strcmp(domus_scene->name, name) == 0) return domus_scene;
+    }
+
+    return NULL;
+}
+
+const List *domus_scenes(void) {
+    if (domus_scene_scenes == NULL) domus_scene_scenes = new_list(NULL, domus_scene_equals);
+
+    return domus_scene_scenes;
+}
+
+long domus_scene_apply(const char *name) {
+    const DomusScene *domus_scene;
+    if ((domus_scene = domus_scene_get(name)) == NULL) return -1;
+
+    if (domus_transaction_is_open()) return domus_transaction_stage_scene(&domus_scene->scene);
+    return domus_switch_multi(&domus_scene->scene);
+}
+
+void domus_scene_tini(void) {
+    free_list(domus_scene_groups);
+    free_list(domus_scene_scenes);
+    domus_scene_groups = NULL;
+    domus_scene_scenes = NULL;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "domus.h"
+#include "domus_snapshot.h"
+#include "device/device_communication.h"
+
+/**
+ * Round a length up to the snapshot alignment
+ * @param length The length
+ * @return The aligned length
+ */
+static size_t domus_snapshot_align(size_t length);
+
+/**
+ * Write the records of every Device, computing the parent of each one from its depth
+ * @param file The snapshot file
+ * @param message_list The info messages in hierarchy order
+ * @return The number of records written
+ */
+static uint32_t domus_snapshot_write_records(FILE *file, const List *message_list);
+
+/**
+ * Check that every record lies inside the mapped file
+ * @param snapshot The Domus Snapshot to check
+ * @return true if valid, false otherwise
+ */
+static bool domus_snapshot_check(const DomusSnapshot *snapshot);
+
+static size_t domus_snapshot_align(size_t length) {
+    return (length + DOMUS_SNAPSHOT_ALIGNMENT - 1) & ~((size_t) DOMUS_SNAPSHOT_ALIGNMENT - 1);
+}
+
+bool domus_snapshot_write(const char *file_name, const List *message_list, size_t next_id, uint64_t sequence) {
+    FILE *file;
+    DomusSnapshotHeader header;
+    char temporary[DOMUS_SNAPSHOT_FILE_NAME_LENGTH + 32];
+    bool written;
+    if (file_name == NULL || message_list == NULL) return false;
+    if (strlen(file_name) == 0 || strlen(file_name) >= DOMUS_SNAPSHOT_FILE_NAME_LENGTH) return false;
+
+    /* Same directory, so the rename is atomic */
+    snprintf(temporary, sizeof(temporary), "%s.%d.tmp", file_name, getpid());
+    if ((file = fopen(temporary, "w")) == NULL) return false;
+
+    /* The count is known only at the end, the header is written twice */
+    memset(&header, 0, sizeof(DomusSnapshotHeader));
+    memcpy(header.magic, DOMUS_SNAPSHOT_MAGIC, DOMUS_SNAPSHOT_MAGIC_LENGTH);
+    header.version = DOMUS_SNAPSHOT_VERSION;
+    header.next_id = (uint32_t) next_id;
+    header.sequence = sequence;
+    fwrite(&header, sizeof(DomusSnapshotHeader), 1, file);
+
+    header.count = domus_snapshot_write_records(file, message_list);
+    written = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(DomusSnapshotHeader), 1, file) == 1;
+
+    /* The rename must never be on disk before the data */
+    written = written && fflush(file) == 0 && !ferror(file) && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0) written = false;
+    if (written && rename(temporary, file_name) == 0) return true;
+
+    unlink(temporary);
+    return false;
+}
+
+static uint32_t domus_snapshot_write_records(FILE *file, const List *message_list) {
+    DeviceCommunicationMessage *data;
+    DomusSnapshotRecord record;
+    const char padding[DOMUS_SNAPSHOT_ALIGNMENT] = {0};
+    size_t *parents;
+    size_t depth;
+    uint32_t count = 0;
+
+    /* The depth of a Device is at most the number of Devices */
+    parents = (size_t *) malloc(sizeof(size_t) * (message_list->size + 1));
+    if (parents == NULL) {
+        perror("Domus Snapshot Parents Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    list_for_each(data, message_list) {
+        depth = data->ctr_hop;
+        if (depth < 1 || depth > message_list->size) continue;
+        parents[depth] = data->id_sender;
+
+        memset(&record, 0, sizeof(DomusSnapshotRecord));
+        record.id = (uint32_t) data->id_sender;
+        record.parent = (depth == 1) ? DOMUS_ID : (uint32_t) parents[depth - 1];
+        record.device_descriptor = (uint16_t) data->id_device_descriptor;
+        record.values_length = (uint16_t) (strnlen(data->message, DEVICE_COMMUNICATION_MESSAGE_LENGTH - 1) + 1);
+        strncpy(record.name, data->device_name, DEVICE_NAME_LENGTH - 1);
+
+        fwrite(&record, sizeof(DomusSnapshotRecord), 1, file);
+        fwrite(data->message, record.values_length - 1, 1, file);
+        fwrite(padding, 1, 1, file);
+        fwrite(padding, domus_snapshot_align(record.values_length) - record.values_length, 1, file);
+        count++;
+    }
+
+    free(parents);
+
+    return count;
+}
+
+DomusSnapshot *domus_snapshot_open(const char *file_name) {
+    DomusSnapshot *snapshot;
+    struct stat file_stat;
+    void *data;
+    int fd;
+    if (file_name == NULL) return NULL;
+
+    if ((fd = open(file_name, O_RDONLY)) == -1) return NULL;
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size < (off_t) sizeof(DomusSnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    data = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    /* The mapping outlives the descriptor */
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    snapshot = (DomusSnapshot *) malloc(sizeof(DomusSnapshot));
+    if (snapshot == NULL) {
+        perror("Domus Snapshot Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    snapshot->data = data;
+    snapshot->size = (size_t) file_stat.st_size;
+    snapshot->header = (const DomusSnapshotHeader *) data;
+
+    if (!domus_snapshot_check(snapshot)) {
+        free_domus_snapshot(snapshot);
+        return NULL;
+    }
+
+    return snapshot;
+}
+
+static bool domus_snapshot_check(const DomusSnapshot *snapshot) {
+    const DomusSnapshotRecord *record;
+    size_t offset = sizeof(DomusSnapshotHeader);
+    uint32_t i;
+
+    if (memcmp(snapshot->header->magic, DOMUS_SNAPSHOT_MAGIC, DOMUS_SNAPSHOT_MAGIC_LENGTH) != 0) return false;
+    if (snapshot->header->version != DOMUS_SNAPSHOT_VERSION) return false;
+
+    for (i = 0; i < snapshot->header->count; ++i) {
+        if (snapshot->size - offset < sizeof(DomusSnapshotRecord)) return false;
+        record = (const DomusSnapshotRecord *) ((const char *) snapshot->data + offset);
+        offset += sizeof(DomusSnapshotRecord);
+
+        if (record->values_length == 0 || record->values_length > DEVICE_COMMUNICATION_MESSAGE_LENGTH) return false;
+        if (snapshot->size - offset < domus_snapshot_align(record->values_length)) return false;
+        if (domus_snapshot_values(record)[record->values_length - 1] != '\0') return false;
+        if (memchr(record->name, '\0', DEVICE_NAME_LENGTH) == NULL) return false;
+        if (device_is_supported_by_id(record->device_descriptor) == NULL) return false;
+
+        offset += domus_snapshot_align(record->values_length);
+    }
+
+    return offset == snapshot->size;
+}
+
+bool free_domus_snapshot(DomusSnapshot *snapshot) {
+    if (snapshot == NULL) return false;
+
+    munmap(snapshot->data, snapshot->size);
+    free(snapshot);
+
+    return true;
+}
+
+const DomusSnapshotRecord *domus_snapshot_next(const DomusSnapshot *snapshot, size_t *offset) {
+    const DomusSnapshotRecord *record;
+    if (snapshot == NULL || offset == NULL) return NULL;
+
+    if (*offset == 0) *offset = sizeof(DomusSnapshotHeader);
+    if (*offset >= snapshot->size) return NULL;
+
+    record = (const DomusSnapshotRecord *) ((const char *) snapshot->data + *offset);
+    *offset += sizeof(DomusSnapshotRecord) + domus_snapshot_align(record->values_length);
+
+    return record;
+}
+
+const char *domus_snapshot_values(const DomusSnapshotRecord *record) {
+    if (record == NULL) return NULL;
+
+    return (const char *) record + sizeof(DomusSnapshotRecord);
+}
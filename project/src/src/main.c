@@ -1,13 +1,18 @@
 
 #include <stdlib.h>
+#include <string.h>
 #include "domus.h"
 #include "author.h"
+#include "cli/cli.h"
 #include "util/util_printer.h"
 
 #define DOMUS_VERSION "1.0.0"
 #define DOMUS_LICENSE "MIT"
 #define DOMUS_SLOGAN "Unicuique sua domus nota"
 #define DOMUS_DESCRIPTION "Home Automation at your CLI"
+#define DOMUS_ARG_SCRIPT "--script"
+#define DOMUS_ARG_TIMING "--timing"
+#define DOMUS_ARG_JOURNAL "--journal"
 
 /**
  * Show information about Domus
@@ -19,15 +24,54 @@ static void domus_information(void);
  */
 static void domus_welcome(void);
 
+/**
+ * Parse the command line arguments
+ * @param argc Number of arguments
+ * @param args Arguments
+ * @return true if valid, false otherwise
+ */
+static bool domus_arguments(int argc, char **args);
+
 int main(int argc, char **args) {
-    /* Show Domus Welcome Page */
-    domus_welcome();
+    if (!domus_arguments(argc, args)) return EXIT_FAILURE;
+    /* Show Domus Welcome Page only if interactive */
+    if (cli_is_interactive()) domus_welcome();
     /* Start Domus System */
     domus_start();
 
     return EXIT_SUCCESS;
 }
 
+static bool domus_arguments(int argc, char **args) {
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(args[i], DOMUS_ARG_SCRIPT) == 0 && i + 1 < argc) {
+            if (!cli_set_script(args[++i])) {
+                fprintf(stderr, "Cannot open script %s\n", args[i]);
+                return false;
+            }
+        } else if (strcmp(args[i], DOMUS_ARG_TIMING) == 0 && i + 1 < argc) {
+            if (!cli_set_timing(args[++i])) {
+                fprintf(stderr, "Cannot open timing file %s\n", args[i]);
+                return false;
+            }
+        } else if (strcmp(args[i], DOMUS_ARG_JOURNAL) == 0 && i + 1 < argc) {
+            if (strlen(args[++i]) >= DOMUS_JOURNAL_FILE_NAME_LENGTH) {
+                fprintf(stderr, "Journal file name too long %s\n", args[i]);
+                return false;
+            }
+            domus_set_journal(args[i]);
+        } else {
+            fprintf(stderr, "Usage: %s [%s <file>] [%s <file>] [%s <file>]\n", args[0], DOMUS_ARG_SCRIPT,
+                    DOMUS_ARG_TIMING, DOMUS_ARG_JOURNAL);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static void domus_information(void) {
     println_color(COLOR_YELLOW, "- AUTHORS");
     author_print_all();
@@ -0,0 +1,38 @@
+#include <stdbool.h>
+#include "util/util_crc.h"
+
+#define CRC32_POLYNOMIAL 0xEDB88320UL
+
+/**
+ * Table of the CRC-32 of every byte, built on first use
+ */
+static uint32_t crc32_table[256];
+static bool crc32_table_ready = false;
+
+/**
+ * Build the CRC-32 table
+ */
+static void crc32_init(void);
+
+static void crc32_init(void) {
+    uint32_t crc;
+    size_t i;
+    size_t bit;
+
+    for (i = 0; i < 256; ++i) {
+        crc = (uint32_t) i;
+        for (bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+        crc32_table[i] = crc;
+    }
+    crc32_table_ready = true;
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t length) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    if (!crc32_table_ready) crc32_init();
+
+    crc = ~crc;
+    while (length-- > 0) crc = crc32_table[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
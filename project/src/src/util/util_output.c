@@ -0,0 +1,343 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "util/util_output.h"
+#include "util/util_printer.h"
+#include "collection/collection_list.h"
+
+/**
+ * Output format of the session
+ */
+static int output_session_format = OUTPUT_FORMAT_TABLE;
+
+/**
+ * Output format of the current command, -1 if not defined
+ */
+static int output_command_format = -1;
+
+/**
+ * List of collected records, every record is a List of Output Field
+ */
+static List *output_records = NULL;
+
+/**
+ * Create a new Output Field and add it to the current record
+ * @param key The field key
+ * @param type The field type
+ * @return The new Output Field, NULL if no record has been started
+ */
+static OutputField *new_output_field(const char *key, int type);
+
+/**
+ * Free a record
+ * @param record The record to free
+ */
+static void free_output_record(List *record);
+
+/**
+ * Find a field in a record given its key
+ * @param record The record
+ * @param key The field key
+ * @return The Output Field, NULL otherwise
+ */
+static const OutputField *output_record_get(const List *record, const char *key);
+
+/**
+ * Print a string escaped for JSON
+ * @param string The string
+ */
+static void output_print_json_string(const char *string);
+
+/**
+ * Print a string escaped for CSV
+ * @param string The string
+ */
+static void output_print_csv_string(const char *string);
+
+/**
+ * Print the value of a field
+ * @param field The Output Field, NULL is an empty value
+ * @param format The output format
+ */
+static void output_print_value(const OutputField *field, int format);
+
+/**
+ * Render the collected records as a JSON array
+ */
+static void output_render_json(void);
+
+/**
+ * Render the collected records as CSV
+ */
+static void output_render_csv(void);
+
+int output_format(void) {
+    return (output_command_format != -1) ? output_command_format : output_session_format;
+}
+
+int output_format_by_name(const char *name) {
+    if (name == NULL) return -1;
+    if (strcmp(name, OUTPUT_FORMAT_NAME_TABLE) == 0) return OUTPUT_FORMAT_TABLE;
+    if (strcmp(name, OUTPUT_FORMAT_NAME_JSON) == 0) return OUTPUT_FORMAT_JSON;
+    if (strcmp(name, OUTPUT_FORMAT_NAME_CSV) == 0) return OUTPUT_FORMAT_CSV;
+    return -1;
+}
+
+int output_format_by_flag(const char *flag) {
+    if (flag == NULL || strncmp(flag, OUTPUT_FLAG_PREFIX, strlen(OUTPUT_FLAG_PREFIX)) != 0) return -1;
+    return output_format_by_name(flag + strlen(OUTPUT_FLAG_PREFIX));
+}
+
+const char *output_format_name(int format) {
+    switch (format) {
+        case OUTPUT_FORMAT_JSON:
+            return OUTPUT_FORMAT_NAME_JSON;
+        case OUTPUT_FORMAT_CSV:
+            return OUTPUT_FORMAT_NAME_CSV;
+        default:
+            return OUTPUT_FORMAT_NAME_TABLE;
+    }
+}
+
+bool output_set_format(int format) {
+    if (format != OUTPUT_FORMAT_TABLE && format != OUTPUT_FORMAT_JSON && format != OUTPUT_FORMAT_CSV) return false;
+
+    output_session_format = format;
+    return true;
+}
+
+int output_set_command_format(int format) {
+    int previous_format = output_command_format;
+    output_command_format = format;
+    return previous_format;
+}
+
+void output_begin(void) {
+    if (output_records != NULL) free_list(output_records);
+    output_records = new_list((void (*)(void *)) free_output_record, NULL);
+}
+
+void output_record(void) {
+    if (output_records == NULL) return;
+    list_add_last(output_records, new_list(NULL, NULL));
+}
+
+static OutputField *new_output_field(const char *key, int type) {
+    OutputField *field;
+    if (output_records == NULL || list_is_empty(output_records) || key == NULL) return NULL;
+
+    field = (OutputField *) malloc(sizeof(OutputField));
+    if (field == NULL) {
+        perror("Output Field Memory Allocation");
+        exit(EXIT_FAILURE);
+    }
+
+    strncpy(field->key, key, OUTPUT_KEY_LENGTH - 1);
+    field->key[OUTPUT_KEY_LENGTH - 1] = '\0';
+    field->type = type;
+    list_add_last((List *) list_get_last(output_records), field);
+
+    return field;
+}
+
+static void free_output_record(List *record) {
+    free_list(record);
+}
+
+void output_null(const char *key) {
+    new_output_field(key, OUTPUT_FIELD_TYPE_NULL);
+}
+
+void output_bool(const char *key, bool value) {
+    OutputField *field = new_output_field(key, OUTPUT_FIELD_TYPE_BOOL);
+    if (field != NULL) field->value.Bool = value;
+}
+
+void output_long(const char *key, long value) {
+    OutputField *field = new_output_field(key, OUTPUT_FIELD_TYPE_LONG);
+    if (field != NULL) field->value.Long = value;
+}
+
+void output_double(const char *key, double value) {
+    OutputField *field = new_output_field(key, OUTPUT_FIELD_TYPE_DOUBLE);
+    if (field != NULL) field->value.Double = value;
+}
+
+void output_string(const char *key, const char *value) {
+    OutputField *field;
+    if (value == NULL) {
+        output_null(key);
+        return;
+    }
+
+    field = new_output_field(key, OUTPUT_FIELD_TYPE_STRING);
+    if (field != NULL) {
+        strncpy(field->value.String, value, OUTPUT_VALUE_LENGTH - 1);
+        field->value.String[OUTPUT_VALUE_LENGTH - 1] = '\0';
+    }
+}
+
+void output_end(void) {
+    if (output_records == NULL) return;
+
+    switch (output_format()) {
+        case OUTPUT_FORMAT_JSON: {
+            output_render_json();
+            break;
+        }
+        case OUTPUT_FORMAT_CSV: {
+            output_render_csv();
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    free_list(output_records);
+    output_records = NULL;
+}
+
+void output_discard(void) {
+    if (output_records == NULL) return;
+
+    free_list(output_records);
+    output_records = NULL;
+}
+
+static const OutputField *output_record_get(const List *record, const char *key) {
+    OutputField *data;
+
+    list_for_each(data, record) {
+        if (strcmp(data->key, key) == 0) return data;
+    }
+
+    return NULL;
+}
+
+static void output_print_json_string(const char *string) {
+    const char *c;
+
+    print_plain("\"");
+    for (c = string; *c != '\0'; ++c) {
+        switch (*c) {
+            case '"':
+            case '\\': {
+                print_plain("\\%c", *c);
+                break;
+            }
+            case '\n': {
+                print_plain("\\n");
+                break;
+            }
+            case '\t': {
+                print_plain("\\t");
+                break;
+            }
+            default: {
+                if ((unsigned char) *c < 0x20) print_plain("\\u%04x", *c);
+                else print_plain("%c", *c);
+                break;
+            }
+        }
+    }
+    print_plain("\"");
+}
+
+static void output_print_csv_string(const char *string) {
+    const char *c;
+
+    if (strpbrk(string, ",\"\n") == NULL) {
+        print_plain("%s", string);
+        return;
+    }
+
+    print_plain("\"");
+    for (c = string; *c != '\0'; ++c) {
+        if (*c == '"') print_plain("\"\"");
+        else print_plain("%c", *c);
+    }
+    print_plain("\"");
+}
+
+static void output_print_value(const OutputField *field, int format) {
+    if (field == NULL) return;
+
+    switch (field->type) {
+        case OUTPUT_FIELD_TYPE_BOOL: {
+            print_plain("%s", (field->value.Bool) ? "true" : "false");
+            break;
+        }
+        case OUTPUT_FIELD_TYPE_LONG: {
+            print_plain("%ld", field->value.Long);
+            break;
+        }
+        case OUTPUT_FIELD_TYPE_DOUBLE: {
+            print_plain("%g", field->value.Double);
+            break;
+        }
+        case OUTPUT_FIELD_TYPE_STRING: {
+            if (format == OUTPUT_FORMAT_JSON) output_print_json_string(field->value.String);
+            else output_print_csv_string(field->value.String);
+            break;
+        }
+        default: {
+            if (format == OUTPUT_FORMAT_JSON) print_plain("null");
+            break;
+        }
+    }
+}
+
+static void output_render_json(void) {
+    Node *record_node;
+    Node *field_node;
+    const OutputField *field;
+
+    print_plain("[");
+    for (record_node = output_records->head; record_node != NULL; record_node = record_node->next) {
+        print_plain("{");
+        for (field_node = ((List *) record_node->data)->head; field_node != NULL; field_node = field_node->next) {
+            field = (OutputField *) field_node->data;
+            output_print_json_string(field->key);
+            print_plain(":");
+            output_print_value(field, OUTPUT_FORMAT_JSON);
+            if (field_node->next != NULL) print_plain(",");
+        }
+        print_plain("}");
+        if (record_node->next != NULL) print_plain(",");
+    }
+    print_plain("]\n");
+}
+
+static void output_render_csv(void) {
+    List *keys;
+    Node *record_node;
+    Node *key_node;
+    OutputField *data;
+
+    /* Header is the union of all keys, in order of appearance */
+    keys = new_list(NULL, NULL);
+    for (record_node = output_records->head; record_node != NULL; record_node = record_node->next) {
+        list_for_each(data, ((List *) record_node->data)) {
+            for (key_node = keys->head; key_node != NULL; key_node = key_node->next) {
+                if (strcmp((char *) key_node->data, data->key) == 0) break;
+            }
+            if (key_node == NULL) list_add_last(keys, strdup(data->key));
+        }
+    }
+
+    for (key_node = keys->head; key_node != NULL; key_node = key_node->next) {
+        output_print_csv_string((char *) key_node->data);
+        print_plain("%s", (key_node->next != NULL) ? "," : "\n");
+    }
+
+    for (record_node = output_records->head; record_node != NULL; record_node = record_node->next) {
+        for (key_node = keys->head; key_node != NULL; key_node = key_node->next) {
+            output_print_value(output_record_get((List *) record_node->data, (char *) key_node->data),
+                               OUTPUT_FORMAT_CSV);
+            print_plain("%s", (key_node->next != NULL) ? "," : "\n");
+        }
+    }
+
+    free_list(keys);
+}
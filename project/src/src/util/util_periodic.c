@@ -0,0 +1,93 @@
+#include <stddef.h>
+#include "util/util_periodic.h"
+#include "util/util_stopwatch.h"
+
+/**
+ * Struct Periodic Entry, a registered task and when it runs next
+ */
+typedef struct PeriodicEntry {
+    PeriodicTask task;
+    Stopwatch interval;
+    Stopwatch next;
+} PeriodicEntry;
+
+static PeriodicEntry periodic_entries[PERIODIC_TASKS_MAX];
+static size_t periodic_entries_count = 0;
+
+/**
+ * Flag if a task is running, tasks can call code that checks for due tasks
+ */
+static bool periodic_running = false;
+
+/**
+ * Return the entry of a task
+ * @param task The task
+ * @return The entry, NULL if not registered
+ */
+static PeriodicEntry *periodic_entry(PeriodicTask task);
+
+static PeriodicEntry *periodic_entry(PeriodicTask task) {
+    size_t i;
+
+    for (i = 0; i < periodic_entries_count; ++i) {
+        if (periodic_entries[i].task == task) return &periodic_entries[i];
+    }
+
+    return NULL;
+}
+
+bool periodic_register(PeriodicTask task, unsigned long interval_ms) {
+    PeriodicEntry *entry;
+    if (task == NULL || interval_ms == 0) return false;
+
+    if ((entry = periodic_entry(task)) == NULL) {
+        if (periodic_entries_count >= PERIODIC_TASKS_MAX) return false;
+        entry = &periodic_entries[periodic_entries_count++];
+        entry->task = task;
+    }
+
+    entry->interval = (Stopwatch) interval_ms * (Stopwatch) STOPWATCH_NS_PER_MS;
+    entry->next = stopwatch_now() + entry->interval;
+
+    return true;
+}
+
+bool periodic_unregister(PeriodicTask task) {
+    PeriodicEntry *entry;
+    if ((entry = periodic_entry(task)) == NULL) return false;
+
+    *entry = periodic_entries[--periodic_entries_count];
+    return true;
+}
+
+long periodic_timeout(void) {
+    Stopwatch now;
+    Stopwatch next;
+    size_t i;
+    if (periodic_entries_count == 0) return -1;
+
+    next = periodic_entries[0].next;
+    for (i = 1; i < periodic_entries_count; ++i) {
+        if (periodic_entries[i].next < next) next = periodic_entries[i].next;
+    }
+
+    now = stopwatch_now();
+    return (next > now) ? (long) ((next - now) / (Stopwatch) STOPWATCH_NS_PER_MS) + 1 : 0;
+}
+
+void periodic_run(void) {
+    Stopwatch now;
+    size_t i;
+    if (periodic_running) return;
+
+    periodic_running = true;
+    now = stopwatch_now();
+    for (i = 0; i < periodic_entries_count; ++i) {
+        if (periodic_entries[i].next > now) continue;
+
+        /* Skip the runs that have been missed, a late task runs once */
+        while (periodic_entries[i].next <= now) periodic_entries[i].next += periodic_entries[i].interval;
+        periodic_entries[i].task();
+    }
+    periodic_running = false;
+}
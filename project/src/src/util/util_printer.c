@@ -1,22 +1,111 @@
-
 #include <stdarg.h>
+#include <stdlib.h>
 #include "util/util_printer.h"
 
+/**
+ * Output buffer, used only between printer_buffer_begin and printer_buffer_end
+ */
+static char *printer_buffer = NULL;
+
+/**
+ * Number of characters in the output buffer
+ */
+static size_t printer_buffer_length = 0;
+
+/**
+ * Allocated size of the output buffer
+ */
+static size_t printer_buffer_size = 0;
+
+/**
+ * Nesting level of printer_buffer_begin
+ */
+static size_t printer_buffer_depth = 0;
+
 /**
  * Print the string to stream with the selected color and add a newline if newline is true
  * @param stream Stream pointer output
- * @param color The Color
+ * @param color The Color, NULL for no color
  * @param format The String
  * @param newline Add a newline at the end
  * @param args Format tags
  */
 static void printer(FILE *stream, const char *color, const char *format, bool newline, va_list args);
 
+/**
+ * Write the formatted string to stream or append it to the output buffer if stdout is buffered
+ * @param stream Stream pointer output
+ * @param format The String
+ * @param args Format tags
+ */
+static void printer_write(FILE *stream, const char *format, va_list args);
+
+/**
+ * Write a plain string using printer_write
+ * @param stream Stream pointer output
+ * @param string The String
+ */
+static void printer_write_string(FILE *stream, const char *string, ...);
+
 static void printer(FILE *stream, const char *color, const char *format, bool newline, va_list args) {
-    fprintf(stream, "%s", color);
-    vfprintf(stream, format, args);
-    fprintf(stream, "%s", COLOR_RESET);
-    if (newline) fprintf(stream, "\n");
+    if (color != NULL) printer_write_string(stream, color);
+    printer_write(stream, format, args);
+    if (color != NULL) printer_write_string(stream, COLOR_RESET);
+    if (newline) printer_write_string(stream, "\n");
+}
+
+static void printer_write(FILE *stream, const char *format, va_list args) {
+    va_list args_copy;
+    int length;
+
+    if (stream != stdout || printer_buffer_depth == 0) {
+        vfprintf(stream, format, args);
+        return;
+    }
+
+    va_copy(args_copy, args);
+    length = vsnprintf(NULL, 0, format, args_copy);
+    va_end(args_copy);
+    if (length < 0) return;
+
+    if (printer_buffer_length + length + 1 > printer_buffer_size) {
+        while (printer_buffer_length + length + 1 > printer_buffer_size) printer_buffer_size += PRINTER_BUFFER_SIZE;
+        printer_buffer = (char *) realloc(printer_buffer, sizeof(char) * printer_buffer_size);
+        if (printer_buffer == NULL) {
+            perror("Printer Buffer Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    vsnprintf(printer_buffer + printer_buffer_length, printer_buffer_size - printer_buffer_length, format, args);
+    printer_buffer_length += length;
+}
+
+static void printer_write_string(FILE *stream, const char *string, ...) {
+    va_list args;
+    va_start(args, string);
+    printer_write(stream, string, args);
+    va_end(args);
+}
+
+void printer_buffer_begin(void) {
+    printer_buffer_depth++;
+}
+
+void printer_buffer_end(void) {
+    if (printer_buffer_depth == 0) return;
+
+    if (printer_buffer_length > 0) {
+        fwrite(printer_buffer, sizeof(char), printer_buffer_length, stdout);
+        printer_buffer_length = 0;
+    }
+    fflush(stdout);
+
+    if (--printer_buffer_depth == 0) {
+        free(printer_buffer);
+        printer_buffer = NULL;
+        printer_buffer_size = 0;
+    }
 }
 
 void print(const char *format, ...) {
@@ -45,4 +134,11 @@ void println_color(const char *color, const char *format, ...) {
     va_start(args, format);
     printer(stdout, color, format, true, args);
     va_end(args);
-}
\ No newline at end of file
+}
+
+void print_plain(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    printer(stdout, NULL, format, false, args);
+    va_end(args);
+}
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "util/util_process.h"
+#include "collection/collection_list.h"
+
+/**
+ * Cache of the latest sample of every process, created on first use
+ */
+static List *process_resources_cache = NULL;
+
+/**
+ * Compare two Process Resources by pid
+ * @param data1 The first Process Resources
+ * @param data2 The second Process Resources
+ * @return true if they describe the same process, false otherwise
+ */
+static bool process_resources_equals(const void *data1, const void *data2);
+
+/**
+ * Read CPU time, start time and resident pages from /proc/<pid>/stat
+ * @param pid The pid of the process
+ * @param resources The resources to fill
+ * @param start_time The start time of the process in seconds since boot
+ * @return true if read, false otherwise
+ */
+static bool process_resources_read_stat(pid_t pid, ProcessResources *resources, double *start_time);
+
+/**
+ * Read resident set size and context switches from /proc/<pid>/status
+ * @param pid The pid of the process
+ * @param resources The resources to fill, fields not found are left untouched
+ * @return true if read, false otherwise
+ */
+static bool process_resources_read_status(pid_t pid, ProcessResources *resources);
+
+/**
+ * Count the open file descriptors in /proc/<pid>/fd
+ * @param pid The pid of the process
+ * @return The number of open file descriptors, -1 if not readable
+ */
+static long process_resources_read_fds(pid_t pid);
+
+/**
+ * Return the seconds elapsed since boot from /proc/uptime
+ * @return The uptime, 0 if not readable
+ */
+static double process_resources_uptime(void);
+
+static bool process_resources_equals(const void *data1, const void *data2) {
+    if (data1 == NULL || data2 == NULL) return false;
+    return ((const ProcessResources *) data1)->pid == ((const ProcessResources *) data2)->pid;
+}
+
+static bool process_resources_read_stat(pid_t pid, ProcessResources *resources, double *start_time) {
+    FILE *file;
+    char path[PROCESS_RESOURCES_PATH_LENGTH];
+    char line[PROCESS_RESOURCES_LINE_LENGTH];
+    char *fields;
+    unsigned long user_ticks;
+    unsigned long system_ticks;
+    unsigned long long start_ticks;
+    long pages;
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    bool read;
+
+    snprintf(path, PROCESS_RESOURCES_PATH_LENGTH, "/proc/%d/stat", pid);
+    if ((file = fopen(path, "r")) == NULL) return false;
+    read = fgets(line, PROCESS_RESOURCES_LINE_LENGTH, file) != NULL;
+    fclose(file);
+    if (!read || ticks_per_second <= 0) return false;
+
+    /* The process name can contain spaces and parentheses, fields start after the last one */
+    if ((fields = strrchr(line, ')')) == NULL) return false;
+    if (sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %*d %*d %*d %*d %*d %*d %llu %*u %ld",
+               &user_ticks, &system_ticks, &start_ticks, &pages) != 4)
+        return false;
+
+    resources->cpu_time = (unsigned long long) (user_ticks + system_ticks) * 1000000000ULL / ticks_per_second;
+    resources->rss = (unsigned long) pages * (sysconf(_SC_PAGESIZE) / 1024);
+    *start_time = (double) start_ticks / ticks_per_second;
+
+    return true;
+}
+
+static bool process_resources_read_status(pid_t pid, ProcessResources *resources) {
+    FILE *file;
+    char path[PROCESS_RESOURCES_PATH_LENGTH];
+    char line[PROCESS_RESOURCES_LINE_LENGTH];
+
+    snprintf(path, PROCESS_RESOURCES_PATH_LENGTH, "/proc/%d/status", pid);
+    if ((file = fopen(path, "r")) == NULL) return false;
+
+    while (fgets(line, PROCESS_RESOURCES_LINE_LENGTH, file) != NULL) {
+        if (sscanf(line, "VmRSS: %lu", &resources->rss) == 1) continue;
+        if (sscanf(line, "voluntary_ctxt_switches: %lu", &resources->voluntary_context_switches) == 1) continue;
+        sscanf(line, "nonvoluntary_ctxt_switches: %lu", &resources->involuntary_context_switches);
+    }
+    fclose(file);
+
+    return true;
+}
+
+static long process_resources_read_fds(pid_t pid) {
+    DIR *directory;
+    struct dirent *entry;
+    char path[PROCESS_RESOURCES_PATH_LENGTH];
+    long fds = 0;
+
+    snprintf(path, PROCESS_RESOURCES_PATH_LENGTH, "/proc/%d/fd", pid);
+    if ((directory = opendir(path)) == NULL) return -1;
+
+    while ((entry = readdir(directory)) != NULL) {
+        if (entry->d_name[0] != '.') fds++;
+    }
+    closedir(directory);
+
+    return fds;
+}
+
+static double process_resources_uptime(void) {
+    FILE *file;
+    double uptime = 0;
+
+    if ((file = fopen("/proc/uptime", "r")) == NULL) return 0;
+    if (fscanf(file, "%lf", &uptime) != 1) uptime = 0;
+    fclose(file);
+
+    return uptime;
+}
+
+bool process_resources_read(pid_t pid, ProcessResources *resources) {
+    double start_time;
+    double lifetime;
+    if (pid <= 0 || resources == NULL) return false;
+
+    memset(resources, 0, sizeof(ProcessResources));
+    resources->pid = pid;
+    if (!process_resources_read_stat(pid, resources, &start_time)) return false;
+    process_resources_read_status(pid, resources);
+    resources->fds = process_resources_read_fds(pid);
+    resources->sampled = stopwatch_now();
+
+    lifetime = process_resources_uptime() - start_time;
+    if (lifetime > 0) resources->cpu_percent = (double) resources->cpu_time / (lifetime * 10000000.0);
+
+    return true;
+}
+
+const ProcessResources *process_resources_sample(pid_t pid) {
+    ProcessResources *cached = NULL;
+    ProcessResources *data;
+    ProcessResources sample;
+    Stopwatch elapsed;
+
+    if (process_resources_cache == NULL) {
+        process_resources_cache = new_list(NULL, process_resources_equals);
+    }
+
+    list_for_each(data, process_resources_cache) {
+        if (data->pid == pid) {
+            cached = data;
+            break;
+        }
+    }
+
+    if (cached != NULL && stopwatch_elapsed_ms(cached->sampled) < PROCESS_RESOURCES_CACHE_TTL_MS) return cached;
+
+    if (!process_resources_read(pid, &sample)) {
+        /* Terminated, its pid can be reused by an unrelated process */
+        if (cached != NULL) list_remove(process_resources_cache, cached);
+        return NULL;
+    }
+
+    if (cached == NULL) {
+        cached = (ProcessResources *) malloc(sizeof(ProcessResources));
+        if (cached == NULL) {
+            perror("Process Resources Memory Allocation");
+            exit(EXIT_FAILURE);
+        }
+        list_add_last(process_resources_cache, cached);
+    } else if ((elapsed = sample.sampled - cached->sampled) > 0) {
+        /* Usage over the interval between the two samples */
+        sample.cpu_percent = (sample.cpu_time > cached->cpu_time)
+                             ? (double) (sample.cpu_time - cached->cpu_time) * 100.0 / (double) elapsed : 0;
+    }
+    *cached = sample;
+
+    return cached;
+}
+
+size_t process_resources_sample_all(const pid_t *pids, size_t count, ProcessResources *resources) {
+    const ProcessResources *sample;
+    size_t read = 0;
+    size_t i;
+    if (pids == NULL || resources == NULL) return 0;
+
+    for (i = 0; i < count; ++i) {
+        if ((sample = process_resources_sample(pids[i])) == NULL) {
+            memset(&resources[i], 0, sizeof(ProcessResources));
+            continue;
+        }
+        resources[i] = *sample;
+        read++;
+    }
+
+    return read;
+}
@@ -0,0 +1,245 @@
+#include <string.h>
+#include "util/util_series.h"
+
+/* No window yet, the first non zero XOR always opens one */
+#define SERIES_NO_WINDOW 64
+#define SERIES_LEADING_MAX 31
+
+/**
+ * Write the lowest bits of a value
+ * @param bits The bit stream
+ * @param value The value
+ * @param count The number of bits, at most 64
+ */
+static void series_bits_write(SeriesBits *bits, uint64_t value, unsigned int count);
+
+/**
+ * Read bits into the lowest bits of a value
+ * @param bits The bit stream
+ * @param count The number of bits, at most 64
+ * @param value The value read
+ * @return true if read, false if the stream ends before
+ */
+static bool series_bits_read(SeriesBits *bits, unsigned int count, uint64_t *value);
+
+/**
+ * Extend the sign of a value of some bits
+ * @param value The value
+ * @param count The number of bits of the value
+ * @return The signed value
+ */
+static int64_t series_sign_extend(uint64_t value, unsigned int count);
+
+static void series_bits_write(SeriesBits *bits, uint64_t value, unsigned int count) {
+    unsigned int i;
+
+    for (i = count; i > 0; --i) {
+        if ((value >> (i - 1)) & 1) bits->data[bits->bits / 8] |= (unsigned char) (0x80 >> (bits->bits % 8));
+        bits->bits++;
+    }
+}
+
+static bool series_bits_read(SeriesBits *bits, unsigned int count, uint64_t *value) {
+    unsigned int i;
+    if (bits->bits + count > bits->capacity * 8) return false;
+
+    *value = 0;
+    for (i = 0; i < count; ++i) {
+        *value = (*value << 1) | ((bits->data[bits->bits / 8] >> (7 - bits->bits % 8)) & 1);
+        bits->bits++;
+    }
+
+    return true;
+}
+
+static int64_t series_sign_extend(uint64_t value, unsigned int count) {
+    if (count < 64 && (value & ((uint64_t) 1 << (count - 1)))) value |= ~(((uint64_t) 1 << count) - 1);
+
+    return (int64_t) value;
+}
+
+void series_encoder_reset(SeriesEncoder *encoder) {
+    if (encoder == NULL) return;
+
+    memset(encoder->timestamps_data, 0, SERIES_TIMESTAMPS_LENGTH);
+    memset(encoder->values_data, 0, SERIES_VALUES_LENGTH);
+    encoder->timestamps.data = encoder->timestamps_data;
+    encoder->timestamps.capacity = SERIES_TIMESTAMPS_LENGTH;
+    encoder->timestamps.bits = 0;
+    encoder->values.data = encoder->values_data;
+    encoder->values.capacity = SERIES_VALUES_LENGTH;
+    encoder->values.bits = 0;
+    encoder->count = 0;
+    encoder->first = 0;
+    encoder->last = 0;
+    encoder->delta = 0;
+    encoder->value = 0;
+    encoder->leading = SERIES_NO_WINDOW;
+    encoder->trailing = 0;
+}
+
+bool series_encoder_append(SeriesEncoder *encoder, int64_t timestamp, double value) {
+    int64_t delta;
+    int64_t delta_of_delta;
+    uint64_t bits;
+    uint64_t xor;
+    unsigned int leading;
+    unsigned int trailing;
+    if (encoder == NULL || encoder->count >= SERIES_BLOCK_POINTS) return false;
+
+    memcpy(&bits, &value, sizeof(uint64_t));
+
+    if (encoder->count == 0) {
+        series_bits_write(&encoder->timestamps, (uint64_t) timestamp, 64);
+        series_bits_write(&encoder->values, bits, 64);
+        encoder->first = timestamp;
+    } else {
+        if (timestamp < encoder->last) return false;
+        delta = timestamp - encoder->last;
+        delta_of_delta = delta - encoder->delta;
+
+        /* Regular sampling makes almost every delta of delta 0, one bit */
+        if (delta_of_delta == 0) {
+            series_bits_write(&encoder->timestamps, 0x0, 1);
+        } else if (delta_of_delta >= -64 && delta_of_delta <= 63) {
+            series_bits_write(&encoder->timestamps, 0x2, 2);
+            series_bits_write(&encoder->timestamps, (uint64_t) delta_of_delta, 7);
+        } else if (delta_of_delta >= -256 && delta_of_delta <= 255) {
+            series_bits_write(&encoder->timestamps, 0x6, 3);
+            series_bits_write(&encoder->timestamps, (uint64_t) delta_of_delta, 9);
+        } else if (delta_of_delta >= -2048 && delta_of_delta <= 2047) {
+            series_bits_write(&encoder->timestamps, 0xE, 4);
+            series_bits_write(&encoder->timestamps, (uint64_t) delta_of_delta, 12);
+        } else if (delta_of_delta >= INT32_MIN && delta_of_delta <= INT32_MAX) {
+            series_bits_write(&encoder->timestamps, 0xF, 4);
+            series_bits_write(&encoder->timestamps, (uint64_t) delta_of_delta, 32);
+        } else {
+            return false;
+        }
+        encoder->delta = delta;
+
+        /* Slowly changing values share most bits with the previous one */
+        if ((xor = bits ^ encoder->value) == 0) {
+            series_bits_write(&encoder->values, 0x0, 1);
+        } else {
+            leading = (unsigned int) __builtin_clzll(xor);
+            trailing = (unsigned int) __builtin_ctzll(xor);
+            if (leading > SERIES_LEADING_MAX) leading = SERIES_LEADING_MAX;
+
+            if (encoder->leading != SERIES_NO_WINDOW && leading >= encoder->leading &&
+                trailing >= encoder->trailing) {
+                series_bits_write(&encoder->values, 0x2, 2);
+                series_bits_write(&encoder->values, xor >> encoder->trailing,
+                                  64 - encoder->leading - encoder->trailing);
+            } else {
+                series_bits_write(&encoder->values, 0x3, 2);
+                series_bits_write(&encoder->values, leading, 5);
+                /* 64 meaningful bits do not fit in 6 bits, they are written as 0 */
+                series_bits_write(&encoder->values, (64 - leading - trailing) & 0x3F, 6);
+                series_bits_write(&encoder->values, xor >> trailing, 64 - leading - trailing);
+                encoder->leading = leading;
+                encoder->trailing = trailing;
+            }
+        }
+    }
+
+    encoder->last = timestamp;
+    encoder->value = bits;
+    encoder->count++;
+
+    return true;
+}
+
+size_t series_encoder_timestamps_length(const SeriesEncoder *encoder) {
+    return (encoder == NULL) ? 0 : (encoder->timestamps.bits + 7) / 8;
+}
+
+size_t series_encoder_values_length(const SeriesEncoder *encoder) {
+    return (encoder == NULL) ? 0 : (encoder->values.bits + 7) / 8;
+}
+
+void series_decoder_init(SeriesDecoder *decoder, const unsigned char *timestamps, size_t timestamps_length,
+                         const unsigned char *values, size_t values_length, size_t count) {
+    if (decoder == NULL) return;
+
+    /* The decoder only reads, the data is never written through it */
+    decoder->timestamps.data = (unsigned char *) timestamps;
+    decoder->timestamps.capacity = timestamps_length;
+    decoder->timestamps.bits = 0;
+    decoder->values.data = (unsigned char *) values;
+    decoder->values.capacity = values_length;
+    decoder->values.bits = 0;
+    decoder->count = count;
+    decoder->index = 0;
+    decoder->last = 0;
+    decoder->delta = 0;
+    decoder->value = 0;
+    decoder->leading = SERIES_NO_WINDOW;
+    decoder->trailing = 0;
+}
+
+bool series_decoder_next(SeriesDecoder *decoder, int64_t *timestamp, double *value) {
+    uint64_t bits;
+    uint64_t control;
+    uint64_t leading;
+    uint64_t meaningful;
+    unsigned int size;
+    if (decoder == NULL || timestamp == NULL || value == NULL || decoder->index >= decoder->count) return false;
+
+    if (decoder->index == 0) {
+        if (!series_bits_read(&decoder->timestamps, 64, &bits)) return false;
+        decoder->last = (int64_t) bits;
+        if (!series_bits_read(&decoder->values, 64, &decoder->value)) return false;
+    } else {
+        /* Count the leading ones of the control, at most 4 */
+        for (size = 0; size < 4; ++size) {
+            if (!series_bits_read(&decoder->timestamps, 1, &control)) return false;
+            if (control == 0) break;
+        }
+        switch (size) {
+            case 0: {
+                bits = 0;
+                break;
+            }
+            case 1:
+            case 2:
+            case 3: {
+                size = (size == 1) ? 7 : (size == 2) ? 9 : 12;
+                if (!series_bits_read(&decoder->timestamps, size, &bits)) return false;
+                bits = (uint64_t) series_sign_extend(bits, size);
+                break;
+            }
+            default: {
+                if (!series_bits_read(&decoder->timestamps, 32, &bits)) return false;
+                bits = (uint64_t) series_sign_extend(bits, 32);
+                break;
+            }
+        }
+        decoder->delta += (int64_t) bits;
+        decoder->last += decoder->delta;
+
+        if (!series_bits_read(&decoder->values, 1, &control)) return false;
+        if (control == 1) {
+            if (!series_bits_read(&decoder->values, 1, &control)) return false;
+            if (control == 1) {
+                if (!series_bits_read(&decoder->values, 5, &leading)) return false;
+                if (!series_bits_read(&decoder->values, 6, &meaningful)) return false;
+                if (meaningful == 0) meaningful = 64;
+                if (leading + meaningful > 64) return false;
+                decoder->leading = (unsigned int) leading;
+                decoder->trailing = (unsigned int) (64 - leading - meaningful);
+            } else if (decoder->leading == SERIES_NO_WINDOW) {
+                return false;
+            }
+
+            if (!series_bits_read(&decoder->values, 64 - decoder->leading - decoder->trailing, &bits)) return false;
+            decoder->value ^= bits << decoder->trailing;
+        }
+    }
+
+    *timestamp = decoder->last;
+    memcpy(value, &decoder->value, sizeof(double));
+    decoder->index++;
+
+    return true;
+}
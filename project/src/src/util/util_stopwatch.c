@@ -0,0 +1,18 @@
+#include <time.h>
+#include "util/util_stopwatch.h"
+
+Stopwatch stopwatch_now(void) {
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) return 0;
+
+    return (Stopwatch) now.tv_sec * 1000000000ULL + (Stopwatch) now.tv_nsec;
+}
+
+Stopwatch stopwatch_elapsed(Stopwatch start) {
+    Stopwatch now = stopwatch_now();
+    return (now > start) ? now - start : 0;
+}
+
+double stopwatch_elapsed_ms(Stopwatch start) {
+    return (double) stopwatch_elapsed(start) / STOPWATCH_NS_PER_MS;
+}